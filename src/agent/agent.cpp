@@ -8,6 +8,7 @@
 #include <shared_mutex>
 #include <mutex>
 #include <future>
+#include <iterator>
 #include <utility>
 #include "task_coordinator.h"
 
@@ -43,15 +44,29 @@ AgentResponse Agent::process(const std::string& userMessage,
     int iteration = 0;
 
     while (iteration < config_.max_iterations) {
-        // 构建消息列表
-        std::vector<ChatMessage> messages = buildMessages(userMessage);
-
-        // 执行一轮对话
-        AgentResponse response = performOneRound(messages);
+        // 执行一轮对话（流水线模式下工具调用在响应到达过程中即开始执行）
+        std::unique_ptr<ToolPipeline> pipeline;
+        if (config_.pipelined_tool_execution) {
+            pipeline = createToolPipeline();
+        }
+        AgentResponse response = performOneRound(pipeline.get());
 
         // 更新token统计
         finalResponse.total_input_tokens += response.total_input_tokens;
         finalResponse.total_output_tokens += response.total_output_tokens;
+        finalResponse.total_cache_read_tokens += response.total_cache_read_tokens;
+        finalResponse.total_cache_creation_tokens += response.total_cache_creation_tokens;
+        finalResponse.cached_rounds += response.cached_rounds;
+
+        // 响应失败前已派发的调用已经执行（可能已写文件、烧录设备），
+        // 等待其结束并如实记入历史，不能丢弃
+        std::vector<std::pair<ChatMessage::ToolCall, ToolResult>> interrupted;
+        if (pipeline && !response.success) {
+            interrupted = pipeline->finish();
+            for (const auto& entry : interrupted) {
+                response.tool_calls.push_back(entry.first);
+            }
+        }
 
         // 添加助手回复到历史
         ChatMessage assistantMsg(MessageRole::ASSISTANT, response.content);
@@ -61,6 +76,17 @@ AgentResponse Agent::process(const std::string& userMessage,
             history_.push_back(assistantMsg);
         }
 
+        if (!interrupted.empty()) {
+            for (const auto& [call, result] : interrupted) {
+                appendToolResult(call.id, result);
+            }
+            finalResponse.tool_calls = response.tool_calls;
+            finalResponse.error = response.error + "（响应中断前已执行 " +
+                                  std::to_string(interrupted.size()) + " 个工具调用，结果已记入历史）";
+            finalResponse.success = false;
+            break;
+        }
+
         // 如果没有工具调用，返回结果
         if (!response.has_tool_calls) {
             finalResponse.content = response.content;
@@ -69,8 +95,9 @@ AgentResponse Agent::process(const std::string& userMessage,
             break;
         }
 
-        // 执行工具调用
-        bool allSuccess = executeToolCalls(response.tool_calls);
+        // 执行工具调用（流水线模式下只需等待已派发的调用完成）
+        bool allSuccess = pipeline ? collectToolPipeline(*pipeline)
+                                   : executeToolCalls(response.tool_calls);
 
         // 如果工具执行失败，停止
         if (!allSuccess) {
@@ -109,67 +136,16 @@ bool Agent::processStream(const std::string& userMessage,
         history_.push_back(userMsg);
     }
 
-    // 构建消息列表
-    std::vector<ChatMessage> messages = buildMessages(userMessage);
-
-    // 获取工具定义
-    std::vector<ToolDescription> toolDescs = tool_executor_->getAllToolDescriptions();
-    std::vector<ToolDefinition> tools;
-    for (const auto& desc : toolDescs) {
-        ToolDefinition tool;
-        tool.name = desc.name;
-        tool.description = desc.description;
-
-        // 构建 JSON Schema 格式的 parameters
-        json paramsSchema;
-        paramsSchema["type"] = "object";
-
-        // 构建 properties
-        json properties = json::object();
-        std::vector<std::string> required;
-        for (const auto& param : desc.parameters) {
-            json paramSchema;
-            paramSchema["type"] = param.type;
-            paramSchema["description"] = param.description;
-
-            // 添加默认值（如果有）
-            if (!param.default_value.empty()) {
-                if (param.type == "string") {
-                    paramSchema["default"] = param.default_value;
-                } else if (param.type == "integer") {
-                    try {
-                        paramSchema["default"] = std::stoi(param.default_value);
-                    } catch (...) {
-                        // 保持默认为字符串
-                    }
-                }
-            }
-
-            properties[param.name] = paramSchema;
-
-            // 记录必需参数
-            if (param.required) {
-                required.push_back(param.name);
-            }
-        }
-        paramsSchema["properties"] = properties;
-
-        // 添加 required 数组（如果有必需参数）
-        if (!required.empty()) {
-            paramsSchema["required"] = required;
-        }
-
-        tool.input_schema = paramsSchema;
-        tools.push_back(tool);
-    }
+    // 获取工具定义（缓存的Schema快照，工具注册变化时才重建）
+    auto toolSchema = tool_executor_->getToolSchema();
 
     // 构建消息
-    std::vector<ChatMessage> apiMessages = prompt_builder_.buildMessages(messages, tools);
+    const std::vector<ChatMessage>& apiMessages = buildMessages(toolSchema->tools);
 
     // 流式请求（注意：当前postStream实现实际返回完整JSON，不是真正的SSE流）
     std::stringstream contentStream;
     std::vector<ChatMessage::ToolCall> accumulatedToolCalls;
-    bool success = llm_provider_->chatStream(apiMessages, tools,
+    bool success = llm_provider_->chatStream(apiMessages, *toolSchema,
         [&](const std::string& chunk) {
             // 当前实现返回完整JSON响应，不是SSE格式
             try {
@@ -249,65 +225,23 @@ bool Agent::processStream(const std::string& userMessage,
     return true;
 }
 
-AgentResponse Agent::performOneRound(const std::vector<ChatMessage>& messages) {
+AgentResponse Agent::performOneRound(ToolPipeline* pipeline) {
     AgentResponse response;
 
-    // 获取工具定义
-    std::vector<ToolDescription> toolDescs = tool_executor_->getAllToolDescriptions();
-    std::vector<ToolDefinition> tools;
-    for (const auto& desc : toolDescs) {
-        ToolDefinition tool;
-        tool.name = desc.name;
-        tool.description = desc.description;
-
-        // 构建 JSON Schema 格式的 parameters
-        json paramsSchema;
-        paramsSchema["type"] = "object";
-
-        // 构建 properties
-        json properties = json::object();
-        std::vector<std::string> required;
-        for (const auto& param : desc.parameters) {
-            json paramSchema;
-            paramSchema["type"] = param.type;
-            paramSchema["description"] = param.description;
-
-            // 添加默认值（如果有）
-            if (!param.default_value.empty()) {
-                if (param.type == "string") {
-                    paramSchema["default"] = param.default_value;
-                } else if (param.type == "integer") {
-                    try {
-                        paramSchema["default"] = std::stoi(param.default_value);
-                    } catch (...) {
-                        // 保持默认为字符串
-                    }
-                }
-            }
-
-            properties[param.name] = paramSchema;
-
-            // 记录必需参数
-            if (param.required) {
-                required.push_back(param.name);
-            }
-        }
-        paramsSchema["properties"] = properties;
-
-        // 添加 required 数组（如果有必需参数）
-        if (!required.empty()) {
-            paramsSchema["required"] = required;
-        }
-
-        tool.input_schema = paramsSchema;
-        tools.push_back(tool);
-    }
+    // 获取工具定义（缓存的Schema快照，工具注册变化时才重建）
+    auto toolSchema = tool_executor_->getToolSchema();
 
     // 构建消息
-    std::vector<ChatMessage> apiMessages = prompt_builder_.buildMessages(messages, tools);
+    const std::vector<ChatMessage>& apiMessages = buildMessages(toolSchema->tools);
 
-    // 调用LLM
-    LLMResponse llmResponse = llm_provider_->chat(apiMessages, tools);
+    // 调用LLM（流水线模式下每个工具调用参数完整后立即派发）
+    LLMResponse llmResponse;
+    if (pipeline) {
+        llmResponse = llm_provider_->chatWithToolCallbacks(apiMessages, *toolSchema,
+            [pipeline](const ChatMessage::ToolCall& call) { pipeline->dispatch(call); });
+    } else {
+        llmResponse = llm_provider_->chat(apiMessages, *toolSchema);
+    }
 
     if (!llmResponse.success) {
         response.success = false;
@@ -322,6 +256,9 @@ AgentResponse Agent::performOneRound(const std::vector<ChatMessage>& messages) {
     response.success = true;
     response.total_input_tokens = llmResponse.input_tokens;
     response.total_output_tokens = llmResponse.output_tokens;
+    response.total_cache_read_tokens = llmResponse.cache_read_input_tokens;
+    response.total_cache_creation_tokens = llmResponse.cache_creation_input_tokens;
+    response.cached_rounds = llmResponse.from_cache ? 1 : 0;
 
     return response;
 }
@@ -331,8 +268,8 @@ bool Agent::executeToolCalls(const std::vector<ChatMessage::ToolCall>& toolCalls
         return true;
     }
 
-    // 如果启用并发执行且有多个工具调用
-    if (config_.concurrent_tool_execution && toolCalls.size() > 1 && thread_pool_) {
+    // 如果启用并发执行且有多个工具调用（按资源冲突分析，互不冲突的调用并行）
+    if (config_.concurrent_tool_execution && toolCalls.size() > 1) {
         return executeToolCallsConcurrent(toolCalls);
     }
 
@@ -347,20 +284,8 @@ bool Agent::executeToolCallsSequential(const std::vector<ChatMessage::ToolCall>&
         // 执行工具
         ToolResult result = tool_executor_->execute(call.name, call.arguments);
 
-        // 存储结果
-        {
-            std::lock_guard<std::mutex> lock(tool_results_mutex_);
-            tool_results_[call.id] = result;
-        }
-
-        // 添加工具响应消息到历史
-        ChatMessage toolMsg(MessageRole::TOOL, result.success ? result.content : result.error_message);
-        toolMsg.tool_call_id = call.id;
-        toolMsg.is_error = !result.success;
-        {
-            std::unique_lock<std::shared_mutex> lock(history_mutex_);
-            history_.push_back(toolMsg);
-        }
+        // 存储结果并添加工具响应消息到历史
+        appendToolResult(call.id, result);
 
         if (!result.success) {
             allSuccess = false;
@@ -371,70 +296,139 @@ bool Agent::executeToolCallsSequential(const std::vector<ChatMessage::ToolCall>&
 }
 
 bool Agent::executeToolCallsConcurrent(const std::vector<ChatMessage::ToolCall>& toolCalls) {
-    std::vector<std::future<std::pair<std::string, ToolResult>>> futures;
-
-    // 提交所有工具调用到线程池
+    // 按冲突图调度：读写同一路径、独占同一设备的调用保持原始顺序，其余并行
+    auto pipeline = createToolPipeline();
     for (const auto& call : toolCalls) {
-        auto future = thread_pool_->submitWithResult(
-            [this, call]() -> std::pair<std::string, ToolResult> {
-                ToolResult result = tool_executor_->execute(call.name, call.arguments);
-                return std::make_pair(call.id, result);
-            }
-        );
-        futures.push_back(std::move(future));
+        pipeline->dispatch(call);
     }
 
-    // 等待所有任务完成并收集结果
-    bool allSuccess = true;
-    for (auto& future : futures) {
-        try {
-            auto [callId, result] = future.get();
-
-            // 存储结果
-            {
-                std::lock_guard<std::mutex> lock(tool_results_mutex_);
-                tool_results_[callId] = result;
-            }
+    // 结果按原始顺序写入历史
+    return collectToolPipeline(*pipeline);
+}
 
-            // 添加工具响应消息到历史
-            ChatMessage toolMsg(MessageRole::TOOL, result.success ? result.content : result.error_message);
-            toolMsg.tool_call_id = callId;
-            toolMsg.is_error = !result.success;
-            {
-                std::unique_lock<std::shared_mutex> lock(history_mutex_);
-                history_.push_back(toolMsg);
-            }
+std::unique_ptr<ToolPipeline> Agent::createToolPipeline() {
+    if (!thread_pool_) {
+        thread_pool_ = std::make_shared<ThreadPool>();
+    }
 
-            if (!result.success) {
-                allSuccess = false;
-            }
-        } catch (const std::exception& e) {
-            LOG_ERROR("并发工具执行异常: " + std::string(e.what()));
+    return std::make_unique<ToolPipeline>(thread_pool_,
+        [this](const ChatMessage::ToolCall& call) {
+            return tool_executor_->execute(call.name, call.arguments);
+        },
+        [this](const ChatMessage::ToolCall& call) {
+            return tool_executor_->describeAccess(call.name, call.arguments);
+        });
+}
+
+bool Agent::collectToolPipeline(ToolPipeline& pipeline) {
+    bool allSuccess = true;
+
+    // 结果按派发顺序（即模型给出的顺序）写入历史
+    for (const auto& [call, result] : pipeline.finish()) {
+        appendToolResult(call.id, result);
+        if (!result.success) {
             allSuccess = false;
         }
     }
 
+    auto stats = pipeline.getStats();
+    if (stats.deferred > 0) {
+        LOG_INFO("工具调度: " + std::to_string(stats.dispatched) + " 个调用, " +
+                 std::to_string(stats.deferred) + " 个因资源冲突延后");
+    }
+
     return allSuccess;
 }
 
-std::vector<ChatMessage> Agent::buildMessages(const std::string& userMessage) {
-    std::vector<ChatMessage> messages;
+void Agent::appendToolResult(const std::string& callId, const ToolResult& result) {
+    {
+        std::lock_guard<std::mutex> lock(tool_results_mutex_);
+        tool_results_[callId] = result;
+    }
 
-    // 获取所有历史消息（包含完整的对话历史）
-    std::vector<ChatMessage> history;
+    ChatMessage toolMsg(MessageRole::TOOL, result.success ? result.content : result.error_message);
+    toolMsg.tool_call_id = callId;
+    toolMsg.is_error = !result.success;
     {
-        std::shared_lock<std::shared_mutex> lock(history_mutex_);
-        history = history_;  // 复制全部历史
+        std::unique_lock<std::shared_mutex> lock(history_mutex_);
+        history_.push_back(toolMsg);
     }
+}
 
-    // 如果启用了Token优化，压缩历史
-    if (token_optimization_enabled_ && token_optimizer_) {
-        messages = token_optimizer_->compressHistory(history, 8000);
-    } else {
-        messages = history;
+const std::vector<ChatMessage>& Agent::buildMessages(const std::vector<ToolDefinition>& tools) {
+    // 持久上下文：系统消息，后台生成的摘要段，摘要未覆盖的原始消息。
+    // 每轮只追加新消息，不复制整个历史；同一修订号内只追加，
+    // 换系统消息、换摘要、压缩或清空历史时修订号递增
+    ChatMessage systemMsg = prompt_builder_.buildSystemMessage(tools);
+    bool optimize = token_optimization_enabled_ && token_optimizer_;
+    bool rewritten = false;
+
+    std::shared_lock<std::shared_mutex> lock(history_mutex_);
+    if (context_.empty() || context_generation_ != history_generation_ ||
+        context_source_ > history_.size()) {
+        context_.clear();
+        context_.push_back(std::move(systemMsg));
+        context_source_ = 0;
+        context_summaries_ = 0;
+        context_summary_version_ = 0;
+        context_generation_ = history_generation_;
+        rewritten = true;
+    } else if (context_[0].content != systemMsg.content) {
+        context_[0] = std::move(systemMsg);
+        rewritten = true;
+    }
+
+    // 启用Prompt缓存时已发送的部分都是稳定前缀，否则只有系统消息和摘要段
+    size_t stablePrefix = llm_provider_->isPromptCachingEnabled() ? context_.size() : 1 + context_summaries_;
+
+    // 后台压缩：只取用最新的已完成摘要，不在请求路径上等待摘要生成。
+    // 新摘要就绪时替换为上下文的稳定前缀，之后直到下一次替换前缀都不变
+    std::shared_ptr<const CompressionSnapshot> snapshot;
+    if (optimize && background_compressor_) {
+        snapshot = background_compressor_->current(history_);
+        uint64_t version = snapshot ? snapshot->version : 0;
+        if (version != context_summary_version_) {
+            context_.resize(1);
+            if (snapshot) {
+                for (const auto& segment : snapshot->segments) {
+                    context_.push_back(segment.summary);
+                }
+            }
+            context_source_ = snapshot ? snapshot->covered : 0;
+            context_summaries_ = context_.size() - 1;
+            context_summary_version_ = version;
+            stablePrefix = context_.size();
+            rewritten = true;
+        }
+    }
+
+    context_.insert(context_.end(), history_.begin() + context_source_, history_.end());
+    context_source_ = history_.size();
+
+    if (optimize && background_compressor_) {
+        background_compressor_->observe(history_, std::move(snapshot), context_);
+    }
+    lock.unlock();
+
+    // 摘要尚未追上历史增长且超出上限时才同步压缩（规则压缩，不调用LLM），
+    // 只改写稳定前缀之后的部分
+    if (optimize && token_optimizer_->getConfig().enable_compression &&
+        token_optimizer_->estimateTokens(context_) >
+            CONTEXT_TOKEN_BUDGET + token_optimizer_->estimateTokens(context_[0].content)) {
+        std::vector<ChatMessage> body(std::make_move_iterator(context_.begin() + 1),
+                                      std::make_move_iterator(context_.end()));
+        body = token_optimizer_->compressHistory(body, CONTEXT_TOKEN_BUDGET, stablePrefix - 1);
+        context_.resize(1);
+        context_.insert(context_.end(), std::make_move_iterator(body.begin()),
+                        std::make_move_iterator(body.end()));
+        rewritten = true;
     }
 
-    return messages;
+    if (rewritten) {
+        ++context_revision_;
+    }
+    llm_provider_->setConversationRevision(context_revision_);
+    return context_;
 }
 
 bool Agent::shouldContinue(const AgentResponse& response) const {
@@ -456,6 +450,16 @@ const std::vector<ChatMessage>& Agent::getHistory() const {
 void Agent::clearHistory() {
     std::unique_lock<std::shared_mutex> lock(history_mutex_);
     history_.clear();
+    // 上下文只由处理线程读写，下一轮构建时按新的历史重建
+    history_generation_++;
+    if (background_compressor_) {
+        background_compressor_->reset();
+    }
+
+    // 新会话不再复用旧消息的序列化缓存
+    if (llm_provider_) {
+        llm_provider_->resetConversation();
+    }
 }
 
 } // namespace roboclaw
@@ -6,10 +6,12 @@
 
 #include "../llm/llm_provider.h"
 #include "tool_executor.h"
+#include "tool_pipeline.h"
 #include "prompt_builder.h"
 #include "task_coordinator.h"
 #include "../optimization/token_optimizer.h"
 #include "../optimization/token_budget.h"
+#include "../optimization/background_compressor.h"
 #include "../utils/thread_pool.h"
 #include <string>
 #include <vector>
@@ -26,14 +28,16 @@ struct AgentConfig {
     int max_tokens;               // 最大输出token数
     double temperature;           // 温度参数
     bool stream_response;         // 是否流式响应
-    bool concurrent_tool_execution; // 是否并发执行工具
+    bool concurrent_tool_execution; // 是否并发执行互不冲突的工具调用
+    bool pipelined_tool_execution;  // 是否在响应流式到达时即派发工具调用
 
     AgentConfig()
         : max_iterations(10)
         , max_tokens(4096)
         , temperature(0.0)
         , stream_response(false)
-        , concurrent_tool_execution(false) {}  // 默认关闭以保证兼容性
+        , concurrent_tool_execution(true)   // 按资源冲突分析并行，结果顺序不变
+        , pipelined_tool_execution(false) {}
 };
 
 // Agent响应
@@ -47,12 +51,18 @@ struct AgentResponse {
     // 使用量统计
     int total_input_tokens;
     int total_output_tokens;
+    int total_cache_read_tokens;      // 命中提供商Prompt缓存的输入token
+    int total_cache_creation_tokens;  // 写入提供商Prompt缓存的输入token
+    int cached_rounds;                // 由本地响应缓存直接返回的轮数
 
     AgentResponse()
         : has_tool_calls(false)
         , success(false)
         , total_input_tokens(0)
-        , total_output_tokens(0) {}
+        , total_output_tokens(0)
+        , total_cache_read_tokens(0)
+        , total_cache_creation_tokens(0)
+        , cached_rounds(0) {}
 };
 
 // Agent类
@@ -108,16 +118,31 @@ public:
         token_budget_ = budget;
     }
 
+    // 设置后台压缩器（摘要在后台生成，请求路径只取用已完成的摘要）
+    void setBackgroundCompressor(std::shared_ptr<BackgroundCompressor> compressor) {
+        background_compressor_ = compressor;
+    }
+
     // 启用Token优化
     void enableTokenOptimization(bool enable) {
         token_optimization_enabled_ = enable;
     }
 
+    // 启用提供商侧Prompt缓存
+    void enablePromptCaching(bool enable) {
+        llm_provider_->setPromptCaching(enable);
+    }
+
     // 启用并发工具执行
     void enableConcurrentToolExecution(bool enable) {
         config_.concurrent_tool_execution = enable;
     }
 
+    // 启用流水线工具执行（工具调用参数接收完整即派发，不等待整个响应）
+    void enablePipelinedToolExecution(bool enable) {
+        config_.pipelined_tool_execution = enable;
+    }
+
     // 设置线程池
     void setThreadPool(std::shared_ptr<ThreadPool> pool) {
         thread_pool_ = pool;
@@ -134,8 +159,17 @@ public:
     }
 
 private:
-    // 执行一轮对话
-    AgentResponse performOneRound(const std::vector<ChatMessage>& messages);
+    // 执行一轮对话（pipeline非空时，工具调用在响应到达过程中即被派发）
+    AgentResponse performOneRound(ToolPipeline* pipeline = nullptr);
+
+    // 创建本轮的工具流水线
+    std::unique_ptr<ToolPipeline> createToolPipeline();
+
+    // 收集流水线结果并按原始顺序写入历史
+    bool collectToolPipeline(ToolPipeline& pipeline);
+
+    // 记录工具结果并追加工具响应消息到历史
+    void appendToolResult(const std::string& callId, const ToolResult& result);
 
     // 执行工具调用
     bool executeToolCalls(const std::vector<ChatMessage::ToolCall>& toolCalls);
@@ -143,11 +177,11 @@ private:
     // 顺序执行工具调用
     bool executeToolCallsSequential(const std::vector<ChatMessage::ToolCall>& toolCalls);
 
-    // 并发执行工具调用
+    // 并发执行工具调用（按资源冲突图调度）
     bool executeToolCallsConcurrent(const std::vector<ChatMessage::ToolCall>& toolCalls);
 
-    // 构建消息列表
-    std::vector<ChatMessage> buildMessages(const std::string& userMessage);
+    // 构建本轮发送的消息列表（返回持久上下文，到下一次构建前有效）
+    const std::vector<ChatMessage>& buildMessages(const std::vector<ToolDefinition>& tools);
 
     // 检查是否需要继续迭代
     bool shouldContinue(const AgentResponse& response) const;
@@ -161,6 +195,7 @@ private:
     // Token优化
     std::shared_ptr<TokenOptimizer> token_optimizer_;
     std::shared_ptr<TokenBudget> token_budget_;
+    std::shared_ptr<BackgroundCompressor> background_compressor_;
     bool token_optimization_enabled_;
 
     // 线程池
@@ -172,6 +207,18 @@ private:
     // 对话历史
     std::vector<ChatMessage> history_;
 
+    uint64_t history_generation_ = 0;      // 每次清空历史递增
+
+    // 发送给提供商的上下文：系统消息 + 后台摘要段 + 原始消息（只由处理线程读写，
+    // 压缩只改写稳定前缀之后的部分）
+    static constexpr int CONTEXT_TOKEN_BUDGET = 8000;
+    std::vector<ChatMessage> context_;
+    size_t context_source_ = 0;            // context_已覆盖的history_消息数
+    size_t context_summaries_ = 0;         // 系统消息之后的摘要消息数
+    uint64_t context_summary_version_ = 0; // 摘要段所属的快照版本
+    uint64_t context_generation_ = 0;      // context_对应的history_generation_
+    uint64_t context_revision_ = 0;        // 只追加时不变，改写时递增
+
     // 工具执行结果
     std::map<std::string, ToolResult> tool_results_;
 
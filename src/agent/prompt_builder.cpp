@@ -112,8 +112,20 @@ std::vector<ChatMessage> PromptBuilder::buildMessages(
         const std::vector<ToolDefinition>& tools) {
 
     std::vector<ChatMessage> messages;
+    messages.reserve(history.size() + 1);
 
     // 添加系统消息
+    messages.push_back(buildSystemMessage(tools));
+
+    // 添加历史消息
+    for (const auto& msg : history) {
+        messages.push_back(msg);
+    }
+
+    return messages;
+}
+
+ChatMessage PromptBuilder::buildSystemMessage(const std::vector<ToolDefinition>& tools) const {
     ChatMessage systemMsg(MessageRole::SYSTEM, getSystemPrompt());
 
     // 如果有工具，添加工具说明
@@ -127,14 +139,7 @@ std::vector<ChatMessage> PromptBuilder::buildMessages(
         systemMsg.content = systemContent;
     }
 
-    messages.push_back(systemMsg);
-
-    // 添加历史消息
-    for (const auto& msg : history) {
-        messages.push_back(msg);
-    }
-
-    return messages;
+    return systemMsg;
 }
 
 std::string PromptBuilder::buildPrompt(
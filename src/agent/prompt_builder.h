@@ -36,6 +36,9 @@ public:
     std::vector<ChatMessage> buildMessages(const std::vector<ChatMessage>& history,
                                            const std::vector<ToolDefinition>& tools);
 
+    // 构建系统消息（系统提示词 + 工具说明）
+    ChatMessage buildSystemMessage(const std::vector<ToolDefinition>& tools) const;
+
     // 获取系统提示词
     std::string getSystemPrompt() const;
 
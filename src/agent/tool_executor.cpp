@@ -84,57 +84,101 @@ std::vector<ToolDescription> ToolExecutor::getAllToolDescriptions() const {
 json ToolExecutor::getToolsSchema() const {
     json schema = json::array();
 
-    auto descriptions = getAllToolDescriptions();
-    for (const auto& desc : descriptions) {
+    auto cached = getToolSchema();
+    for (const auto& tool : cached->tools) {
         json toolJson;
-        toolJson["name"] = desc.name;
-        toolJson["description"] = desc.description;
+        toolJson["name"] = tool.name;
+        toolJson["description"] = tool.description;
+        toolJson["input_schema"] = tool.input_schema;
+        schema.push_back(toolJson);
+    }
+
+    return schema;
+}
+
+std::shared_ptr<const ToolSchema> ToolExecutor::getToolSchema() const {
+    std::lock_guard<std::mutex> lock(schema_mutex_);
+
+    // 版本在读取描述前获取：若期间有新注册，下次调用会看到更高版本并重建
+    uint64_t version = registry_.getVersion();
+    if (schema_cache_ && schema_cache_->version == version) {
+        return schema_cache_;
+    }
+
+    auto schema = std::make_shared<ToolSchema>();
+    schema->version = version;
+    for (const auto& desc : getAllToolDescriptions()) {
+        schema->tools.push_back(toToolDefinition(desc));
+    }
+
+    schema_cache_ = schema;
+    return schema_cache_;
+}
 
-        // 构建参数Schema
-        json parameters = json::object();
-        parameters["type"] = "object";
+ToolDefinition ToolExecutor::toToolDefinition(const ToolDescription& desc) {
+    ToolDefinition tool;
+    tool.name = desc.name;
+    tool.description = desc.description;
 
-        json props = json::object();
-        json required = json::array();
+    // 构建 JSON Schema 格式的 parameters
+    json props = json::object();
+    json required = json::array();
 
-        for (const auto& param : desc.parameters) {
-            json paramDef;
-            paramDef["description"] = param.description;
-            paramDef["type"] = param.type;
+    for (const auto& param : desc.parameters) {
+        json paramDef;
+        paramDef["type"] = param.type;
+        paramDef["description"] = param.description;
 
-            if (!param.default_value.empty()) {
-                if (param.type == "integer") {
+        // 添加默认值（如果有），无法转换时保持字符串
+        if (!param.default_value.empty()) {
+            if (param.type == "integer") {
+                try {
                     paramDef["default"] = std::stoi(param.default_value);
-                } else if (param.type == "boolean") {
-                    paramDef["default"] = (param.default_value == "true");
-                } else {
+                } catch (...) {
                     paramDef["default"] = param.default_value;
                 }
+            } else if (param.type == "boolean") {
+                paramDef["default"] = (param.default_value == "true");
+            } else {
+                paramDef["default"] = param.default_value;
             }
+        }
 
-            props[param.name] = paramDef;
-
-            if (param.required) {
-                required.push_back(param.name);
-            }
+        if (!param.items.is_null()) {
+            paramDef["items"] = param.items;
         }
 
-        parameters["properties"] = props;
-        if (!required.empty()) {
-            parameters["required"] = required;
+        props[param.name] = paramDef;
+
+        if (param.required) {
+            required.push_back(param.name);
         }
+    }
 
-        toolJson["input_schema"] = parameters;
-        schema.push_back(toolJson);
+    json parameters = json::object();
+    parameters["type"] = "object";
+    parameters["properties"] = props;
+    if (!required.empty()) {
+        parameters["required"] = required;
     }
 
-    return schema;
+    tool.input_schema = parameters;
+    return tool;
 }
 
 bool ToolExecutor::hasTool(const std::string& name) const {
     return registry_.hasTool(name);
 }
 
+ToolAccess ToolExecutor::describeAccess(const std::string& toolName, const json& parameters) {
+    auto tool = registry_.getTool(toolName);
+    if (!tool) {
+        // 工具可能在分析与执行之间被注册（插件热加载），保守串行
+        return ToolAccess::unknown();
+    }
+    return tool->describeAccess(parameters);
+}
+
 std::shared_ptr<ToolBase> ToolExecutor::getTool(const std::string& name) {
     return registry_.getTool(name);
 }
@@ -6,8 +6,10 @@
 
 #include "../tools/tool_base.h"
 #include "../storage/config_manager.h"
+#include "../llm/llm_provider.h"
 #include <memory>
 #include <map>
+#include <mutex>
 
 namespace roboclaw {
 
@@ -62,15 +64,28 @@ public:
     // 获取工具Schema（用于发送给LLM）
     json getToolsSchema() const;
 
+    // 获取缓存的工具定义快照（注册表版本变化时重建，否则返回同一快照）
+    std::shared_ptr<const ToolSchema> getToolSchema() const;
+
+    // 将工具描述转换为工具定义（JSON Schema格式的参数）
+    static ToolDefinition toToolDefinition(const ToolDescription& desc);
+
     // 检查工具是否存在
     bool hasTool(const std::string& name) const;
 
+    // 描述工具调用的资源访问（用于并发冲突分析，未知工具视为无副作用）
+    ToolAccess describeAccess(const std::string& toolName, const json& parameters);
+
     // 获取工具
     std::shared_ptr<ToolBase> getTool(const std::string& name);
 
 private:
     ToolRegistry& registry_;
 
+    // 工具Schema缓存（按注册表版本失效）
+    mutable std::mutex schema_mutex_;
+    mutable std::shared_ptr<const ToolSchema> schema_cache_;
+
     // 从配置加载工具设置
     void loadToolSettings(const ConfigManager& config_mgr);
 };
@@ -0,0 +1,122 @@
+// ToolPipeline实现
+
+#include "tool_pipeline.h"
+#include "../utils/logger.h"
+
+namespace roboclaw {
+
+ToolPipeline::ToolPipeline(std::shared_ptr<ThreadPool> pool,
+                           Executor executor,
+                           AccessResolver resolveAccess)
+    : pool_(std::move(pool))
+    , executor_(std::move(executor))
+    , resolve_access_(std::move(resolveAccess)) {
+}
+
+ToolPipeline::~ToolPipeline() {
+    // 线程池中的任务引用本对象，必须等待全部完成
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return stats_.completed == nodes_.size(); });
+}
+
+void ToolPipeline::dispatch(const ChatMessage::ToolCall& call) {
+    // 未声明访问方式时保守处理：与所有调用冲突
+    ToolAccess access = resolve_access_ ? resolve_access_(call) : ToolAccess::unknown();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    size_t index = nodes_.size();
+    nodes_.emplace_back();
+    nodes_[index].call = call;
+    nodes_[index].access = std::move(access);
+    ++stats_.dispatched;
+
+    // 冲突图：依赖之前所有未完成且与本调用冲突的调用
+    for (size_t i = 0; i < index; ++i) {
+        if (!nodes_[i].done && nodes_[i].access.conflictsWith(nodes_[index].access)) {
+            nodes_[i].dependents.push_back(index);
+            ++nodes_[index].pending_deps;
+        }
+    }
+
+    if (nodes_[index].pending_deps == 0) {
+        submitLocked(index);
+    } else {
+        ++stats_.deferred;
+    }
+
+    // 没有线程池时同步执行
+    if (!pool_) {
+        lock.unlock();
+        run(index);
+    }
+}
+
+void ToolPipeline::submitLocked(size_t index) {
+    if (!pool_) {
+        return;
+    }
+    try {
+        pool_->submit([this, index] { run(index); });
+    } catch (const std::exception& e) {
+        // 队列已满等情况：记录失败，保证finish()不会永久等待
+        LOG_ERROR("工具流水线提交失败: " + std::string(e.what()));
+        completeLocked(index, ToolResult::error(std::string("工具提交失败: ") + e.what()));
+    }
+}
+
+void ToolPipeline::run(size_t index) {
+    ChatMessage::ToolCall call;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (nodes_[index].done) {
+            return;
+        }
+        call = nodes_[index].call;
+    }
+
+    ToolResult result;
+    try {
+        result = executor_(call);
+    } catch (const std::exception& e) {
+        LOG_ERROR("流水线工具执行异常: " + std::string(e.what()));
+        result = ToolResult::error(std::string("工具执行异常: ") + e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    completeLocked(index, std::move(result));
+}
+
+void ToolPipeline::completeLocked(size_t index, ToolResult result) {
+    nodes_[index].result = std::move(result);
+    nodes_[index].done = true;
+    ++stats_.completed;
+
+    // 依赖全部完成的调用随即提交（无线程池时同步执行，不会产生未满足的依赖）。
+    // 提交失败时submitLocked会递归完成该节点，因此失败也会沿依赖链传递
+    for (size_t dependent : nodes_[index].dependents) {
+        if (--nodes_[dependent].pending_deps == 0) {
+            submitLocked(dependent);
+        }
+    }
+    done_cv_.notify_all();
+}
+
+std::vector<std::pair<ChatMessage::ToolCall, ToolResult>> ToolPipeline::finish() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return stats_.completed == nodes_.size(); });
+
+    std::vector<std::pair<ChatMessage::ToolCall, ToolResult>> results;
+    results.reserve(nodes_.size());
+    for (auto& node : nodes_) {
+        results.emplace_back(node.call, node.result);
+    }
+    return results;
+}
+
+ToolPipeline::Stats ToolPipeline::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace roboclaw
@@ -0,0 +1,91 @@
+// 工具流水线 - ToolPipeline
+// 在LLM响应仍在流式到达时逐个派发工具调用
+
+#ifndef ROBOCLAW_AGENT_TOOL_PIPELINE_H
+#define ROBOCLAW_AGENT_TOOL_PIPELINE_H
+
+#include "../llm/llm_provider.h"
+#include "../tools/tool_base.h"
+#include "../utils/thread_pool.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace roboclaw {
+
+// 工具流水线（每轮对话一个实例）
+//
+// 每个工具调用的参数接收完整后立即调用dispatch()提交到线程池，不必等待整个
+// 响应结束。派发时根据各调用声明的资源访问（ToolAccess）构建冲突图：与之前
+// 未完成的调用冲突（读写同一路径、独占同一设备、副作用未知）时等待其完成，
+// 否则立即并行执行，因此结果与顺序执行等价。
+// finish()等待全部完成，并按派发顺序返回结果。
+class ToolPipeline {
+public:
+    // 执行单个工具调用
+    using Executor = std::function<ToolResult(const ChatMessage::ToolCall&)>;
+
+    // 获取工具调用的资源访问声明
+    using AccessResolver = std::function<ToolAccess(const ChatMessage::ToolCall&)>;
+
+    // 流水线统计
+    struct Stats {
+        size_t dispatched = 0;       // 已派发的调用数
+        size_t completed = 0;        // 已完成的调用数
+        size_t deferred = 0;         // 因冲突而延后启动的调用数
+    };
+
+    ToolPipeline(std::shared_ptr<ThreadPool> pool,
+                 Executor executor,
+                 AccessResolver resolveAccess);
+
+    ~ToolPipeline();
+
+    ToolPipeline(const ToolPipeline&) = delete;
+    ToolPipeline& operator=(const ToolPipeline&) = delete;
+
+    // 派发工具调用（依赖满足时立即提交，否则在依赖完成后自动提交）
+    void dispatch(const ChatMessage::ToolCall& call);
+
+    // 等待全部调用完成，按派发顺序返回结果
+    std::vector<std::pair<ChatMessage::ToolCall, ToolResult>> finish();
+
+    // 获取统计
+    Stats getStats() const;
+
+private:
+    struct Node {
+        ChatMessage::ToolCall call;
+        ToolResult result;
+        ToolAccess access;
+        bool done = false;
+        size_t pending_deps = 0;
+        std::vector<size_t> dependents;
+    };
+
+    // 提交节点到线程池（调用方持有mutex_）
+    void submitLocked(size_t index);
+
+    // 在工作线程中执行节点
+    void run(size_t index);
+
+    // 记录节点结果并释放依赖它的调用（调用方持有mutex_）
+    void completeLocked(size_t index, ToolResult result);
+
+    std::shared_ptr<ThreadPool> pool_;
+    Executor executor_;
+    AccessResolver resolve_access_;
+
+    std::vector<Node> nodes_;
+    Stats stats_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable done_cv_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_AGENT_TOOL_PIPELINE_H
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
 
 #ifdef PLATFORM_WINDOWS
 #include <windows.h>
@@ -69,9 +70,28 @@ bool InteractiveMode::processMessage(const std::string& message) {
 
     std::cout << "\n";
 
+    // 记录到会话树：每轮一个节点（用户消息 + AI回复）
+    auto session = session_manager_->getCurrentSession();
+    std::shared_ptr<ConversationNode> node;
+    if (session) {
+        node = session->addNode(session->getCurrentNodeId(), message);
+        if (node) {
+            session->switchToNode(node->getId());
+        }
+    }
+
     // 发送给Agent处理
     AgentResponse response = agent_->process(message);
 
+    if (node) {
+        ConversationNode::AssistantMessage reply;
+        reply.content = response.success ? response.content : response.error;
+        for (const auto& call : response.tool_calls) {
+            reply.tool_calls.push_back(json{{"name", call.name}, {"arguments", call.arguments}}.dump());
+        }
+        session->setAssistantMessage(node->getId(), reply);
+    }
+
     // 显示响应
     displayResponse(response);
 
@@ -120,6 +140,13 @@ void InteractiveMode::displayResponse(const AgentResponse& response) {
         std::ostringstream oss;
         oss << "Tokens: " << response.total_input_tokens
             << " input, " << response.total_output_tokens << " output";
+        if (response.total_cache_read_tokens > 0 || response.total_cache_creation_tokens > 0) {
+            oss << " (cache: " << response.total_cache_read_tokens << " read, "
+                << response.total_cache_creation_tokens << " written)";
+        }
+        if (response.cached_rounds > 0) {
+            oss << " (response cache: " << response.cached_rounds << " hit)";
+        }
         UI::drawInfo(oss.str());
     }
 }
@@ -170,6 +197,7 @@ bool InteractiveMode::handleSlashCommand(const std::string& command) {
     if (cmd == "browser") return cmdBrowser(args);
     if (cmd == "link") return cmdLink(args);
     if (cmd == "skills") return cmdSkills(args);
+    if (cmd == "search") return cmdSearch(args);
 
     std::cout << Color::RED << "Unknown command: " << cmd << Color::RESET << std::endl;
     std::cout << "Type /help for available commands" << std::endl;
@@ -447,6 +475,36 @@ bool InteractiveMode::cmdSkills(const std::string& args) {
     return true;
 }
 
+bool InteractiveMode::cmdSearch(const std::string& args) {
+    using namespace Color;
+
+    if (args.empty()) {
+        std::cout << YELLOW << "Usage / 用法: " << RESET << GREEN << "/search <query>" << RESET
+                  << "   Search past conversations / 搜索历史对话\n";
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto hits = session_manager_->searchSessions(args, 10);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (hits.empty()) {
+        std::cout << GRAY << "No matches / 没有找到匹配的对话" << RESET << "\n";
+        return true;
+    }
+
+    std::cout << CYAN << "Search results / 搜索结果" << RESET << GRAY << " (" << hits.size()
+              << ", " << elapsed << " ms)" << RESET << "\n\n";
+    for (const auto& hit : hits) {
+        auto metadata = session_manager_->getSessionMetadata(hit.session_id);
+        std::cout << "  " << GREEN << (metadata.title.empty() ? hit.session_id : metadata.title) << RESET
+                  << GRAY << "  " << hit.session_id << RESET << "\n";
+        std::cout << "    " << hit.snippet << "\n\n";
+    }
+    return true;
+}
+
 bool InteractiveMode::handleCommand(const std::string& input) {
     std::istringstream iss(input);
     std::string command;
@@ -599,6 +657,7 @@ Slash Commands / 斜杠命令:
   /skills     List and manage skills / 技能列表和管理
   /clear      Clear conversation / 清空对话
   /link       Connect social platforms / 连接社交平台
+  /search     Search past conversations / 搜索历史对话
   Ctrl+D      Exit / 退出
 )";
 
@@ -97,6 +97,7 @@ private:
     bool cmdBrowser(const std::string& args);
     bool cmdLink(const std::string& args);
     bool cmdSkills(const std::string& args);
+    bool cmdSearch(const std::string& args);
 
     // 保存当前会话
     void saveCurrentSession();
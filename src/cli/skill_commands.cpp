@@ -2,6 +2,7 @@
 
 #include "skill_commands.h"
 #include "../utils/logger.h"
+#include "../skills/skill_downloader.h"
 #include "../skills/skill_parser.h"
 #include <iostream>
 #include <filesystem>
@@ -147,7 +148,13 @@ void SkillCommands::displaySkillInfo(const Skill& skill) {
 int SkillCommands::installSkill(const std::string& source, const std::string& url) {
     std::string destPath;
 
-    if (url.empty()) {
+    // source本身是URL时同样从远程安装
+    std::string remote = url;
+    if (remote.empty() && (source.rfind("http://", 0) == 0 || source.rfind("https://", 0) == 0)) {
+        remote = source;
+    }
+
+    if (remote.empty()) {
         // 从本地文件安装
         std::filesystem::path sourcePath(source);
 
@@ -171,9 +178,29 @@ int SkillCommands::installSkill(const std::string& source, const std::string& ur
         }
 
     } else {
-        // TODO: 从URL下载（需要SkillDownloader）
-        std::cerr << "错误: 从远程下载功能尚未实现" << std::endl;
-        return 1;
+        // 从URL下载：经由技能缓存目录，按配置决定缓存有效期和是否每次重新验证
+        const Config& config = config_.getConfig();
+        SkillDownloader downloader(config.cache.skills_cache_dir);
+        downloader.setAutoUpdate(config.skills.auto_update);
+        downloader.setCacheTtlHours(config.cache.skill_cache_ttl);
+
+        // 文件名取自source（同时给出URL时）或URL的最后一段
+        std::string fileName = remote == source
+            ? std::filesystem::path(remote.substr(0, remote.find_first_of("?#"))).filename().string()
+            : std::filesystem::path(source).filename().string();
+        if (fileName.empty()) {
+            std::cerr << "错误: 无法从URL确定技能文件名: " << remote << std::endl;
+            return 1;
+        }
+
+        std::string userDir = getUserSkillsDir();
+        std::filesystem::create_directories(userDir);
+        destPath = userDir + "/" + fileName;
+
+        if (!downloader.downloadSkill(remote, destPath)) {
+            std::cerr << "错误: 下载技能失败: " << remote << std::endl;
+            return 1;
+        }
     }
 
     // 解析并注册技能
@@ -0,0 +1,502 @@
+// src/embedded/flash_scheduler.cpp
+#include "flash_scheduler.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace roboclaw::embedded {
+
+namespace {
+
+std::array<uint32_t, 256> makeCrc32Table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+std::string hex32(uint32_t value) {
+    std::stringstream ss;
+    ss << "0x" << std::hex << value;
+    return ss.str();
+}
+
+// Size and mtime (ns since epoch) of a file
+bool fileStamp(const std::string& path, uintmax_t& size, int64_t& mtime) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        fs::last_write_time(path, ec).time_since_epoch()).count();
+    return !ec;
+}
+
+// Private copy of an image for platforms that can only flash from a file,
+// so the bytes programmed are the ones that were checksummed. The file keeps
+// the original name because tools pick the format from the extension.
+class ImageSnapshot {
+public:
+    explicit ImageSnapshot(const FirmwareImage& image) {
+        namespace fs = std::filesystem;
+        static std::atomic<uint64_t> sequence{0};
+        std::error_code ec;
+        dir_ = fs::temp_directory_path(ec) /
+               ("roboclaw_flash_" + std::to_string(std::random_device{}()) + "_" +
+                std::to_string(sequence.fetch_add(1)));
+        if (ec || !fs::create_directories(dir_, ec)) {
+            dir_.clear();
+            return;
+        }
+        fs::path path = dir_ / fs::path(image.path).filename();
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(image.data.data()),
+                   static_cast<std::streamsize>(image.data.size()));
+        file.close();
+        if (file) {
+            path_ = path.string();
+        }
+    }
+
+    ~ImageSnapshot() {
+        if (!dir_.empty()) {
+            std::error_code ec;
+            std::filesystem::remove_all(dir_, ec);
+        }
+    }
+
+    ImageSnapshot(const ImageSnapshot&) = delete;
+    ImageSnapshot& operator=(const ImageSnapshot&) = delete;
+
+    // Empty if the copy could not be written
+    const std::string& path() const { return path_; }
+
+private:
+    std::filesystem::path dir_;
+    std::string path_;
+};
+
+} // namespace
+
+//=============================================================================
+// FirmwareImage
+//=============================================================================
+
+uint32_t FirmwareImage::computeCrc32(const uint8_t* data, size_t length) {
+    static const std::array<uint32_t, 256> table = makeCrc32Table();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+//=============================================================================
+// FirmwareImageCache
+//=============================================================================
+
+std::shared_ptr<const FirmwareImage> FirmwareImageCache::get(const std::string& path) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    std::string key = ec ? path : canonical.string();
+
+    uintmax_t size = 0;
+    int64_t mtime = 0;
+    if (!fileStamp(key, size, mtime)) {
+        return nullptr;
+    }
+
+    // Held across the read so concurrent requests for one file load it once
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = images_.find(key);
+    if (it != images_.end() && it->second->mtime == mtime && it->second->size() == size) {
+        return it->second;
+    }
+
+    std::ifstream file(key, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+
+    auto image = std::make_shared<FirmwareImage>();
+    image->path = key;
+    image->mtime = mtime;
+    image->data.resize(size);
+    if (size > 0 && !file.read(reinterpret_cast<char*>(image->data.data()),
+                               static_cast<std::streamsize>(size))) {
+        return nullptr;
+    }
+    image->crc32 = FirmwareImage::computeCrc32(image->data.data(), image->data.size());
+
+    loads_.fetch_add(1);
+    images_[key] = image;
+    return image;
+}
+
+size_t FirmwareImageCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return images_.size();
+}
+
+void FirmwareImageCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    images_.clear();
+}
+
+//=============================================================================
+// IFlashBackend
+//=============================================================================
+
+std::optional<uint32_t> IFlashBackend::readChecksum(const roboclaw::plugins::ProgrammerInfo&,
+                                                    size_t) {
+    return std::nullopt;
+}
+
+bool IFlashBackend::verify(const roboclaw::plugins::ProgrammerInfo& programmer,
+                           const FirmwareImage& image,
+                           std::string& detail) {
+    auto device_crc = readChecksum(programmer, image.size());
+    if (!device_crc) {
+        detail = "Programmer cannot read back flash contents";
+        return false;
+    }
+    if (*device_crc != image.crc32) {
+        detail = "Checksum mismatch: device " + hex32(*device_crc) + ", image " + hex32(image.crc32);
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// PlatformFlashBackend
+//=============================================================================
+
+PlatformFlashBackend::PlatformFlashBackend(std::shared_ptr<roboclaw::plugins::IEmbeddedPlatform> platform)
+    : platform_(std::move(platform)) {
+}
+
+bool PlatformFlashBackend::program(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                   const FirmwareImage& image,
+                                   const FlashOptions&,
+                                   const PhaseCallback& progress) {
+    if (!platform_) {
+        return false;
+    }
+    if (progress) {
+        progress("write", 0.0);
+    }
+    // Program the checksummed bytes; the file may have been rebuilt since
+    // the image was loaded
+    bool ok = false;
+    if (auto result = platform_->flashFirmwareData(image.path, image.data, programmer.id)) {
+        ok = *result;
+    } else {
+        ImageSnapshot snapshot(image);
+        if (snapshot.path().empty()) {
+            return false;
+        }
+        ok = platform_->flashFirmware(snapshot.path(), programmer.id);
+    }
+    if (ok && progress) {
+        progress("write", 1.0);
+    }
+    return ok;
+}
+
+std::optional<uint32_t> PlatformFlashBackend::readChecksum(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                                           size_t length) {
+    if (!platform_) {
+        return std::nullopt;
+    }
+    return platform_->readFlashChecksum(programmer.id, length);
+}
+
+bool PlatformFlashBackend::verify(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                  const FirmwareImage& image,
+                                  std::string& detail) {
+    if (!platform_) {
+        detail = "No platform configured";
+        return false;
+    }
+    // Prefer comparing this board against the image CRC; the file on disk
+    // may have been rebuilt since the image was read
+    if (auto device_crc = platform_->readFlashChecksum(programmer.id, image.size())) {
+        if (*device_crc != image.crc32) {
+            detail = "Checksum mismatch: device " + hex32(*device_crc) + ", image " + hex32(image.crc32);
+            return false;
+        }
+        return true;
+    }
+    uintmax_t size = 0;
+    int64_t mtime = 0;
+    if (!fileStamp(image.path, size, mtime) || size != image.size() || mtime != image.mtime) {
+        detail = "Firmware file changed since it was loaded; cannot verify " + programmer.id + " against it";
+        return false;
+    }
+    auto verified = platform_->verifyFlashedFirmware(image.path, programmer.id);
+    if (!verified) {
+        detail = "Platform cannot read back or verify individual boards (" + programmer.id + ")";
+        return false;
+    }
+    if (!*verified) {
+        detail = "Platform verification failed on " + programmer.id;
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// SimulatedFlashBackend
+//=============================================================================
+
+SimulatedFlashBackend::SimulatedFlashBackend(size_t page_size, std::chrono::microseconds page_delay)
+    : page_size_(std::max<size_t>(page_size, 1))
+    , page_delay_(page_delay) {
+}
+
+bool SimulatedFlashBackend::program(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                    const FirmwareImage& image,
+                                    const FlashOptions&,
+                                    const PhaseCallback& progress) {
+    int active = active_.fetch_add(1) + 1;
+    int peak = peak_active_.load();
+    while (active > peak && !peak_active_.compare_exchange_weak(peak, active)) {
+    }
+
+    bool fail;
+    bool corrupt;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fail = failures_[programmer.id];
+        corrupt = corruptions_[programmer.id];
+    }
+
+    if (progress) {
+        progress("erase", 0.0);
+    }
+    std::vector<uint8_t> flash(image.size(), 0xFF);
+    if (progress) {
+        progress("erase", 1.0);
+    }
+
+    bool ok = !fail;
+    const size_t pages = (image.size() + page_size_ - 1) / page_size_;
+    for (size_t page = 0; ok && page < pages; ++page) {
+        size_t begin = page * page_size_;
+        size_t end = std::min(begin + page_size_, image.size());
+        std::copy(image.data.begin() + begin, image.data.begin() + end, flash.begin() + begin);
+        if (page_delay_.count() > 0) {
+            std::this_thread::sleep_for(page_delay_);
+        }
+        if (progress) {
+            progress("write", static_cast<double>(page + 1) / pages);
+        }
+    }
+
+    if (ok) {
+        if (corrupt && !flash.empty()) {
+            flash[flash.size() / 2] ^= 0x01;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        memory_[programmer.id] = std::move(flash);
+    }
+
+    active_.fetch_sub(1);
+    return ok;
+}
+
+std::optional<uint32_t> SimulatedFlashBackend::readChecksum(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                                            size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = memory_.find(programmer.id);
+    if (it == memory_.end() || it->second.size() < length) {
+        return std::nullopt;
+    }
+    return FirmwareImage::computeCrc32(it->second.data(), length);
+}
+
+void SimulatedFlashBackend::setFailure(const std::string& programmer_id, bool fail) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failures_[programmer_id] = fail;
+}
+
+void SimulatedFlashBackend::setCorruption(const std::string& programmer_id, bool corrupt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    corruptions_[programmer_id] = corrupt;
+}
+
+std::vector<uint8_t> SimulatedFlashBackend::getMemory(const std::string& programmer_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = memory_.find(programmer_id);
+    return it != memory_.end() ? it->second : std::vector<uint8_t>{};
+}
+
+//=============================================================================
+// FlashScheduler
+//=============================================================================
+
+FlashScheduler::FlashScheduler(std::shared_ptr<IFlashBackend> backend,
+                               const FlashSchedulerConfig& config)
+    : backend_(std::move(backend))
+    , config_(config) {
+}
+
+FlashBatchReport FlashScheduler::run(const std::vector<FlashJob>& jobs,
+                                     const FlashOptions& options,
+                                     FlashProgressCallback progress) {
+    FlashBatchReport report;
+    report.results.resize(jobs.size());
+    if (jobs.empty()) {
+        return report;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t loads_before = images_.loadCount();
+
+    // Load every distinct image up front; workers only ever see shared memory
+    std::vector<std::shared_ptr<const FirmwareImage>> images(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        images[i] = images_.get(jobs[i].firmware_path);
+    }
+    report.images_loaded = images_.loadCount() - loads_before;
+
+    std::mutex progress_mutex;
+    auto emit = [&](const FlashProgress& event) {
+        if (progress) {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            progress(event);
+        }
+    };
+
+    size_t workers = jobs.size();
+    if (config_.max_parallel > 0) {
+        workers = std::min(workers, static_cast<size_t>(config_.max_parallel));
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1)) {
+            report.results[i] = flashOne(jobs[i], images[i], options, emit);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& result : report.results) {
+        if (result.success) {
+            ++report.succeeded;
+        } else {
+            ++report.failed;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    report.time_elapsed = std::chrono::duration<double>(end - start).count();
+    return report;
+}
+
+FlashBatchReport FlashScheduler::flashAll(const std::vector<roboclaw::plugins::ProgrammerInfo>& programmers,
+                                          const std::string& firmware_path,
+                                          const FlashOptions& options,
+                                          FlashProgressCallback progress) {
+    std::vector<FlashJob> jobs;
+    for (const auto& programmer : programmers) {
+        if (programmer.is_connected) {
+            jobs.push_back({programmer, firmware_path});
+        }
+    }
+    return run(jobs, options, std::move(progress));
+}
+
+DetailedFlashResult FlashScheduler::flashOne(const FlashJob& job,
+                                             const std::shared_ptr<const FirmwareImage>& image,
+                                             const FlashOptions& options,
+                                             const std::function<void(const FlashProgress&)>& emit) {
+    DetailedFlashResult result;
+    result.success = false;
+    result.programmer_id = job.programmer.id;
+    result.programmer_name = job.programmer.name;
+    result.firmware_path = job.firmware_path;
+    result.bytes_written = 0;
+    result.time_elapsed = 0.0;
+    result.verification_passed = false;
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto fail = [&](const std::string& message) {
+        result.time_elapsed = elapsed();
+        result.messages.push_back("Error: " + message);
+        emit({job.programmer.id, "failed", 1.0, message});
+    };
+
+    if (!backend_) {
+        fail("No flash backend configured");
+        return result;
+    }
+    if (!image) {
+        fail("Cannot read firmware file: " + job.firmware_path);
+        return result;
+    }
+
+    try {
+        auto on_phase = [&](const std::string& phase, double fraction) {
+            emit({job.programmer.id, phase, fraction, ""});
+        };
+        if (!backend_->program(job.programmer, *image, options, on_phase)) {
+            fail("Programming failed");
+            return result;
+        }
+        result.bytes_written = static_cast<int>(image->size());
+        result.messages.push_back("Firmware written successfully");
+
+        if (options.verify) {
+            emit({job.programmer.id, "verify", 0.0, ""});
+            std::string detail;
+            if (!backend_->verify(job.programmer, *image, detail)) {
+                fail("Verification failed: " + detail);
+                return result;
+            }
+            result.verification_passed = true;
+            result.messages.push_back("Verification passed (CRC32 " + hex32(image->crc32) + ")");
+            emit({job.programmer.id, "verify", 1.0, ""});
+        }
+
+        result.success = true;
+    } catch (const std::exception& e) {
+        fail(e.what());
+        return result;
+    }
+
+    result.time_elapsed = elapsed();
+    emit({job.programmer.id, "done", 1.0, "Firmware flashed successfully"});
+    return result;
+}
+
+} // namespace roboclaw::embedded
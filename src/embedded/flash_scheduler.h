@@ -0,0 +1,284 @@
+// src/embedded/flash_scheduler.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "plugins/interfaces/iembedded_platform.h"
+#include "programmer_detector.h"
+
+namespace roboclaw::embedded {
+
+/**
+ * @brief Firmware file loaded into memory and checksummed once
+ */
+struct FirmwareImage {
+    std::string path;              // Canonical path of the source file
+    std::vector<uint8_t> data;     // File contents
+    uint32_t crc32 = 0;            // CRC-32 (IEEE) of data
+    int64_t mtime = 0;             // Modification time (ns since epoch) when loaded
+
+    size_t size() const { return data.size(); }
+
+    /**
+     * @brief CRC-32 (IEEE 802.3), as computed by ST-Link/OpenOCD verify
+     */
+    static uint32_t computeCrc32(const uint8_t* data, size_t length);
+};
+
+/**
+ * @brief Shared cache of firmware images keyed by canonical path
+ *
+ * Every board flashed with the same file shares one immutable image, so a
+ * batch reads and hashes each firmware once no matter how many targets it
+ * goes to. An entry is reloaded when the file's mtime or size changes.
+ * Thread-safe.
+ */
+class FirmwareImageCache {
+public:
+    /**
+     * @brief Get the image for a file, loading it on first use
+     * @param path Firmware file path
+     * @return Shared image, or nullptr if the file cannot be read
+     */
+    std::shared_ptr<const FirmwareImage> get(const std::string& path);
+
+    /**
+     * @brief Number of times a file was actually read from disk
+     */
+    size_t loadCount() const { return loads_.load(); }
+
+    size_t size() const;
+    void clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<const FirmwareImage>> images_;
+    std::atomic<size_t> loads_{0};
+};
+
+/**
+ * @brief Progress event for one target of a flash batch
+ */
+struct FlashProgress {
+    std::string programmer_id;
+    std::string phase;             // "erase", "write", "verify", "done" or "failed"
+    double fraction = 0.0;         // Phase completion, 0..1
+    std::string message;
+};
+
+using FlashProgressCallback = std::function<void(const FlashProgress&)>;
+
+/**
+ * @brief Device access used by FlashScheduler
+ *
+ * One backend serves all targets of a batch and is called concurrently
+ * with different programmers; implementations must be thread-safe across
+ * programmers. Calls for the same programmer are never concurrent.
+ */
+class IFlashBackend {
+public:
+    using PhaseCallback = std::function<void(const std::string& phase, double fraction)>;
+
+    virtual ~IFlashBackend() = default;
+
+    /**
+     * @brief Erase and program an image through a programmer
+     * @param programmer Target programmer
+     * @param image Image to write
+     * @param options Flash options
+     * @param progress Reports phase progress; may be called from this thread only
+     * @return true if the image was written
+     */
+    virtual bool program(const roboclaw::plugins::ProgrammerInfo& programmer,
+                         const FirmwareImage& image,
+                         const FlashOptions& options,
+                         const PhaseCallback& progress) = 0;
+
+    /**
+     * @brief Read back the CRC-32 of the first length bytes of flash
+     * @return Device checksum, or nullopt if the backend cannot read back
+     */
+    virtual std::optional<uint32_t> readChecksum(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                                 size_t length);
+
+    /**
+     * @brief Verify a programmed image
+     *
+     * The default compares readChecksum() with the image CRC. Backends that
+     * cannot read back override this with their own verification.
+     * @param detail Set to a human-readable reason on failure
+     */
+    virtual bool verify(const roboclaw::plugins::ProgrammerInfo& programmer,
+                        const FirmwareImage& image,
+                        std::string& detail);
+};
+
+/**
+ * @brief Backend that drives an IEmbeddedPlatform plugin
+ *
+ * Programming hands the plugin the in-memory image. Plugins that only
+ * take a path get a private copy of it, so a file rebuilt mid-batch never
+ * reaches a board. Verification compares each board's read-back CRC with
+ * the shared image when the plugin supports it, and otherwise asks the
+ * plugin to verify that programmer. It fails when neither is supported.
+ * The plugin is called concurrently for different programmers.
+ */
+class PlatformFlashBackend : public IFlashBackend {
+public:
+    explicit PlatformFlashBackend(std::shared_ptr<roboclaw::plugins::IEmbeddedPlatform> platform);
+
+    bool program(const roboclaw::plugins::ProgrammerInfo& programmer,
+                 const FirmwareImage& image,
+                 const FlashOptions& options,
+                 const PhaseCallback& progress) override;
+    std::optional<uint32_t> readChecksum(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                         size_t length) override;
+    bool verify(const roboclaw::plugins::ProgrammerInfo& programmer,
+                const FirmwareImage& image,
+                std::string& detail) override;
+
+private:
+    std::shared_ptr<roboclaw::plugins::IEmbeddedPlatform> platform_;
+};
+
+/**
+ * @brief In-memory flash targets for dry runs and tests
+ *
+ * Each programmer owns a simulated flash array. Writes proceed in pages
+ * with an optional per-page delay so concurrency is observable, and a
+ * target can be set to fail or to corrupt its contents.
+ */
+class SimulatedFlashBackend : public IFlashBackend {
+public:
+    explicit SimulatedFlashBackend(size_t page_size = 4096,
+                                   std::chrono::microseconds page_delay = std::chrono::microseconds(0));
+
+    bool program(const roboclaw::plugins::ProgrammerInfo& programmer,
+                 const FirmwareImage& image,
+                 const FlashOptions& options,
+                 const PhaseCallback& progress) override;
+    std::optional<uint32_t> readChecksum(const roboclaw::plugins::ProgrammerInfo& programmer,
+                                         size_t length) override;
+
+    /**
+     * @brief Make program() fail for a programmer
+     */
+    void setFailure(const std::string& programmer_id, bool fail);
+
+    /**
+     * @brief Flip a byte after programming so verification fails
+     */
+    void setCorruption(const std::string& programmer_id, bool corrupt);
+
+    /**
+     * @brief Contents of a target's flash
+     */
+    std::vector<uint8_t> getMemory(const std::string& programmer_id) const;
+
+    /**
+     * @brief Highest number of programmers written at the same time
+     */
+    int getPeakConcurrency() const { return peak_active_.load(); }
+
+private:
+    size_t page_size_;
+    std::chrono::microseconds page_delay_;
+    mutable std::mutex mutex_;
+    std::map<std::string, std::vector<uint8_t>> memory_;
+    std::map<std::string, bool> failures_;
+    std::map<std::string, bool> corruptions_;
+    std::atomic<int> active_{0};
+    std::atomic<int> peak_active_{0};
+};
+
+/**
+ * @brief One board to flash
+ */
+struct FlashJob {
+    roboclaw::plugins::ProgrammerInfo programmer;
+    std::string firmware_path;
+};
+
+/**
+ * @brief Outcome of a flash batch
+ */
+struct FlashBatchReport {
+    std::vector<DetailedFlashResult> results;  // Same order as the jobs
+    size_t succeeded = 0;
+    size_t failed = 0;
+    size_t images_loaded = 0;      // Distinct firmware files read for this batch
+    double time_elapsed = 0.0;     // Wall time of the whole batch (s)
+
+    bool allSucceeded() const { return failed == 0 && !results.empty(); }
+};
+
+/**
+ * @brief Scheduler configuration
+ */
+struct FlashSchedulerConfig {
+    int max_parallel = 0;          // Concurrent targets; 0 = one worker per job
+};
+
+/**
+ * @brief Flashes many boards concurrently
+ *
+ * Firmware files are loaded through a shared FirmwareImageCache before any
+ * worker starts, then each job runs on its own worker: program, then
+ * verify the device checksum against the image CRC. A failing board never
+ * stops the others. Progress events from all workers are serialized, so
+ * the callback does not need to be thread-safe.
+ */
+class FlashScheduler {
+public:
+    FlashScheduler(std::shared_ptr<IFlashBackend> backend,
+                   const FlashSchedulerConfig& config = FlashSchedulerConfig());
+
+    // Disable copy
+    FlashScheduler(const FlashScheduler&) = delete;
+    FlashScheduler& operator=(const FlashScheduler&) = delete;
+
+    /**
+     * @brief Flash all jobs; blocks until every target finished
+     * @param jobs Targets and their firmware files
+     * @param options Flash options (options.verify enables checksum verification)
+     * @param progress Optional per-device progress callback
+     * @return Batch report with one result per job
+     */
+    FlashBatchReport run(const std::vector<FlashJob>& jobs,
+                         const FlashOptions& options = FlashOptions{},
+                         FlashProgressCallback progress = nullptr);
+
+    /**
+     * @brief Flash the same firmware to every connected programmer
+     */
+    FlashBatchReport flashAll(const std::vector<roboclaw::plugins::ProgrammerInfo>& programmers,
+                              const std::string& firmware_path,
+                              const FlashOptions& options = FlashOptions{},
+                              FlashProgressCallback progress = nullptr);
+
+    /**
+     * @brief Image cache shared by all batches of this scheduler
+     */
+    FirmwareImageCache& getImageCache() { return images_; }
+
+private:
+    DetailedFlashResult flashOne(const FlashJob& job,
+                                 const std::shared_ptr<const FirmwareImage>& image,
+                                 const FlashOptions& options,
+                                 const std::function<void(const FlashProgress&)>& emit);
+
+    std::shared_ptr<IFlashBackend> backend_;
+    FlashSchedulerConfig config_;
+    FirmwareImageCache images_;
+};
+
+} // namespace roboclaw::embedded
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include <thread>
 #include <chrono>
+#include <future>
 
 namespace roboclaw::embedded {
 
@@ -19,22 +20,22 @@ ProgrammerDetectionResult ProgrammerDetector::scanProgrammers() {
     ProgrammerDetectionResult result;
     result.found = false;
 
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    detected_programmers_.clear();
-
-    // Scan for different programmer types
-    auto stlink = detectSTLink();
-    detected_programmers_.insert(detected_programmers_.end(), stlink.begin(), stlink.end());
+    // Each probe waits on its own USB/tool round trips, so run them side by
+    // side; the detectors touch no shared state and the lock is only needed
+    // to publish the merged list.
+    auto stlink = std::async(std::launch::async, [this]() { return detectSTLink(); });
+    auto jlink = std::async(std::launch::async, [this]() { return detectJLink(); });
+    auto openocd = std::async(std::launch::async, [this]() { return detectOpenOCD(); });
+    auto serial = std::async(std::launch::async, [this]() { return detectSerialProgrammers(); });
 
-    auto jlink = detectJLink();
-    detected_programmers_.insert(detected_programmers_.end(), jlink.begin(), jlink.end());
-
-    auto openocd = detectOpenOCD();
-    detected_programmers_.insert(detected_programmers_.end(), openocd.begin(), openocd.end());
+    std::vector<roboclaw::plugins::ProgrammerInfo> programmers;
+    for (auto* probe : {&stlink, &jlink, &openocd, &serial}) {
+        auto found = probe->get();
+        programmers.insert(programmers.end(), found.begin(), found.end());
+    }
 
-    auto serial = detectSerialProgrammers();
-    detected_programmers_.insert(detected_programmers_.end(), serial.begin(), serial.end());
+    std::lock_guard<std::mutex> lock(mutex_);
+    detected_programmers_ = std::move(programmers);
 
     result.programmers = detected_programmers_;
     result.found = !detected_programmers_.empty();
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 #include "plugins/interfaces/iembedded_platform.h"
 #include "workflow_controller.h"
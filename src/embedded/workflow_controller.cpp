@@ -1,6 +1,8 @@
 // src/embedded/workflow_controller.cpp
 #include "workflow_controller.h"
+#include "flash_scheduler.h"
 #include <algorithm>
+#include <filesystem>
 #include <sstream>
 #include <iomanip>
 
@@ -15,6 +17,11 @@ WorkflowController::~WorkflowController() {
 
 void WorkflowController::setPlatform(std::shared_ptr<roboclaw::plugins::IEmbeddedPlatform> platform) {
     platform_ = platform;
+    flash_scheduler_.reset();
+    if (platform_) {
+        flash_scheduler_ = std::make_unique<FlashScheduler>(
+            std::make_shared<PlatformFlashBackend>(platform_));
+    }
 }
 
 bool WorkflowController::configureCubeMX(const roboclaw::plugins::MCUModel& mcu,
@@ -106,9 +113,9 @@ FlashResult WorkflowController::flashToFirmware(const std::string& firmware_path
         auto end = std::chrono::steady_clock::now();
         result.time_elapsed = std::chrono::duration<double>(end - start).count();
 
-        // Get file size for bytes written
-        // TODO: Implement actual file size reading
-        result.bytes_written = 0;
+        std::error_code ec;
+        auto size = std::filesystem::file_size(firmware_path, ec);
+        result.bytes_written = ec ? 0 : static_cast<int>(size);
     } else {
         result.message = "Firmware flashing failed";
     }
@@ -116,6 +123,25 @@ FlashResult WorkflowController::flashToFirmware(const std::string& firmware_path
     return result;
 }
 
+FlashBatchReport WorkflowController::flashBoards(const std::string& firmware_path,
+                                                const FlashOptions& options,
+                                                std::function<void(const FlashProgress&)> progress) {
+    if (!platform_) {
+        return FlashBatchReport{};
+    }
+    return flash_scheduler_->flashAll(platform_->detectProgrammers(), firmware_path,
+                                      options, std::move(progress));
+}
+
+FlashBatchReport WorkflowController::flashBoards(const std::vector<FlashJob>& jobs,
+                                                const FlashOptions& options,
+                                                std::function<void(const FlashProgress&)> progress) {
+    if (!platform_) {
+        return FlashBatchReport{};
+    }
+    return flash_scheduler_->run(jobs, options, std::move(progress));
+}
+
 bool WorkflowController::runFullWorkflow(const WorkflowSpec& spec) {
     if (!platform_) {
         return false;
@@ -10,6 +10,11 @@
 
 namespace roboclaw::embedded {
 
+class FlashScheduler;
+struct FlashJob;
+struct FlashBatchReport;
+struct FlashProgress;
+
 /**
  * @brief Optimization constraints for parameter tuning
  */
@@ -137,6 +142,28 @@ public:
     FlashResult flashToFirmware(const std::string& firmware_path,
                                 const FlashOptions& options = FlashOptions{});
 
+    /**
+     * @brief Flash the same firmware to every connected programmer in parallel
+     * @param firmware_path Path to firmware file, read and checksummed once
+     * @param options Flash options
+     * @param progress Optional per-device progress callback (serialized)
+     * @return Batch report with one result per board
+     */
+    FlashBatchReport flashBoards(const std::string& firmware_path,
+                                 const FlashOptions& options = FlashOptions{},
+                                 std::function<void(const FlashProgress&)> progress = nullptr);
+
+    /**
+     * @brief Flash an explicit set of boards in parallel
+     * @param jobs Programmer and firmware per board; identical files are shared
+     * @param options Flash options
+     * @param progress Optional per-device progress callback (serialized)
+     * @return Batch report in job order
+     */
+    FlashBatchReport flashBoards(const std::vector<FlashJob>& jobs,
+                                 const FlashOptions& options = FlashOptions{},
+                                 std::function<void(const FlashProgress&)> progress = nullptr);
+
     /**
      * @brief Run complete workflow
      * @param spec Workflow specification
@@ -158,6 +185,7 @@ public:
 
 private:
     std::shared_ptr<roboclaw::plugins::IEmbeddedPlatform> platform_;
+    std::unique_ptr<FlashScheduler> flash_scheduler_;  // Keeps firmware images cached across batches
 
     /**
      * @brief Convert MCU model enum to string
@@ -7,6 +7,15 @@
 
 namespace roboclaw {
 
+namespace {
+
+// 临时缓存标记（Anthropic prompt caching）
+json ephemeralCacheControl() {
+    return json{{"type", "ephemeral"}};
+}
+
+} // namespace
+
 AnthropicProvider::AnthropicProvider(const std::string& apiKey,
                                      const std::string& model,
                                      const std::string& baseUrl)
@@ -24,18 +33,41 @@ AnthropicProvider::AnthropicProvider(const std::string& apiKey,
 
 LLMResponse AnthropicProvider::chat(const std::vector<ChatMessage>& messages,
                                     const std::vector<ToolDefinition>& tools) {
+    return sendChat(messages, tools, 0);
+}
+
+LLMResponse AnthropicProvider::chat(const std::vector<ChatMessage>& messages,
+                                    const ToolSchema& schema) {
+    return sendChat(messages, schema.tools, schema.version);
+}
+
+bool AnthropicProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                   const std::vector<ToolDefinition>& tools,
+                                   StreamCallback callback) {
+    return sendChatStream(messages, tools, 0, callback);
+}
+
+bool AnthropicProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                   const ToolSchema& schema,
+                                   StreamCallback callback) {
+    return sendChatStream(messages, schema.tools, schema.version, callback);
+}
+
+LLMResponse AnthropicProvider::sendChat(const std::vector<ChatMessage>& messages,
+                                        const std::vector<ToolDefinition>& tools,
+                                        uint64_t toolsVersion) {
     LLMResponse response;
 
     try {
         // 构建请求体
-        json requestBody = buildRequestBody(messages, tools);
+        std::string requestBody = buildRequestBody(messages, tools, toolsVersion);
 
         // 发送请求
         std::string url = base_url_ + "/v1/messages";
         std::map<std::string, std::string> headers;
         headers["x-api-key"] = api_key_;
 
-        HttpResponse httpResponse = http_client_.postJson(url, requestBody, headers);
+        HttpResponse httpResponse = http_client_.post(url, std::move(requestBody), headers);
 
         if (!httpResponse.success) {
             response.error = "HTTP请求失败: " + std::to_string(httpResponse.status_code);
@@ -53,20 +85,20 @@ LLMResponse AnthropicProvider::chat(const std::vector<ChatMessage>& messages,
     return response;
 }
 
-bool AnthropicProvider::chatStream(const std::vector<ChatMessage>& messages,
-                                   const std::vector<ToolDefinition>& tools,
-                                   StreamCallback callback) {
+bool AnthropicProvider::sendChatStream(const std::vector<ChatMessage>& messages,
+                                       const std::vector<ToolDefinition>& tools,
+                                       uint64_t toolsVersion,
+                                       StreamCallback callback) {
     try {
         // 构建请求体
-        json requestBody = buildRequestBody(messages, tools);
-        requestBody["stream"] = true;
+        std::string requestBody = buildRequestBody(messages, tools, toolsVersion, true);
 
         // 发送流式请求
         std::string url = base_url_ + "/v1/messages";
         std::map<std::string, std::string> headers;
         headers["x-api-key"] = api_key_;
 
-        return http_client_.postStream(url, requestBody, headers, callback);
+        return http_client_.postStream(url, std::move(requestBody), headers, callback);
 
     } catch (const std::exception& e) {
         callback("error: " + std::string(e.what()));
@@ -74,41 +106,98 @@ bool AnthropicProvider::chatStream(const std::vector<ChatMessage>& messages,
     }
 }
 
-json AnthropicProvider::buildRequestBody(const std::vector<ChatMessage>& messages,
-                                         const std::vector<ToolDefinition>& tools) const {
+LLMResponse AnthropicProvider::chatWithToolCallbacks(const std::vector<ChatMessage>& messages,
+                                                     const ToolSchema& schema,
+                                                     ToolCallCallback onToolCall) {
+    LLMResponse response;
+
+    try {
+        std::string requestBody = buildRequestBody(messages, schema.tools, schema.version, true);
+
+        std::string url = base_url_ + "/v1/messages";
+        std::map<std::string, std::string> headers;
+        headers["x-api-key"] = api_key_;
+
+        // 边接收边解析，工具调用块结束即回调
+        AnthropicStreamParser parser(onToolCall);
+        HttpResponse httpResponse = http_client_.postEventStream(url, std::move(requestBody), headers,
+            [&parser](const std::string& event, const std::string& data) {
+                return parser.feed(event, data);
+            });
+
+        response = parser.finish();
+        if (!httpResponse.success) {
+            response.success = false;
+            if (response.error.empty()) {
+                response.error = "HTTP请求失败: " + std::to_string(httpResponse.status_code);
+            }
+        }
+
+    } catch (const std::exception& e) {
+        response.success = false;
+        response.error = std::string("请求异常: ") + e.what();
+    }
+
+    return response;
+}
+
+std::string AnthropicProvider::buildRequestBody(const std::vector<ChatMessage>& messages,
+                                                const std::vector<ToolDefinition>& tools,
+                                                uint64_t toolsVersion,
+                                                bool stream) const {
     json request;
 
     request["model"] = model_;
     request["max_tokens"] = max_tokens_;
-
-    // 转换消息
-    json convertedMessages = json::array();
-    for (const auto& msg : messages) {
-        convertedMessages.push_back(convertMessage(msg));
+    if (temperature_) {
+        request["temperature"] = *temperature_;
     }
-    request["messages"] = convertedMessages;
+    if (stream) {
+        request["stream"] = true;
+    }
+
+    bool caching = prompt_caching_.load();
 
     // 添加系统消息（如果有）
     for (const auto& msg : messages) {
         if (msg.role == MessageRole::SYSTEM) {
-            request["system"] = msg.content;
+            if (caching && !msg.content.empty()) {
+                // 系统提示作为带缓存标记的文本块
+                json block;
+                block["type"] = "text";
+                block["text"] = msg.content;
+                block["cache_control"] = ephemeralCacheControl();
+                request["system"] = json::array({block});
+            } else {
+                request["system"] = msg.content;
+            }
             break;
         }
     }
 
-    // 添加工具定义
+    // 添加工具定义（同一版本的工具块只转换和序列化一次）
+    // 启用缓存时在最后一个工具上放置断点，整个工具块作为缓存前缀
+    std::vector<RequestSerializer::RawField> rawFields;
     if (!tools.empty()) {
-        json toolsArray = json::array();
-        for (const auto& tool : tools) {
-            toolsArray.push_back(convertTool(tool));
-        }
-        request["tools"] = toolsArray;
+        rawFields.emplace_back("tools", serializeTools(tools, toolsVersion,
+            [this, caching, &tools](const ToolDefinition& tool) {
+                json converted = convertTool(tool);
+                if (caching && &tool == &tools.back()) {
+                    converted["cache_control"] = ephemeralCacheControl();
+                }
+                return converted;
+            }));
     }
 
-    return request;
+    // 消息增量序列化：已发送过的消息直接复用缓存的字节，
+    // 启用缓存时在上次请求末尾和本次请求末尾放置断点
+    return request_serializer_.build(request, messages,
+        [this](const ChatMessage& msg, bool breakpoint) {
+            return convertMessage(msg, breakpoint);
+        }, rawFields, caching);
 }
 
-json AnthropicProvider::convertMessage(const ChatMessage& msg) const {
+json AnthropicProvider::convertMessage(const ChatMessage& msg, bool breakpoint) const {
     json anthropicMsg;
 
     switch (msg.role) {
@@ -178,6 +267,22 @@ json AnthropicProvider::convertMessage(const ChatMessage& msg) const {
             break;
     }
 
+    // 缓存断点：标记在消息的最后一个内容块上（空文本块不能携带标记）
+    if (breakpoint) {
+        json& content = anthropicMsg["content"];
+        if (content.is_string()) {
+            if (!content.get_ref<const std::string&>().empty()) {
+                json block;
+                block["type"] = "text";
+                block["text"] = content;
+                block["cache_control"] = ephemeralCacheControl();
+                content = json::array({block});
+            }
+        } else if (content.is_array() && !content.empty()) {
+            content.back()["cache_control"] = ephemeralCacheControl();
+        }
+    }
+
     return anthropicMsg;
 }
 
@@ -238,6 +343,8 @@ LLMResponse AnthropicProvider::parseResponse(const std::string& body) const {
             auto usage = jsonResponse["usage"];
             response.input_tokens = usage.value("input_tokens", 0);
             response.output_tokens = usage.value("output_tokens", 0);
+            response.cache_creation_input_tokens = usage.value("cache_creation_input_tokens", 0);
+            response.cache_read_input_tokens = usage.value("cache_read_input_tokens", 0);
         }
 
         response.success = true;
@@ -268,6 +375,96 @@ std::vector<ChatMessage::ToolCall> AnthropicProvider::parseToolCalls(const json&
     return toolCalls;
 }
 
+// ==================== AnthropicStreamParser ====================
+
+AnthropicStreamParser::AnthropicStreamParser(ToolCallCallback onToolCall)
+    : on_tool_call_(std::move(onToolCall)) {
+}
+
+bool AnthropicStreamParser::feed(const std::string& event, const std::string& data) {
+    json payload;
+    try {
+        payload = json::parse(data);
+    } catch (const std::exception&) {
+        // ping等事件可能没有JSON数据
+        return true;
+    }
+
+    std::string type = payload.value("type", event);
+
+    if (type == "message_start") {
+        started_ = true;
+        if (payload.contains("message") && payload["message"].contains("usage")) {
+            const auto& usage = payload["message"]["usage"];
+            response_.input_tokens = usage.value("input_tokens", 0);
+            response_.output_tokens = usage.value("output_tokens", 0);
+            response_.cache_creation_input_tokens = usage.value("cache_creation_input_tokens", 0);
+            response_.cache_read_input_tokens = usage.value("cache_read_input_tokens", 0);
+        }
+    } else if (type == "content_block_start") {
+        Block& block = blocks_[payload.value("index", 0)];
+        const json& content = payload.value("content_block", json::object());
+        block.type = content.value("type", "");
+        block.text = content.value("text", "");
+        block.id = content.value("id", "");
+        block.name = content.value("name", "");
+    } else if (type == "content_block_delta") {
+        Block& block = blocks_[payload.value("index", 0)];
+        const json& delta = payload.value("delta", json::object());
+        std::string deltaType = delta.value("type", "");
+        if (deltaType == "text_delta") {
+            block.text += delta.value("text", "");
+        } else if (deltaType == "input_json_delta") {
+            block.partial_json += delta.value("partial_json", "");
+        }
+    } else if (type == "content_block_stop") {
+        auto it = blocks_.find(payload.value("index", 0));
+        if (it != blocks_.end() && it->second.type == "tool_use") {
+            ChatMessage::ToolCall call;
+            call.id = it->second.id;
+            call.name = it->second.name;
+            try {
+                call.arguments = it->second.partial_json.empty()
+                    ? json::object() : json::parse(it->second.partial_json);
+            } catch (const std::exception&) {
+                call.arguments = json::object();
+            }
+            response_.tool_calls.push_back(call);
+
+            // 参数已完整，立即交给调用方（响应的其余部分可能仍在到达）
+            if (on_tool_call_) {
+                on_tool_call_(call);
+            }
+        }
+    } else if (type == "message_delta") {
+        if (payload.contains("usage")) {
+            response_.output_tokens = payload["usage"].value("output_tokens", response_.output_tokens);
+        }
+    } else if (type == "error") {
+        response_.error = payload.value("error", json::object()).value("message", "流式响应错误");
+        return false;
+    }
+
+    return true;
+}
+
+LLMResponse AnthropicStreamParser::finish() const {
+    LLMResponse response = response_;
+
+    // 文本块按索引顺序拼接
+    for (const auto& [index, block] : blocks_) {
+        if (block.type == "text") {
+            response.content += block.text;
+        }
+    }
+
+    response.success = started_ && response.error.empty();
+    if (!started_ && response.error.empty()) {
+        response.error = "流式响应为空";
+    }
+    return response;
+}
+
 std::string AnthropicProvider::generateToolCallId() const {
     // 生成格式: toolu_随机字符串
     static std::random_device rd;
@@ -4,10 +4,40 @@
 #define ROBOCLAW_LLM_ANTHROPIC_PROVIDER_H
 
 #include "llm_provider.h"
+#include <map>
 #include <sstream>
 
 namespace roboclaw {
 
+// Anthropic流式事件解析器
+// 把SSE事件（message_start、content_block_*、message_delta等）组装成完整响应，
+// 每个tool_use块结束（参数JSON接收完整）时立即回调
+class AnthropicStreamParser {
+public:
+    explicit AnthropicStreamParser(ToolCallCallback onToolCall = nullptr);
+
+    // 处理一个SSE事件，返回false表示收到错误事件
+    bool feed(const std::string& event, const std::string& data);
+
+    // 获取组装完成的响应
+    LLMResponse finish() const;
+
+private:
+    // 内容块（文本或工具调用）
+    struct Block {
+        std::string type;
+        std::string text;
+        std::string id;
+        std::string name;
+        std::string partial_json;
+    };
+
+    ToolCallCallback on_tool_call_;
+    std::map<int, Block> blocks_;
+    LLMResponse response_;
+    bool started_ = false;
+};
+
 class AnthropicProvider : public LLMProvider {
 public:
     AnthropicProvider(const std::string& apiKey,
@@ -25,6 +55,20 @@ public:
                    const std::vector<ToolDefinition>& tools,
                    StreamCallback callback) override;
 
+    // 发送消息（带版本的工具Schema）
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                    const ToolSchema& schema) override;
+
+    // 流式响应（带版本的工具Schema）
+    bool chatStream(const std::vector<ChatMessage>& messages,
+                   const ToolSchema& schema,
+                   StreamCallback callback) override;
+
+    // 流式发送，tool_use块结束时立即回调
+    LLMResponse chatWithToolCallbacks(const std::vector<ChatMessage>& messages,
+                                      const ToolSchema& schema,
+                                      ToolCallCallback onToolCall) override;
+
     // 获取模型名称
     std::string getModelName() const override { return model_; }
 
@@ -32,12 +76,25 @@ public:
     void setModel(const std::string& model) override { model_ = model; }
 
 private:
-    // 构建请求体
-    json buildRequestBody(const std::vector<ChatMessage>& messages,
-                         const std::vector<ToolDefinition>& tools) const;
-
-    // 转换消息格式（RoboClaw -> Anthropic）
-    json convertMessage(const ChatMessage& msg) const;
+    // 发送请求（toolsVersion为工具Schema版本，0表示不缓存工具块）
+    LLMResponse sendChat(const std::vector<ChatMessage>& messages,
+                        const std::vector<ToolDefinition>& tools,
+                        uint64_t toolsVersion);
+
+    // 发送流式请求
+    bool sendChatStream(const std::vector<ChatMessage>& messages,
+                       const std::vector<ToolDefinition>& tools,
+                       uint64_t toolsVersion,
+                       StreamCallback callback);
+
+    // 构建请求体（工具块使用缓存的序列化片段拼接）
+    std::string buildRequestBody(const std::vector<ChatMessage>& messages,
+                                const std::vector<ToolDefinition>& tools,
+                                uint64_t toolsVersion,
+                                bool stream = false) const;
+
+    // 转换消息格式（RoboClaw -> Anthropic），breakpoint为true时在末尾内容块上加缓存标记
+    json convertMessage(const ChatMessage& msg, bool breakpoint = false) const;
 
     // 转换工具格式（RoboClaw -> Anthropic）
     json convertTool(const ToolDefinition& tool) const;
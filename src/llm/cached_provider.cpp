@@ -0,0 +1,133 @@
+// CachedProvider实现
+
+#include "cached_provider.h"
+
+namespace roboclaw {
+
+CachedProvider::CachedProvider(std::shared_ptr<LLMProvider> inner,
+                               std::shared_ptr<ResponseCache> cache)
+    : LLMProvider("", "")
+    , inner_(std::move(inner))
+    , cache_(cache ? std::move(cache) : std::make_shared<ResponseCache>()) {
+}
+
+ResponseCacheKey CachedProvider::makeKey(const std::vector<ChatMessage>& messages,
+                                         const std::vector<ToolDefinition>& tools) const {
+    return ResponseCache::makeKey(inner_->getModelName(), inner_->getTemperature(),
+                                  inner_->getMaxTokens(), messages, tools);
+}
+
+LLMResponse CachedProvider::chat(const std::vector<ChatMessage>& messages,
+                                 const std::vector<ToolDefinition>& tools) {
+    auto key = makeKey(messages, tools);
+    if (auto cached = cache_->lookup(key)) {
+        return *cached;
+    }
+    LLMResponse response = inner_->chat(messages, tools);
+    cache_->store(key, response);
+    return response;
+}
+
+LLMResponse CachedProvider::chat(const std::vector<ChatMessage>& messages,
+                                 const ToolSchema& schema) {
+    auto key = makeKey(messages, schema.tools);
+    if (auto cached = cache_->lookup(key)) {
+        return *cached;
+    }
+    LLMResponse response = inner_->chat(messages, schema);
+    cache_->store(key, response);
+    return response;
+}
+
+std::optional<LLMResponse> CachedProvider::lookupForStream(const std::vector<ChatMessage>& messages,
+                                                           const std::vector<ToolDefinition>& tools) {
+    // 工具调用无法通过文本流回放，只回放纯文本响应
+    auto cached = cache_->lookup(makeKey(messages, tools));
+    if (cached && cached->tool_calls.empty()) {
+        return cached;
+    }
+    return std::nullopt;
+}
+
+bool CachedProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                const std::vector<ToolDefinition>& tools,
+                                StreamCallback callback) {
+    if (auto cached = lookupForStream(messages, tools)) {
+        callback(cached->content);
+        return true;
+    }
+    return inner_->chatStream(messages, tools, callback);
+}
+
+bool CachedProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                const ToolSchema& schema,
+                                StreamCallback callback) {
+    if (auto cached = lookupForStream(messages, schema.tools)) {
+        callback(cached->content);
+        return true;
+    }
+    return inner_->chatStream(messages, schema, callback);
+}
+
+LLMResponse CachedProvider::chatWithToolCallbacks(const std::vector<ChatMessage>& messages,
+                                                  const ToolSchema& schema,
+                                                  ToolCallCallback onToolCall) {
+    auto key = makeKey(messages, schema.tools);
+    if (auto cached = cache_->lookup(key)) {
+        if (onToolCall) {
+            for (const auto& call : cached->tool_calls) {
+                onToolCall(call);
+            }
+        }
+        return *cached;
+    }
+    LLMResponse response = inner_->chatWithToolCallbacks(messages, schema, onToolCall);
+    cache_->store(key, response);
+    return response;
+}
+
+std::string CachedProvider::getModelName() const {
+    return inner_->getModelName();
+}
+
+void CachedProvider::setModel(const std::string& model) {
+    inner_->setModel(model);
+}
+
+int CachedProvider::getMaxTokens() const {
+    return inner_->getMaxTokens();
+}
+
+void CachedProvider::setMaxTokens(int maxTokens) {
+    inner_->setMaxTokens(maxTokens);
+}
+
+void CachedProvider::resetConversation() {
+    inner_->resetConversation();
+}
+
+void CachedProvider::setConversationRevision(uint64_t revision) {
+    inner_->setConversationRevision(revision);
+}
+
+void CachedProvider::cancel() {
+    inner_->cancel();
+}
+
+void CachedProvider::setTemperature(double temperature) {
+    inner_->setTemperature(temperature);
+}
+
+std::optional<double> CachedProvider::getTemperature() const {
+    return inner_->getTemperature();
+}
+
+void CachedProvider::setPromptCaching(bool enabled) {
+    inner_->setPromptCaching(enabled);
+}
+
+bool CachedProvider::isPromptCachingEnabled() const {
+    return inner_->isPromptCachingEnabled();
+}
+
+} // namespace roboclaw
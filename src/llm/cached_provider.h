@@ -0,0 +1,83 @@
+// 缓存提供商 - CachedProvider
+// 在任意提供商前加一层响应缓存，重复的确定性请求不再发送网络请求
+
+#ifndef ROBOCLAW_LLM_CACHED_PROVIDER_H
+#define ROBOCLAW_LLM_CACHED_PROVIDER_H
+
+#include "llm_provider.h"
+#include "response_cache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace roboclaw {
+
+// 缓存提供商
+//
+// chat()和chatWithToolCallbacks()先查询ResponseCache，命中时直接返回（工具调用按顺序
+// 回调），未命中时转发给内部提供商并缓存成功的响应。
+// 流式响应命中时一次性回调完整内容；未命中时直接转发，不写入缓存。
+class CachedProvider : public LLMProvider {
+public:
+    CachedProvider(std::shared_ptr<LLMProvider> inner,
+                   std::shared_ptr<ResponseCache> cache);
+
+    ~CachedProvider() override = default;
+
+    // 发送消息（先查缓存）
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                    const std::vector<ToolDefinition>& tools = {}) override;
+
+    // 发送消息（带版本的工具Schema，先查缓存）
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                    const ToolSchema& schema) override;
+
+    // 流式响应
+    bool chatStream(const std::vector<ChatMessage>& messages,
+                   const std::vector<ToolDefinition>& tools,
+                   StreamCallback callback) override;
+
+    // 流式响应（带版本的工具Schema）
+    bool chatStream(const std::vector<ChatMessage>& messages,
+                   const ToolSchema& schema,
+                   StreamCallback callback) override;
+
+    // 发送消息并回调工具调用（先查缓存）
+    LLMResponse chatWithToolCallbacks(const std::vector<ChatMessage>& messages,
+                                      const ToolSchema& schema,
+                                      ToolCallCallback onToolCall) override;
+
+    // 转发到内部提供商
+    std::string getModelName() const override;
+    void setModel(const std::string& model) override;
+    int getMaxTokens() const override;
+    void setMaxTokens(int maxTokens) override;
+    void resetConversation() override;
+    void setConversationRevision(uint64_t revision) override;
+    void cancel() override;
+    void setTemperature(double temperature) override;
+    std::optional<double> getTemperature() const override;
+    void setPromptCaching(bool enabled) override;
+    bool isPromptCachingEnabled() const override;
+
+    // 获取缓存
+    std::shared_ptr<ResponseCache> getCache() const { return cache_; }
+
+    // 获取内部提供商
+    std::shared_ptr<LLMProvider> getInner() const { return inner_; }
+
+private:
+    ResponseCacheKey makeKey(const std::vector<ChatMessage>& messages,
+                             const std::vector<ToolDefinition>& tools) const;
+
+    // 流式命中时回放缓存内容
+    std::optional<LLMResponse> lookupForStream(const std::vector<ChatMessage>& messages,
+                                               const std::vector<ToolDefinition>& tools);
+
+    std::shared_ptr<LLMProvider> inner_;
+    std::shared_ptr<ResponseCache> cache_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_LLM_CACHED_PROVIDER_H
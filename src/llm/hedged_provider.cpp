@@ -0,0 +1,430 @@
+// HedgedProvider实现
+
+#include "hedged_provider.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <thread>
+#include <tuple>
+
+namespace roboclaw {
+
+namespace {
+
+// 计算延迟样本的分位数
+double percentileOf(std::vector<double> samples, double percentile) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(percentile * (samples.size() - 1) + 0.5);
+    rank = std::min(rank, samples.size() - 1);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+} // namespace
+
+HedgedProvider::HedgedProvider(std::vector<Endpoint> endpoints, const HedgeConfig& config)
+    : LLMProvider("", "")
+    , config_(config) {
+    for (auto& [name, provider] : endpoints) {
+        if (!provider) {
+            continue;
+        }
+        auto state = std::make_shared<EndpointState>();
+        state->name = name;
+        state->provider = std::move(provider);
+        state->stats.name = name;
+        endpoints_.push_back(std::move(state));
+    }
+}
+
+HedgedProvider::~HedgedProvider() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto& task : tasks) {
+        task.token->cancel();
+    }
+    for (auto& task : tasks) {
+        task.thread.join();
+    }
+}
+
+LLMResponse HedgedProvider::chat(const std::vector<ChatMessage>& messages,
+                                 const std::vector<ToolDefinition>& tools) {
+    // 落败请求可能比本次调用存活更久，请求数据复制一份共享
+    auto sharedMessages = std::make_shared<const std::vector<ChatMessage>>(messages);
+    auto sharedTools = std::make_shared<const std::vector<ToolDefinition>>(tools);
+    return hedged([sharedMessages, sharedTools](LLMProvider& provider) {
+        return provider.chat(*sharedMessages, *sharedTools);
+    });
+}
+
+LLMResponse HedgedProvider::chat(const std::vector<ChatMessage>& messages,
+                                 const ToolSchema& schema) {
+    auto sharedMessages = std::make_shared<const std::vector<ChatMessage>>(messages);
+    auto sharedSchema = std::make_shared<const ToolSchema>(schema);
+    return hedged([sharedMessages, sharedSchema](LLMProvider& provider) {
+        return provider.chat(*sharedMessages, *sharedSchema);
+    });
+}
+
+bool HedgedProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                const std::vector<ToolDefinition>& tools,
+                                StreamCallback callback) {
+    auto order = rankEndpoints();
+    if (order.empty()) {
+        return false;
+    }
+    auto& state = *endpoints_[order.front()];
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        ++state.stats.requests;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool success = state.provider->chatStream(messages, tools, callback);
+    recordResult(state, config_, std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count(), success);
+    return success;
+}
+
+bool HedgedProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                const ToolSchema& schema,
+                                StreamCallback callback) {
+    auto order = rankEndpoints();
+    if (order.empty()) {
+        return false;
+    }
+    auto& state = *endpoints_[order.front()];
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        ++state.stats.requests;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool success = state.provider->chatStream(messages, schema, callback);
+    recordResult(state, config_, std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count(), success);
+    return success;
+}
+
+LLMResponse HedgedProvider::hedged(const Call& call) {
+    auto order = rankEndpoints();
+    if (order.empty()) {
+        LLMResponse response;
+        response.error = "没有可用的LLM端点";
+        return response;
+    }
+
+    // 一次对冲竞速的共享状态（落败线程在返回后仍可能访问）
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        LLMResponse winner;
+        LLMResponse last_failure;
+        size_t winner_slot = SIZE_MAX;
+        size_t finished = 0;
+        std::vector<bool> slot_finished;
+    };
+    auto race = std::make_shared<Race>();
+    HedgeConfig config = config_;
+    std::vector<size_t> launched;  // 每个槽位对应的端点下标
+    std::vector<std::shared_ptr<CancellationToken>> tokens;  // 每个槽位的取消令牌
+
+    auto launch = [&](size_t index, bool isHedge) {
+        auto state = endpoints_[index];
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            ++state->stats.requests;
+            if (isHedge) {
+                ++state->stats.hedges;
+            }
+        }
+
+        size_t slot = launched.size();
+        launched.push_back(index);
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            race->slot_finished.push_back(false);
+        }
+
+        // 令牌在请求发出前创建，尚未连接的落败请求同样能被取消
+        auto token = std::make_shared<CancellationToken>();
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        tokens.push_back(token);
+
+        std::thread worker([race, state, call, config, slot, token, finished]() {
+            ScopedCancellation scope(token);
+            auto start = std::chrono::steady_clock::now();
+            LLMResponse response;
+            try {
+                if (token->isCancelled()) {
+                    response.error = "请求已取消";
+                } else {
+                    response = call(*state->provider);
+                }
+            } catch (const std::exception& e) {
+                response.success = false;
+                response.error = std::string("请求异常: ") + e.what();
+            }
+            double latencyMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+
+            // 先记录端点统计再公布结果，调用方返回时统计已是最新
+            {
+                std::lock_guard<std::mutex> lock(race->mutex);
+                bool lost = race->done;
+                if (lost && !response.success) {
+                    // 已有胜者，失败多半是被取消，不计入端点健康度
+                    std::lock_guard<std::mutex> stateLock(state->mutex);
+                    ++state->stats.cancelled;
+                } else {
+                    recordResult(*state, config, latencyMs, response.success);
+                }
+
+                if (!race->done && response.success) {
+                    race->done = true;
+                    race->winner = response;
+                    race->winner_slot = slot;
+                    std::lock_guard<std::mutex> stateLock(state->mutex);
+                    ++state->stats.wins;
+                } else if (!response.success && !race->done) {
+                    race->last_failure = response;
+                }
+                race->slot_finished[slot] = true;
+                ++race->finished;
+            }
+            race->cv.notify_all();
+            finished->store(true);
+        });
+
+        reapTasks();
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks_.push_back({std::move(worker), token, finished});
+    };
+
+    launch(order[0], false);
+    size_t next = 1;
+    size_t hedgesLaunched = 0;
+    auto deadline = std::chrono::steady_clock::now() + getHedgeDelay(order[0]);
+
+    std::unique_lock<std::mutex> lock(race->mutex);
+    while (!race->done) {
+        size_t inFlight = launched.size() - race->finished;
+
+        // 在途请求全部失败：立即转向下一个端点
+        if (inFlight == 0) {
+            if (next >= order.size()) {
+                break;
+            }
+            lock.unlock();
+            LOG_WARNING("LLM端点失败，转向 " + endpoints_[order[next]]->name);
+            launch(order[next], false);
+            lock.lock();
+            deadline = std::chrono::steady_clock::now() + getHedgeDelay(order[next]);
+            ++next;
+            continue;
+        }
+
+        bool canHedge = config_.enabled && next < order.size() && hedgesLaunched < config_.max_hedges;
+        if (!canHedge) {
+            race->cv.wait(lock);
+            continue;
+        }
+
+        // 超过主端点的分位数延迟仍未返回：发起对冲请求
+        if (race->cv.wait_until(lock, deadline) == std::cv_status::timeout && !race->done &&
+            launched.size() > race->finished) {
+            lock.unlock();
+            launch(order[next], true);
+            lock.lock();
+            deadline = std::chrono::steady_clock::now() + getHedgeDelay(order[next]);
+            ++next;
+            ++hedgesLaunched;
+        }
+    }
+
+    LLMResponse result = race->done ? race->winner : race->last_failure;
+    std::vector<size_t> losers;
+    if (race->done) {
+        for (size_t slot = 0; slot < launched.size(); ++slot) {
+            if (slot != race->winner_slot && !race->slot_finished[slot]) {
+                losers.push_back(slot);
+            }
+        }
+    }
+    lock.unlock();
+
+    // 只取消仍在进行的落败请求，同一端点上的其他请求不受影响
+    for (size_t slot : losers) {
+        tokens[slot]->cancel();
+    }
+
+    if (!result.success && result.error.empty()) {
+        result.error = "所有LLM端点请求失败";
+    }
+    return result;
+}
+
+void HedgedProvider::reapTasks() {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    auto done = std::partition(tasks_.begin(), tasks_.end(),
+                               [](const Task& task) { return !task.finished->load(); });
+    for (auto it = done; it != tasks_.end(); ++it) {
+        it->thread.join();
+    }
+    tasks_.erase(done, tasks_.end());
+}
+
+std::vector<size_t> HedgedProvider::rankEndpoints() const {
+    // 排序键：是否连续失败、EWMA延迟（无样本视为最慢）、配置顺序
+    std::vector<std::tuple<bool, double, size_t>> keys;
+    keys.reserve(endpoints_.size());
+    for (size_t i = 0; i < endpoints_.size(); ++i) {
+        const auto& state = *endpoints_[i];
+        std::lock_guard<std::mutex> lock(state.mutex);
+        keys.emplace_back(state.consecutive_failures > 0,
+                          state.has_samples ? state.ewma_ms : std::numeric_limits<double>::infinity(),
+                          i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<size_t> order;
+    order.reserve(keys.size());
+    for (const auto& key : keys) {
+        order.push_back(std::get<2>(key));
+    }
+    return order;
+}
+
+void HedgedProvider::recordResult(EndpointState& state, const HedgeConfig& config,
+                                  double latencyMs, bool success) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!success) {
+        ++state.stats.failures;
+        ++state.consecutive_failures;
+        return;
+    }
+
+    ++state.stats.successes;
+    state.consecutive_failures = 0;
+    if (state.has_samples) {
+        state.ewma_ms = config.ewma_alpha * latencyMs + (1.0 - config.ewma_alpha) * state.ewma_ms;
+    } else {
+        state.ewma_ms = latencyMs;
+        state.has_samples = true;
+    }
+    state.window.push_back(latencyMs);
+    while (state.window.size() > config.window_size) {
+        state.window.pop_front();
+    }
+}
+
+std::chrono::milliseconds HedgedProvider::getHedgeDelay(size_t index) const {
+    if (index >= endpoints_.size()) {
+        return config_.initial_delay;
+    }
+
+    const auto& state = *endpoints_[index];
+    std::vector<double> samples;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.window.size() < config_.min_samples) {
+            return config_.initial_delay;
+        }
+        samples.assign(state.window.begin(), state.window.end());
+    }
+
+    auto delay = std::chrono::milliseconds(
+        static_cast<int64_t>(percentileOf(std::move(samples), config_.percentile)));
+    return std::clamp(delay, config_.min_delay, config_.max_delay);
+}
+
+std::vector<EndpointStats> HedgedProvider::getEndpointStats() const {
+    std::vector<EndpointStats> result;
+    result.reserve(endpoints_.size());
+    for (const auto& state : endpoints_) {
+        std::vector<double> samples;
+        EndpointStats stats;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            stats = state->stats;
+            stats.ewma_ms = state->ewma_ms;
+            samples.assign(state->window.begin(), state->window.end());
+        }
+        stats.p95_ms = percentileOf(std::move(samples), config_.percentile);
+        result.push_back(stats);
+    }
+    return result;
+}
+
+std::string HedgedProvider::getModelName() const {
+    auto order = rankEndpoints();
+    return order.empty() ? model_ : endpoints_[order.front()]->provider->getModelName();
+}
+
+void HedgedProvider::setModel(const std::string& model) {
+    model_ = model;
+    for (auto& state : endpoints_) {
+        state->provider->setModel(model);
+    }
+}
+
+void HedgedProvider::setMaxTokens(int maxTokens) {
+    max_tokens_ = maxTokens;
+    for (auto& state : endpoints_) {
+        state->provider->setMaxTokens(maxTokens);
+    }
+}
+
+void HedgedProvider::resetConversation() {
+    for (auto& state : endpoints_) {
+        state->provider->resetConversation();
+    }
+}
+
+void HedgedProvider::setConversationRevision(uint64_t revision) {
+    for (auto& state : endpoints_) {
+        state->provider->setConversationRevision(revision);
+    }
+}
+
+void HedgedProvider::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        for (auto& task : tasks_) {
+            task.token->cancel();
+        }
+    }
+    // 流式请求不经过对冲线程，仍由端点自身取消
+    for (auto& state : endpoints_) {
+        state->provider->cancel();
+    }
+}
+
+void HedgedProvider::setTemperature(double temperature) {
+    temperature_ = temperature;
+    for (auto& state : endpoints_) {
+        state->provider->setTemperature(temperature);
+    }
+}
+
+std::optional<double> HedgedProvider::getTemperature() const {
+    return endpoints_.empty() ? temperature_ : endpoints_.front()->provider->getTemperature();
+}
+
+void HedgedProvider::setPromptCaching(bool enabled) {
+    for (auto& state : endpoints_) {
+        state->provider->setPromptCaching(enabled);
+    }
+}
+
+bool HedgedProvider::isPromptCachingEnabled() const {
+    return !endpoints_.empty() && endpoints_.front()->provider->isPromptCachingEnabled();
+}
+
+} // namespace roboclaw
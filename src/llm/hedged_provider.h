@@ -0,0 +1,153 @@
+// 对冲请求提供商 - HedgedProvider
+// 组合多个提供商/区域，主端点超过p95延迟未返回时向备用端点发送相同请求
+
+#ifndef ROBOCLAW_LLM_HEDGED_PROVIDER_H
+#define ROBOCLAW_LLM_HEDGED_PROVIDER_H
+
+#include "llm_provider.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace roboclaw {
+
+// 对冲配置
+struct HedgeConfig {
+    bool enabled = true;                                   // 是否启用对冲（关闭时只做故障转移）
+    double percentile = 0.95;                              // 对冲延迟取主端点延迟的该分位数
+    size_t max_hedges = 1;                                 // 同时在途的额外请求数上限
+    size_t min_samples = 8;                                // 样本不足时使用initial_delay
+    size_t window_size = 128;                              // 每个端点保留的最近延迟样本数
+    double ewma_alpha = 0.2;                               // 延迟EWMA平滑系数
+    std::chrono::milliseconds initial_delay{2000};         // 冷启动时的对冲延迟
+    std::chrono::milliseconds min_delay{50};               // 对冲延迟下限
+    std::chrono::milliseconds max_delay{15000};            // 对冲延迟上限
+};
+
+// 端点统计
+struct EndpointStats {
+    std::string name;
+    double ewma_ms = 0.0;          // 成功请求延迟的EWMA
+    double p95_ms = 0.0;           // 最近窗口内的延迟分位数
+    uint64_t requests = 0;         // 发往该端点的请求数
+    uint64_t successes = 0;        // 成功次数
+    uint64_t failures = 0;         // 失败次数（不含被取消的落败请求）
+    uint64_t wins = 0;             // 作为最先成功者被采用的次数
+    uint64_t hedges = 0;           // 作为对冲请求被发起的次数
+    uint64_t cancelled = 0;        // 落败后被取消的次数
+};
+
+// 对冲请求提供商
+//
+// 端点按EWMA延迟排序（连续失败的端点排在最后），请求先发往最快的端点；
+// 若在该端点的p95延迟内没有返回，再向下一个端点发送相同请求，采用最先成功的
+// 响应并取消其余请求。主端点失败时立即转向下一个端点，不再等待。
+// 每个请求绑定自己的取消令牌，取消落败者不影响同一端点上的其他请求。
+// 流式响应无法对冲，直接路由到当前最快的端点。
+class HedgedProvider : public LLMProvider {
+public:
+    using Endpoint = std::pair<std::string, std::shared_ptr<LLMProvider>>;
+
+    explicit HedgedProvider(std::vector<Endpoint> endpoints,
+                            const HedgeConfig& config = HedgeConfig());
+
+    // 取消并等待仍在进行的落败请求
+    ~HedgedProvider() override;
+
+    // 发送消息（对冲）
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                    const std::vector<ToolDefinition>& tools = {}) override;
+
+    // 发送消息（带版本的工具Schema，对冲）
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                    const ToolSchema& schema) override;
+
+    // 流式响应（路由到最快的端点）
+    bool chatStream(const std::vector<ChatMessage>& messages,
+                   const std::vector<ToolDefinition>& tools,
+                   StreamCallback callback) override;
+
+    // 流式响应（带版本的工具Schema）
+    bool chatStream(const std::vector<ChatMessage>& messages,
+                   const ToolSchema& schema,
+                   StreamCallback callback) override;
+
+    // 获取模型名称（当前最快端点的模型）
+    std::string getModelName() const override;
+
+    // 设置模型（应用到所有端点）
+    void setModel(const std::string& model) override;
+
+    // 转发到所有端点
+    void setMaxTokens(int maxTokens) override;
+    void resetConversation() override;
+    void setConversationRevision(uint64_t revision) override;
+    void cancel() override;
+    void setTemperature(double temperature) override;
+    std::optional<double> getTemperature() const override;
+    void setPromptCaching(bool enabled) override;
+    bool isPromptCachingEnabled() const override;
+
+    // 获取各端点统计（按配置顺序）
+    std::vector<EndpointStats> getEndpointStats() const;
+
+    // 获取端点当前的对冲延迟
+    std::chrono::milliseconds getHedgeDelay(size_t index) const;
+
+    // 获取配置
+    const HedgeConfig& getConfig() const { return config_; }
+
+private:
+    // 端点状态（由可能比本对象存活更久的落败请求线程共享）
+    struct EndpointState {
+        std::string name;
+        std::shared_ptr<LLMProvider> provider;
+
+        mutable std::mutex mutex;
+        double ewma_ms = 0.0;
+        bool has_samples = false;
+        std::deque<double> window;
+        int consecutive_failures = 0;
+        EndpointStats stats;
+    };
+
+    using Call = std::function<LLMResponse(LLMProvider&)>;
+
+    // 请求线程（落败请求可能在调用返回后继续运行）
+    struct Task {
+        std::thread thread;
+        std::shared_ptr<CancellationToken> token;
+        std::shared_ptr<std::atomic<bool>> finished;
+    };
+
+    // 执行对冲请求
+    LLMResponse hedged(const Call& call);
+
+    // 按路由优先级排序的端点下标
+    std::vector<size_t> rankEndpoints() const;
+
+    // 记录请求结果
+    static void recordResult(EndpointState& state, const HedgeConfig& config,
+                             double latencyMs, bool success);
+
+    // 回收已结束的请求线程
+    void reapTasks();
+
+    std::vector<std::shared_ptr<EndpointState>> endpoints_;
+    HedgeConfig config_;
+
+    std::mutex tasks_mutex_;
+    std::vector<Task> tasks_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_LLM_HEDGED_PROVIDER_H
@@ -5,6 +5,8 @@
 #include <thread>
 #include <sstream>
 #include <tuple>
+#include <algorithm>
+#include <string_view>
 
 namespace roboclaw {
 
@@ -59,14 +61,79 @@ HttpResponse HttpClient::get(const std::string& url,
     }
 }
 
+HttpResponse HttpClient::getStream(const std::string& url,
+                                    const std::map<std::string, std::string>& headers,
+                                    DataCallback onData,
+                                    int timeout) {
+    try {
+        cpr::Session session;
+        session.SetUrl(url);
+        installCancellation(session);
+
+        int actualTimeout = timeout > 0 ? timeout : default_timeout_;
+        session.SetTimeout(cpr::Timeout{std::chrono::milliseconds(actualTimeout * 1000)});
+
+        cpr::Header header;
+        for (const auto& pair : default_headers_) {
+            header[pair.first] = pair.second;
+        }
+        for (const auto& pair : headers) {
+            header[pair.first] = pair.second;
+        }
+        session.SetHeader(header);
+
+        bool aborted = false;
+        session.SetWriteCallback(cpr::WriteCallback{[&](std::string_view data, intptr_t) -> bool {
+            if (!onData(data)) {
+                aborted = true;
+                return false;
+            }
+            return true;
+        }});
+
+        cpr::Response response = session.Get();
+
+        HttpResponse resp;
+        resp.status_code = response.status_code;
+        resp.success = !aborted && response.status_code >= 200 && response.status_code < 300;
+        if (aborted) {
+            resp.error_message = "数据接收被中止";
+        } else if (response.status_code == 0) {
+            resp.error_message = response.error.message;
+        }
+        for (const auto& pair : response.header) {
+            resp.headers[pair.first] = pair.second;
+        }
+        return resp;
+
+    } catch (const std::exception& e) {
+        return HttpResponse::error(std::string("流式GET请求失败: ") + e.what());
+    }
+}
+
 HttpResponse HttpClient::post(const std::string& url,
                                const std::string& body,
                                const std::map<std::string, std::string>& headers,
                                int timeout) {
+    return sendPost(url, cpr::Body{body}, headers, timeout);
+}
+
+HttpResponse HttpClient::post(const std::string& url,
+                               std::string&& body,
+                               const std::map<std::string, std::string>& headers,
+                               int timeout) {
+    return sendPost(url, cpr::Body{std::move(body)}, headers, timeout);
+}
+
+HttpResponse HttpClient::sendPost(const std::string& url,
+                                   cpr::Body body,
+                                   const std::map<std::string, std::string>& headers,
+                                   int timeout) {
     try {
         cpr::Session session;
         session.SetUrl(url);
-        session.SetBody(body);
+        session.SetBody(std::move(body));
+        installCancellation(session);
 
         // 设置超时
         int actualTimeout = timeout > 0 ? timeout : default_timeout_;
@@ -121,9 +188,23 @@ bool HttpClient::postStream(const std::string& url,
                              const std::map<std::string, std::string>& headers,
                              StreamCallback callback,
                              int timeout) {
+    return postStream(url, data.dump(), headers, callback, timeout);
+}
+
+bool HttpClient::postStream(const std::string& url,
+                             std::string body,
+                             const std::map<std::string, std::string>& headers,
+                             StreamCallback callback,
+                             int timeout) {
     // 暂时简化：使用非流式方式，然后一次性回调
     try {
-        HttpResponse response = postJson(url, data, headers, timeout);
+        // 添加Content-Type头部（如果未指定）
+        auto finalHeaders = headers;
+        if (finalHeaders.find("Content-Type") == finalHeaders.end()) {
+            finalHeaders["Content-Type"] = "application/json";
+        }
+
+        HttpResponse response = post(url, std::move(body), finalHeaders, timeout);
         if (response.success) {
             // 简单的 SSE 数据模拟
             callback(response.body);
@@ -136,6 +217,125 @@ bool HttpClient::postStream(const std::string& url,
     }
 }
 
+HttpResponse HttpClient::postEventStream(const std::string& url,
+                                         std::string body,
+                                         const std::map<std::string, std::string>& headers,
+                                         EventCallback onEvent,
+                                         int timeout) {
+    try {
+        cpr::Session session;
+        session.SetUrl(url);
+        session.SetBody(cpr::Body{std::move(body)});
+        installCancellation(session);
+
+        int actualTimeout = timeout > 0 ? timeout : default_timeout_;
+        session.SetTimeout(cpr::Timeout{std::chrono::milliseconds(actualTimeout * 1000)});
+
+        cpr::Header header;
+        for (const auto& pair : default_headers_) {
+            header[pair.first] = pair.second;
+        }
+        for (const auto& pair : headers) {
+            header[pair.first] = pair.second;
+        }
+        header["Accept"] = "text/event-stream";
+        session.SetHeader(header);
+
+        // 按空行切分事件，逐行解析 event/data 字段
+        std::string buffer;
+        std::string raw;          // 未解析出任何事件前保留原始内容（错误响应为普通JSON）
+        bool sawEvent = false;
+        bool aborted = false;
+
+        auto dispatchEvent = [&](const std::string& block) {
+            std::string event;
+            std::string data;
+            size_t start = 0;
+            while (start <= block.size()) {
+                size_t end = block.find('\n', start);
+                if (end == std::string::npos) {
+                    end = block.size();
+                }
+                std::string line = block.substr(start, end - start);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                start = end + 1;
+
+                if (line.empty() || line[0] == ':') {
+                    continue;
+                }
+                size_t colon = line.find(':');
+                std::string field = line.substr(0, colon);
+                std::string value = colon == std::string::npos ? "" : line.substr(colon + 1);
+                if (!value.empty() && value[0] == ' ') {
+                    value.erase(0, 1);
+                }
+
+                if (field == "event") {
+                    event = value;
+                } else if (field == "data") {
+                    if (!data.empty()) {
+                        data += '\n';
+                    }
+                    data += value;
+                }
+            }
+            if (event.empty() && data.empty()) {
+                return true;
+            }
+            sawEvent = true;
+            raw.clear();
+            return onEvent(event, data);
+        };
+
+        session.SetWriteCallback(cpr::WriteCallback{[&](std::string_view data, intptr_t) -> bool {
+            buffer.append(data.data(), data.size());
+            if (!sawEvent) {
+                raw.append(data.data(), data.size());
+            }
+
+            while (true) {
+                size_t lf = buffer.find("\n\n");
+                size_t crlf = buffer.find("\r\n\r\n");
+                size_t pos = std::min(lf, crlf);
+                if (pos == std::string::npos) {
+                    break;
+                }
+                std::string block = buffer.substr(0, pos);
+                buffer.erase(0, pos + (pos == lf ? 2 : 4));
+                if (!dispatchEvent(block)) {
+                    aborted = true;
+                    return false;
+                }
+            }
+            return true;
+        }});
+
+        cpr::Response response = session.Post();
+
+        // 末尾未以空行结束的事件
+        if (!aborted && !buffer.empty() && sawEvent) {
+            dispatchEvent(buffer);
+        }
+
+        HttpResponse resp;
+        resp.status_code = response.status_code;
+        resp.success = !aborted && response.status_code >= 200 && response.status_code < 300;
+        if (!resp.success) {
+            resp.body = raw.empty() ? buffer : raw;
+            resp.error_message = aborted ? "事件流被中止" : response.error.message;
+        }
+        for (const auto& pair : response.header) {
+            resp.headers[pair.first] = pair.second;
+        }
+        return resp;
+
+    } catch (const std::exception& e) {
+        return HttpResponse::error(std::string("流式POST请求失败: ") + e.what());
+    }
+}
+
 HttpResponse HttpClient::postWithRetry(const std::string& url,
                                        const json& data,
                                        const std::map<std::string, std::string>& headers,
@@ -274,6 +474,35 @@ std::vector<std::future<HttpResponse>> HttpClient::postBatchAsync(
     return futures;
 }
 
+namespace {
+
+thread_local std::shared_ptr<CancellationToken> currentCancellation;
+
+} // namespace
+
+ScopedCancellation::ScopedCancellation(std::shared_ptr<CancellationToken> token)
+    : previous_(std::move(currentCancellation)) {
+    currentCancellation = std::move(token);
+}
+
+ScopedCancellation::~ScopedCancellation() {
+    currentCancellation = std::move(previous_);
+}
+
+std::shared_ptr<CancellationToken> ScopedCancellation::current() {
+    return currentCancellation;
+}
+
+void HttpClient::installCancellation(cpr::Session& session) {
+    uint64_t generation = cancel_generation_.load();
+    auto token = ScopedCancellation::current();
+    session.SetProgressCallback(cpr::ProgressCallback{
+        [this, generation, token](auto&&...) -> bool {
+            // 返回false时libcurl中止传输；令牌在请求发出前已被取消时第一次回调即中止
+            return cancel_generation_.load() == generation && !(token && token->isCancelled());
+        }});
+}
+
 void HttpClient::cancelAllAsync() {
     // CPR库不支持真正取消正在进行的请求
     // 这里我们只能减少计数器并记录日志
@@ -5,10 +5,12 @@
 #define ROBOCLAW_LLM_HTTP_CLIENT_H
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <memory>
 #include <future>
 #include <atomic>
+#include <cstdint>
 
 #include <cpr/cpr.h>
 #include <nlohmann/json.hpp>
@@ -17,6 +19,32 @@ using json = nlohmann::json;
 
 namespace roboclaw {
 
+// 单个请求的取消令牌：在发出请求前创建，cancel()只中止绑定了该令牌的请求
+class CancellationToken {
+public:
+    void cancel() { cancelled_.store(true); }
+    bool isCancelled() const { return cancelled_.load(); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+// 在当前线程上绑定取消令牌，作用域内发出的同步/流式请求都受该令牌控制
+class ScopedCancellation {
+public:
+    explicit ScopedCancellation(std::shared_ptr<CancellationToken> token);
+    ~ScopedCancellation();
+
+    ScopedCancellation(const ScopedCancellation&) = delete;
+    ScopedCancellation& operator=(const ScopedCancellation&) = delete;
+
+    // 当前线程绑定的令牌（未绑定时为空）
+    static std::shared_ptr<CancellationToken> current();
+
+private:
+    std::shared_ptr<CancellationToken> previous_;
+};
+
 // HTTP响应
 struct HttpResponse {
     int status_code;
@@ -61,6 +89,12 @@ struct HttpResponse {
 // 流式响应回调
 using StreamCallback = std::function<void(const std::string& chunk)>;
 
+// SSE事件回调（event为事件类型，data为数据行拼接结果；返回false中止接收）
+using EventCallback = std::function<bool(const std::string& event, const std::string& data)>;
+
+// 响应体数据块回调（返回false中止接收）
+using DataCallback = std::function<bool(std::string_view chunk)>;
+
 // HTTP客户端
 class HttpClient {
 public:
@@ -78,12 +112,25 @@ public:
                      const std::map<std::string, std::string>& headers = {},
                      int timeout = 0);
 
+    // 流式GET请求：响应体按块交给onData（返回false中止接收），不在内存中缓冲
+    // 非2xx响应的内容同样交给onData，调用方根据status_code判断
+    HttpResponse getStream(const std::string& url,
+                           const std::map<std::string, std::string>& headers,
+                           DataCallback onData,
+                           int timeout = 0);
+
     // POST请求
     HttpResponse post(const std::string& url,
                       const std::string& body,
                       const std::map<std::string, std::string>& headers = {},
                       int timeout = 0);
 
+    // POST请求（移入请求体，发送时不再复制）
+    HttpResponse post(const std::string& url,
+                      std::string&& body,
+                      const std::map<std::string, std::string>& headers = {},
+                      int timeout = 0);
+
     // POST请求（JSON）
     HttpResponse postJson(const std::string& url,
                           const json& data,
@@ -97,6 +144,21 @@ public:
                     StreamCallback callback,
                     int timeout = 0);
 
+    // 流式POST请求（已序列化的请求体，按值传入以便移动）
+    bool postStream(const std::string& url,
+                    std::string body,
+                    const std::map<std::string, std::string>& headers,
+                    StreamCallback callback,
+                    int timeout = 0);
+
+    // 流式POST请求（Server-Sent Events），边接收边按事件回调
+    // 返回的HttpResponse不含已回调的事件数据；非2xx时body为原始响应内容
+    HttpResponse postEventStream(const std::string& url,
+                                 std::string body,
+                                 const std::map<std::string, std::string>& headers,
+                                 EventCallback onEvent,
+                                 int timeout = 0);
+
     // 带重试的POST请求
     HttpResponse postWithRetry(const std::string& url,
                                const json& data,
@@ -144,6 +206,9 @@ public:
     // 取消所有正在进行的异步请求
     void cancelAllAsync();
 
+    // 中止调用前已发出、仍在进行的同步/流式请求（之后发出的请求不受影响）
+    void cancel() { cancel_generation_.fetch_add(1); }
+
     // 获取活跃异步请求数
     int getActiveAsyncRequests() const { return active_async_requests_.load(); }
 
@@ -154,8 +219,20 @@ private:
     // 异步请求计数
     std::atomic<int> active_async_requests_;
 
+    // 取消代数：请求开始时记录，cancel()递增后进行中的请求在进度回调中中止
+    std::atomic<uint64_t> cancel_generation_{0};
+
+    // 为会话安装取消检查（同时检查当前线程绑定的取消令牌）
+    void installCancellation(cpr::Session& session);
+
     // 执行请求（带超时）
     HttpResponse execute(cpr::Session& session, int timeout);
+
+    // 发送POST请求（请求体由cpr持有）
+    HttpResponse sendPost(const std::string& url,
+                          cpr::Body body,
+                          const std::map<std::string, std::string>& headers,
+                          int timeout);
 };
 
 } // namespace roboclaw
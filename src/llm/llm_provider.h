@@ -5,10 +5,15 @@
 #define ROBOCLAW_LLM_LLM_PROVIDER_H
 
 #include "http_client.h"
+#include "request_serializer.h"
 #include <string>
 #include <vector>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <optional>
 
 #include <nlohmann/json.hpp>
 
@@ -143,6 +148,13 @@ struct ToolDefinition {
     }
 };
 
+// 工具Schema快照（由ToolExecutor缓存生成）
+// version 在工具集合变化时递增，提供商据此复用已序列化的工具块；0 表示不缓存
+struct ToolSchema {
+    uint64_t version = 0;
+    std::vector<ToolDefinition> tools;
+};
+
 // LLM响应
 struct LLMResponse {
     std::string content;
@@ -155,12 +167,22 @@ struct LLMResponse {
     int input_tokens = 0;
     int output_tokens = 0;
 
+    // Prompt缓存统计（提供商支持时填充）
+    int cache_creation_input_tokens = 0;  // 写入缓存的输入token数
+    int cache_read_input_tokens = 0;      // 命中缓存的输入token数
+
+    // 是否来自本地响应缓存（未发送网络请求）
+    bool from_cache = false;
+
     LLMResponse() : success(false) {}
 };
 
 // 流式响应回调
 using StreamCallback = std::function<void(const std::string& delta)>;
 
+// 工具调用回调（流式响应中某个工具调用的参数接收完整时调用）
+using ToolCallCallback = std::function<void(const ChatMessage::ToolCall& call)>;
+
 // LLM提供商抽象基类
 class LLMProvider {
 public:
@@ -178,6 +200,33 @@ public:
                            const std::vector<ToolDefinition>& tools,
                            StreamCallback callback) = 0;
 
+    // 发送消息（带版本的工具Schema，版本不变时复用已序列化的工具块）
+    virtual LLMResponse chat(const std::vector<ChatMessage>& messages,
+                            const ToolSchema& schema) {
+        return chat(messages, schema.tools);
+    }
+
+    // 流式响应（带版本的工具Schema）
+    virtual bool chatStream(const std::vector<ChatMessage>& messages,
+                           const ToolSchema& schema,
+                           StreamCallback callback) {
+        return chatStream(messages, schema.tools, callback);
+    }
+
+    // 发送消息，每个工具调用的参数接收完整后立即回调（响应可能仍在到达）
+    // 默认实现：等待完整响应后按顺序回调
+    virtual LLMResponse chatWithToolCallbacks(const std::vector<ChatMessage>& messages,
+                                              const ToolSchema& schema,
+                                              ToolCallCallback onToolCall) {
+        LLMResponse response = chat(messages, schema);
+        if (response.success && onToolCall) {
+            for (const auto& call : response.tool_calls) {
+                onToolCall(call);
+            }
+        }
+        return response;
+    }
+
     // 获取模型名称
     virtual std::string getModelName() const = 0;
 
@@ -192,10 +241,60 @@ public:
     }
 
     // 设置最大token数
-    void setMaxTokens(int maxTokens) {
+    virtual void setMaxTokens(int maxTokens) {
         max_tokens_ = maxTokens;
     }
 
+    // 设置采样温度（未设置时使用提供商默认值）
+    virtual void setTemperature(double temperature) {
+        temperature_ = temperature;
+    }
+
+    // 获取采样温度
+    virtual std::optional<double> getTemperature() const {
+        return temperature_;
+    }
+
+    // 开始新会话：丢弃已缓存的消息序列化结果
+    virtual void resetConversation() {
+        request_serializer_.reset();
+    }
+
+    // 声明下一次请求的消息修订号：同一修订号内消息列表只在末尾追加，
+    // 序列化时已发送的前缀不再逐条比对（0表示未知）
+    virtual void setConversationRevision(uint64_t revision) {
+        request_serializer_.setRevision(revision);
+    }
+
+    // 中止正在进行的请求（被中止的调用返回失败响应）
+    virtual void cancel() {
+        http_client_.cancel();
+    }
+
+    // 启用/禁用提供商侧Prompt缓存（在系统提示、工具块和稳定历史前缀上放置缓存断点）
+    virtual void setPromptCaching(bool enabled) {
+        if (prompt_caching_.exchange(enabled) == enabled) {
+            return;
+        }
+        // 已序列化的工具块和消息可能带有（或缺少）缓存标记，全部作废
+        {
+            std::lock_guard<std::mutex> lock(tools_cache_mutex_);
+            tools_cache_version_ = 0;
+            tools_cache_.reset();
+        }
+        request_serializer_.reset();
+    }
+
+    // 是否启用Prompt缓存
+    virtual bool isPromptCachingEnabled() const {
+        return prompt_caching_.load();
+    }
+
+    // 获取上次请求体构建的统计
+    RequestSerializer::Stats getSerializerStats() const {
+        return request_serializer_.getStats();
+    }
+
     // 获取API密钥
     std::string getApiKey() const { return api_key_; }
 
@@ -207,9 +306,44 @@ protected:
     std::string base_url_;
     std::string model_;
     int max_tokens_ = 4096;
+    std::optional<double> temperature_;
 
     // HTTP客户端
     HttpClient http_client_;
+
+    // 获取工具块的序列化JSON，按Schema版本缓存（version为0时每次重新转换）
+    std::shared_ptr<const std::string> serializeTools(
+            const std::vector<ToolDefinition>& tools, uint64_t version,
+            const std::function<json(const ToolDefinition&)>& convert) const {
+        std::lock_guard<std::mutex> lock(tools_cache_mutex_);
+        if (version != 0 && version == tools_cache_version_ && tools_cache_) {
+            return tools_cache_;
+        }
+
+        json toolsArray = json::array();
+        for (const auto& tool : tools) {
+            toolsArray.push_back(convert(tool));
+        }
+        auto serialized = std::make_shared<const std::string>(toolsArray.dump());
+
+        if (version != 0) {
+            tools_cache_version_ = version;
+            tools_cache_ = serialized;
+        }
+        return serialized;
+    }
+
+    // 增量请求体序列化器（一个提供商实例对应一个会话）
+    mutable RequestSerializer request_serializer_;
+
+    // 是否启用Prompt缓存
+    std::atomic<bool> prompt_caching_{false};
+
+private:
+    // 工具块序列化缓存
+    mutable std::mutex tools_cache_mutex_;
+    mutable uint64_t tools_cache_version_ = 0;
+    mutable std::shared_ptr<const std::string> tools_cache_;
 };
 
 // 提供商工厂
@@ -24,11 +24,34 @@ OpenAIProvider::OpenAIProvider(const std::string& apiKey,
 
 LLMResponse OpenAIProvider::chat(const std::vector<ChatMessage>& messages,
                                  const std::vector<ToolDefinition>& tools) {
+    return sendChat(messages, tools, 0);
+}
+
+LLMResponse OpenAIProvider::chat(const std::vector<ChatMessage>& messages,
+                                 const ToolSchema& schema) {
+    return sendChat(messages, schema.tools, schema.version);
+}
+
+bool OpenAIProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                const std::vector<ToolDefinition>& tools,
+                                StreamCallback callback) {
+    return sendChatStream(messages, tools, 0, callback);
+}
+
+bool OpenAIProvider::chatStream(const std::vector<ChatMessage>& messages,
+                                const ToolSchema& schema,
+                                StreamCallback callback) {
+    return sendChatStream(messages, schema.tools, schema.version, callback);
+}
+
+LLMResponse OpenAIProvider::sendChat(const std::vector<ChatMessage>& messages,
+                                     const std::vector<ToolDefinition>& tools,
+                                     uint64_t toolsVersion) {
     LLMResponse response;
 
     try {
         // 构建请求体
-        json requestBody = buildRequestBody(messages, tools);
+        std::string requestBody = buildRequestBody(messages, tools, toolsVersion);
 
         // 发送请求
         std::string url = base_url_ + "/chat/completions";
@@ -37,9 +60,9 @@ LLMResponse OpenAIProvider::chat(const std::vector<ChatMessage>& messages,
 
         // Debug logging
         Logger::getInstance().debug("Sending request to: " + url, "openai_provider.cpp", __LINE__);
-        Logger::getInstance().debug("Request body: " + requestBody.dump(), "openai_provider.cpp", __LINE__);
+        Logger::getInstance().debug("Request body: " + requestBody, "openai_provider.cpp", __LINE__);
 
-        HttpResponse httpResponse = http_client_.postJson(url, requestBody, headers);
+        HttpResponse httpResponse = http_client_.post(url, std::move(requestBody), headers);
 
         Logger::getInstance().debug("Response status: " + std::to_string(httpResponse.status_code), "openai_provider.cpp", __LINE__);
         Logger::getInstance().debug("Response body: " + httpResponse.body, "openai_provider.cpp", __LINE__);
@@ -78,20 +101,20 @@ LLMResponse OpenAIProvider::chat(const std::vector<ChatMessage>& messages,
     return response;
 }
 
-bool OpenAIProvider::chatStream(const std::vector<ChatMessage>& messages,
-                                const std::vector<ToolDefinition>& tools,
-                                StreamCallback callback) {
+bool OpenAIProvider::sendChatStream(const std::vector<ChatMessage>& messages,
+                                    const std::vector<ToolDefinition>& tools,
+                                    uint64_t toolsVersion,
+                                    StreamCallback callback) {
     try {
         // 构建请求体
-        json requestBody = buildRequestBody(messages, tools);
-        requestBody["stream"] = true;
+        std::string requestBody = buildRequestBody(messages, tools, toolsVersion, true);
 
         // 发送流式请求
         std::string url = base_url_ + "/chat/completions";
         std::map<std::string, std::string> headers;
         headers["Authorization"] = "Bearer " + api_key_;
 
-        return http_client_.postStream(url, requestBody, headers, callback);
+        return http_client_.postStream(url, std::move(requestBody), headers, callback);
 
     } catch (const std::exception& e) {
         callback("error: " + std::string(e.what()));
@@ -99,30 +122,32 @@ bool OpenAIProvider::chatStream(const std::vector<ChatMessage>& messages,
     }
 }
 
-json OpenAIProvider::buildRequestBody(const std::vector<ChatMessage>& messages,
-                                      const std::vector<ToolDefinition>& tools) const {
+std::string OpenAIProvider::buildRequestBody(const std::vector<ChatMessage>& messages,
+                                             const std::vector<ToolDefinition>& tools,
+                                             uint64_t toolsVersion,
+                                             bool stream) const {
     json request;
 
     request["model"] = model_;
     request["max_tokens"] = max_tokens_;
-
-    // 转换消息
-    json convertedMessages = json::array();
-    for (const auto& msg : messages) {
-        convertedMessages.push_back(convertMessage(msg));
+    if (temperature_) {
+        request["temperature"] = *temperature_;
+    }
+    if (stream) {
+        request["stream"] = true;
     }
-    request["messages"] = convertedMessages;
 
-    // 添加工具定义
+    // 添加工具定义（同一版本的工具块只转换和序列化一次）
+    std::vector<RequestSerializer::RawField> rawFields;
     if (!tools.empty()) {
-        json toolsArray = json::array();
-        for (const auto& tool : tools) {
-            toolsArray.push_back(convertTool(tool));
-        }
-        request["tools"] = toolsArray;
+        rawFields.emplace_back("tools", serializeTools(tools, toolsVersion,
+            [this](const ToolDefinition& tool) { return convertTool(tool); }));
     }
 
-    return request;
+    // 消息增量序列化：已发送过的消息直接复用缓存的字节
+    // OpenAI自动缓存公共前缀，无需显式断点
+    return request_serializer_.build(request, messages,
+        [this](const ChatMessage& msg, bool) { return convertMessage(msg); }, rawFields);
 }
 
 json OpenAIProvider::convertMessage(const ChatMessage& msg) const {
@@ -242,6 +267,10 @@ LLMResponse OpenAIProvider::parseResponse(const std::string& body) const {
             auto usage = jsonResponse["usage"];
             response.input_tokens = usage.value("prompt_tokens", 0);
             response.output_tokens = usage.value("completion_tokens", 0);
+            if (usage.contains("prompt_tokens_details") && usage["prompt_tokens_details"].is_object()) {
+                response.cache_read_input_tokens =
+                    usage["prompt_tokens_details"].value("cached_tokens", 0);
+            }
         }
 
     } catch (const std::exception& e) {
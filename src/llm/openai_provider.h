@@ -24,6 +24,15 @@ public:
                    const std::vector<ToolDefinition>& tools,
                    StreamCallback callback) override;
 
+    // 发送消息（带版本的工具Schema）
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                    const ToolSchema& schema) override;
+
+    // 流式响应（带版本的工具Schema）
+    bool chatStream(const std::vector<ChatMessage>& messages,
+                   const ToolSchema& schema,
+                   StreamCallback callback) override;
+
     // 获取模型名称
     std::string getModelName() const override { return model_; }
 
@@ -31,9 +40,22 @@ public:
     void setModel(const std::string& model) override { model_ = model; }
 
 private:
-    // 构建请求体
-    json buildRequestBody(const std::vector<ChatMessage>& messages,
-                         const std::vector<ToolDefinition>& tools) const;
+    // 发送请求（toolsVersion为工具Schema版本，0表示不缓存工具块）
+    LLMResponse sendChat(const std::vector<ChatMessage>& messages,
+                        const std::vector<ToolDefinition>& tools,
+                        uint64_t toolsVersion);
+
+    // 发送流式请求
+    bool sendChatStream(const std::vector<ChatMessage>& messages,
+                       const std::vector<ToolDefinition>& tools,
+                       uint64_t toolsVersion,
+                       StreamCallback callback);
+
+    // 构建请求体（工具块使用缓存的序列化片段拼接）
+    std::string buildRequestBody(const std::vector<ChatMessage>& messages,
+                                const std::vector<ToolDefinition>& tools,
+                                uint64_t toolsVersion,
+                                bool stream = false) const;
 
     // 转换消息格式（RoboClaw -> OpenAI）
     json convertMessage(const ChatMessage& msg) const;
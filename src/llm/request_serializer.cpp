@@ -0,0 +1,167 @@
+// RequestSerializer实现
+
+#include "request_serializer.h"
+#include "llm_provider.h"
+#include <algorithm>
+#include <utility>
+
+namespace roboclaw {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+void hashBytes(uint64_t& hash, const std::string& data) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+    // 写入长度作为分隔，避免字段拼接产生歧义
+    uint64_t length = data.size();
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (length >> (i * 8)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+}
+
+} // namespace
+
+std::string RequestSerializer::build(const json& fields,
+                                     const std::vector<ChatMessage>& messages,
+                                     const Converter& convert,
+                                     const std::vector<RawField>& rawFields,
+                                     bool cacheBreakpoints) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stats_ = Stats{};
+
+    // 同一修订号内只追加，已缓存的前缀无需重新计算指纹
+    uint64_t revision = std::exchange(revision_, 0);
+    size_t trusted = 0;
+    if (revision != 0 && revision == built_revision_) {
+        trusted = std::min(entries_.size(), messages.size());
+    }
+    built_revision_ = revision;
+
+    // 与缓存一致的前缀（即上次请求已发送的部分）
+    std::vector<uint64_t> fingerprints;
+    fingerprints.reserve(messages.size());
+    for (size_t i = 0; i < trusted; ++i) {
+        fingerprints.push_back(entries_[i].fingerprint);
+    }
+    size_t prefix = trusted;
+    for (size_t i = trusted; i < messages.size(); ++i) {
+        fingerprints.push_back(fingerprint(messages[i]));
+        if (prefix == i && prefix < entries_.size() && entries_[prefix].fingerprint == fingerprints.back()) {
+            ++prefix;
+        }
+    }
+    entries_.resize(prefix);
+    stats_.prefix = prefix;
+
+    // 断点：最后一条消息，以及稳定前缀的末尾（保证能命中上次写入的缓存）
+    auto isBreakpoint = [&](size_t i) {
+        return cacheBreakpoints && (i + 1 == messages.size() || i + 1 == prefix);
+    };
+
+    // 复用一致的前缀，断点变化或新增的消息重新编码
+    size_t messagesBytes = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        bool breakpoint = isBreakpoint(i);
+        if (i < prefix && entries_[i].breakpoint == breakpoint) {
+            ++stats_.reused;
+        } else {
+            Entry entry{fingerprints[i], breakpoint, convert(messages[i], breakpoint).dump()};
+            if (i < prefix) {
+                entries_[i] = std::move(entry);
+            } else {
+                entries_.push_back(std::move(entry));
+            }
+            ++stats_.encoded;
+        }
+        messagesBytes += entries_[i].bytes.size() + 1;
+    }
+
+    std::string head = fields.dump();
+
+    // 一次分配足够的空间
+    size_t capacity = head.size() + messagesBytes + 16;
+    for (const auto& field : rawFields) {
+        if (field.second) {
+            capacity += field.first.size() + field.second->size() + 4;
+        }
+    }
+
+    std::string body;
+    body.reserve(capacity);
+
+    // 普通字段（去掉结尾的 '}'，后续继续追加）
+    body.append(head, 0, head.empty() ? 0 : head.size() - 1);
+    if (body.empty()) {
+        body += '{';
+    }
+    bool first = body.size() == 1;
+
+    body += first ? "\"messages\":[" : ",\"messages\":[";
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (i > 0) {
+            body += ',';
+        }
+        body += entries_[i].bytes;
+    }
+    body += ']';
+
+    for (const auto& field : rawFields) {
+        if (!field.second) {
+            continue;
+        }
+        body += ",\"";
+        body += field.first;
+        body += "\":";
+        body += *field.second;
+    }
+    body += '}';
+
+    stats_.bytes = body.size();
+    return body;
+}
+
+void RequestSerializer::setRevision(uint64_t revision) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    revision_ = revision;
+}
+
+void RequestSerializer::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    revision_ = 0;
+    built_revision_ = 0;
+    stats_ = Stats{};
+}
+
+RequestSerializer::Stats RequestSerializer::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+uint64_t RequestSerializer::fingerprint(const ChatMessage& msg) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    hash ^= static_cast<uint64_t>(msg.role) + 1;
+    hash *= FNV_PRIME;
+    hash ^= msg.is_error ? 1 : 0;
+    hash *= FNV_PRIME;
+
+    hashBytes(hash, msg.content);
+    hashBytes(hash, msg.tool_call_id);
+    for (const auto& call : msg.tool_calls) {
+        hashBytes(hash, call.id);
+        hashBytes(hash, call.name);
+        hashBytes(hash, call.arguments.dump());
+    }
+
+    return hash;
+}
+
+} // namespace roboclaw
@@ -0,0 +1,92 @@
+// 增量请求体序列化器 - RequestSerializer
+// 缓存已发送消息的序列化结果，多轮对话中只编码新增消息
+
+#ifndef ROBOCLAW_LLM_REQUEST_SERIALIZER_H
+#define ROBOCLAW_LLM_REQUEST_SERIALIZER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace roboclaw {
+
+struct ChatMessage;
+
+// 请求体序列化器（每个会话一个实例）
+//
+// 每条消息按内容指纹缓存其序列化后的JSON字节。构建请求体时从头比对，
+// 与缓存一致的前缀直接复用，从第一条不一致的消息开始重新编码（例如压缩
+// 改写了历史），之后的缓存随之丢弃。请求体按预估大小一次分配后返回，
+// 调用方可将其移动给HttpClient发送，不再复制。
+//
+// 启用缓存断点时，自动在最后一条消息和上次请求的末尾（稳定前缀的边界）
+// 标记断点，供提供商生成prompt缓存标记。断点移动时只重新编码受影响的消息。
+//
+// 调用方可以用修订号声明消息列表只在末尾追加：修订号与缓存所属的修订号
+// 相同时，已缓存的前缀不再逐条计算指纹比对，只处理新增的消息。
+class RequestSerializer {
+public:
+    // 消息转换函数（RoboClaw -> 提供商格式），breakpoint表示该消息是缓存断点
+    using Converter = std::function<json(const ChatMessage& msg, bool breakpoint)>;
+
+    // 已序列化的原始JSON字段（如缓存的工具块）
+    using RawField = std::pair<std::string, std::shared_ptr<const std::string>>;
+
+    // 构建统计
+    struct Stats {
+        size_t reused = 0;    // 上次构建复用的消息数
+        size_t encoded = 0;   // 上次构建重新编码的消息数
+        size_t bytes = 0;     // 上次构建的请求体大小
+        size_t prefix = 0;    // 与上次请求一致的稳定前缀消息数
+    };
+
+    RequestSerializer() = default;
+
+    // 构建请求体
+    // fields: 普通字段（model、max_tokens等），messages: 完整消息列表
+    // rawFields: 已序列化的字段，原样拼接
+    // cacheBreakpoints: 是否自动放置缓存断点
+    std::string build(const json& fields,
+                      const std::vector<ChatMessage>& messages,
+                      const Converter& convert,
+                      const std::vector<RawField>& rawFields = {},
+                      bool cacheBreakpoints = false);
+
+    // 设置下一次构建的修订号（0表示未知）。同一修订号内消息列表只在末尾追加，
+    // 修订号只对下一次构建有效
+    void setRevision(uint64_t revision);
+
+    // 清空缓存（开始新会话时调用）
+    void reset();
+
+    // 获取上次构建的统计
+    Stats getStats() const;
+
+    // 计算消息指纹
+    static uint64_t fingerprint(const ChatMessage& msg);
+
+private:
+    struct Entry {
+        uint64_t fingerprint;
+        bool breakpoint;
+        std::string bytes;
+    };
+
+    std::vector<Entry> entries_;
+    uint64_t revision_ = 0;        // 下一次构建的修订号
+    uint64_t built_revision_ = 0;  // entries_所属的修订号
+    Stats stats_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_LLM_REQUEST_SERIALIZER_H
@@ -0,0 +1,461 @@
+// ResponseCache实现
+
+#include "response_cache.h"
+#include "../utils/atomic_file.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace roboclaw {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t fnv1a(const std::string& data, uint64_t hash = FNV_OFFSET_BASIS) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// 两路独立的64位哈希拼成128位十六进制键
+std::string hashKey(const std::string& canonical) {
+    uint64_t high = fnv1a(canonical);
+    uint64_t low = fnv1a(canonical, high ^ 0x9E3779B97F4A7C15ULL);
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0') << std::setw(16) << high << std::setw(16) << low;
+    return oss.str();
+}
+
+json messageToCanonical(const ChatMessage& msg) {
+    json j = msg.toJson();
+    if (msg.is_error) {
+        j["is_error"] = true;
+    }
+    return j;
+}
+
+// 拆分UTF-8字符（ASCII字母转小写，连续空白合并为一个空格）
+std::vector<std::string> splitCharacters(const std::string& text) {
+    std::vector<std::string> chars;
+    bool lastSpace = true;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        size_t len = 1;
+        if (c >= 0xF0) len = 4;
+        else if (c >= 0xE0) len = 3;
+        else if (c >= 0xC0) len = 2;
+        len = std::min(len, text.size() - i);
+
+        if (len == 1 && std::isspace(c)) {
+            if (!lastSpace) {
+                chars.emplace_back(" ");
+                lastSpace = true;
+            }
+        } else if (len == 1 && std::ispunct(c)) {
+            // 标点不参与相似度
+        } else {
+            chars.push_back(len == 1 ? std::string(1, static_cast<char>(std::tolower(c)))
+                                     : text.substr(i, len));
+            lastSpace = false;
+        }
+        i += len;
+    }
+    return chars;
+}
+
+// 提取文本中的数字序列（数字不同的问题不视为相似）
+std::vector<std::string> extractNumbers(const std::string& text) {
+    std::vector<std::string> numbers;
+    std::string current;
+    for (char c : text) {
+        if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && !current.empty())) {
+            current += c;
+        } else if (!current.empty()) {
+            numbers.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        numbers.push_back(current);
+    }
+    return numbers;
+}
+
+double cosine(const std::vector<float>& a, const std::vector<float>& b) {
+    if (a.size() != b.size()) {
+        return 0.0;
+    }
+    double dot = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        dot += static_cast<double>(a[i]) * b[i];
+    }
+    return dot;  // 向量已归一化
+}
+
+json responseToJson(const LLMResponse& response) {
+    json calls = json::array();
+    for (const auto& call : response.tool_calls) {
+        calls.push_back({{"id", call.id}, {"name", call.name}, {"arguments", call.arguments}});
+    }
+    return {
+        {"content", response.content},
+        {"tool_calls", calls},
+        {"input_tokens", response.input_tokens},
+        {"output_tokens", response.output_tokens}
+    };
+}
+
+LLMResponse responseFromJson(const json& j) {
+    LLMResponse response;
+    response.success = true;
+    response.content = j.value("content", "");
+    response.input_tokens = j.value("input_tokens", 0);
+    response.output_tokens = j.value("output_tokens", 0);
+    for (const auto& callJson : j.value("tool_calls", json::array())) {
+        ChatMessage::ToolCall call;
+        call.id = callJson.value("id", "");
+        call.name = callJson.value("name", "");
+        call.arguments = callJson.value("arguments", json::object());
+        response.tool_calls.push_back(call);
+    }
+    return response;
+}
+
+// 命中时返回的响应：标记来源，不计token用量
+LLMResponse asCacheHit(LLMResponse response) {
+    response.from_cache = true;
+    response.input_tokens = 0;
+    response.output_tokens = 0;
+    response.cache_creation_input_tokens = 0;
+    response.cache_read_input_tokens = 0;
+    return response;
+}
+
+} // namespace
+
+ResponseCache::ResponseCache(const ResponseCacheConfig& config)
+    : config_(config) {
+    if (!config_.disk_dir.empty()) {
+        std::error_code ec;
+        fs::create_directories(config_.disk_dir, ec);
+        if (ec) {
+            LOG_WARNING("无法创建响应缓存目录 " + config_.disk_dir + ": " + ec.message());
+            config_.disk_dir.clear();
+        }
+    }
+}
+
+ResponseCacheKey ResponseCache::makeKey(const std::string& model,
+                                        std::optional<double> temperature,
+                                        int maxTokens,
+                                        const std::vector<ChatMessage>& messages,
+                                        const std::vector<ToolDefinition>& tools) {
+    ResponseCacheKey key;
+    key.deterministic = temperature.has_value() && *temperature == 0.0;
+
+    // json对象的键有序，dump()即为规范形式
+    json canonical;
+    canonical["model"] = model;
+    canonical["temperature"] = temperature ? json(*temperature) : json(nullptr);
+    canonical["max_tokens"] = maxTokens;
+
+    json toolsJson = json::array();
+    for (const auto& tool : tools) {
+        toolsJson.push_back(tool.toJson());
+    }
+    canonical["tools"] = std::move(toolsJson);
+
+    json messagesJson = json::array();
+    for (const auto& msg : messages) {
+        messagesJson.push_back(messageToCanonical(msg));
+    }
+
+    // 上下文键：去掉最后一条用户消息的内容
+    if (!messages.empty() && messages.back().role == MessageRole::USER) {
+        key.query = messages.back().content;
+        json context = canonical;
+        json contextMessages = messagesJson;
+        contextMessages.back()["content"] = nullptr;
+        context["messages"] = std::move(contextMessages);
+        key.context = hashKey(context.dump());
+    }
+
+    canonical["messages"] = std::move(messagesJson);
+    key.exact = hashKey(canonical.dump());
+    return key;
+}
+
+bool ResponseCache::isCacheable(const ResponseCacheKey& key) const {
+    return key.deterministic || config_.cache_nondeterministic;
+}
+
+std::optional<LLMResponse> ResponseCache::lookup(const ResponseCacheKey& key) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!isCacheable(key)) {
+        ++stats_.bypassed;
+        return std::nullopt;
+    }
+    ++stats_.lookups;
+    auto now = std::chrono::system_clock::now();
+
+    // 内存精确层
+    auto it = index_.find(key.exact);
+    if (it != index_.end()) {
+        if (!expired(*it->second, now)) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            ++stats_.memory_hits;
+            return asCacheHit(it->second->response);
+        }
+        entries_.erase(it->second);
+        index_.erase(it);
+        ++stats_.expirations;
+    }
+
+    // 磁盘精确层
+    if (!config_.disk_dir.empty()) {
+        lock.unlock();
+        auto entry = loadFromDisk(key);
+        lock.lock();
+        if (entry) {
+            ++stats_.disk_hits;
+            LLMResponse response = entry->response;
+            insertLocked(std::move(*entry));
+            return asCacheHit(std::move(response));
+        }
+    }
+
+    // 相似度层
+    if (config_.enable_similarity) {
+        auto similar = findSimilarLocked(key, now);
+        if (similar) {
+            ++stats_.similar_hits;
+            return asCacheHit(std::move(*similar));
+        }
+    }
+
+    ++stats_.misses;
+    return std::nullopt;
+}
+
+void ResponseCache::store(const ResponseCacheKey& key, const LLMResponse& response) {
+    if (!response.success || response.from_cache || !isCacheable(key)) {
+        return;
+    }
+    if (response.content.empty() && response.tool_calls.empty()) {
+        return;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.response.success = true;
+    entry.response.content = response.content;
+    entry.response.tool_calls = response.tool_calls;
+    entry.response.input_tokens = response.input_tokens;
+    entry.response.output_tokens = response.output_tokens;
+    entry.expires_at = config_.ttl.count() > 0
+        ? std::chrono::system_clock::now() + config_.ttl
+        : std::chrono::system_clock::time_point::max();
+    if (config_.enable_similarity && !key.context.empty()) {
+        entry.embedding = embed(key.query, config_.embedding_dim);
+    }
+
+    if (!config_.disk_dir.empty()) {
+        saveToDisk(entry);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.stores;
+    insertLocked(std::move(entry));
+}
+
+void ResponseCache::insertLocked(Entry entry) {
+    auto it = index_.find(entry.key.exact);
+    if (it != index_.end()) {
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    if (entry.embedding.empty() && config_.enable_similarity && !entry.key.context.empty()) {
+        entry.embedding = embed(entry.key.query, config_.embedding_dim);
+    }
+
+    std::string exact = entry.key.exact;
+    entries_.push_front(std::move(entry));
+    index_[exact] = entries_.begin();
+
+    while (entries_.size() > std::max<size_t>(config_.max_entries, 1)) {
+        index_.erase(entries_.back().key.exact);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+bool ResponseCache::expired(const Entry& entry, std::chrono::system_clock::time_point now) const {
+    return now >= entry.expires_at;
+}
+
+std::optional<LLMResponse> ResponseCache::findSimilarLocked(const ResponseCacheKey& key,
+                                                            std::chrono::system_clock::time_point now) {
+    if (key.context.empty() || key.query.empty()) {
+        return std::nullopt;
+    }
+
+    auto query = embed(key.query, config_.embedding_dim);
+    auto numbers = extractNumbers(key.query);
+
+    EntryList::iterator best = entries_.end();
+    double bestScore = config_.similarity_threshold;
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        const Entry& entry = *it;
+        if (entry.key.context != key.context || entry.embedding.empty() ||
+            !entry.response.tool_calls.empty() || expired(entry, now)) {
+            continue;
+        }
+        if (extractNumbers(entry.key.query) != numbers) {
+            continue;
+        }
+        double score = cosine(query, entry.embedding);
+        if (score >= bestScore) {
+            bestScore = score;
+            best = it;
+        }
+    }
+
+    if (best == entries_.end()) {
+        return std::nullopt;
+    }
+    entries_.splice(entries_.begin(), entries_, best);
+    return best->response;
+}
+
+std::vector<float> ResponseCache::embed(const std::string& text, size_t dim) {
+    std::vector<float> vec(std::max<size_t>(dim, 1), 0.0f);
+    auto chars = splitCharacters(text);
+
+    // 字符二元组和三元组的带符号特征哈希
+    for (size_t n = 2; n <= 3; ++n) {
+        if (chars.size() < n) {
+            continue;
+        }
+        for (size_t i = 0; i + n <= chars.size(); ++i) {
+            std::string gram;
+            for (size_t k = 0; k < n; ++k) {
+                gram += chars[i + k];
+            }
+            uint64_t hash = fnv1a(gram, FNV_OFFSET_BASIS + n);
+            vec[hash % vec.size()] += (hash >> 63) ? 1.0f : -1.0f;
+        }
+    }
+    // 极短文本（单个字符）退化为一元特征
+    if (chars.size() == 1) {
+        uint64_t hash = fnv1a(chars[0]);
+        vec[hash % vec.size()] += 1.0f;
+    }
+
+    double norm = 0.0;
+    for (float v : vec) {
+        norm += static_cast<double>(v) * v;
+    }
+    if (norm > 0.0) {
+        float inv = static_cast<float>(1.0 / std::sqrt(norm));
+        for (float& v : vec) {
+            v *= inv;
+        }
+    }
+    return vec;
+}
+
+std::string ResponseCache::diskPath(const std::string& exactKey) const {
+    return (fs::path(config_.disk_dir) / (exactKey + ".json")).string();
+}
+
+std::optional<ResponseCache::Entry> ResponseCache::loadFromDisk(const ResponseCacheKey& key) {
+    std::string path = diskPath(key.exact);
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    try {
+        json j = json::parse(file);
+        if (j.value("key", "") != key.exact) {
+            return std::nullopt;
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.response = responseFromJson(j.at("response"));
+        int64_t expiresAt = j.value("expires_at", static_cast<int64_t>(0));
+        entry.expires_at = expiresAt > 0
+            ? std::chrono::system_clock::time_point(std::chrono::seconds(expiresAt))
+            : std::chrono::system_clock::time_point::max();
+
+        if (expired(entry, std::chrono::system_clock::now())) {
+            file.close();
+            std::error_code ec;
+            fs::remove(path, ec);
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.expirations;
+            return std::nullopt;
+        }
+        return entry;
+    } catch (const std::exception& e) {
+        LOG_WARNING("响应缓存文件损坏，已忽略: " + path + " (" + e.what() + ")");
+        return std::nullopt;
+    }
+}
+
+void ResponseCache::saveToDisk(const Entry& entry) const {
+    int64_t expiresAt = 0;
+    if (entry.expires_at != std::chrono::system_clock::time_point::max()) {
+        expiresAt = std::chrono::duration_cast<std::chrono::seconds>(
+            entry.expires_at.time_since_epoch()).count();
+    }
+    json j = {
+        {"key", entry.key.exact},
+        {"expires_at", expiresAt},
+        {"response", responseToJson(entry.response)}
+    };
+
+    // 先写唯一命名的临时文件再重命名：进程中断不会留下半个条目，
+    // 多个进程共享缓存目录、同时写入同一条目时也不会互相覆盖临时文件。
+    // 缓存可以重建，不需要fsync
+    std::string path = diskPath(entry.key.exact);
+    std::string error;
+    if (!writeFileAtomic(path, j.dump(), error, false)) {
+        LOG_WARNING("无法写入响应缓存: " + path + " (" + error + ")");
+    }
+}
+
+void ResponseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+
+    if (!config_.disk_dir.empty()) {
+        std::error_code ec;
+        for (const auto& file : fs::directory_iterator(config_.disk_dir, ec)) {
+            if (file.path().extension() == ".json") {
+                fs::remove(file.path(), ec);
+            }
+        }
+    }
+}
+
+ResponseCacheStats ResponseCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace roboclaw
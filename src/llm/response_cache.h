@@ -0,0 +1,132 @@
+// 响应缓存 - ResponseCache
+// 对重复的LLM请求直接返回之前的响应：精确匹配（内存LRU + 可选磁盘持久化）和可选的相似度匹配
+
+#ifndef ROBOCLAW_LLM_RESPONSE_CACHE_H
+#define ROBOCLAW_LLM_RESPONSE_CACHE_H
+
+#include "llm_provider.h"
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace roboclaw {
+
+// 响应缓存配置
+struct ResponseCacheConfig {
+    size_t max_entries = 256;                  // 内存LRU容量
+    std::chrono::seconds ttl{86400};           // 条目有效期（0表示永不过期）
+    bool cache_nondeterministic = false;       // 是否缓存非零温度（或未设置温度）的请求
+    std::string disk_dir;                      // 磁盘持久化目录（为空时不持久化）
+
+    bool enable_similarity = false;            // 是否启用相似度匹配
+    double similarity_threshold = 0.92;        // 余弦相似度阈值
+    size_t embedding_dim = 256;                // 本地嵌入向量维度
+};
+
+// 响应缓存统计
+struct ResponseCacheStats {
+    uint64_t lookups = 0;        // 可缓存请求的查询次数
+    uint64_t memory_hits = 0;    // 内存精确命中
+    uint64_t disk_hits = 0;      // 磁盘精确命中
+    uint64_t similar_hits = 0;   // 相似度命中
+    uint64_t misses = 0;         // 未命中
+    uint64_t bypassed = 0;       // 非确定性请求，未查询缓存
+    uint64_t stores = 0;         // 写入条目数
+    uint64_t evictions = 0;      // LRU淘汰数
+    uint64_t expirations = 0;    // 过期丢弃数
+
+    uint64_t hits() const { return memory_hits + disk_hits + similar_hits; }
+
+    double hitRate() const {
+        return lookups == 0 ? 0.0 : static_cast<double>(hits()) / lookups;
+    }
+};
+
+// 缓存请求键
+struct ResponseCacheKey {
+    std::string exact;       // 模型、消息、工具、温度等的规范化哈希
+    std::string context;     // 除最后一条用户消息外的规范化哈希（相似度匹配的分组）
+    std::string query;       // 最后一条用户消息内容（相似度匹配的文本）
+    bool deterministic = false;
+};
+
+// 响应缓存
+//
+// 精确层以请求的规范化JSON（对象键有序）的128位哈希为键，只缓存成功响应。
+// 默认只缓存温度为0的确定性请求，相同请求不会重复付费。
+// 相似度层只在上下文（系统提示、历史、工具、模型、温度）完全一致时，比较最后一条
+// 用户消息的本地嵌入（字符n-gram特征哈希）；数字不同的问题不视为相似，带工具调用的
+// 响应也不通过相似度复用，避免对机器人重放不同的动作。
+class ResponseCache {
+public:
+    explicit ResponseCache(const ResponseCacheConfig& config = ResponseCacheConfig());
+
+    // 生成请求键
+    static ResponseCacheKey makeKey(const std::string& model,
+                                    std::optional<double> temperature,
+                                    int maxTokens,
+                                    const std::vector<ChatMessage>& messages,
+                                    const std::vector<ToolDefinition>& tools);
+
+    // 查询缓存（命中时返回的响应from_cache为true，token用量为0）
+    std::optional<LLMResponse> lookup(const ResponseCacheKey& key);
+
+    // 写入成功的响应
+    void store(const ResponseCacheKey& key, const LLMResponse& response);
+
+    // 该请求是否可缓存（确定性请求，或配置允许缓存非确定性请求）
+    bool isCacheable(const ResponseCacheKey& key) const;
+
+    // 清空内存和磁盘缓存
+    void clear();
+
+    // 获取统计
+    ResponseCacheStats getStats() const;
+
+    // 获取配置
+    const ResponseCacheConfig& getConfig() const { return config_; }
+
+    // 计算文本的本地嵌入向量（L2归一化）
+    static std::vector<float> embed(const std::string& text, size_t dim);
+
+private:
+    struct Entry {
+        ResponseCacheKey key;
+        LLMResponse response;
+        std::chrono::system_clock::time_point expires_at;
+        std::vector<float> embedding;  // 仅启用相似度匹配时计算
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // 插入内存层（调用方持有mutex_）
+    void insertLocked(Entry entry);
+
+    // 条目是否已过期
+    bool expired(const Entry& entry, std::chrono::system_clock::time_point now) const;
+
+    // 磁盘层
+    std::string diskPath(const std::string& exactKey) const;
+    std::optional<Entry> loadFromDisk(const ResponseCacheKey& key);
+    void saveToDisk(const Entry& entry) const;
+
+    // 相似度查找（调用方持有mutex_）
+    std::optional<LLMResponse> findSimilarLocked(const ResponseCacheKey& key,
+                                                 std::chrono::system_clock::time_point now);
+
+    ResponseCacheConfig config_;
+
+    mutable std::mutex mutex_;
+    EntryList entries_;                                            // 最近使用的在前
+    std::unordered_map<std::string, EntryList::iterator> index_;
+    ResponseCacheStats stats_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_LLM_RESPONSE_CACHE_H
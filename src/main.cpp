@@ -2,6 +2,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 
 // 引入自定义模块
 #include "utils/logger.h"
@@ -13,12 +16,18 @@
 #include "llm/llm_provider.h"
 #include "llm/anthropic_provider.h"
 #include "llm/openai_provider.h"
+#include "llm/cached_provider.h"
 #include "agent/agent.h"
 #include "agent/tool_executor.h"
+#include "tools/bash_tool.h"
+#include "utils/terminal.h"
 #include "session/session_manager.h"
 #include "skills/skill_registry.h"
 #include "skills/skill_executor.h"
 #include "optimization/token_optimizer.h"
+#include "optimization/bpe_tokenizer.h"
+#include "optimization/background_compressor.h"
+#include "optimization/conversation_compressor.h"
 #include "optimization/token_budget.h"
 #include "hal/hardware_config.h"
 
@@ -560,11 +569,38 @@ void startInteractiveMode(ConfigManager& config_mgr) {
         cerr << "无法创建LLM提供商" << endl;
         return;
     }
+    llmProvider->setPromptCaching(config.optimization.enable_prompt_caching);
+    if (config.default_config.temperature >= 0.0) {
+        llmProvider->setTemperature(config.default_config.temperature);
+    }
+
+    // 本地响应缓存（默认只缓存温度为0的确定性请求）
+    if (config.cache.enable_response_cache) {
+        ResponseCacheConfig cacheConfig;
+        cacheConfig.max_entries = static_cast<size_t>(std::max(config.cache.response_cache_size, 1));
+        cacheConfig.ttl = std::chrono::seconds(std::max(config.cache.response_cache_ttl, 0));
+        cacheConfig.disk_dir = config.cache.response_cache_dir;
+        cacheConfig.enable_similarity = config.cache.response_cache_similarity;
+        cacheConfig.similarity_threshold = config.cache.response_cache_threshold;
+        llmProvider = std::make_unique<CachedProvider>(
+            std::shared_ptr<LLMProvider>(std::move(llmProvider)),
+            std::make_shared<ResponseCache>(cacheConfig));
+        LOG_INFO("LLM响应缓存已启用");
+    }
 
     // 创建工具执行器
     auto toolExecutor = std::make_unique<ToolExecutor>();
     toolExecutor->initialize();
 
+    // bash命令运行时实时显示输出（灰色），并发的命令按行交错
+    if (auto bashTool = std::dynamic_pointer_cast<BashTool>(toolExecutor->getTool("bash"))) {
+        auto outputMutex = std::make_shared<std::mutex>();
+        bashTool->setOutputCallback([outputMutex](const std::string&, bool, std::string_view line) {
+            std::lock_guard<std::mutex> lock(*outputMutex);
+            cout << Color::GRAY << "  │ " << line << Color::RESET << "\n" << flush;
+        });
+    }
+
     // 创建Agent
     auto agent = std::make_shared<Agent>(std::move(llmProvider), std::move(toolExecutor));
 
@@ -572,9 +608,41 @@ void startInteractiveMode(ConfigManager& config_mgr) {
     std::shared_ptr<TokenOptimizer> tokenOptimizer;
     if (config.optimization.enable_compression) {
         tokenOptimizer = std::make_shared<TokenOptimizer>();
+        if (!config.optimization.tokenizer_vocab.empty()) {
+            auto tokenizer = std::make_shared<BpeTokenizer>();
+            if (tokenizer->loadFiles(config.optimization.tokenizer_vocab,
+                                     config.optimization.tokenizer_merges)) {
+                tokenizer->setThreadPool(std::make_shared<ThreadPool>());
+                tokenOptimizer->setTokenizer(tokenizer);
+                LOG_INFO("Token计数使用BPE分词器");
+            } else {
+                LOG_WARNING("BPE词表加载失败，使用启发式token估算");
+            }
+        }
         agent->setTokenOptimizer(tokenOptimizer);
         agent->enableTokenOptimization(true);
         LOG_INFO("Token优化已启用");
+
+        // 后台压缩：超过压缩阈值的75%时开始在后台生成早期对话摘要
+        if (config.optimization.background_compression) {
+            BackgroundCompressionConfig compressionConfig;
+            compressionConfig.soft_threshold = config.optimization.compression_threshold * 3 / 4;
+            auto compressor = std::make_shared<BackgroundCompressor>(
+                std::make_shared<ThreadPool>(1), tokenOptimizer, compressionConfig);
+
+            // 摘要使用独立的提供商实例，不与请求路径共享连接和序列化状态
+            if (auto summaryProvider = createLLMProvider(config_mgr)) {
+                summaryProvider->setMaxTokens(1024);
+                summaryProvider->setTemperature(0.0);
+                auto summarizer = std::make_shared<ConversationCompressor>();
+                summarizer->setLLMProvider(std::shared_ptr<LLMProvider>(std::move(summaryProvider)));
+                compressor->setSummarizer([summarizer](const std::vector<ChatMessage>& messages) {
+                    return summarizer->generateSummary(messages, 2000);
+                });
+            }
+            agent->setBackgroundCompressor(compressor);
+            LOG_INFO("后台对话压缩已启用");
+        }
     }
 
     // 创建Token预算管理
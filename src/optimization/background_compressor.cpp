@@ -0,0 +1,224 @@
+// BackgroundCompressor实现
+
+#include "background_compressor.h"
+#include "conversation_compressor.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+namespace roboclaw {
+
+namespace {
+
+constexpr int MAX_SUMMARY_LENGTH = 2000;
+
+} // namespace
+
+BackgroundCompressor::BackgroundCompressor(std::shared_ptr<ThreadPool> pool,
+                                           std::shared_ptr<TokenOptimizer> optimizer,
+                                           const BackgroundCompressionConfig& config)
+    : pool_(std::move(pool))
+    , optimizer_(std::move(optimizer))
+    , config_(config) {
+}
+
+BackgroundCompressor::~BackgroundCompressor() {
+    // 任务持有this，析构前必须等待其结束
+    reset();
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return !running_; });
+}
+
+void BackgroundCompressor::setSummarizer(Summarizer summarizer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    summarizer_ = std::move(summarizer);
+}
+
+size_t BackgroundCompressor::fingerprint(const ChatMessage& message) {
+    size_t hash = std::hash<std::string>{}(message.content);
+    hash ^= std::hash<std::string>{}(message.tool_call_id) + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    hash ^= static_cast<size_t>(message.role) * 31 + message.tool_calls.size();
+    return hash;
+}
+
+std::shared_ptr<const CompressionSnapshot> BackgroundCompressor::current(
+        const std::vector<ChatMessage>& history) const {
+    auto snapshot = snapshot_.load();
+
+    // 快照只在仍与历史对应时使用（历史被清空或改写后失效）
+    if (snapshot && (snapshot->epoch != epoch_.load() || snapshot->covered > history.size() ||
+                     snapshot->covered == 0 ||
+                     fingerprint(history[snapshot->covered - 1]) != snapshot->boundary_hash)) {
+        snapshot.reset();
+    }
+    return snapshot;
+}
+
+void BackgroundCompressor::observe(const std::vector<ChatMessage>& history,
+                                   std::shared_ptr<const CompressionSnapshot> base,
+                                   const std::vector<ChatMessage>& composed) {
+    if (optimizer_ && optimizer_->estimateTokens(composed) > config_.soft_threshold) {
+        schedule(history, std::move(base));
+    }
+}
+
+std::vector<ChatMessage> BackgroundCompressor::apply(const std::vector<ChatMessage>& history,
+                                                    size_t* summaryCount) {
+    auto snapshot = current(history);
+
+    std::vector<ChatMessage> messages;
+    size_t covered = 0;
+    if (snapshot) {
+        covered = snapshot->covered;
+        messages.reserve(snapshot->segments.size() + history.size() - covered);
+        for (const auto& segment : snapshot->segments) {
+            messages.push_back(segment.summary);
+        }
+    }
+    if (summaryCount) {
+        *summaryCount = messages.size();
+    }
+    messages.insert(messages.end(), history.begin() + covered, history.end());
+
+    observe(history, std::move(snapshot), messages);
+    return messages;
+}
+
+void BackgroundCompressor::schedule(const std::vector<ChatMessage>& history,
+                                    std::shared_ptr<const CompressionSnapshot> base) {
+    size_t begin = base ? base->covered : 0;
+    if (history.size() <= config_.keep_recent) {
+        return;
+    }
+    size_t end = history.size() - config_.keep_recent;
+
+    // 不拆开工具调用和工具结果：保留部分不能以工具结果开头
+    while (end < history.size() && history[end].role == MessageRole::TOOL) {
+        ++end;
+    }
+    if (end <= begin || end - begin < config_.min_segment_messages) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+        stats_.jobs_started++;
+    }
+
+    std::vector<ChatMessage> messages(history.begin() + begin, history.begin() + end);
+    uint64_t epoch = epoch_.load();
+    LOG_INFO("后台压缩: 摘要第 " + std::to_string(begin) + "-" + std::to_string(end) + " 条消息");
+
+    auto task = [this, messages = std::move(messages), begin, end, base = std::move(base), epoch]() mutable {
+        run(std::move(messages), begin, end, std::move(base), epoch);
+    };
+    if (pool_) {
+        pool_->submit(std::move(task));
+    } else {
+        std::thread(std::move(task)).detach();
+    }
+}
+
+void BackgroundCompressor::run(std::vector<ChatMessage> messages, size_t begin, size_t end,
+                               std::shared_ptr<const CompressionSnapshot> base, uint64_t epoch) {
+    size_t boundary = fingerprint(messages.back());
+    std::string summary = summarize(messages);
+
+    auto next = std::make_shared<CompressionSnapshot>();
+    if (base) {
+        next->segments = base->segments;
+    }
+    next->segments.push_back({begin, end, ChatMessage(MessageRole::SYSTEM, summary)});
+
+    // 段数超过上限时合并最早的两段（对摘要再做摘要）
+    while (next->segments.size() > std::max<size_t>(config_.max_segments, 1)) {
+        auto& first = next->segments[0];
+        auto& second = next->segments[1];
+        std::string merged = summarize({first.summary, second.summary});
+        SummarySegment combined{first.begin, second.end, ChatMessage(MessageRole::SYSTEM, merged)};
+        next->segments.erase(next->segments.begin(), next->segments.begin() + 2);
+        next->segments.insert(next->segments.begin(), std::move(combined));
+    }
+
+    next->epoch = epoch;
+    next->covered = end;
+    next->boundary_hash = boundary;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (epoch == epoch_.load()) {
+        auto current = snapshot_.load();
+        next->version = (current ? current->version : 0) + 1;
+        snapshot_.store(std::move(next));
+        stats_.jobs_completed++;
+        stats_.segments = snapshot_.load()->segments.size();
+        stats_.summarized_messages = end;
+        LOG_INFO("后台压缩完成: 已摘要 " + std::to_string(end) + " 条消息");
+    } else {
+        stats_.jobs_discarded++;
+    }
+    running_ = false;
+    idle_cv_.notify_all();
+}
+
+std::string BackgroundCompressor::summarize(const std::vector<ChatMessage>& messages) const {
+    Summarizer summarizer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        summarizer = summarizer_;
+    }
+
+    if (summarizer) {
+        try {
+            std::string summary = summarizer(messages);
+            if (!summary.empty()) {
+                return summary;
+            }
+        } catch (const std::exception& e) {
+            LOG_WARNING(std::string("摘要生成失败，使用规则摘要: ") + e.what());
+        }
+    }
+
+    // 合并摘要段时直接拼接
+    bool allSummaries = std::all_of(messages.begin(), messages.end(), [](const ChatMessage& msg) {
+        return msg.role == MessageRole::SYSTEM;
+    });
+    if (allSummaries) {
+        std::string joined;
+        for (const auto& msg : messages) {
+            if (!joined.empty()) joined += "\n";
+            joined += msg.content;
+        }
+        return joined;
+    }
+
+    ConversationCompressor compressor;
+    return compressor.generateSummary(messages, MAX_SUMMARY_LENGTH);
+}
+
+void BackgroundCompressor::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_++;
+    snapshot_.store(nullptr);
+    stats_.segments = 0;
+    stats_.summarized_messages = 0;
+}
+
+bool BackgroundCompressor::waitIdle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_cv_.wait_for(lock, timeout, [this] { return !running_; });
+}
+
+uint64_t BackgroundCompressor::version() const {
+    auto snapshot = snapshot_.load();
+    return snapshot ? snapshot->version : 0;
+}
+
+BackgroundCompressionStats BackgroundCompressor::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace roboclaw
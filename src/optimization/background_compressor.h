@@ -0,0 +1,141 @@
+// 后台对话压缩器 - BackgroundCompressor
+// 在后台预先生成早期对话的摘要段，请求路径只取用最新的已完成摘要
+
+#ifndef ROBOCLAW_OPTIMIZATION_BACKGROUND_COMPRESSOR_H
+#define ROBOCLAW_OPTIMIZATION_BACKGROUND_COMPRESSOR_H
+
+#include "../llm/llm_provider.h"
+#include "../utils/thread_pool.h"
+#include "token_optimizer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace roboclaw {
+
+// 后台压缩配置
+struct BackgroundCompressionConfig {
+    int soft_threshold;          // 超过该token数时开始在后台生成摘要
+    size_t keep_recent;          // 始终完整保留的最近消息数
+    size_t min_segment_messages; // 一个摘要段至少覆盖的消息数
+    size_t max_segments;         // 摘要段数上限，超过时合并最早的两段
+
+    BackgroundCompressionConfig()
+        : soft_threshold(6000)
+        , keep_recent(10)
+        , min_segment_messages(4)
+        , max_segments(4) {}
+};
+
+// 摘要段：用一条摘要消息替换历史中的[begin, end)
+struct SummarySegment {
+    size_t begin;
+    size_t end;
+    ChatMessage summary;
+};
+
+// 摘要快照（不可变，整体原子替换）
+struct CompressionSnapshot {
+    uint64_t version = 0;
+    uint64_t epoch = 0;
+    std::vector<SummarySegment> segments;  // 按位置排列，首尾相接
+    size_t covered = 0;                    // 摘要覆盖的历史消息数
+    size_t boundary_hash = 0;              // history[covered - 1]的指纹，用于检测历史被改写
+};
+
+// 后台压缩统计
+struct BackgroundCompressionStats {
+    size_t jobs_started = 0;
+    size_t jobs_completed = 0;
+    size_t jobs_discarded = 0;   // 完成时历史已被清空
+    size_t segments = 0;
+    size_t summarized_messages = 0;
+};
+
+// 后台对话压缩器
+//
+// apply()组合最新快照与快照之后的原始消息，不做任何阻塞操作；
+// 组合结果超过软阈值时向线程池提交一个摘要任务（同一时间最多一个），
+// 任务完成后生成新快照并原子替换。摘要稳定不变时输出前缀也稳定，
+// 不会破坏提供商侧的Prompt缓存。
+class BackgroundCompressor {
+public:
+    // 摘要函数（在后台线程调用，可以调用LLM）
+    using Summarizer = std::function<std::string(const std::vector<ChatMessage>&)>;
+
+    BackgroundCompressor(std::shared_ptr<ThreadPool> pool,
+                         std::shared_ptr<TokenOptimizer> optimizer,
+                         const BackgroundCompressionConfig& config = BackgroundCompressionConfig());
+    ~BackgroundCompressor();
+
+    BackgroundCompressor(const BackgroundCompressor&) = delete;
+    BackgroundCompressor& operator=(const BackgroundCompressor&) = delete;
+
+    // 设置摘要函数（未设置时使用ConversationCompressor的规则摘要）
+    void setSummarizer(Summarizer summarizer);
+
+    // 组合最新摘要和其后的原始消息，必要时调度后台摘要
+    // summaryCount非空时返回结果开头的摘要消息数（稳定前缀长度）
+    std::vector<ChatMessage> apply(const std::vector<ChatMessage>& history,
+                                   size_t* summaryCount = nullptr);
+
+    // 获取仍与历史对应的最新快照（历史被清空或改写后返回空）
+    std::shared_ptr<const CompressionSnapshot> current(const std::vector<ChatMessage>& history) const;
+
+    // 组合后的消息（base的摘要段 + 其后的原始消息）超过软阈值时调度后台摘要
+    void observe(const std::vector<ChatMessage>& history,
+                 std::shared_ptr<const CompressionSnapshot> base,
+                 const std::vector<ChatMessage>& composed);
+
+    // 丢弃所有摘要（清空历史时调用），进行中的任务结果将被丢弃
+    void reset();
+
+    // 等待进行中的任务完成
+    bool waitIdle(std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+
+    // 当前快照版本（每次替换递增）
+    uint64_t version() const;
+
+    // 获取统计
+    BackgroundCompressionStats getStats() const;
+
+    // 消息指纹
+    static size_t fingerprint(const ChatMessage& message);
+
+private:
+    // 调度一次后台摘要（调用方已确认超过软阈值）
+    void schedule(const std::vector<ChatMessage>& history,
+                  std::shared_ptr<const CompressionSnapshot> base);
+
+    // 后台任务：摘要[begin, end)并发布新快照
+    void run(std::vector<ChatMessage> messages, size_t begin, size_t end,
+             std::shared_ptr<const CompressionSnapshot> base, uint64_t epoch);
+
+    // 调用摘要函数（异常时退回规则摘要）
+    std::string summarize(const std::vector<ChatMessage>& messages) const;
+
+    std::shared_ptr<ThreadPool> pool_;
+    std::shared_ptr<TokenOptimizer> optimizer_;
+    BackgroundCompressionConfig config_;
+    Summarizer summarizer_;
+
+    // 最新快照（请求路径无锁读取）
+    std::atomic<std::shared_ptr<const CompressionSnapshot>> snapshot_;
+    std::atomic<uint64_t> epoch_{0};
+
+    // 任务状态
+    mutable std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    bool running_ = false;
+    BackgroundCompressionStats stats_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_OPTIMIZATION_BACKGROUND_COMPRESSOR_H
@@ -0,0 +1,597 @@
+// BpeTokenizer实现
+
+#include "bpe_tokenizer.h"
+#include "token_constants.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <queue>
+#include <thread>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+
+namespace roboclaw {
+
+namespace {
+
+using json = nlohmann::json;
+
+std::atomic<uint64_t> next_generation{1};
+
+// ==================== UTF-8 ====================
+
+// 解码一个UTF-8字符，返回码点并前进pos（非法字节按单字节处理）
+uint32_t decodeUtf8(std::string_view text, size_t& pos) {
+    unsigned char c = static_cast<unsigned char>(text[pos]);
+    size_t len = 1;
+    uint32_t cp = c;
+    if (c >= 0xF0 && c < 0xF8) { len = 4; cp = c & 0x07; }
+    else if (c >= 0xE0) { len = 3; cp = c & 0x0F; }
+    else if (c >= 0xC0) { len = 2; cp = c & 0x1F; }
+
+    if (len == 1 || pos + len > text.size()) {
+        pos += 1;
+        return c;
+    }
+    for (size_t i = 1; i < len; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            pos += 1;
+            return c;
+        }
+        cp = (cp << 6) | (next & 0x3F);
+    }
+    pos += len;
+    return cp;
+}
+
+// ==================== 字符类别（预分词用） ====================
+
+enum class CharClass { LETTER, NUMBER, NEWLINE, SPACE, OTHER };
+
+CharClass classify(uint32_t cp) {
+    if (cp < 0x80) {
+        if ((cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z')) return CharClass::LETTER;
+        if (cp >= '0' && cp <= '9') return CharClass::NUMBER;
+        if (cp == '\n' || cp == '\r') return CharClass::NEWLINE;
+        if (cp == ' ' || cp == '\t' || cp == '\v' || cp == '\f') return CharClass::SPACE;
+        return CharClass::OTHER;
+    }
+    // 常见的非字母非ASCII字符：空白、标点和符号区段
+    if (cp == 0x85) return CharClass::NEWLINE;
+    if (cp == 0xA0 || cp == 0x1680 || (cp >= 0x2000 && cp <= 0x200A) ||
+        cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000) {
+        return CharClass::SPACE;
+    }
+    if (cp >= 0xFF10 && cp <= 0xFF19) return CharClass::NUMBER;         // 全角数字
+    if ((cp >= 0x80 && cp <= 0xBF) || cp == 0xD7 || cp == 0xF7 ||
+        (cp >= 0x2010 && cp <= 0x2BFF) ||                                // 通用标点、符号、箭头、框线
+        (cp >= 0x3001 && cp <= 0x3003) || (cp >= 0x3008 && cp <= 0x3020) ||  // CJK标点
+        (cp >= 0xFE10 && cp <= 0xFE6F) ||                                // 竖排/小写变体标点
+        (cp >= 0xFF01 && cp <= 0xFF0F) || (cp >= 0xFF1A && cp <= 0xFF20) ||
+        (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65) ||  // 全角标点
+        (cp >= 0x1F000 && cp <= 0x1FAFF)) {                              // 表情符号
+        return CharClass::OTHER;
+    }
+    return CharClass::LETTER;
+}
+
+bool isWhitespace(CharClass c) {
+    return c == CharClass::SPACE || c == CharClass::NEWLINE;
+}
+
+// ==================== 文件格式 ====================
+
+// GPT-2的字节 <-> 可见Unicode字符映射
+std::array<uint32_t, 256> byteToUnicode() {
+    std::array<uint32_t, 256> table{};
+    std::array<bool, 256> direct{};
+    for (int b = '!'; b <= '~'; ++b) direct[b] = true;
+    for (int b = 0xA1; b <= 0xAC; ++b) direct[b] = true;
+    for (int b = 0xAE; b <= 0xFF; ++b) direct[b] = true;
+
+    uint32_t next = 256;
+    for (int b = 0; b < 256; ++b) {
+        table[b] = direct[b] ? static_cast<uint32_t>(b) : next++;
+    }
+    return table;
+}
+
+// 将GPT-2映射后的token字符串还原为原始字节
+bool unmapGpt2Token(const std::string& mapped, const std::unordered_map<uint32_t, uint8_t>& inverse,
+                    std::string& bytes) {
+    bytes.clear();
+    size_t pos = 0;
+    while (pos < mapped.size()) {
+        uint32_t cp = decodeUtf8(mapped, pos);
+        auto it = inverse.find(cp);
+        if (it == inverse.end()) {
+            return false;
+        }
+        bytes += static_cast<char>(it->second);
+    }
+    return true;
+}
+
+bool decodeBase64(std::string_view input, std::string& out) {
+    static const std::string alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.clear();
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : input) {
+        if (c == '=') break;
+        size_t value = alphabet.find(c);
+        if (value == std::string::npos) {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += static_cast<char>((buffer >> bits) & 0xFF);
+        }
+    }
+    return true;
+}
+
+// ==================== 每线程缓存 ====================
+
+// 预分词单元 -> 编码结果（按分词器的加载代数区分）
+struct ThreadCache {
+    static constexpr size_t MAX_ENTRIES = 32768;
+    uint64_t generation = 0;
+    std::unordered_map<std::string, std::vector<uint32_t>> words;
+};
+
+ThreadCache& threadCache(uint64_t generation) {
+    thread_local ThreadCache cache;
+    if (cache.generation != generation || cache.words.size() >= ThreadCache::MAX_ENTRIES) {
+        cache.words.clear();
+        cache.generation = generation;
+    }
+    return cache;
+}
+
+} // namespace
+
+BpeTokenizer::BpeTokenizer() {
+    byte_to_id_.fill(UNKNOWN_ID);
+}
+
+void BpeTokenizer::reset() {
+    token_to_id_.clear();
+    id_to_token_.clear();
+    merges_.clear();
+    byte_to_id_.fill(UNKNOWN_ID);
+    loaded_ = false;
+}
+
+uint32_t BpeTokenizer::addToken(const std::string& bytes, uint32_t id) {
+    token_to_id_[bytes] = id;
+    if (id >= id_to_token_.size()) {
+        id_to_token_.resize(static_cast<size_t>(id) + 1);
+    }
+    id_to_token_[id] = bytes;
+    return id;
+}
+
+bool BpeTokenizer::finalize() {
+    for (int b = 0; b < 256; ++b) {
+        auto it = token_to_id_.find(std::string(1, static_cast<char>(b)));
+        if (it != token_to_id_.end()) {
+            byte_to_id_[b] = it->second;
+        }
+    }
+    loaded_ = !token_to_id_.empty();
+    generation_ = next_generation.fetch_add(1);
+    return loaded_;
+}
+
+bool BpeTokenizer::load(const std::string& vocabPath, const std::string& mergesPath) {
+    reset();
+
+    std::ifstream vocabFile(vocabPath);
+    if (!vocabFile) {
+        LOG_ERROR("无法打开词表文件: " + vocabPath);
+        return false;
+    }
+
+    auto mapping = byteToUnicode();
+    std::unordered_map<uint32_t, uint8_t> inverse;
+    for (int b = 0; b < 256; ++b) {
+        inverse[mapping[b]] = static_cast<uint8_t>(b);
+    }
+
+    try {
+        json vocab = json::parse(vocabFile);
+        std::string bytes;
+        for (auto it = vocab.begin(); it != vocab.end(); ++it) {
+            if (!it.value().is_number_integer()) {
+                continue;
+            }
+            // 特殊token（如<|endoftext|>）不是字节映射形式，原样保留
+            if (!unmapGpt2Token(it.key(), inverse, bytes)) {
+                bytes = it.key();
+            }
+            addToken(bytes, it.value().get<uint32_t>());
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("词表文件解析失败: " + vocabPath + " (" + e.what() + ")");
+        reset();
+        return false;
+    }
+
+    std::ifstream mergesFile(mergesPath);
+    if (!mergesFile) {
+        LOG_ERROR("无法打开合并规则文件: " + mergesPath);
+        reset();
+        return false;
+    }
+
+    std::string line;
+    std::string left;
+    std::string right;
+    uint32_t rank = 0;
+    while (std::getline(mergesFile, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.rfind("#version", 0) == 0) {
+            continue;
+        }
+        size_t space = line.find(' ');
+        if (space == std::string::npos ||
+            !unmapGpt2Token(line.substr(0, space), inverse, left) ||
+            !unmapGpt2Token(line.substr(space + 1), inverse, right)) {
+            continue;
+        }
+
+        auto l = token_to_id_.find(left);
+        auto r = token_to_id_.find(right);
+        auto merged = token_to_id_.find(left + right);
+        if (l != token_to_id_.end() && r != token_to_id_.end() && merged != token_to_id_.end()) {
+            merges_.emplace(pairKey(l->second, r->second), Merge{rank, merged->second});
+        }
+        ++rank;
+    }
+
+    if (!finalize()) {
+        return false;
+    }
+    LOG_INFO("已加载BPE词表: " + std::to_string(token_to_id_.size()) + " tokens, " +
+             std::to_string(merges_.size()) + " merges");
+    return true;
+}
+
+bool BpeTokenizer::loadTiktoken(const std::string& path) {
+    reset();
+
+    std::ifstream file(path);
+    if (!file) {
+        LOG_ERROR("无法打开词表文件: " + path);
+        return false;
+    }
+
+    std::string line;
+    std::string bytes;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos || !decodeBase64(std::string_view(line).substr(0, space), bytes)) {
+            continue;
+        }
+        try {
+            addToken(bytes, static_cast<uint32_t>(std::stoul(line.substr(space + 1))));
+        } catch (...) {
+            continue;
+        }
+    }
+
+    // 合并优先级即合并结果的rank：登记每个token所有可能的拆分方式
+    for (const auto& [token, id] : token_to_id_) {
+        for (size_t split = 1; split < token.size(); ++split) {
+            auto l = token_to_id_.find(token.substr(0, split));
+            if (l == token_to_id_.end()) {
+                continue;
+            }
+            auto r = token_to_id_.find(token.substr(split));
+            if (r == token_to_id_.end()) {
+                continue;
+            }
+            auto [it, inserted] = merges_.emplace(pairKey(l->second, r->second), Merge{id, id});
+            if (!inserted && id < it->second.rank) {
+                it->second = Merge{id, id};
+            }
+        }
+    }
+
+    if (!finalize()) {
+        LOG_ERROR("词表文件为空: " + path);
+        return false;
+    }
+    LOG_INFO("已加载tiktoken词表: " + std::to_string(token_to_id_.size()) + " tokens");
+    return true;
+}
+
+bool BpeTokenizer::loadFiles(const std::string& vocabPath, const std::string& mergesPath) {
+    if (mergesPath.empty()) {
+        return loadTiktoken(vocabPath);
+    }
+    return load(vocabPath, mergesPath);
+}
+
+std::vector<std::string_view> BpeTokenizer::pretokenize(std::string_view text) {
+    std::vector<std::string_view> pieces;
+
+    // 预先解码码点和类别
+    std::vector<size_t> offsets;
+    std::vector<CharClass> classes;
+    offsets.reserve(text.size() + 1);
+    classes.reserve(text.size());
+    for (size_t pos = 0; pos < text.size();) {
+        offsets.push_back(pos);
+        classes.push_back(classify(decodeUtf8(text, pos)));
+    }
+    offsets.push_back(text.size());
+
+    const size_t n = classes.size();
+    auto lower = [&](size_t i) {
+        char c = text[offsets[i]];
+        return static_cast<char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+    };
+    auto run = [&](size_t i, auto predicate) {
+        while (i < n && predicate(classes[i])) ++i;
+        return i;
+    };
+    auto isLetter = [](CharClass c) { return c == CharClass::LETTER; };
+
+    size_t i = 0;
+    while (i < n) {
+        size_t end = i;
+        CharClass c = classes[i];
+
+        // 1. 英文缩写：'s 't 're 've 'm 'll 'd（不区分大小写）
+        if (text[offsets[i]] == '\'' && i + 1 < n) {
+            char a = lower(i + 1);
+            char b = i + 2 < n ? lower(i + 2) : '\0';
+            bool twoLetters = (a == 'r' && b == 'e') || (a == 'v' && b == 'e') || (a == 'l' && b == 'l');
+            if (twoLetters) {
+                end = i + 3;
+            } else if (a == 's' || a == 't' || a == 'm' || a == 'd') {
+                end = i + 2;
+            }
+        }
+
+        if (end == i) {
+            if (c == CharClass::LETTER) {
+                // 2. 字母串
+                end = run(i, isLetter);
+            } else if (c != CharClass::NEWLINE && c != CharClass::NUMBER &&
+                       i + 1 < n && classes[i + 1] == CharClass::LETTER) {
+                // 2. 一个非字母数字字符（如空格、标点）+ 字母串
+                end = run(i + 1, isLetter);
+            } else if (c == CharClass::NUMBER) {
+                // 3. 最多3位的数字
+                end = i;
+                while (end < n && end - i < 3 && classes[end] == CharClass::NUMBER) ++end;
+            } else if (c == CharClass::OTHER ||
+                       (text[offsets[i]] == ' ' && i + 1 < n && classes[i + 1] == CharClass::OTHER)) {
+                // 4. 可选空格 + 标点串 + 换行
+                size_t start = c == CharClass::OTHER ? i : i + 1;
+                end = run(start, [](CharClass k) { return k == CharClass::OTHER; });
+                end = run(end, [](CharClass k) { return k == CharClass::NEWLINE; });
+            } else {
+                size_t wsEnd = run(i, isWhitespace);
+                // 5. 以换行结尾的空白
+                size_t lastNewline = n;
+                for (size_t k = i; k < wsEnd; ++k) {
+                    if (classes[k] == CharClass::NEWLINE) lastNewline = k;
+                }
+                if (lastNewline != n) {
+                    end = lastNewline + 1;
+                } else if (wsEnd < n && wsEnd - i > 1) {
+                    // 6. 后面跟非空白时留下最后一个空白与下一个词相连
+                    end = wsEnd - 1;
+                } else {
+                    // 7. 其余空白
+                    end = wsEnd;
+                }
+            }
+        }
+
+        end = std::min(std::max(end, i + 1), n);
+        pieces.push_back(text.substr(offsets[i], offsets[end] - offsets[i]));
+        i = end;
+    }
+    return pieces;
+}
+
+void BpeTokenizer::mergeWord(std::string_view word, std::vector<uint32_t>& out) const {
+    // 整个单元就是一个token时直接返回
+    auto whole = token_to_id_.find(std::string(word));
+    if (whole != token_to_id_.end()) {
+        out.push_back(whole->second);
+        return;
+    }
+
+    const size_t n = word.size();
+    std::vector<uint32_t> ids(n);
+    std::vector<int> prev(n);
+    std::vector<int> next(n);
+    for (size_t i = 0; i < n; ++i) {
+        ids[i] = byte_to_id_[static_cast<unsigned char>(word[i])];
+        prev[i] = static_cast<int>(i) - 1;
+        next[i] = (i + 1 < n) ? static_cast<int>(i + 1) : -1;
+    }
+
+    // 最小堆：(优先级, 左节点位置)，优先级相同时先合并靠左的
+    struct Candidate {
+        uint32_t rank;
+        int pos;
+        uint32_t left;
+        uint32_t right;
+        bool operator>(const Candidate& other) const {
+            return rank != other.rank ? rank > other.rank : pos > other.pos;
+        }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+
+    auto push = [&](int pos) {
+        if (pos < 0 || next[pos] < 0) {
+            return;
+        }
+        uint32_t left = ids[pos];
+        uint32_t right = ids[next[pos]];
+        if (left == UNKNOWN_ID || right == UNKNOWN_ID) {
+            return;
+        }
+        auto it = merges_.find(pairKey(left, right));
+        if (it != merges_.end()) {
+            heap.push({it->second.rank, pos, left, right});
+        }
+    };
+
+    for (size_t i = 0; i + 1 < n; ++i) {
+        push(static_cast<int>(i));
+    }
+
+    while (!heap.empty()) {
+        Candidate top = heap.top();
+        heap.pop();
+
+        // 过期的候选：节点已被合并或内容已改变
+        int pos = top.pos;
+        if (ids[pos] != top.left || next[pos] < 0 || ids[next[pos]] != top.right) {
+            continue;
+        }
+
+        int right = next[pos];
+        ids[pos] = merges_.at(pairKey(top.left, top.right)).id;
+        ids[right] = UNKNOWN_ID - 1;  // 标记已删除
+        next[pos] = next[right];
+        if (next[right] >= 0) {
+            prev[next[right]] = pos;
+        }
+
+        push(prev[pos]);
+        push(pos);
+    }
+
+    for (int pos = 0; pos >= 0; pos = next[pos]) {
+        out.push_back(ids[pos]);
+    }
+}
+
+const std::vector<uint32_t>& BpeTokenizer::encodeWord(std::string_view word) const {
+    ThreadCache& cache = threadCache(generation_);
+    auto it = cache.words.find(std::string(word));
+    if (it != cache.words.end()) {
+        cache_hits_++;
+        return it->second;
+    }
+
+    cache_misses_++;
+    std::vector<uint32_t> ids;
+    mergeWord(word, ids);
+    return cache.words.emplace(std::string(word), std::move(ids)).first->second;
+}
+
+std::vector<uint32_t> BpeTokenizer::encode(std::string_view text) const {
+    std::vector<uint32_t> ids;
+    if (!loaded_) {
+        return ids;
+    }
+    for (auto piece : pretokenize(text)) {
+        const auto& wordIds = encodeWord(piece);
+        ids.insert(ids.end(), wordIds.begin(), wordIds.end());
+    }
+    return ids;
+}
+
+std::string BpeTokenizer::decode(const std::vector<uint32_t>& ids) const {
+    std::string text;
+    for (uint32_t id : ids) {
+        if (id < id_to_token_.size()) {
+            text += id_to_token_[id];
+        }
+    }
+    return text;
+}
+
+size_t BpeTokenizer::count(std::string_view text) const {
+    if (!loaded_) {
+        return 0;
+    }
+    size_t total = 0;
+    for (auto piece : pretokenize(text)) {
+        total += encodeWord(piece).size();
+    }
+    return total;
+}
+
+size_t BpeTokenizer::countMessage(const ChatMessage& message) const {
+    size_t total = TokenConstants::BPE_TOKENS_PER_MESSAGE + count(message.content);
+    for (const auto& call : message.tool_calls) {
+        total += TokenConstants::BPE_TOKENS_PER_TOOL_CALL + count(call.name) + count(call.arguments.dump());
+    }
+    if (!message.tool_call_id.empty()) {
+        total += count(message.tool_call_id);
+    }
+    return total;
+}
+
+std::vector<size_t> BpeTokenizer::countMessages(const std::vector<const ChatMessage*>& messages) const {
+    std::vector<size_t> counts(messages.size(), 0);
+    if (messages.empty()) {
+        return counts;
+    }
+
+    auto countRange = [this, &messages, &counts](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            counts[i] = countMessage(*messages[i]);
+        }
+    };
+
+    // 少量消息或没有线程池时直接在当前线程计算
+    size_t workers = pool_ ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : 1;
+    if (workers == 1 || messages.size() < 4) {
+        countRange(0, messages.size());
+        return counts;
+    }
+
+    size_t chunks = std::min(workers, messages.size());
+    size_t chunkSize = (messages.size() + chunks - 1) / chunks;
+    std::vector<std::future<void>> futures;
+    for (size_t begin = chunkSize; begin < messages.size(); begin += chunkSize) {
+        size_t end = std::min(begin + chunkSize, messages.size());
+        futures.push_back(pool_->submitWithResult(countRange, begin, end));
+    }
+    countRange(0, std::min(chunkSize, messages.size()));
+    for (auto& future : futures) {
+        future.get();
+    }
+    return counts;
+}
+
+std::vector<size_t> BpeTokenizer::countBatch(const std::vector<std::string>& texts) const {
+    std::vector<ChatMessage> messages;
+    messages.reserve(texts.size());
+    for (const auto& text : texts) {
+        messages.emplace_back(MessageRole::USER, text);
+    }
+    std::vector<const ChatMessage*> pointers;
+    pointers.reserve(messages.size());
+    for (const auto& msg : messages) {
+        pointers.push_back(&msg);
+    }
+
+    auto counts = countMessages(pointers);
+    for (auto& c : counts) {
+        c -= TokenConstants::BPE_TOKENS_PER_MESSAGE;
+    }
+    return counts;
+}
+
+} // namespace roboclaw
@@ -0,0 +1,118 @@
+// BPE分词器 - BpeTokenizer
+// 从磁盘加载词表和合并规则，按模型的真实分词精确计算token数
+
+#ifndef ROBOCLAW_OPTIMIZATION_BPE_TOKENIZER_H
+#define ROBOCLAW_OPTIMIZATION_BPE_TOKENIZER_H
+
+#include "../llm/llm_provider.h"
+#include "../utils/thread_pool.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace roboclaw {
+
+// 字节级BPE分词器
+//
+// 支持两种文件格式：
+// - GPT-2/HuggingFace：vocab.json（token -> id，字节映射为可见Unicode字符）+ merges.txt
+// - tiktoken：每行 "base64(token字节) rank"，合并优先级即合并结果的rank
+// 两种格式都转换为同一个合并表：相邻token id对 -> (优先级, 合并后的id)，
+// 每个预分词单元用最小堆按优先级从左到右合并。
+//
+// 文本先按cl100k风格的规则预分词（缩写、字母串、最多3位的数字、标点串、空白），
+// 每个线程缓存预分词单元的编码结果，批量计数时按消息并行。
+class BpeTokenizer {
+public:
+    BpeTokenizer();
+
+    // 加载GPT-2/HuggingFace格式
+    bool load(const std::string& vocabPath, const std::string& mergesPath);
+
+    // 加载tiktoken格式
+    bool loadTiktoken(const std::string& path);
+
+    // 按文件扩展名加载（merges为空时视为tiktoken格式）
+    bool loadFiles(const std::string& vocabPath, const std::string& mergesPath = "");
+
+    // 是否已加载
+    bool isLoaded() const { return loaded_; }
+
+    // 词表大小
+    size_t vocabSize() const { return id_to_token_.size(); }
+
+    // 编码/解码
+    std::vector<uint32_t> encode(std::string_view text) const;
+    std::string decode(const std::vector<uint32_t>& ids) const;
+
+    // 计算文本的token数
+    size_t count(std::string_view text) const;
+
+    // 计算单条消息的token数（含角色和分隔符开销、工具调用）
+    size_t countMessage(const ChatMessage& message) const;
+
+    // 并行计算多条消息各自的token数
+    std::vector<size_t> countMessages(const std::vector<const ChatMessage*>& messages) const;
+
+    // 并行计算多段文本各自的token数
+    std::vector<size_t> countBatch(const std::vector<std::string>& texts) const;
+
+    // 设置批量计数使用的线程池（未设置时在调用线程中计算）
+    void setThreadPool(std::shared_ptr<ThreadPool> pool) { pool_ = std::move(pool); }
+
+    // 预分词（返回原文的切片）
+    static std::vector<std::string_view> pretokenize(std::string_view text);
+
+    // 每线程缓存的命中统计（所有线程累计）
+    size_t getCacheHits() const { return cache_hits_.load(); }
+    size_t getCacheMisses() const { return cache_misses_.load(); }
+
+    // 未知字节的占位id
+    static constexpr uint32_t UNKNOWN_ID = 0xFFFFFFFFu;
+
+private:
+    struct Merge {
+        uint32_t rank;
+        uint32_t id;
+    };
+
+    static uint64_t pairKey(uint32_t left, uint32_t right) {
+        return (static_cast<uint64_t>(left) << 32) | right;
+    }
+
+    // 添加token（返回id）
+    uint32_t addToken(const std::string& bytes, uint32_t id);
+
+    // 词表加载完成后建立字节表
+    bool finalize();
+
+    // 编码一个预分词单元（使用每线程缓存）
+    const std::vector<uint32_t>& encodeWord(std::string_view word) const;
+
+    // 对一个预分词单元执行BPE合并
+    void mergeWord(std::string_view word, std::vector<uint32_t>& out) const;
+
+    // 重置词表
+    void reset();
+
+    std::unordered_map<std::string, uint32_t> token_to_id_;
+    std::vector<std::string> id_to_token_;                 // id -> 原始字节
+    std::array<uint32_t, 256> byte_to_id_{};
+    std::unordered_map<uint64_t, Merge> merges_;
+    bool loaded_ = false;
+
+    uint64_t generation_ = 0;                              // 每次加载唯一，使线程缓存失效
+    std::shared_ptr<ThreadPool> pool_;
+
+    mutable std::atomic<size_t> cache_hits_{0};
+    mutable std::atomic<size_t> cache_misses_{0};
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_OPTIMIZATION_BPE_TOKENIZER_H
@@ -74,8 +74,15 @@ std::string ConversationCompressor::generateSummary(
         return "";
     }
 
-    // 简化实现：生成文本摘要
-    // 完整实现可以调用LLM生成更准确的摘要
+    if (llm_provider_) {
+        std::string summary = generateLLMSummary(messages, max_length);
+        if (!summary.empty()) {
+            return summary;
+        }
+        LOG_WARNING("LLM摘要生成失败，使用规则摘要");
+    }
+
+    // 规则摘要
 
     std::stringstream ss;
     ss << "[对话摘要] ";
@@ -122,6 +129,53 @@ std::string ConversationCompressor::generateSummary(
     return summary;
 }
 
+std::string ConversationCompressor::generateLLMSummary(
+        const std::vector<ChatMessage>& messages,
+        int max_length) {
+
+    // 把对话整理为文本记录，工具结果只保留开头
+    std::stringstream transcript;
+    for (const auto& msg : messages) {
+        switch (msg.role) {
+            case MessageRole::SYSTEM: transcript << "[摘要] "; break;
+            case MessageRole::USER: transcript << "用户: "; break;
+            case MessageRole::ASSISTANT: transcript << "助手: "; break;
+            case MessageRole::TOOL: transcript << "工具结果: "; break;
+        }
+        std::string content = msg.content;
+        if (msg.role == MessageRole::TOOL && content.length() > 500) {
+            content = content.substr(0, 497) + "...";
+        }
+        transcript << content;
+        for (const auto& call : msg.tool_calls) {
+            transcript << " [调用 " << call.name << " " << call.arguments.dump() << "]";
+        }
+        transcript << "\n";
+    }
+
+    std::vector<ChatMessage> request;
+    request.emplace_back(MessageRole::SYSTEM,
+        "将以下对话记录压缩为不超过" + std::to_string(max_length / 3) + "字的摘要。"
+        "保留用户的目标、已做出的决定、读取或修改过的文件、工具结论和未完成的事项，不要添加记录中没有的内容。");
+    request.emplace_back(MessageRole::USER, transcript.str());
+
+    LLMResponse response = llm_provider_->chat(request);
+    if (!response.success || response.content.empty()) {
+        return "";
+    }
+
+    std::string summary = "[对话摘要] " + response.content;
+    if (summary.length() > static_cast<size_t>(max_length)) {
+        // 不在UTF-8多字节字符中间截断
+        size_t cut = static_cast<size_t>(std::max(max_length - 3, 0));
+        while (cut > 0 && (static_cast<unsigned char>(summary[cut]) & 0xC0) == 0x80) {
+            --cut;
+        }
+        summary = summary.substr(0, cut) + "...";
+    }
+    return summary;
+}
+
 bool ConversationCompressor::needsCompression(
         const std::vector<ChatMessage>& history,
         int threshold) const {
@@ -34,7 +34,7 @@ public:
                                int max_recent = 5,
                                int max_middle = 10);
 
-    // 生成摘要
+    // 生成摘要（设置了LLM提供商时由LLM生成，失败时退回规则摘要）
     std::string generateSummary(const std::vector<ChatMessage>& messages,
                                int max_length = 500);
 
@@ -47,6 +47,9 @@ private:
     // 简化摘要生成（不调用LLM）
     std::string generateSimpleSummary(const std::vector<ChatMessage>& messages);
 
+    // 调用LLM生成摘要（失败时返回空字符串）
+    std::string generateLLMSummary(const std::vector<ChatMessage>& messages, int max_length);
+
     // 从消息中提取关键信息
     std::string extractKeyInfo(const ChatMessage& msg) const;
 
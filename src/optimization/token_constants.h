@@ -13,6 +13,10 @@ namespace TokenConstants {
     constexpr int CHARS_PER_TOKEN_CHINESE = 2;      // 中文每token约2字符
     constexpr int TOKENS_PER_MESSAGE_OVERHEAD = 10; // 每条消息额外开销
 
+    // BPE精确计数常量（聊天模板的固定开销）
+    constexpr int BPE_TOKENS_PER_MESSAGE = 4;       // 角色和分隔符
+    constexpr int BPE_TOKENS_PER_TOOL_CALL = 8;     // 工具调用的结构开销（不含名称和参数）
+
     // Token预算常量
     constexpr int DEFAULT_TOKEN_BUDGET = 12000;     // 默认token预算
     constexpr int MIN_TOKEN_BUDGET = 1000;          // 最小token预算
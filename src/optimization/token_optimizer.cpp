@@ -2,13 +2,106 @@
 
 #include "token_optimizer.h"
 #include "token_constants.h"
+#include "bpe_tokenizer.h"
 #include "../utils/logger.h"
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <regex>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace roboclaw {
 
+namespace {
+
+constexpr uint64_t HASH_SEED = 0x9E3779B97F4A7C15ULL;
+constexpr uint64_t HASH_PRIME = 0xFF51AFD7ED558CCDULL;
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= HASH_PRIME;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// 64位哈希，每次处理8字节
+uint64_t hashBytes(const char* data, size_t len, uint64_t seed) {
+    uint64_t hash = seed ^ (len * HASH_PRIME);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = std::rotl(hash ^ mix64(word), 27) * 5 + 0x52DCE729;
+    }
+    if (i < len) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, len - i);
+        hash = std::rotl(hash ^ mix64(word), 27) * 5 + 0x52DCE729;
+    }
+    return mix64(hash);
+}
+
+// 字节类别计数
+struct ByteClassCounts {
+    size_t whitespace = 0;   // ASCII空白（空格、\t \n \v \f \r）
+    size_t ascii = 0;        // 其他ASCII字节
+    size_t non_ascii = 0;    // 非ASCII字节（UTF-8多字节字符，主要是中文）
+};
+
+ByteClassCounts countByteClasses(const char* data, size_t len) {
+    ByteClassCounts counts;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // 每次16字节：最高位为1即非ASCII；空白为' '或9..13（有符号比较，非ASCII字节为负数）
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i ctrlLow = _mm_set1_epi8(8);
+    const __m128i ctrlHigh = _mm_set1_epi8(14);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i ctrl = _mm_and_si128(_mm_cmpgt_epi8(v, ctrlLow), _mm_cmplt_epi8(v, ctrlHigh));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space), ctrl);
+        counts.non_ascii += std::popcount(static_cast<unsigned>(_mm_movemask_epi8(v)));
+        counts.whitespace += std::popcount(static_cast<unsigned>(_mm_movemask_epi8(ws)));
+    }
+#elif defined(__aarch64__)
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t four = vdupq_n_u8(4);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t nonAscii = vcgeq_u8(v, high);
+        uint8x16_t ws = vorrq_u8(vceqq_u8(v, space), vcleq_u8(vsubq_u8(v, tab), four));
+        counts.non_ascii += vaddvq_u8(vshrq_n_u8(nonAscii, 7));
+        counts.whitespace += vaddvq_u8(vshrq_n_u8(ws, 7));
+    }
+#endif
+
+    for (; i < len; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c >= 0x80) {
+            counts.non_ascii++;
+        } else if (c == ' ' || (c >= '\t' && c <= '\r')) {
+            counts.whitespace++;
+        }
+    }
+
+    counts.ascii = len - counts.whitespace - counts.non_ascii;
+    return counts;
+}
+
+} // namespace
+
 TokenOptimizer::TokenOptimizer()
     : cache_hits_(0)
     , cache_misses_(0) {
@@ -20,68 +113,90 @@ void TokenOptimizer::setConfig(const TokenOptimizationConfig& config) {
 }
 
 int TokenOptimizer::estimateTokens(const std::vector<ChatMessage>& messages) {
+    return estimateTokensImpl(messages);
+}
+
+int TokenOptimizer::estimateTokensImpl(const std::vector<ChatMessage>& messages) const {
     if (!config_.enable_token_cache) {
-        return estimateTokensImpl(messages);
+        int total = 0;
+        for (const auto& msg : messages) {
+            total += messageTokens(msg);
+        }
+        return total;
     }
 
-    // 生成缓存键
-    CacheKey key = generateCacheKey(messages);
+    // 先在锁外计算每条消息的哈希
+    std::vector<CacheKey> keys;
+    keys.reserve(messages.size());
+    for (const auto& msg : messages) {
+        keys.push_back(messageKey(msg));
+    }
 
-    // 检查缓存
+    std::vector<int> tokens(messages.size(), 0);
+    std::vector<size_t> missing;
+    size_t common = 0;
+    uint64_t version = 0;
     {
         std::lock_guard<std::mutex> lock(cache_mutex_);
-        auto it = cache_index_.find(key);
-        if (it != cache_index_.end()) {
-            // 缓存命中，移动到LRU头部
-            cache_hits_++;
-            auto entry = it->second;
-            cache_list_.splice(cache_list_.begin(), cache_list_, entry);
-            return entry->token_count;
-        }
-    }
 
-    // 缓存未命中
-    cache_misses_++;
-    int result = estimateTokensImpl(messages);
+        // 与上次估算的历史逐条比对，一致的前缀直接使用前缀和
+        size_t limit = std::min(keys.size(), history_keys_.size());
+        while (common < limit && keys[common] == history_keys_[common]) {
+            ++common;
+        }
+        cache_hits_ += common;
+        for (size_t i = 0; i < common; ++i) {
+            tokens[i] = history_prefix_[i + 1] - history_prefix_[i];
+        }
 
-    // 添加到缓存
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        cache_list_.push_front(CacheEntry(result));
-        cache_index_[key] = cache_list_.begin();
-
-        // 如果超过最大缓存大小，移除最旧的条目
-        while (cache_list_.size() > config_.max_cache_size) {
-            auto last = cache_list_.end();
-            --last;
-            // 需要反向查找键（这是低效的，但简化了实现）
-            for (auto it = cache_index_.begin(); it != cache_index_.end(); ++it) {
-                if (it->second == last) {
-                    cache_index_.erase(it);
-                    break;
-                }
+        // 新增或改变的消息先查LRU
+        for (size_t i = common; i < messages.size(); ++i) {
+            if (lookupLocked(keys[i], tokens[i])) {
+                cache_hits_++;
+            } else {
+                cache_misses_++;
+                missing.push_back(i);
             }
-            cache_list_.pop_back();
         }
+        version = history_version_;
     }
 
-    return result;
-}
-
-int TokenOptimizer::estimateTokensImpl(const std::vector<ChatMessage>& messages) const {
-    int total = 0;
+    // 未命中的消息在锁外计算，精确计数时并行分词
+    if (tokenizer_ && tokenizer_->isLoaded() && missing.size() > 1) {
+        std::vector<const ChatMessage*> batch;
+        batch.reserve(missing.size());
+        for (size_t i : missing) {
+            batch.push_back(&messages[i]);
+        }
+        auto counts = tokenizer_->countMessages(batch);
+        for (size_t j = 0; j < missing.size(); ++j) {
+            tokens[missing[j]] = static_cast<int>(counts[j]);
+        }
+    } else {
+        for (size_t i : missing) {
+            tokens[i] = messageTokens(messages[i]);
+        }
+    }
 
-    for (const auto& msg : messages) {
-        // 估算每条消息的token数
-        total += estimateTokensOptimized(msg.content);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    for (size_t i : missing) {
+        insertLocked(keys[i], tokens[i]);
+    }
 
-        // 工具调用也需要token
-        if (!msg.tool_calls.empty()) {
-            total += static_cast<int>(msg.tool_calls.size()) * TokenConstants::TOKENS_PER_TOOL_CALL;
-        }
+    // 期间历史被其他调用重建过时从头重建
+    if (history_version_ != version) {
+        common = 0;
+    }
+    history_version_++;
+    history_keys_.resize(common);
+    history_prefix_.resize(common + 1);
+    history_prefix_[0] = 0;
+    for (size_t i = common; i < messages.size(); ++i) {
+        history_keys_.push_back(keys[i]);
+        history_prefix_.push_back(history_prefix_.back() + tokens[i]);
     }
 
-    return total;
+    return history_prefix_[messages.size()];
 }
 
 int TokenOptimizer::estimateTokens(const std::string& text) {
@@ -93,86 +208,77 @@ int TokenOptimizer::estimateTokens(const std::string& text) {
         return estimateTokensOptimized(text);
     }
 
-    // 生成缓存键
     CacheKey key = generateCacheKey(text);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
 
-    // 检查缓存
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        auto it = cache_index_.find(key);
-        if (it != cache_index_.end()) {
-            cache_hits_++;
-            auto entry = it->second;
-            cache_list_.splice(cache_list_.begin(), cache_list_, entry);
-            return entry->token_count;
-        }
+    int tokens = 0;
+    if (lookupLocked(key, tokens)) {
+        cache_hits_++;
+        return tokens;
     }
 
-    // 缓存未命中
     cache_misses_++;
-    int result = estimateTokensOptimized(text);
+    tokens = estimateTokensOptimized(text);
+    insertLocked(key, tokens);
+    return tokens;
+}
 
-    // 添加到缓存
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        cache_list_.push_front(CacheEntry(result));
-        cache_index_[key] = cache_list_.begin();
-
-        while (cache_list_.size() > config_.max_cache_size) {
-            auto last = cache_list_.end();
-            --last;
-            for (auto it = cache_index_.begin(); it != cache_index_.end(); ++it) {
-                if (it->second == last) {
-                    cache_index_.erase(it);
-                    break;
-                }
-            }
-            cache_list_.pop_back();
-        }
+bool TokenOptimizer::lookupLocked(CacheKey key, int& tokens) const {
+    auto it = cache_index_.find(key);
+    if (it == cache_index_.end()) {
+        return false;
+    }
+    // 命中，移动到LRU头部
+    cache_list_.splice(cache_list_.begin(), cache_list_, it->second);
+    it->second->access_count++;
+    tokens = it->second->token_count;
+    return true;
+}
+
+void TokenOptimizer::insertLocked(CacheKey key, int tokens) const {
+    cache_list_.emplace_front(key, tokens);
+    cache_index_[key] = cache_list_.begin();
+
+    // 超过最大缓存大小时淘汰最旧的条目（条目保存了键，无需反向查找）
+    while (cache_list_.size() > std::max<size_t>(config_.max_cache_size, 1)) {
+        cache_index_.erase(cache_list_.back().key);
+        cache_list_.pop_back();
     }
+}
 
-    return result;
+int TokenOptimizer::messageTokens(const ChatMessage& message) const {
+    if (tokenizer_ && tokenizer_->isLoaded()) {
+        return static_cast<int>(tokenizer_->countMessage(message));
+    }
+    return estimateTokensOptimized(message.content) +
+           static_cast<int>(message.tool_calls.size()) * TokenConstants::TOKENS_PER_TOOL_CALL;
 }
 
 int TokenOptimizer::estimateTokensOptimized(const std::string& text) const {
-    // 使用混合估算策略
-    int chinese_chars = 0;
-    int english_chars = 0;
-    int code_chars = 0;
-    int whitespace = 0;
-
-    for (char c : text) {
-        if (c >= 0 && c <= 127) {
-            // ASCII字符
-            if (std::isspace(c)) {
-                whitespace++;
-            } else {
-                english_chars++;
-            }
-        } else {
-            // 非ASCII（主要是中文）
-            chinese_chars++;
-        }
+    if (tokenizer_ && tokenizer_->isLoaded()) {
+        return static_cast<int>(tokenizer_->count(text));
     }
 
+    // 使用混合估算策略
+    ByteClassCounts counts = countByteClasses(text.data(), text.size());
+
     // 估算规则：
-    // 中文：约1.5字符/token
+    // 中文：约1.5字符/token（按非ASCII字节计）
     // 英文：约4字符/token (CHARS_PER_TOKEN_ENGLISH)
     // 空格：约10字符/token
-    // 代码：约4字符/token（但包含较多符号，保守估计）
 
     int tokens = 0;
-    tokens += static_cast<int>(std::ceil(chinese_chars / 1.5));
-    tokens += static_cast<int>(std::ceil(english_chars / static_cast<double>(TokenConstants::CHARS_PER_TOKEN_ENGLISH)));
-    tokens += static_cast<int>(std::ceil(whitespace / 10.0));
-    tokens += static_cast<int>(std::ceil(code_chars / static_cast<double>(TokenConstants::CHARS_PER_TOKEN_ENGLISH)));
+    tokens += static_cast<int>(std::ceil(counts.non_ascii / 1.5));
+    tokens += static_cast<int>(std::ceil(counts.ascii / static_cast<double>(TokenConstants::CHARS_PER_TOKEN_ENGLISH)));
+    tokens += static_cast<int>(std::ceil(counts.whitespace / 10.0));
 
     return std::max(tokens, 1);  // 至少1个token
 }
 
 std::vector<ChatMessage> TokenOptimizer::compressHistory(
         const std::vector<ChatMessage>& history,
-        int target_tokens) {
+        int target_tokens,
+        size_t preserve_prefix) {
 
     if (!config_.enable_compression) {
         return history;
@@ -187,6 +293,24 @@ std::vector<ChatMessage> TokenOptimizer::compressHistory(
 
     LOG_INFO("压缩对话历史: " + std::to_string(current_tokens) + " -> " + std::to_string(threshold) + " tokens");
 
+    // 保留稳定前缀，只压缩前缀之后的消息
+    if (preserve_prefix > 0 && preserve_prefix < history.size()) {
+        std::vector<ChatMessage> compressed(history.begin(), history.begin() + preserve_prefix);
+        std::vector<ChatMessage> tail(history.begin() + preserve_prefix, history.end());
+
+        CompressionLayers layers = createCompressionLayers(tail);
+        compressed.insert(compressed.end(), layers.old_summary.begin(), layers.old_summary.end());
+        compressed.insert(compressed.end(), layers.middle.begin(), layers.middle.end());
+        compressed.insert(compressed.end(), layers.recent.begin(), layers.recent.end());
+
+        if (estimateTokensImpl(compressed) <= threshold) {
+            return compressed;
+        }
+    }
+    if (preserve_prefix > 0) {
+        LOG_INFO("稳定前缀超出预算，执行完整压缩（缓存前缀失效）");
+    }
+
     // 创建分层结构
     CompressionLayers layers = createCompressionLayers(history);
 
@@ -318,7 +442,7 @@ bool TokenOptimizer::needsCompression(const std::vector<ChatMessage>& messages)
         return false;
     }
 
-    // 使用非缓存版本进行估算（const方法）
+    // 历史只增长时只估算新增消息
     int current_tokens = estimateTokensImpl(messages);
     return current_tokens > config_.compression_threshold;
 }
@@ -383,10 +507,21 @@ std::string TokenOptimizer::getCachedPromptKey() {
 
 // ==================== 缓存相关方法 ====================
 
+void TokenOptimizer::setTokenizer(std::shared_ptr<BpeTokenizer> tokenizer) {
+    tokenizer_ = std::move(tokenizer);
+    clearCache();
+}
+
+bool TokenOptimizer::isExact() const {
+    return tokenizer_ && tokenizer_->isLoaded();
+}
+
 void TokenOptimizer::clearCache() {
     std::lock_guard<std::mutex> lock(cache_mutex_);
     cache_list_.clear();
     cache_index_.clear();
+    history_keys_.clear();
+    history_prefix_.clear();
     cache_hits_ = 0;
     cache_misses_ = 0;
     LOG_INFO("Token估算缓存已清空");
@@ -405,43 +540,28 @@ size_t TokenOptimizer::getCacheMisses() const {
     return cache_misses_.load();
 }
 
-TokenOptimizer::CacheKey TokenOptimizer::generateCacheKey(const std::vector<ChatMessage>& messages) const {
-    std::stringstream ss;
-
-    // 生成消息序列的哈希键
-    for (const auto& msg : messages) {
-        ss << static_cast<int>(msg.role) << "|";
-
-        // 使用内容的前100个字符作为键的一部分
-        size_t len = std::min(size_t(100), msg.content.length());
-        ss << msg.content.substr(0, len) << "|";
-
-        // 包含工具调用信息
-        ss << msg.tool_calls.size() << ";";
+TokenOptimizer::CacheKey TokenOptimizer::generateCacheKey(const ChatMessage& message) {
+    // 覆盖角色、内容、tool_call_id以及每个工具调用的id、名称和参数，
+    // 原地修改其中任何一项都会得到不同的键
+    CacheKey key = hashBytes(message.content.data(), message.content.size(),
+                             HASH_SEED + static_cast<uint64_t>(message.role));
+    for (const auto& call : message.tool_calls) {
+        std::string args = call.arguments.dump();
+        key = hashBytes(call.id.data(), call.id.size(), key);
+        key = hashBytes(call.name.data(), call.name.size(), key);
+        key = hashBytes(args.data(), args.size(), key);
     }
-
-    // 对长键进行哈希
-    std::string key_str = ss.str();
-    std::hash<std::string> hash_fn;
-    size_t hash_value = hash_fn(key_str);
-
-    std::stringstream result;
-    result << std::hex << hash_value;
-    return result.str();
+    return hashBytes(message.tool_call_id.data(), message.tool_call_id.size(),
+                     key + message.tool_calls.size());
 }
 
-TokenOptimizer::CacheKey TokenOptimizer::generateCacheKey(const std::string& text) const {
-    // 对短文本直接使用前100字符，长文本使用哈希
-    if (text.length() <= 100) {
-        return text;
-    }
-
-    std::hash<std::string> hash_fn;
-    size_t hash_value = hash_fn(text);
+TokenOptimizer::CacheKey TokenOptimizer::messageKey(const ChatMessage& message) const {
+    // 精确计数和启发式估算共用同一个键：键不依赖指针，消息被复制或移动后仍然命中
+    return generateCacheKey(message);
+}
 
-    std::stringstream ss;
-    ss << std::hex << hash_value;
-    return ss.str();
+TokenOptimizer::CacheKey TokenOptimizer::generateCacheKey(const std::string& text) {
+    return hashBytes(text.data(), text.size(), ~HASH_SEED);
 }
 
 } // namespace roboclaw
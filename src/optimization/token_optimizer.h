@@ -13,9 +13,13 @@
 #include <mutex>
 #include <list>
 #include <atomic>
+#include <cstdint>
+#include <memory>
 
 namespace roboclaw {
 
+class BpeTokenizer;
+
 // Token统计信息
 struct TokenStats {
     int input_tokens;
@@ -61,14 +65,24 @@ public:
     void setConfig(const TokenOptimizationConfig& config);
     TokenOptimizationConfig getConfig() const { return config_; }
 
+    // 设置BPE分词器（已加载时按真实分词精确计数，否则使用启发式估算；清空估算缓存）
+    void setTokenizer(std::shared_ptr<BpeTokenizer> tokenizer);
+    std::shared_ptr<BpeTokenizer> getTokenizer() const { return tokenizer_; }
+
+    // 是否使用精确计数
+    bool isExact() const;
+
     // 估算消息的token数
     int estimateTokens(const std::vector<ChatMessage>& messages);
     int estimateTokens(const std::string& text);
 
     // 压缩对话历史
+    // preserve_prefix: 前N条消息原样保留（提供商已缓存的稳定前缀），只压缩其后的消息；
+    // 若保留前缀后仍超出目标，则退回完整压缩（缓存前缀失效）
     std::vector<ChatMessage> compressHistory(
         const std::vector<ChatMessage>& history,
-        int target_tokens = -1);
+        int target_tokens = -1,
+        size_t preserve_prefix = 0);
 
     // 压缩工具结果
     std::string compressToolResult(const std::string& result, const std::string& toolName);
@@ -105,7 +119,7 @@ private:
     TokenOptimizationConfig config_;
     TokenStats stats_;
 
-    // Token估算算法
+    // Token估算算法（按字节类别计数，SIMD加速）
     int estimateTokensOptimized(const std::string& text) const;
     int estimateTokensImpl(const std::vector<ChatMessage>& messages) const;
 
@@ -123,25 +137,44 @@ private:
     };
     CompressionLayers createCompressionLayers(const std::vector<ChatMessage>& history);
 
-    // Token估算缓存条目
+    // 缓存键：内容的64位哈希
+    using CacheKey = uint64_t;
+
+    // Token估算缓存条目（保存键，淘汰时O(1)删除索引）
     struct CacheEntry {
+        CacheKey key;
         int token_count;
         size_t access_count;
 
-        CacheEntry(int tokens) : token_count(tokens), access_count(1) {}
+        CacheEntry(CacheKey k, int tokens) : key(k), token_count(tokens), access_count(1) {}
     };
 
-    // 缓存键类型
-    using CacheKey = std::string;
-
     // 生成缓存键
-    CacheKey generateCacheKey(const std::vector<ChatMessage>& messages) const;
-    CacheKey generateCacheKey(const std::string& text) const;
+    static CacheKey generateCacheKey(const ChatMessage& message);
+    static CacheKey generateCacheKey(const std::string& text);
 
-    // 缓存存储（LRU）
+    // 消息的缓存键（内容、角色及全部工具调用的64位哈希）
+    CacheKey messageKey(const ChatMessage& message) const;
+
+    // 单条消息的token数（不经过缓存）
+    int messageTokens(const ChatMessage& message) const;
+
+    // 查询/写入LRU（调用方持有cache_mutex_）
+    bool lookupLocked(CacheKey key, int& tokens) const;
+    void insertLocked(CacheKey key, int tokens) const;
+
+    // 缓存存储（LRU，最近使用的在前）
     mutable std::unordered_map<CacheKey, std::list<CacheEntry>::iterator> cache_index_;
     mutable std::list<CacheEntry> cache_list_;
 
+    // 上次估算的历史：每条消息的哈希和token前缀和，历史增长时只计算新增消息
+    mutable std::vector<CacheKey> history_keys_;
+    mutable std::vector<int> history_prefix_;   // history_prefix_[i] = 前i条消息的token总数
+    mutable uint64_t history_version_ = 0;      // 历史每次重建时递增
+
+    // BPE分词器
+    std::shared_ptr<BpeTokenizer> tokenizer_;
+
     // 缓存统计
     mutable std::atomic<size_t> cache_hits_;
     mutable std::atomic<size_t> cache_misses_;
@@ -1,6 +1,8 @@
 // src/plugins/interfaces/iembedded_platform.h
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
@@ -134,12 +136,35 @@ public:
 
     /**
      * @brief Flash firmware to the MCU
+     *
+     * May be called concurrently for different programmer IDs when several
+     * boards are flashed in parallel.
      * @param firmware_path Path to firmware file
      * @param programmer_id ID of programmer to use
      * @return true if flashing successful
      */
     virtual bool flashFirmware(const std::string& firmware_path, const std::string& programmer_id) = 0;
 
+    /**
+     * @brief Flash an in-memory firmware image to the MCU
+     *
+     * Lets callers program exactly the bytes they checksummed, even if the
+     * file is rebuilt in the meantime. The default reports that flashing
+     * from memory is unsupported.
+     * @param firmware_path Path the image was loaded from (format hint)
+     * @param data Firmware file contents
+     * @param programmer_id ID of programmer to use
+     * @return true if flashing successful, or nullopt if unsupported
+     */
+    virtual std::optional<bool> flashFirmwareData(const std::string& firmware_path,
+                                                  const std::vector<uint8_t>& data,
+                                                  const std::string& programmer_id) {
+        (void)firmware_path;
+        (void)data;
+        (void)programmer_id;
+        return std::nullopt;
+    }
+
     /**
      * @brief Verify flashed firmware
      * @param firmware_path Path to original firmware file
@@ -147,6 +172,38 @@ public:
      */
     virtual bool verifyFirmware(const std::string& firmware_path) = 0;
 
+    /**
+     * @brief Verify flashed firmware on one board
+     *
+     * Called when several boards are flashed in parallel. The default
+     * reports that per-board verification is unsupported; verifyFirmware()
+     * cannot tell boards apart, so it is not used as a fallback.
+     * @param firmware_path Path to original firmware file
+     * @param programmer_id ID of programmer attached to the board
+     * @return true if verification successful, or nullopt if unsupported
+     */
+    virtual std::optional<bool> verifyFlashedFirmware(const std::string& firmware_path,
+                                                      const std::string& programmer_id) {
+        (void)firmware_path;
+        (void)programmer_id;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Read back the CRC-32 (IEEE) of the first length bytes of flash
+     *
+     * Lets callers compare one board against the image they hold in memory.
+     * The default reports that read-back is unsupported.
+     * @param programmer_id ID of programmer attached to the board
+     * @param length Number of bytes to checksum
+     * @return Device checksum, or nullopt if unsupported
+     */
+    virtual std::optional<uint32_t> readFlashChecksum(const std::string& programmer_id, size_t length) {
+        (void)programmer_id;
+        (void)length;
+        return std::nullopt;
+    }
+
     // ========================================================================
     // Hardware Detection
     // ========================================================================
@@ -41,6 +41,33 @@ public:
      * @brief Shutdown the plugin and release resources
      */
     virtual void shutdown() = 0;
+
+    /**
+     * @brief Export runtime state for hot reload
+     *
+     * Called on the running instance when PluginManager::reloadPlugin()
+     * replaces it. The default exports nothing.
+     *
+     * @return JSON state to hand to the replacement instance
+     */
+    virtual nlohmann::json exportState() const { return nlohmann::json(); }
+
+    /**
+     * @brief Import state exported by the instance being replaced
+     *
+     * Called on the freshly initialized replacement before it is
+     * published. Returning false aborts the reload and keeps the old
+     * instance. The old instance is still alive at this point, so plugins
+     * that own an exclusive device should defer reopening it until first
+     * use. The default accepts any state.
+     *
+     * @param state State returned by exportState() of the old instance
+     * @return true if the state was accepted
+     */
+    virtual bool importState(const nlohmann::json& state) {
+        (void)state;
+        return true;
+    }
 };
 
 } // namespace roboclaw::plugins
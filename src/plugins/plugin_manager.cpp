@@ -1,9 +1,13 @@
 // src/plugins/plugin_manager.cpp
 #include "plugin_manager.h"
+#include "interfaces/ivision_device.h"
+#include "interfaces/iembedded_platform.h"
+#include "interfaces/isimulation_tool.h"
 
 #include <stdexcept>
 #include <functional>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -13,6 +17,7 @@
         #define PLATFORM_WINDOWS
     #endif
     #include <windows.h>
+    #include <process.h>
 #else
     #if defined(__APPLE__)
         #ifndef PLATFORM_MACOS
@@ -24,12 +29,71 @@
         #endif
     #endif
     #include <dlfcn.h>
+    #include <unistd.h>
 #endif
 
 #include <sys/stat.h>
 
 namespace roboclaw::plugins {
 
+namespace {
+
+// Default manifest cache filename inside an indexed plugin directory
+constexpr const char* DEFAULT_MANIFEST_CACHE = ".plugin_manifests.json";
+
+// Shadow copies share one temp directory across processes and managers;
+// the pid and a process-wide sequence keep their names from colliding
+std::string shadowFileName(const std::string& id, const std::string& extension) {
+    static std::atomic<uint64_t> sequence{0};
+#ifdef PLATFORM_WINDOWS
+    const long pid = static_cast<long>(_getpid());
+#else
+    const long pid = static_cast<long>(getpid());
+#endif
+    return id + "." + std::to_string(pid) + "." + std::to_string(++sequence) + extension;
+}
+
+/**
+ * @brief Copy descriptive fields from a manifest JSON document
+ */
+void applyManifestJson(PluginManifest& manifest, const nlohmann::json& json) {
+    PluginManifest parsed = PluginManifest::fromJson(json);
+    if (!parsed.name.empty()) manifest.name = parsed.name;
+    if (!parsed.version.empty()) manifest.version = parsed.version;
+    manifest.interface_type = parsed.interface_type;
+    manifest.capabilities = parsed.capabilities;
+}
+
+/**
+ * @brief Classify a plugin instance by the most specific interface it implements
+ */
+std::string detectInterfaceType(IPlugin* plugin) {
+    if (dynamic_cast<IVisionDevice*>(plugin)) return "vision_device";
+    if (dynamic_cast<IEmbeddedPlatform*>(plugin)) return "embedded_platform";
+    if (dynamic_cast<ISimulationTool*>(plugin)) return "simulation_tool";
+    return "plugin";
+}
+
+} // namespace
+
+// ============================================================================
+// Loaded Library
+// ============================================================================
+
+struct PluginManager::LoadedLibrary {
+    void* handle = nullptr;
+    std::string path;         // Original library path
+    std::string shadow_path;  // Versioned copy actually loaded (hot reload), removed on close
+
+    ~LoadedLibrary() {
+        PluginManager::unloadLibrary(handle);
+        if (!shadow_path.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(shadow_path, ec);
+        }
+    }
+};
+
 // ============================================================================
 // Constructor/Destructor
 // ============================================================================
@@ -72,68 +136,135 @@ bool PluginManager::loadPlugin(const std::string& path) {
         (void)unloadPlugin_unlocked(id);
     }
 
+    return loadPlugin_unlocked(id, path);
+}
+
+bool PluginManager::loadPlugin_unlocked(const std::string& id, const std::string& path) {
+    // IMPORTANT: mutex_ must already be locked before calling this method
+
     // Load the shared library
-    void* handle = loadLibrary(path);
-    if (!handle) {
-        std::cerr << "PluginManager: Failed to load library '" << path << "': " << getDLError() << std::endl;
+    auto library = openLibrary(path);
+    if (!library) {
         return false;
     }
 
-    // Look for the plugin factory function
-    using CreatePluginFunc = IPlugin* (*)();
-    auto* create_func = reinterpret_cast<CreatePluginFunc>(getSymbol(handle, "create_plugin"));
+    auto plugin = instantiatePlugin(id, library);
+    if (!plugin) {
+        return false;
+    }
 
-    if (!create_func) {
-        std::cerr << "PluginManager: Plugin '" << id << "' missing 'create_plugin' symbol" << std::endl;
-        unloadLibrary(handle);
+    // Register the plugin and store the handle
+    if (!registry_.registerPlugin(id, plugin)) {
+        std::cerr << "PluginManager: Failed to register plugin '" << id << "'" << std::endl;
         return false;
     }
 
-    // Create the plugin instance
-    IPlugin* plugin_raw = create_func();
-    if (!plugin_raw) {
-        std::cerr << "PluginManager: Plugin '" << id << "' factory returned null" << std::endl;
-        unloadLibrary(handle);
+    handles_[id] = std::move(library);
+    return true;
+}
+
+bool PluginManager::reloadPlugin(const std::string& id, const std::string& path) {
+    namespace fs = std::filesystem;
+
+    if (!validateId(id)) {
         return false;
     }
 
-    // Wrap in shared_ptr with custom deleter
-    // NOTE: The deleter may run asynchronously from any thread when the last
-    // shared_ptr reference is released. Plugin implementations must handle this.
-    std::shared_ptr<IPlugin> plugin(plugin_raw, [id](IPlugin* p) {
-        if (p) {
-            p->shutdown();
-            delete p;
+    std::shared_ptr<IPlugin> old_plugin;
+    std::shared_ptr<IPlugin> new_plugin;
+    std::vector<ReloadListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::string source_path = path;
+        if (source_path.empty()) {
+            auto handle_it = handles_.find(id);
+            auto manifest_it = manifests_.find(id);
+            if (handle_it != handles_.end()) {
+                source_path = handle_it->second->path;
+            } else if (manifest_it != manifests_.end()) {
+                source_path = manifest_it->second.path;
+            }
+        }
+        if (!validatePath(source_path) || !fileExists(source_path)) {
+            std::cerr << "PluginManager: Cannot reload '" << id << "': invalid path '" << source_path << "'" << std::endl;
+            return false;
         }
-    });
 
-    // Initialize the plugin with empty config by default
-    nlohmann::json config;
-    try {
-        if (!plugin->initialize(config)) {
-            std::cerr << "PluginManager: Plugin '" << id << "' initialization failed" << std::endl;
-            unloadLibrary(handle);
+        old_plugin = registry_.getPlugin(id);
+        if (!old_plugin) {
+            // Nothing running, nothing to migrate
+            return loadPlugin_unlocked(id, source_path);
+        }
+
+        // Load a versioned shadow copy beside the running library. Loading
+        // the original path again could return the already-mapped image.
+        uint64_t generation = generations_[id] + 1;
+        std::error_code ec;
+        fs::path shadow_dir = fs::temp_directory_path(ec) / "roboclaw_plugins";
+        fs::create_directories(shadow_dir, ec);
+        fs::path shadow_path = shadow_dir / shadowFileName(id, fs::path(source_path).extension().string());
+        fs::copy_file(source_path, shadow_path, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::cerr << "PluginManager: Cannot stage reload of '" << id << "': " << ec.message() << std::endl;
             return false;
         }
-    } catch (const std::exception& e) {
-        // Initialization failed
-        std::cerr << "PluginManager: Plugin '" << id << "' initialization threw exception: " << e.what() << std::endl;
-        unloadLibrary(handle);
-        return false;
-    }
 
-    // Register the plugin and store the handle
-    if (!registry_.registerPlugin(id, plugin)) {
-        std::cerr << "PluginManager: Failed to register plugin '" << id << "'" << std::endl;
-        plugin->shutdown();
-        unloadLibrary(handle);
-        return false;
+        auto library = openLibrary(source_path, shadow_path.string());
+        if (!library) {
+            return false;
+        }
+        new_plugin = instantiatePlugin(id, library);
+        if (!new_plugin) {
+            return false;
+        }
+
+        // Migrate state; a rejected import keeps the old instance running
+        try {
+            if (!new_plugin->importState(old_plugin->exportState())) {
+                std::cerr << "PluginManager: Plugin '" << id << "' rejected migrated state, keeping old instance" << std::endl;
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "PluginManager: Plugin '" << id << "' state migration threw exception: " << e.what() << std::endl;
+            return false;
+        }
+
+        // Publish: readers switch atomically; the old library stays mapped
+        // until the last in-flight holder of old_plugin releases it
+        if (!registry_.registerPlugin(id, new_plugin)) {
+            return false;
+        }
+        handles_[id] = std::move(library);
+        generations_[id] = generation;
+
+        auto manifest_it = manifests_.find(id);
+        if (manifest_it != manifests_.end()) {
+            manifest_it->second.version = new_plugin->getVersion();
+        }
+        listeners = reload_listeners_;
     }
 
-    handles_[id] = handle;
+    for (const auto& listener : listeners) {
+        listener(id, old_plugin, new_plugin);
+    }
     return true;
 }
 
+void PluginManager::addReloadListener(ReloadListener listener) {
+    if (!listener) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    reload_listeners_.push_back(std::move(listener));
+}
+
+uint64_t PluginManager::getPluginGeneration(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = generations_.find(id);
+    return it != generations_.end() ? it->second : 0;
+}
+
 bool PluginManager::unloadPlugin(const std::string& id) {
     if (!validateId(id)) {
         return false;
@@ -154,38 +285,58 @@ bool PluginManager::unloadPlugin_unlocked(const std::string& id) {
     // Unregister from registry (this will trigger plugin shutdown via shared_ptr deleter)
     registry_.unregisterPlugin(id);
 
-    // Close the library handle
-    unloadLibrary(handle_it->second);
-
+    // Drop our library reference; it closes once no plugin instance needs it
     handles_.erase(handle_it);
     return true;
 }
 
-std::shared_ptr<IPlugin> PluginManager::getPlugin(const std::string& id) const {
+std::shared_ptr<IPlugin> PluginManager::getPlugin(const std::string& id) {
     if (!validateId(id)) {
         return nullptr;
     }
 
+    // Fast path: loaded plugins are served from the registry snapshot without locking
+    if (auto plugin = registry_.getPlugin(id)) {
+        return plugin;
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
+    if (auto plugin = registry_.getPlugin(id)) {
+        return plugin;  // Loaded by another thread meanwhile
+    }
+
+    // Not loaded yet - load on first use if it is indexed
+    auto manifest_it = manifests_.find(id);
+    if (manifest_it == manifests_.end()) {
+        return nullptr;
+    }
+
+    if (!loadPlugin_unlocked(id, manifest_it->second.path)) {
+        // Drop it from the index so every later lookup does not retry dlopen
+        manifests_.erase(manifest_it);
+        return nullptr;
+    }
     return registry_.getPlugin(id);
 }
 
 std::vector<std::string> PluginManager::listPlugins() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     return registry_.listPlugins();
 }
 
 void PluginManager::shutdown() {
+    // Stop prefetching before taking the lock the prefetch task needs
+    cancel_prefetch_.store(true);
+    waitForPrefetch();
+
     std::lock_guard<std::mutex> lock(mutex_);
 
     // Unregister all plugins (this will trigger shutdown via shared_ptr deleters)
     registry_.clear();
 
-    // Close all library handles
-    for (auto& [id, handle] : handles_) {
-        unloadLibrary(handle);
-    }
+    // Release library handles (closed once no plugin instance needs them)
     handles_.clear();
+    manifests_.clear();
+    // generations_ is kept: reload counts stay monotonic across restarts
 }
 
 bool PluginManager::isLoaded(const std::string& id) const {
@@ -210,7 +361,7 @@ bool PluginManager::empty() const {
 size_t PluginManager::loadPluginsFromDirectory(const std::string& directory) {
     namespace fs = std::filesystem;
 
-    size_t loaded_count = 0;
+    size_t indexed_count = 0;
 
     try {
         fs::path dir_path(directory);
@@ -220,33 +371,111 @@ size_t PluginManager::loadPluginsFromDirectory(const std::string& directory) {
             return 0;
         }
 
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::string cache_path = manifest_cache_path_.empty()
+            ? (dir_path / DEFAULT_MANIFEST_CACHE).string()
+            : manifest_cache_path_;
+        manifest_cache_.load(cache_path);
+
         // Iterate through directory entries
         for (const auto& entry : fs::directory_iterator(dir_path)) {
             if (!entry.is_regular_file()) {
                 continue;
             }
 
-            std::string path = entry.path().string();
+            std::string path = fs::absolute(entry.path()).string();
 
             // Check if file has valid library extension
             if (!validatePath(path)) {
                 continue;
             }
 
-            // Try to load the plugin
-            if (loadPlugin(path)) {
-                ++loaded_count;
+            // Index the plugin; it is loaded on first getPlugin()
+            if (auto manifest = indexLibrary_unlocked(path)) {
+                manifests_[manifest->id] = std::move(*manifest);
+                ++indexed_count;
             }
         }
+
+        // A read-only plugin directory just means re-probing next time
+        (void)manifest_cache_.save();
     } catch (const fs::filesystem_error&) {
         // Directory access error - return count so far
-        return loaded_count;
+        return indexed_count;
     } catch (const std::exception&) {
         // Other errors - return count so far
-        return loaded_count;
+        return indexed_count;
+    }
+
+    return indexed_count;
+}
+
+void PluginManager::setManifestCachePath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    manifest_cache_path_ = path;
+}
+
+std::vector<PluginManifest> PluginManager::listAvailablePlugins() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<PluginManifest> manifests;
+    manifests.reserve(manifests_.size());
+    for (const auto& [_, manifest] : manifests_) {
+        manifests.push_back(manifest);
+    }
+    return manifests;
+}
+
+std::optional<PluginManifest> PluginManager::getManifest(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = manifests_.find(id);
+    if (it == manifests_.end()) {
+        return std::nullopt;
     }
+    return it->second;
+}
+
+std::vector<std::string> PluginManager::findPluginsByInterface(const std::string& interface_type) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> ids;
+    for (const auto& [id, manifest] : manifests_) {
+        if (manifest.interface_type == interface_type) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+void PluginManager::prefetchPlugins(const std::vector<std::string>& ids) {
+    std::lock_guard<std::mutex> prefetch_lock(prefetch_mutex_);
+    if (prefetch_task_.valid()) {
+        prefetch_task_.wait();
+    }
+
+    std::vector<std::string> targets = ids;
+    if (targets.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [id, _] : manifests_) {
+            targets.push_back(id);
+        }
+    }
+
+    cancel_prefetch_.store(false);
+    prefetch_task_ = std::async(std::launch::async, [this, targets = std::move(targets)]() {
+        for (const auto& id : targets) {
+            if (cancel_prefetch_.load()) {
+                break;
+            }
+            (void)getPlugin(id);
+        }
+    });
+}
 
-    return loaded_count;
+void PluginManager::waitForPrefetch() {
+    std::lock_guard<std::mutex> prefetch_lock(prefetch_mutex_);
+    if (prefetch_task_.valid()) {
+        prefetch_task_.wait();
+    }
 }
 
 // ============================================================================
@@ -294,6 +523,171 @@ std::string PluginManager::extractPluginId(const std::string& path) const {
     }
 }
 
+std::shared_ptr<PluginManager::LoadedLibrary> PluginManager::openLibrary(const std::string& path,
+                                                                         const std::string& shadow_path) {
+    const std::string& load_path = shadow_path.empty() ? path : shadow_path;
+    void* handle = loadLibrary(load_path);
+    if (!handle) {
+        std::cerr << "PluginManager: Failed to load library '" << load_path << "': " << getDLError() << std::endl;
+        if (!shadow_path.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(shadow_path, ec);
+        }
+        return nullptr;
+    }
+
+    auto library = std::make_shared<LoadedLibrary>();
+    library->handle = handle;
+    library->path = path;
+    library->shadow_path = shadow_path;
+    return library;
+}
+
+std::shared_ptr<IPlugin> PluginManager::instantiatePlugin(const std::string& id,
+                                                          const std::shared_ptr<LoadedLibrary>& library) {
+    // Look for the plugin factory function
+    using CreatePluginFunc = IPlugin* (*)();
+    auto* create_func = reinterpret_cast<CreatePluginFunc>(getSymbol(library->handle, "create_plugin"));
+
+    if (!create_func) {
+        std::cerr << "PluginManager: Plugin '" << id << "' missing 'create_plugin' symbol" << std::endl;
+        return nullptr;
+    }
+
+    // Create the plugin instance
+    IPlugin* plugin_raw = create_func();
+    if (!plugin_raw) {
+        std::cerr << "PluginManager: Plugin '" << id << "' factory returned null" << std::endl;
+        return nullptr;
+    }
+
+    // Wrap in shared_ptr with custom deleter
+    // NOTE: The deleter may run asynchronously from any thread when the last
+    // shared_ptr reference is released. Plugin implementations must handle this.
+    // The deleter owns a library reference so the code stays mapped until
+    // the instance is destroyed.
+    std::shared_ptr<IPlugin> plugin(plugin_raw, [library](IPlugin* p) {
+        if (p) {
+            p->shutdown();
+            delete p;
+        }
+    });
+
+    // Initialize the plugin with empty config by default
+    nlohmann::json config;
+    try {
+        if (!plugin->initialize(config)) {
+            std::cerr << "PluginManager: Plugin '" << id << "' initialization failed" << std::endl;
+            return nullptr;
+        }
+    } catch (const std::exception& e) {
+        // Initialization failed
+        std::cerr << "PluginManager: Plugin '" << id << "' initialization threw exception: " << e.what() << std::endl;
+        return nullptr;
+    }
+
+    return plugin;
+}
+
+std::optional<PluginManifest> PluginManager::indexLibrary_unlocked(const std::string& path) {
+    // IMPORTANT: mutex_ must already be locked before calling this method
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    auto write_time = fs::last_write_time(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    int64_t mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        write_time.time_since_epoch()).count();
+
+    PluginManifest manifest;
+    manifest.id = extractPluginId(path);
+    manifest.path = path;
+    manifest.name = manifest.id;
+    manifest.interface_type = "plugin";
+    manifest.mtime = mtime;
+    manifest.size = size;
+    if (!validateId(manifest.id)) {
+        return std::nullopt;
+    }
+
+    // 1. Sidecar manifest shipped next to the library: authoritative, no dlopen
+    fs::path sidecar = fs::path(path).replace_extension(".manifest.json");
+    if (fs::exists(sidecar, ec)) {
+        std::ifstream file(sidecar);
+        try {
+            applyManifestJson(manifest, nlohmann::json::parse(file));
+            return manifest;
+        } catch (const std::exception& e) {
+            std::cerr << "PluginManager: Ignoring invalid manifest '" << sidecar.string()
+                      << "': " << e.what() << std::endl;
+        }
+    }
+
+    // 2. Cached result of an earlier probe of the same file
+    if (auto cached = manifest_cache_.lookup(path, mtime, size)) {
+        return cached;
+    }
+
+    // 3. Probe once and remember the result
+    manifest.hash = PluginManifestCache::hashFile(path);
+    if (!probeLibrary(manifest)) {
+        return std::nullopt;
+    }
+    manifest_cache_.put(manifest);
+    return manifest;
+}
+
+bool PluginManager::probeLibrary(PluginManifest& manifest) {
+    void* handle = loadLibrary(manifest.path);
+    if (!handle) {
+        std::cerr << "PluginManager: Failed to probe library '" << manifest.path << "': "
+                  << getDLError() << std::endl;
+        return false;
+    }
+
+    bool ok = false;
+    using ManifestFunc = const char* (*)();
+    using CreatePluginFunc = IPlugin* (*)();
+
+    if (auto* manifest_func = reinterpret_cast<ManifestFunc>(getSymbol(handle, "plugin_manifest"))) {
+        try {
+            const char* json = manifest_func();
+            applyManifestJson(manifest, nlohmann::json::parse(json ? json : "{}"));
+            ok = true;
+        } catch (const std::exception& e) {
+            std::cerr << "PluginManager: Plugin '" << manifest.id << "' returned invalid manifest: "
+                      << e.what() << std::endl;
+        }
+    } else if (auto* create_func = reinterpret_cast<CreatePluginFunc>(getSymbol(handle, "create_plugin"))) {
+        // Throwaway instance: inspected but never initialized
+        IPlugin* plugin = nullptr;
+        try {
+            plugin = create_func();
+            if (plugin) {
+                manifest.name = plugin->getName();
+                manifest.version = plugin->getVersion();
+                manifest.interface_type = detectInterfaceType(plugin);
+                ok = true;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "PluginManager: Plugin '" << manifest.id << "' probe threw exception: "
+                      << e.what() << std::endl;
+        }
+        delete plugin;
+    } else {
+        std::cerr << "PluginManager: Plugin '" << manifest.id << "' missing 'create_plugin' symbol" << std::endl;
+    }
+
+    unloadLibrary(handle);
+    return ok;
+}
+
 bool PluginManager::fileExists(const std::string& path) const {
     #ifdef PLATFORM_WINDOWS
         struct _stat buffer;
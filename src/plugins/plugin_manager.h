@@ -8,8 +8,13 @@
 #include <mutex>
 #include <stdexcept>
 #include <filesystem>
+#include <future>
+#include <atomic>
+#include <optional>
+#include <functional>
 
 #include "plugin_registry.h"
+#include "plugin_manifest.h"
 #include "plugin.h"
 
 namespace roboclaw::plugins {
@@ -27,9 +32,31 @@ namespace roboclaw::plugins {
  * - Plugin lifecycle management (initialize, shutdown, unload)
  * - Error handling for load failures
  * - Platform-specific library extension handling
+ * - Manifest index with lazy loading: directory scans record each library's
+ *   id, interface, version and capabilities without dlopen (when a cached or
+ *   sidecar manifest exists); the library is loaded on first getPlugin()
+ * - Hot reload: a new build is loaded beside the running one, state is
+ *   migrated through IPlugin::exportState()/importState() and the
+ *   replacement is published atomically
+ *
+ * Library lifetime follows plugin lifetime: every plugin instance keeps a
+ * reference to the library it came from, so a library is closed only
+ * after the last shared_ptr to its plugin (including copies held by
+ * in-flight frames or tool calls) is released.
  */
 class PluginManager {
 public:
+    /**
+     * @brief Callback invoked after a plugin was hot-reloaded
+     *
+     * Runs on the reloading thread without the manager lock held. Use it
+     * to switch consumers to the new instance, e.g.
+     * VisionPipeline::replaceSource() or WorkflowController::setPlatform().
+     */
+    using ReloadListener = std::function<void(const std::string& id,
+                                              const std::shared_ptr<IPlugin>& old_plugin,
+                                              const std::shared_ptr<IPlugin>& new_plugin)>;
+
     PluginManager() = default;
     ~PluginManager();
 
@@ -54,21 +81,107 @@ public:
     [[nodiscard]] bool loadPlugin(const std::string& path);
 
     /**
-     * @brief Load all plugins from a directory
+     * @brief Index all plugins in a directory for lazy loading
      *
      * Scans the specified directory for shared libraries (.so/.dylib/.dll)
-     * and attempts to load each one. The plugin ID is extracted from the
-     * library filename (without extension).
+     * and records a manifest for each one. Manifests come from, in order:
+     * a sidecar "<id>.manifest.json" next to the library, the manifest
+     * cache (matched by mtime/size, then content hash), or a one-time probe
+     * that loads the library, reads its metadata and unloads it again.
+     * No plugin is created or initialized here; that happens on the first
+     * getPlugin() call or through prefetchPlugins().
      *
      * @param directory Path to the directory containing plugin libraries
-     * @return Number of plugins successfully loaded
+     * @return Number of plugins indexed
      */
     [[nodiscard]] size_t loadPluginsFromDirectory(const std::string& directory);
 
+    /**
+     * @brief Set the manifest cache file
+     *
+     * Defaults to ".plugin_manifests.json" inside the directory passed to
+     * loadPluginsFromDirectory(). Must be called before indexing.
+     *
+     * @param path Path to the cache file
+     */
+    void setManifestCachePath(const std::string& path);
+
+    /**
+     * @brief List manifests of all indexed plugins, loaded or not
+     *
+     * @return Vector of plugin manifests
+     */
+    [[nodiscard]] std::vector<PluginManifest> listAvailablePlugins() const;
+
+    /**
+     * @brief Get the manifest of an indexed plugin without loading it
+     *
+     * @param id The plugin identifier
+     * @return Manifest, or nullopt if the plugin is not indexed
+     */
+    [[nodiscard]] std::optional<PluginManifest> getManifest(const std::string& id) const;
+
+    /**
+     * @brief Find indexed plugins implementing an interface
+     *
+     * @param interface_type Interface name (e.g. "vision_device")
+     * @return Vector of plugin IDs
+     */
+    [[nodiscard]] std::vector<std::string> findPluginsByInterface(const std::string& interface_type) const;
+
+    /**
+     * @brief Load indexed plugins in the background
+     *
+     * Runs on a single background task so startup is not blocked. Plugins
+     * that fail to load are skipped; getPlugin() reports them as nullptr.
+     *
+     * @param ids Plugins to prefetch; empty means all indexed plugins
+     */
+    void prefetchPlugins(const std::vector<std::string>& ids = {});
+
+    /**
+     * @brief Block until a running prefetch has finished
+     */
+    void waitForPrefetch();
+
+    /**
+     * @brief Hot-reload a loaded plugin from a new build
+     *
+     * Copies the library to a versioned shadow path (so the dynamic loader
+     * maps a fresh image even if the file was overwritten in place), loads
+     * and initializes the new instance beside the running one, migrates
+     * state via exportState()/importState(), swaps the registry entry and
+     * notifies reload listeners. On any failure the running instance is
+     * left untouched. If the plugin is not loaded yet it is simply loaded.
+     *
+     * @param id The plugin identifier
+     * @param path New library path; empty reuses the current path
+     * @return true if the new instance is now active
+     */
+    [[nodiscard]] bool reloadPlugin(const std::string& id, const std::string& path = "");
+
+    /**
+     * @brief Register a callback for completed hot reloads
+     *
+     * @param listener Callback receiving the old and new instance
+     */
+    void addReloadListener(ReloadListener listener);
+
+    /**
+     * @brief Number of successful hot reloads of a plugin
+     *
+     * The count is not reset by shutdown().
+     *
+     * @param id The plugin identifier
+     * @return Reload generation, 0 if never reloaded
+     */
+    [[nodiscard]] uint64_t getPluginGeneration(const std::string& id) const;
+
     /**
      * @brief Unload a plugin by ID
      *
-     * Shuts down the plugin and unloads the shared library.
+     * Shuts down the plugin and unloads the shared library once no
+     * caller holds the plugin any more.
      * If the plugin ID doesn't exist, this operation is a no-op.
      *
      * @param id The plugin identifier to unload
@@ -77,12 +190,12 @@ public:
     [[nodiscard]] bool unloadPlugin(const std::string& id);
 
     /**
-     * @brief Get a loaded plugin by ID
+     * @brief Get a plugin by ID, loading it on first use if it is indexed
      *
      * @param id The plugin identifier
-     * @return Shared pointer to the plugin, or nullptr if not found
+     * @return Shared pointer to the plugin, or nullptr if not found or the load failed
      */
-    [[nodiscard]] std::shared_ptr<IPlugin> getPlugin(const std::string& id) const;
+    [[nodiscard]] std::shared_ptr<IPlugin> getPlugin(const std::string& id);
 
     /**
      * @brief List all loaded plugin IDs
@@ -94,7 +207,8 @@ public:
     /**
      * @brief Shutdown all loaded plugins and release resources
      *
-     * Unloads all plugins and closes all shared library handles.
+     * Waits for a running prefetch, unloads all plugins, closes all shared
+     * library handles and forgets the manifest index.
      * After calling this method, the manager is in its initial state.
      */
     void shutdown();
@@ -186,6 +300,64 @@ private:
      */
     [[nodiscard]] bool unloadPlugin_unlocked(const std::string& id);
 
+    /**
+     * @brief Load, create, initialize and register a plugin
+     *
+     * IMPORTANT: The mutex_ must be locked before calling this method.
+     *
+     * @param id Plugin identifier
+     * @param path Path to the shared library
+     * @return true if the plugin was loaded successfully
+     */
+    [[nodiscard]] bool loadPlugin_unlocked(const std::string& id, const std::string& path);
+
+    /**
+     * @brief Build a manifest for a library (cache, sidecar or probe)
+     *
+     * IMPORTANT: The mutex_ must be locked before calling this method.
+     *
+     * @param path Path to the shared library
+     * @return Manifest, or nullopt if the library is not a usable plugin
+     */
+    [[nodiscard]] std::optional<PluginManifest> indexLibrary_unlocked(const std::string& path);
+
+    /**
+     * @brief Read metadata by loading the library once and unloading it
+     *
+     * Uses the optional "plugin_manifest" export (a function returning a
+     * JSON string) if present, otherwise creates a throwaway instance via
+     * "create_plugin" and inspects it without initializing it.
+     *
+     * @param manifest Manifest to fill in (id and path already set)
+     * @return true if the library was probed successfully
+     */
+    [[nodiscard]] bool probeLibrary(PluginManifest& manifest);
+
+    // Open shared library; closes itself when the last owner releases it
+    struct LoadedLibrary;
+
+    /**
+     * @brief Open a library and wrap its handle
+     *
+     * @param path Original library path
+     * @param shadow_path Copy to actually load (removed on close); empty loads path
+     * @return Library, or nullptr on failure
+     */
+    [[nodiscard]] std::shared_ptr<LoadedLibrary> openLibrary(const std::string& path,
+                                                             const std::string& shadow_path = "");
+
+    /**
+     * @brief Create and initialize a plugin instance from an open library
+     *
+     * The returned instance owns a reference to the library.
+     *
+     * @param id Plugin identifier (for diagnostics)
+     * @param library Open library exporting "create_plugin"
+     * @return Initialized plugin, or nullptr on failure
+     */
+    [[nodiscard]] std::shared_ptr<IPlugin> instantiatePlugin(const std::string& id,
+                                                             const std::shared_ptr<LoadedLibrary>& library);
+
     /**
      * @brief Platform-specific plugin loading implementation
      *
@@ -199,7 +371,7 @@ private:
      *
      * @param handle Handle to the loaded library
      */
-    void unloadLibrary(void* handle);
+    static void unloadLibrary(void* handle);
 
     /**
      * @brief Platform-specific symbol lookup implementation
@@ -213,8 +385,24 @@ private:
     // Plugin registry for managing plugin instances
     PluginRegistry<IPlugin> registry_;
 
-    // Map of plugin IDs to their library handles
-    std::unordered_map<std::string, void*> handles_;
+    // Map of plugin IDs to their (shared) library handles
+    std::unordered_map<std::string, std::shared_ptr<LoadedLibrary>> handles_;
+
+    // Hot reload bookkeeping
+    std::unordered_map<std::string, uint64_t> generations_;
+    std::vector<ReloadListener> reload_listeners_;
+
+    // Manifest index of plugins that can be loaded on demand
+    std::unordered_map<std::string, PluginManifest> manifests_;
+
+    // Persistent manifest cache and its location
+    PluginManifestCache manifest_cache_;
+    std::string manifest_cache_path_;
+
+    // Background prefetch task
+    std::future<void> prefetch_task_;
+    std::atomic<bool> cancel_prefetch_{false};
+    std::mutex prefetch_mutex_;
 
     // Mutex for thread safety
     mutable std::mutex mutex_;
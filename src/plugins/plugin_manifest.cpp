@@ -0,0 +1,174 @@
+// src/plugins/plugin_manifest.cpp
+#include "plugins/plugin_manifest.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace roboclaw::plugins {
+
+namespace {
+
+constexpr int CACHE_FORMAT_VERSION = 1;
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+} // namespace
+
+// ============================================================================
+// PluginManifest
+// ============================================================================
+
+nlohmann::json PluginManifest::toJson() const {
+    return {
+        {"id", id},
+        {"path", path},
+        {"name", name},
+        {"version", version},
+        {"interface", interface_type},
+        {"capabilities", capabilities},
+        {"mtime", mtime},
+        {"size", size},
+        {"hash", hash}
+    };
+}
+
+PluginManifest PluginManifest::fromJson(const nlohmann::json& json) {
+    PluginManifest manifest;
+    manifest.id = json.value("id", "");
+    manifest.path = json.value("path", "");
+    manifest.name = json.value("name", "");
+    manifest.version = json.value("version", "");
+    manifest.interface_type = json.value("interface", "plugin");
+    if (json.contains("capabilities") && json["capabilities"].is_array()) {
+        for (const auto& cap : json["capabilities"]) {
+            if (cap.is_string()) {
+                manifest.capabilities.push_back(cap.get<std::string>());
+            }
+        }
+    }
+    manifest.mtime = json.value("mtime", int64_t{0});
+    manifest.size = json.value("size", uint64_t{0});
+    manifest.hash = json.value("hash", uint64_t{0});
+    return manifest;
+}
+
+// ============================================================================
+// PluginManifestCache
+// ============================================================================
+
+void PluginManifestCache::load(const std::string& path) {
+    path_ = path;
+    entries_.clear();
+    dirty_ = false;
+
+    std::ifstream file(path);
+    if (!file) {
+        return;
+    }
+
+    try {
+        nlohmann::json json = nlohmann::json::parse(file);
+        if (json.value("format", 0) != CACHE_FORMAT_VERSION || !json.contains("plugins")) {
+            return;
+        }
+        for (const auto& entry : json["plugins"]) {
+            PluginManifest manifest = PluginManifest::fromJson(entry);
+            if (!manifest.path.empty()) {
+                entries_[manifest.path] = std::move(manifest);
+            }
+        }
+    } catch (const std::exception&) {
+        // Corrupt cache - start over, it will be rewritten on save()
+        entries_.clear();
+        dirty_ = true;
+    }
+}
+
+bool PluginManifestCache::save() {
+    namespace fs = std::filesystem;
+
+    if (!dirty_ || path_.empty()) {
+        return true;
+    }
+
+    nlohmann::json plugins = nlohmann::json::array();
+    for (const auto& [_, manifest] : entries_) {
+        plugins.push_back(manifest.toJson());
+    }
+    nlohmann::json json = {{"format", CACHE_FORMAT_VERSION}, {"plugins", plugins}};
+
+    // Write to a temp file and rename so readers never see a partial cache
+    std::string temp_path = path_ + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file << json.dump();
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(temp_path, path_, ec);
+    if (ec) {
+        fs::remove(temp_path, ec);
+        return false;
+    }
+
+    dirty_ = false;
+    return true;
+}
+
+std::optional<PluginManifest> PluginManifestCache::lookup(const std::string& path,
+                                                          int64_t mtime,
+                                                          uint64_t size) {
+    auto it = entries_.find(path);
+    if (it == entries_.end() || it->second.size != size) {
+        return std::nullopt;
+    }
+
+    if (it->second.mtime != mtime) {
+        // Touched but possibly identical: only the content hash can tell
+        if (it->second.hash == 0 || hashFile(path) != it->second.hash) {
+            return std::nullopt;
+        }
+        it->second.mtime = mtime;
+        dirty_ = true;
+    }
+
+    return it->second;
+}
+
+void PluginManifestCache::put(const PluginManifest& manifest) {
+    entries_[manifest.path] = manifest;
+    dirty_ = true;
+}
+
+void PluginManifestCache::clear() {
+    if (!entries_.empty()) {
+        dirty_ = true;
+    }
+    entries_.clear();
+}
+
+uint64_t PluginManifestCache::hashFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        std::streamsize count = file.gcount();
+        for (std::streamsize i = 0; i < count; ++i) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+} // namespace roboclaw::plugins
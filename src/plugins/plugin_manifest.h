@@ -0,0 +1,92 @@
+// src/plugins/plugin_manifest.h
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace roboclaw::plugins {
+
+/**
+ * @brief Static description of a plugin library
+ *
+ * Everything needed to list and query a plugin without loading it. The
+ * file identity fields (mtime, size, hash) decide whether a cached
+ * manifest still describes the library on disk.
+ */
+struct PluginManifest {
+    std::string id;                         // Library filename without extension
+    std::string path;                       // Absolute path to the library
+    std::string name;                       // IPlugin::getName()
+    std::string version;                    // IPlugin::getVersion()
+    std::string interface_type;             // "vision_device", "embedded_platform", "simulation_tool" or "plugin"
+    std::vector<std::string> capabilities;  // Free-form capability tags
+    int64_t mtime = 0;                      // Modification time (ns since epoch)
+    uint64_t size = 0;                      // File size in bytes
+    uint64_t hash = 0;                      // FNV-1a 64 of the file contents
+
+    nlohmann::json toJson() const;
+    static PluginManifest fromJson(const nlohmann::json& json);
+};
+
+/**
+ * @brief Persistent cache of plugin manifests keyed by library path
+ *
+ * A lookup hits when mtime and size match. If only the mtime changed
+ * (the file was touched or re-copied) the content hash is compared
+ * before the entry is discarded, so re-installing identical plugins does
+ * not force a re-probe. Not thread-safe; PluginManager guards it.
+ */
+class PluginManifestCache {
+public:
+    PluginManifestCache() = default;
+
+    /**
+     * @brief Load cache entries from a JSON file
+     * @param path Cache file path; a missing or corrupt file yields an empty cache
+     */
+    void load(const std::string& path);
+
+    /**
+     * @brief Write the cache back if it changed since load()
+     * @return true if the file is up to date
+     */
+    bool save();
+
+    /**
+     * @brief Find a manifest that still matches the library on disk
+     * @param path Library path
+     * @param mtime Current modification time
+     * @param size Current file size
+     * @return Cached manifest with refreshed identity, or nullopt on miss
+     */
+    std::optional<PluginManifest> lookup(const std::string& path, int64_t mtime, uint64_t size);
+
+    /**
+     * @brief Insert or replace the manifest for manifest.path
+     */
+    void put(const PluginManifest& manifest);
+
+    /**
+     * @brief Drop all entries
+     */
+    void clear();
+
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * @brief FNV-1a 64 hash of a file's contents
+     * @return Hash, or 0 if the file cannot be read
+     */
+    static uint64_t hashFile(const std::string& path);
+
+private:
+    std::string path_;
+    std::unordered_map<std::string, PluginManifest> entries_;
+    bool dirty_ = false;
+};
+
+} // namespace roboclaw::plugins
@@ -1,6 +1,8 @@
 // src/plugins/plugin_registry.h
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,6 +12,49 @@
 
 namespace roboclaw::plugins {
 
+template<typename T>
+class PluginRegistry;
+
+/**
+ * @brief Cacheable typed reference to a registered plugin
+ *
+ * A handle owns its plugin through shared ownership, so it stays valid
+ * after the plugin is unregistered or replaced. Callers on hot paths
+ * (frame callbacks, tool dispatch) keep a handle and call
+ * PluginRegistry::refresh() instead of looking the plugin up per call;
+ * refresh() costs one atomic load when nothing changed.
+ *
+ * @tparam T The plugin interface type
+ */
+template<typename T>
+class PluginHandle {
+public:
+    PluginHandle() = default;
+
+    T* operator->() const { return plugin_.get(); }
+    T& operator*() const { return *plugin_; }
+    explicit operator bool() const { return plugin_ != nullptr; }
+
+    /**
+     * @brief Get the owned plugin
+     */
+    [[nodiscard]] const std::shared_ptr<T>& get() const { return plugin_; }
+
+    /**
+     * @brief Registry version this handle was resolved against
+     */
+    [[nodiscard]] uint64_t version() const { return version_; }
+
+private:
+    friend class PluginRegistry<T>;
+
+    PluginHandle(std::shared_ptr<T> plugin, uint64_t version)
+        : plugin_(std::move(plugin)), version_(version) {}
+
+    std::shared_ptr<T> plugin_;
+    uint64_t version_ = 0;
+};
+
 /**
  * @brief Thread-safe registry for managing plugin instances
  *
@@ -17,21 +62,33 @@ namespace roboclaw::plugins {
  * of a specific type. It provides thread-safe operations for registering,
  * retrieving, listing, and unregistering plugins.
  *
+ * Reads use read-copy-update: the plugin map is an immutable snapshot
+ * published through an atomic shared_ptr. getPlugin() and listPlugins()
+ * never block on the writer mutex, which is held while a writer copies
+ * the current map, modifies the copy and swaps it in. Loading the
+ * snapshot is not wait-free, though: atomic<shared_ptr> is not lock-free
+ * in common standard libraries (libstdc++ guards it with an internal
+ * spin bit, and the atomic_load fallback uses a global mutex pool), so a
+ * reader can briefly wait on a concurrent load or store of the pointer.
+ * Readers holding an older snapshot keep it alive until they drop it.
+ *
  * @tparam T The base plugin interface type (e.g., IPlugin)
  */
 template<typename T>
 class PluginRegistry {
 public:
-    PluginRegistry() = default;
+    using PluginMap = std::unordered_map<std::string, std::shared_ptr<T>>;
+
+    PluginRegistry() : snapshot_(std::make_shared<const PluginMap>()) {}
     ~PluginRegistry() = default;
 
     // Disable copy to avoid accidental duplication of plugin instances
     PluginRegistry(const PluginRegistry&) = delete;
     PluginRegistry& operator=(const PluginRegistry&) = delete;
 
-    // Enable move
-    PluginRegistry(PluginRegistry&&) = default;
-    PluginRegistry& operator=(PluginRegistry&&) = default;
+    // Disable move (atomic snapshot and mutex are not movable)
+    PluginRegistry(PluginRegistry&&) = delete;
+    PluginRegistry& operator=(PluginRegistry&&) = delete;
 
     /**
      * @brief Register a plugin with a unique ID
@@ -51,8 +108,10 @@ public:
             return false;
         }
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        plugins_[id] = plugin;
+        update([&](PluginMap& plugins) {
+            plugins[id] = std::move(plugin);
+            return true;
+        });
         return true;
     }
 
@@ -63,9 +122,69 @@ public:
      * @return Shared pointer to the plugin, or nullptr if not found
      */
     [[nodiscard]] std::shared_ptr<T> getPlugin(const std::string& id) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = plugins_.find(id);
-        return (it != plugins_.end()) ? it->second : nullptr;
+        auto plugins = snapshot();
+        auto it = plugins->find(id);
+        return (it != plugins->end()) ? it->second : nullptr;
+    }
+
+    /**
+     * @brief Resolve a cacheable handle to a plugin
+     *
+     * @param id The plugin identifier
+     * @return Handle; empty if the plugin is not registered
+     */
+    [[nodiscard]] PluginHandle<T> getHandle(const std::string& id) const {
+        // Read the version first: a concurrent write can only make the
+        // handle look stale, never make a stale handle look current
+        uint64_t version = version_.load(std::memory_order_acquire);
+        return PluginHandle<T>(getPlugin(id), version);
+    }
+
+    /**
+     * @brief Check whether a handle was resolved against the current registry
+     *
+     * @param handle Handle to check
+     * @return true if no registration change happened since it was resolved
+     */
+    [[nodiscard]] bool isCurrent(const PluginHandle<T>& handle) const {
+        return handle.version_ == version_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Re-resolve a cached handle if the registry changed
+     *
+     * @param handle Handle to refresh in place
+     * @param id The plugin identifier the handle refers to
+     * @return true if the handle refers to a registered plugin afterwards
+     */
+    bool refresh(PluginHandle<T>& handle, const std::string& id) const {
+        if (!isCurrent(handle)) {
+            handle = getHandle(id);
+        }
+        return static_cast<bool>(handle);
+    }
+
+    /**
+     * @brief Get the current immutable snapshot of all plugins
+     *
+     * Iterating the snapshot needs no lock and no copy; it reflects the
+     * registry at the time of the call.
+     *
+     * @return Shared pointer to the plugin map
+     */
+    [[nodiscard]] std::shared_ptr<const PluginMap> snapshot() const {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return snapshot_.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+#endif
+    }
+
+    /**
+     * @brief Registry version, incremented by every registration change
+     */
+    [[nodiscard]] uint64_t version() const {
+        return version_.load(std::memory_order_acquire);
     }
 
     /**
@@ -74,10 +193,10 @@ public:
      * @return Vector of plugin IDs
      */
     std::vector<std::string> listPlugins() const {
-        std::lock_guard<std::mutex> lock(mutex_);
+        auto plugins = snapshot();
         std::vector<std::string> ids;
-        ids.reserve(plugins_.size());
-        for (const auto& [id, _] : plugins_) {
+        ids.reserve(plugins->size());
+        for (const auto& [id, _] : *plugins) {
             ids.push_back(id);
         }
         return ids;
@@ -87,25 +206,27 @@ public:
      * @brief Unregister a plugin by ID
      *
      * If the plugin ID doesn't exist, this operation is a no-op.
+     * Handles and snapshots that still reference the plugin keep it alive.
      *
      * @param id The plugin identifier to remove
      */
     void unregisterPlugin(const std::string& id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        plugins_.erase(id);
+        update([&](PluginMap& plugins) {
+            return plugins.erase(id) > 0;
+        });
     }
 
     /**
      * @brief Load plugins from a directory
      *
-     * NOTE: This is a stub method. Dynamic plugin loading will be
-     *       implemented in Task 1.3 (Plugin Manager). Currently, this
-     *       method does nothing and ignores the provided path.
+     * NOTE: The registry only holds instances. Directory discovery, the
+     *       manifest index and lazy loading live in
+     *       PluginManager::loadPluginsFromDirectory(); this method is kept
+     *       as a no-op for API compatibility.
      *
-     * @param path Path to the directory containing plugins (currently ignored)
+     * @param path Path to the directory containing plugins (ignored)
      */
     void loadPluginsFromDirectory(const std::string& path) {
-        // Stub: Not yet implemented - will be done in Task 1.3 (Plugin Manager)
         (void)path; // Suppress unused parameter warning
     }
 
@@ -115,8 +236,7 @@ public:
      * @return Number of plugins in the registry
      */
     size_t size() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return plugins_.size();
+        return snapshot()->size();
     }
 
     /**
@@ -125,21 +245,52 @@ public:
      * @return true if no plugins are registered
      */
     bool empty() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return plugins_.empty();
+        return snapshot()->empty();
     }
 
     /**
      * @brief Clear all plugins from the registry
      */
     void clear() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        plugins_.clear();
+        update([](PluginMap& plugins) {
+            bool changed = !plugins.empty();
+            plugins.clear();
+            return changed;
+        });
     }
 
 private:
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, std::shared_ptr<T>> plugins_;
+    /**
+     * @brief Copy-modify-publish a new snapshot
+     *
+     * @param mutate Applied to a private copy; returns false if nothing changed
+     */
+    template<typename F>
+    void update(F&& mutate) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto next = std::make_shared<PluginMap>(*snapshot());
+        if (!mutate(*next)) {
+            return;
+        }
+        std::shared_ptr<const PluginMap> published = std::move(next);
+#ifdef __cpp_lib_atomic_shared_ptr
+        snapshot_.store(std::move(published), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&snapshot_, std::move(published), std::memory_order_release);
+#endif
+        version_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // Serializes writers only; readers never touch it
+    std::mutex write_mutex_;
+
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const PluginMap>> snapshot_;
+#else
+    std::shared_ptr<const PluginMap> snapshot_;
+#endif
+
+    std::atomic<uint64_t> version_{0};
 };
 
 } // namespace roboclaw::plugins
@@ -1,98 +1,213 @@
 // ConversationTree实现
 
 #include "conversation_tree.h"
+#include "../utils/logger.h"
+#include "../utils/mapped_file.h"
 #include <algorithm>
 
 namespace roboclaw {
 
+// 正文文件（只读，按偏移读取单个节点的正文）
+// POSIX上保持描述符打开并用pread读取：文件被压缩替换后仍指向旧文件，尚未加载的
+// 正文照常可读。Windows上MappedFile打开时读入整个文件，不占用文件句柄，压缩时可以替换
+class ConversationTree::BodyFile {
+public:
+    explicit BodyFile(const std::string& path)
+        : path_(path) {
+        std::string error;
+        if (!file_.open(path, error)) {
+            LOG_ERROR("无法打开会话正文文件: " + error);
+        }
+    }
+
+    BodyFile(const BodyFile&) = delete;
+    BodyFile& operator=(const BodyFile&) = delete;
+
+    bool read(uint64_t offset, uint32_t length, std::string& out) const {
+        out.resize(length);
+        if (file_.read(offset, length, out.data()) != length) {
+            LOG_ERROR("读取会话正文失败: " + path_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string path_;
+    MappedFile file_;
+};
+
 ConversationTree::ConversationTree()
     : conversation_id_(ConversationNode::generateId()) {
-    // 创建根节点
-    root_ = std::make_shared<ConversationNode>();
-    nodes_[root_->getId()] = root_;
-    current_node_id_ = root_->getId();
+    resetToRoot();
 }
 
 ConversationTree::ConversationTree(const std::string& conversationId)
     : conversation_id_(conversationId) {
+    resetToRoot();
+}
+
+ConversationTree::~ConversationTree() = default;
+
+void ConversationTree::resetToRoot() {
+    pool_.clear();
+    nodes_.clear();
+    handle_by_atom_.clear();
+    body_file_.reset();
+
     // 创建根节点
-    root_ = std::make_shared<ConversationNode>();
-    nodes_[root_->getId()] = root_;
-    current_node_id_ = root_->getId();
+    root_ = current_ = createNode(ConversationNode::generateId(), INVALID_NODE);
 }
 
-std::shared_ptr<ConversationNode> ConversationTree::getCurrentNode() const {
-    return getNode(current_node_id_);
+NodeHandle ConversationTree::createNode(std::string_view id, NodeHandle parent) {
+    NodeHandle handle = static_cast<NodeHandle>(nodes_.size());
+    uint32_t atom = pool_.intern(id);
+    if (handle_by_atom_.size() <= atom) {
+        handle_by_atom_.resize(atom + 1, INVALID_NODE);
+    }
+    handle_by_atom_[atom] = handle;
+
+    NodeSlot slot;
+    slot.id = atom;
+    slot.parent = parent;
+    slot.timestamp = std::chrono::system_clock::now();
+    if (parent != INVALID_NODE) {
+        slot.depth = nodes_[parent].depth + 1;
+        nodes_[parent].children.push_back(handle);
+    }
+    nodes_.push_back(std::move(slot));
+    return handle;
+}
+
+NodeHandle ConversationTree::findNode(std::string_view nodeId) const {
+    uint32_t atom = pool_.find(nodeId);
+    if (atom == StringPool::NOT_FOUND || atom >= handle_by_atom_.size()) {
+        return INVALID_NODE;
+    }
+    return handle_by_atom_[atom];
+}
+
+const ConversationTree::NodeSlot& ConversationTree::loadBody(NodeHandle node) const {
+    const NodeSlot& slot = nodes_[node];
+    if (slot.body_loaded) {
+        return slot;
+    }
+    slot.body_loaded = true;
+
+    std::string raw;
+    if (!body_file_ || !body_file_->read(slot.body_offset, slot.body_length, raw)) {
+        return slot;
+    }
+    json body = json::parse(raw, nullptr, false);
+    if (body.is_discarded() || !body.is_object()) {
+        LOG_ERROR("会话正文损坏: " + nodeId(node));
+        return slot;
+    }
+    slot.user_message = body.value("user", "");
+    if (body.contains("assistant")) {
+        slot.assistant_message = ConversationNode::AssistantMessage::fromJson(body["assistant"]);
+    }
+    return slot;
+}
+
+const std::string& ConversationTree::userMessageOf(NodeHandle node) const {
+    return loadBody(node).user_message;
+}
+
+const ConversationNode::AssistantMessage& ConversationTree::assistantMessageOf(NodeHandle node) const {
+    return loadBody(node).assistant_message;
+}
+
+size_t ConversationTree::getLoadedBodyCount() const {
+    return static_cast<size_t>(std::count_if(nodes_.begin(), nodes_.end(),
+        [](const NodeSlot& slot) { return slot.body_loaded; }));
+}
+
+std::shared_ptr<ConversationNode> ConversationTree::materialize(NodeHandle node) const {
+    if (node >= nodes_.size()) {
+        return nullptr;
+    }
+    const NodeSlot& slot = loadBody(node);
+    auto result = std::make_shared<ConversationNode>(nodeId(node),
+        slot.parent != INVALID_NODE ? nodeId(slot.parent) : std::string());
+    for (NodeHandle child : slot.children) {
+        result->addChild(nodeId(child));
+    }
+    result->setUserMessage(slot.user_message);
+    result->setAssistantMessage(slot.assistant_message);
+    result->setTimestamp(slot.timestamp);
+    result->setBranchName(branchNameOf(node));
+    result->setActive(slot.active);
+    return result;
 }
 
 void ConversationTree::setCurrentNode(const std::string& nodeId) {
-    if (nodes_.find(nodeId) != nodes_.end()) {
-        // 取消之前的活动状态
-        if (nodes_.find(current_node_id_) != nodes_.end()) {
-            nodes_[current_node_id_]->setActive(false);
-        }
-        // 设置新的活动状态
-        current_node_id_ = nodeId;
-        nodes_[nodeId]->setActive(true);
+    NodeHandle node = findNode(nodeId);
+    if (node == INVALID_NODE) {
+        return;
     }
+    // 取消之前的活动状态，设置新的活动状态
+    nodes_[current_].active = false;
+    current_ = node;
+    nodes_[node].active = true;
+    journal_.push_back({{"op", "current"}, {"id", nodeId}});
 }
 
 std::shared_ptr<ConversationNode> ConversationTree::getNode(const std::string& nodeId) const {
-    auto it = nodes_.find(nodeId);
-    if (it != nodes_.end()) {
-        return it->second;
-    }
-    return nullptr;
+    NodeHandle node = findNode(nodeId);
+    return node != INVALID_NODE ? materialize(node) : nullptr;
 }
 
 std::shared_ptr<ConversationNode> ConversationTree::addNode(
         const std::string& parentId,
         const std::string& userMessage) {
 
-    auto parent = getNode(parentId);
-    if (!parent) {
+    NodeHandle parent = findNode(parentId);
+    if (parent == INVALID_NODE) {
         return nullptr;
     }
 
-    // 创建新节点
-    auto node = std::make_shared<ConversationNode>();
-    node->setParentId(parentId);
-    node->setUserMessage(userMessage);
+    NodeHandle node = createNode(ConversationNode::generateId(), parent);
+    nodes_[node].user_message = userMessage;
+    journalNode(node);
 
-    // 添加到父节点的子列表
-    parent->addChild(node->getId());
-
-    // 存储节点
-    nodes_[node->getId()] = node;
-
-    return node;
+    return materialize(node);
 }
 
 std::shared_ptr<ConversationNode> ConversationTree::createBranch(
         const std::string& parentId,
         const std::string& branchName) {
 
-    auto parent = getNode(parentId);
-    if (!parent) {
+    NodeHandle parent = findNode(parentId);
+    if (parent == INVALID_NODE) {
         return nullptr;
     }
 
     // 创建新节点作为分支起点
-    auto node = std::make_shared<ConversationNode>();
-    node->setParentId(parentId);
-    node->setBranchName(branchName);
+    NodeHandle node = createNode(ConversationNode::generateId(), parent);
+    nodes_[node].branch = pool_.intern(branchName);
+    journalNode(node);
 
-    // 添加到父节点的子列表
-    parent->addChild(node->getId());
+    return materialize(node);
+}
 
-    // 存储节点
-    nodes_[node->getId()] = node;
+bool ConversationTree::setAssistantMessage(const std::string& nodeId,
+                                           const ConversationNode::AssistantMessage& message) {
+    NodeHandle node = findNode(nodeId);
+    if (node == INVALID_NODE) {
+        return false;
+    }
 
-    return node;
+    loadBody(node).assistant_message = message;
+    json record = message.toJson();
+    record["op"] = "assistant";
+    record["id"] = nodeId;
+    journal_.push_back(std::move(record));
+    return true;
 }
 
 bool ConversationTree::switchToNode(const std::string& nodeId) {
-    if (nodes_.find(nodeId) == nodes_.end()) {
+    if (findNode(nodeId) == INVALID_NODE) {
         return false;
     }
 
@@ -101,141 +216,308 @@ bool ConversationTree::switchToNode(const std::string& nodeId) {
 }
 
 bool ConversationTree::switchToParent() {
-    auto current = getCurrentNode();
-    if (!current) {
-        return false;
-    }
-
-    const std::string& parentId = current->getParentId();
-    if (parentId.empty()) {
+    NodeHandle parent = nodes_[current_].parent;
+    if (parent == INVALID_NODE) {
         return false;  // 已经是根节点
     }
 
-    return switchToNode(parentId);
+    return switchToNode(nodeId(parent));
 }
 
 std::vector<std::string> ConversationTree::getBranchNames() const {
     std::vector<std::string> branches;
 
-    for (const auto& pair : nodes_) {
-        const std::string& branchName = pair.second->getBranchName();
-        if (!branchName.empty()) {
-            branches.push_back(branchName);
+    for (const auto& slot : nodes_) {
+        if (slot.branch != StringPool::EMPTY) {
+            branches.push_back(pool_.get(slot.branch));
         }
     }
 
     return branches;
 }
 
-std::vector<std::string> ConversationTree::getPath() const {
-    std::vector<std::string> path;
-    getPathRecursive(current_node_id_, path);
-    std::reverse(path.begin(), path.end());
-    return path;
-}
-
-void ConversationTree::getPathRecursive(const std::string& nodeId,
-                                         std::vector<std::string>& path) const {
-    auto node = getNode(nodeId);
-    if (!node) {
+void ConversationTree::pathTo(NodeHandle node, std::vector<NodeHandle>& out) const {
+    out.clear();
+    if (node >= nodes_.size()) {
         return;
     }
 
-    path.push_back(node->getId());
+    // 深度已知，从叶子向上直接填到对应位置，无需反转
+    out.resize(nodes_[node].depth + 1);
+    for (size_t i = out.size(); i > 0 && node != INVALID_NODE; --i) {
+        out[i - 1] = node;
+        node = nodes_[node].parent;
+    }
+}
 
-    const std::string& parentId = node->getParentId();
-    if (!parentId.empty()) {
-        getPathRecursive(parentId, path);
+std::vector<std::string> ConversationTree::getPath() const {
+    std::vector<NodeHandle> handles;
+    pathTo(current_, handles);
+
+    std::vector<std::string> path;
+    path.reserve(handles.size());
+    for (NodeHandle node : handles) {
+        path.push_back(nodeId(node));
     }
+    return path;
 }
 
 json ConversationTree::toJson() const {
     json j;
 
     j["conversation_id"] = conversation_id_;
-    j["current_node_id"] = current_node_id_;
+    j["current_node_id"] = nodeId(current_);
 
     // 序列化所有节点
     json nodesJson = json::object();
-    for (const auto& pair : nodes_) {
-        nodesJson[pair.first] = pair.second->toJson();
+    for (NodeHandle node = 0; node < nodes_.size(); ++node) {
+        nodesJson[nodeId(node)] = materialize(node)->toJson();
     }
     j["nodes"] = nodesJson;
 
     return j;
 }
 
+json ConversationTree::toSnapshot(std::string& bodies) const {
+    json j;
+
+    j["conversation_id"] = conversation_id_;
+    j["current_node_id"] = nodeId(current_);
+
+    json nodesJson = json::object();
+    std::string raw;
+    for (NodeHandle node = 0; node < nodes_.size(); ++node) {
+        const NodeSlot& slot = nodes_[node];
+
+        json children = json::array();
+        for (NodeHandle child : slot.children) {
+            children.push_back(nodeId(child));
+        }
+
+        json nodeJson;
+        nodeJson["id"] = nodeId(node);
+        nodeJson["parent_id"] = slot.parent != INVALID_NODE ? nodeId(slot.parent) : std::string();
+        nodeJson["children"] = std::move(children);
+        nodeJson["timestamp"] = std::chrono::system_clock::to_time_t(slot.timestamp);
+        nodeJson["branch_name"] = branchNameOf(node);
+        nodeJson["is_active"] = slot.active;
+
+        // 未加载的正文直接复制原始字节
+        raw.clear();
+        bool copied = !slot.body_loaded && body_file_ &&
+                      body_file_->read(slot.body_offset, slot.body_length, raw);
+        if (!copied) {
+            const NodeSlot& loaded = loadBody(node);
+            if (!loaded.user_message.empty() || !loaded.assistant_message.content.empty() ||
+                !loaded.assistant_message.tool_calls.empty()) {
+                raw = json{{"user", loaded.user_message},
+                           {"assistant", loaded.assistant_message.toJson()}}.dump();
+            }
+        }
+        if (!raw.empty()) {
+            nodeJson["body"] = json::array({bodies.size(), raw.size()});
+            bodies += raw;
+        }
+
+        nodesJson[nodeId(node)] = std::move(nodeJson);
+    }
+    j["nodes"] = std::move(nodesJson);
+
+    return j;
+}
+
 bool ConversationTree::fromJson(const json& j) {
+    return parseNodes(j, "");
+}
+
+bool ConversationTree::fromSnapshot(const json& j, const std::string& bodiesPath) {
+    return parseNodes(j, bodiesPath);
+}
+
+bool ConversationTree::parseNodes(const json& j, const std::string& bodiesPath) {
     try {
         conversation_id_ = j.value("conversation_id", ConversationNode::generateId());
-        current_node_id_ = j.value("current_node_id", "");
+        const std::string currentId = j.value("current_node_id", "");
 
+        pool_.clear();
         nodes_.clear();
+        handle_by_atom_.clear();
+        journal_.clear();
+        body_file_.reset();
+        root_ = current_ = INVALID_NODE;
+
+        if (!bodiesPath.empty()) {
+            body_file_ = std::make_shared<BodyFile>(bodiesPath);
+        }
+
+        const json empty = json::object();
+        const json& nodesJson = j.contains("nodes") ? j["nodes"] : empty;
+
+        // 第一遍：为每个节点分配句柄，读取结构和正文位置
+        nodes_.reserve(nodesJson.size());
+        for (const auto& pair : nodesJson.items()) {
+            const json& nodeJson = pair.value();
+            NodeHandle node = createNode(pair.key(), INVALID_NODE);
+            NodeSlot& slot = nodes_[node];
 
-        if (j.contains("nodes")) {
-            for (const auto& pair : j["nodes"].items()) {
-                auto node = std::make_shared<ConversationNode>(
-                    ConversationNode::fromJson(pair.value())
-                );
-                nodes_[pair.key()] = node;
+            slot.branch = pool_.intern(nodeJson.value("branch_name", ""));
+            slot.active = nodeJson.value("is_active", false);
+            if (nodeJson.contains("timestamp")) {
+                slot.timestamp = std::chrono::system_clock::from_time_t(nodeJson["timestamp"].get<std::time_t>());
+            }
 
-                // 设置根节点
-                if (node->getParentId().empty()) {
-                    root_ = node;
+            if (nodeJson.contains("body")) {
+                slot.body_offset = nodeJson["body"].at(0).get<uint64_t>();
+                slot.body_length = nodeJson["body"].at(1).get<uint32_t>();
+                slot.body_loaded = slot.body_length == 0;
+            } else {
+                slot.user_message = nodeJson.value("user_message", "");
+                if (nodeJson.contains("assistant_message")) {
+                    slot.assistant_message = ConversationNode::AssistantMessage::fromJson(nodeJson["assistant_message"]);
+                }
+            }
+        }
+
+        // 第二遍：连接父子关系
+        for (const auto& pair : nodesJson.items()) {
+            NodeHandle node = findNode(pair.key());
+            const std::string parentId = pair.value().value("parent_id", "");
+            if (parentId.empty()) {
+                root_ = node;
+            } else {
+                nodes_[node].parent = findNode(parentId);
+            }
+            if (pair.value().contains("children")) {
+                for (const auto& child : pair.value()["children"]) {
+                    NodeHandle childHandle = findNode(child.get<std::string>());
+                    if (childHandle != INVALID_NODE) {
+                        nodes_[node].children.push_back(childHandle);
+                    }
                 }
             }
         }
 
         // 确保有根节点
-        if (!root_) {
-            root_ = std::make_shared<ConversationNode>();
-            nodes_[root_->getId()] = root_;
+        if (root_ == INVALID_NODE) {
+            root_ = createNode(ConversationNode::generateId(), INVALID_NODE);
+        }
+
+        // 从根开始计算深度
+        std::vector<NodeHandle> stack{root_};
+        while (!stack.empty()) {
+            NodeHandle node = stack.back();
+            stack.pop_back();
+            for (NodeHandle child : nodes_[node].children) {
+                nodes_[child].depth = nodes_[node].depth + 1;
+                stack.push_back(child);
+            }
         }
 
         // 确保当前节点存在
-        if (nodes_.find(current_node_id_) == nodes_.end()) {
-            current_node_id_ = root_->getId();
+        current_ = findNode(currentId);
+        if (current_ == INVALID_NODE) {
+            current_ = root_;
         }
 
         return true;
 
     } catch (const std::exception& e) {
+        resetToRoot();
         return false;
     }
 }
 
-std::vector<std::shared_ptr<ConversationNode>> ConversationTree::getAllNodes() const {
-    std::vector<std::shared_ptr<ConversationNode>> nodes;
-    getAllNodesRecursive(root_, nodes);
-    return nodes;
+void ConversationTree::journalNode(NodeHandle node) {
+    const NodeSlot& slot = nodes_[node];
+    journal_.push_back({
+        {"op", "node"},
+        {"id", nodeId(node)},
+        {"parent", nodeId(slot.parent)},
+        {"user", slot.user_message},
+        {"branch", branchNameOf(node)},
+        {"ts", std::chrono::system_clock::to_time_t(slot.timestamp)}
+    });
 }
 
-void ConversationTree::getAllNodesRecursive(
-        std::shared_ptr<ConversationNode> node,
-        std::vector<std::shared_ptr<ConversationNode>>& nodes) const {
+std::vector<json> ConversationTree::takeJournal() {
+    std::vector<json> records;
+    records.swap(journal_);
+    return records;
+}
 
-    if (!node) {
-        return;
-    }
+void ConversationTree::restoreJournal(std::vector<json> records) {
+    records.insert(records.end(), std::make_move_iterator(journal_.begin()),
+                   std::make_move_iterator(journal_.end()));
+    journal_.swap(records);
+}
 
-    nodes.push_back(node);
+bool ConversationTree::applyRecord(const json& record) {
+    try {
+        const std::string op = record.value("op", "");
+        const std::string id = record.value("id", "");
 
-    for (const auto& childId : node->getChildren()) {
-        auto child = getNode(childId);
-        if (child) {
-            getAllNodesRecursive(child, nodes);
+        if (op == "node") {
+            NodeHandle parent = findNode(record.value("parent", ""));
+            if (parent == INVALID_NODE) {
+                return false;
+            }
+            NodeHandle node = findNode(id);
+            if (node == INVALID_NODE) {
+                node = createNode(id, parent);
+            }
+            const NodeSlot& slot = loadBody(node);
+            slot.user_message = record.value("user", "");
+            nodes_[node].branch = pool_.intern(record.value("branch", ""));
+            if (record.contains("ts")) {
+                nodes_[node].timestamp = std::chrono::system_clock::from_time_t(record["ts"].get<std::time_t>());
+            }
+            return true;
+        }
+
+        NodeHandle node = findNode(id);
+        if (node == INVALID_NODE) {
+            return false;
+        }
+        if (op == "assistant") {
+            loadBody(node).assistant_message = ConversationNode::AssistantMessage::fromJson(record);
+        } else if (op == "current") {
+            nodes_[current_].active = false;
+            current_ = node;
+            nodes_[node].active = true;
+        } else {
+            return false;
         }
+        return true;
+
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::vector<std::shared_ptr<ConversationNode>> ConversationTree::getAllNodes() const {
+    // 深度优先，子节点按添加顺序
+    std::vector<std::shared_ptr<ConversationNode>> result;
+    std::vector<NodeHandle> stack{root_};
+    while (!stack.empty()) {
+        NodeHandle node = stack.back();
+        stack.pop_back();
+        result.push_back(materialize(node));
+        const auto& children = nodes_[node].children;
+        stack.insert(stack.end(), children.rbegin(), children.rend());
     }
+    return result;
 }
 
 std::vector<std::string> ConversationTree::getConversationHistory() const {
     std::vector<std::string> history;
 
-    std::vector<std::string> path = getPath();
-    for (const auto& nodeId : path) {
-        auto node = getNode(nodeId);
-        if (node && !node->getUserMessage().empty()) {
-            history.push_back(node->getUserMessage());
+    // 只加载路径上节点的正文
+    std::vector<NodeHandle> path;
+    pathTo(current_, path);
+    for (NodeHandle node : path) {
+        const std::string& message = userMessageOf(node);
+        if (!message.empty()) {
+            history.push_back(message);
         }
     }
 
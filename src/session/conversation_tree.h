@@ -5,29 +5,48 @@
 #define ROBOCLAW_SESSION_CONVERSATION_TREE_H
 
 #include "conversation_node.h"
-#include <string>
-#include <map>
+#include "string_pool.h"
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace roboclaw {
 
+// 节点句柄（节点在arena中的下标，树的生命周期内不变）
+using NodeHandle = uint32_t;
+constexpr NodeHandle INVALID_NODE = std::numeric_limits<NodeHandle>::max();
+
 // 对话树
+//
+// 节点存放在连续的arena（vector）中，用整数句柄互相引用；
+// 节点ID和分支名驻留在字符串池中，每个节点的子节点是一段连续的句柄数组。
+// 从快照加载时消息正文不解析，只记录其在正文文件中的位置，首次访问时再读取。
+//
+// getNode()/getRoot()/getCurrentNode()返回节点的副本，便于兼容旧接口；
+// 热路径请使用句柄接口（findNode、pathTo、userMessageOf等）。
 class ConversationTree {
 public:
     ConversationTree();
     explicit ConversationTree(const std::string& conversationId);
+    ~ConversationTree();
+
+    ConversationTree(const ConversationTree&) = delete;
+    ConversationTree& operator=(const ConversationTree&) = delete;
 
     // 获取对话ID
     std::string getConversationId() const { return conversation_id_; }
     void setConversationId(const std::string& id) { conversation_id_ = id; }
 
     // 获取根节点
-    std::shared_ptr<ConversationNode> getRoot() const { return root_; }
+    std::shared_ptr<ConversationNode> getRoot() const { return materialize(root_); }
 
     // 获取当前活动节点
-    std::shared_ptr<ConversationNode> getCurrentNode() const;
-    std::string getCurrentNodeId() const { return current_node_id_; }
+    std::shared_ptr<ConversationNode> getCurrentNode() const { return materialize(current_); }
+    std::string getCurrentNodeId() const { return nodeId(current_); }
 
     // 设置当前节点
     void setCurrentNode(const std::string& nodeId);
@@ -43,6 +62,10 @@ public:
     std::shared_ptr<ConversationNode> createBranch(const std::string& parentId,
                                                    const std::string& branchName);
 
+    // 设置节点的AI回复
+    bool setAssistantMessage(const std::string& nodeId,
+                             const ConversationNode::AssistantMessage& message);
+
     // 切换到指定节点
     bool switchToNode(const std::string& nodeId);
 
@@ -55,28 +78,102 @@ public:
     // 获取路径（从根到当前节点）
     std::vector<std::string> getPath() const;
 
-    // 序列化
+    // 句柄接口
+    NodeHandle findNode(std::string_view nodeId) const;
+    NodeHandle getRootHandle() const { return root_; }
+    NodeHandle getCurrentHandle() const { return current_; }
+    const std::string& nodeId(NodeHandle node) const { return pool_.get(nodes_[node].id); }
+    NodeHandle parentOf(NodeHandle node) const { return nodes_[node].parent; }
+    std::span<const NodeHandle> childrenOf(NodeHandle node) const { return nodes_[node].children; }
+    const std::string& branchNameOf(NodeHandle node) const { return pool_.get(nodes_[node].branch); }
+    size_t depthOf(NodeHandle node) const { return nodes_[node].depth; }
+
+    // 消息正文（未加载时从正文文件读取）
+    const std::string& userMessageOf(NodeHandle node) const;
+    const ConversationNode::AssistantMessage& assistantMessageOf(NodeHandle node) const;
+
+    // 从根到node的路径写入out（O(深度)，复用out已有的容量）
+    void pathTo(NodeHandle node, std::vector<NodeHandle>& out) const;
+
+    // 已加载正文的节点数
+    size_t getLoadedBodyCount() const;
+
+    // 序列化（toJson包含全部正文）
     json toJson() const;
     bool fromJson(const json& j);
 
+    // 快照序列化：结构写入json，正文依次追加到bodies，节点只记录偏移和长度
+    // 未加载的正文按原始字节复制，不解析
+    json toSnapshot(std::string& bodies) const;
+
+    // 从快照加载；bodiesPath为正文文件，节点正文在首次访问时读取
+    bool fromSnapshot(const json& j, const std::string& bodiesPath);
+
     // 获取所有节点
     std::vector<std::shared_ptr<ConversationNode>> getAllNodes() const;
+    size_t getNodeCount() const { return nodes_.size(); }
+
+    // 增量日志：自上次取出后的修改记录（每个新节点、回复和当前节点变化一条）
+    // 注意：直接修改getNode()返回的节点不会产生记录
+    std::vector<json> takeJournal();
+
+    // 放回未能写入的记录（排在之后产生的记录之前），下次保存时重新写入
+    void restoreJournal(std::vector<json> records);
+    bool hasJournal() const { return !journal_.empty(); }
+
+    // 重放一条日志记录（幂等，重复重放结果相同）
+    bool applyRecord(const json& record);
 
     // 获取对话历史（从根到当前节点）
     std::vector<std::string> getConversationHistory() const;
 
 private:
+    class BodyFile;
+
+    // arena中的节点
+    struct NodeSlot {
+        uint32_t id = StringPool::EMPTY;       // 字符串池编号
+        uint32_t branch = StringPool::EMPTY;   // 分支名（字符串池编号）
+        NodeHandle parent = INVALID_NODE;
+        uint32_t depth = 0;
+        bool active = false;
+        std::vector<NodeHandle> children;
+        std::chrono::system_clock::time_point timestamp;
+
+        // 正文（body_length > 0且未加载时在正文文件中）
+        mutable bool body_loaded = true;
+        uint64_t body_offset = 0;
+        uint32_t body_length = 0;
+        mutable std::string user_message;
+        mutable ConversationNode::AssistantMessage assistant_message;
+    };
+
     std::string conversation_id_;
-    std::shared_ptr<ConversationNode> root_;
-    std::string current_node_id_;
-    std::map<std::string, std::shared_ptr<ConversationNode>> nodes_;
+    StringPool pool_;
+    std::vector<NodeSlot> nodes_;
+    std::vector<NodeHandle> handle_by_atom_;   // 字符串池编号 -> 节点句柄
+    NodeHandle root_ = INVALID_NODE;
+    NodeHandle current_ = INVALID_NODE;
+    std::shared_ptr<BodyFile> body_file_;
+    std::vector<json> journal_;
+
+    // 创建节点
+    NodeHandle createNode(std::string_view id, NodeHandle parent);
+
+    // 重置为只有根节点的树
+    void resetToRoot();
+
+    // 确保正文已加载
+    const NodeSlot& loadBody(NodeHandle node) const;
+
+    // 生成节点副本
+    std::shared_ptr<ConversationNode> materialize(NodeHandle node) const;
 
-    // 递归获取路径
-    void getPathRecursive(const std::string& nodeId, std::vector<std::string>& path) const;
+    // 解析快照或完整JSON
+    bool parseNodes(const json& j, const std::string& bodiesPath);
 
-    // 递归获取所有节点
-    void getAllNodesRecursive(std::shared_ptr<ConversationNode> node,
-                               std::vector<std::shared_ptr<ConversationNode>>& nodes) const;
+    // 记录新节点
+    void journalNode(NodeHandle node);
 };
 
 } // namespace roboclaw
@@ -0,0 +1,385 @@
+// SessionIndex实现
+
+#include "session_index.h"
+#include "../utils/atomic_file.h"
+#include "../utils/logger.h"
+#include "../utils/mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+
+#ifdef PLATFORM_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace roboclaw {
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = {'R', 'C', 'S', 'I', 'D', 'X', '0', '1'};
+constexpr uint32_t INDEX_VERSION = 1;
+constexpr size_t HEADER_SIZE = 64;
+
+constexpr uint32_t SLOT_FREE = 0;
+constexpr uint32_t SLOT_USED = 1;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    char reserved[48];
+};
+static_assert(sizeof(IndexHeader) == HEADER_SIZE, "index header must be 64 bytes");
+
+// 定长记录槽
+struct IndexRecord {
+    uint32_t state;
+    uint32_t checksum;        // 除本字段外整条记录的FNV-1a
+    char id[48];
+    int64_t created_at;       // 毫秒
+    int64_t updated_at;       // 毫秒
+    int32_t message_count;
+    uint32_t title_length;
+    char title[176];
+};
+static_assert(sizeof(IndexRecord) == 256, "index record must be 256 bytes");
+
+uint32_t checksumOf(const IndexRecord& record) {
+    IndexRecord copy = record;
+    copy.checksum = 0;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&copy);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(copy); ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::chrono::system_clock::time_point fromMillis(int64_t ms) {
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+}
+
+bool encode(const SessionMetadata& metadata, int64_t created, int64_t updated, IndexRecord& record) {
+    if (metadata.id.empty() || metadata.id.size() >= sizeof(record.id)) {
+        return false;
+    }
+    std::memset(&record, 0, sizeof(record));
+    record.state = SLOT_USED;
+    std::memcpy(record.id, metadata.id.data(), metadata.id.size());
+    record.created_at = created;
+    record.updated_at = updated;
+    record.message_count = metadata.message_count;
+
+    // 标题按UTF-8字符边界截断
+    size_t length = std::min(metadata.title.size(), sizeof(record.title));
+    while (length > 0 && length < metadata.title.size() &&
+           (static_cast<unsigned char>(metadata.title[length]) & 0xC0) == 0x80) {
+        --length;
+    }
+    std::memcpy(record.title, metadata.title.data(), length);
+    record.title_length = static_cast<uint32_t>(length);
+    record.checksum = checksumOf(record);
+    return true;
+}
+
+// 索引文件的平台相关操作（整文件读取用MappedFile，重建用writeFileAtomic）
+#ifdef PLATFORM_WINDOWS
+int openIndex(const std::string& path) {
+    return ::_open(path.c_str(), _O_RDWR | _O_BINARY | _O_NOINHERIT);
+}
+
+bool writeAt(int fd, const void* data, size_t size, uint64_t offset) {
+    return ::_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) >= 0 &&
+           ::_write(fd, data, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+bool syncData(int fd) { return ::_commit(fd) == 0; }
+void closeIndex(int fd) { ::_close(fd); }
+#else
+int openIndex(const std::string& path) {
+    return ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+}
+
+bool writeAt(int fd, const void* data, size_t size, uint64_t offset) {
+    const char* bytes = static_cast<const char*>(data);
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::pwrite(fd, bytes + written, size - written, static_cast<off_t>(offset + written));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool syncData(int fd) {
+#ifdef PLATFORM_MACOS
+    // macOS没有fdatasync；F_FULLFSYNC才会刷到存储介质，文件系统不支持时退回fsync
+    return ::fcntl(fd, F_FULLFSYNC) == 0 || ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+
+void closeIndex(int fd) { ::close(fd); }
+#endif
+
+} // namespace
+
+SessionIndex::~SessionIndex() {
+    close();
+}
+
+int64_t SessionIndex::toMillis(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+bool SessionIndex::open(const std::string& path) {
+    close();
+    entries_.clear();
+    order_.clear();
+    free_slots_.clear();
+    slot_count_ = 0;
+
+    // 整个文件一次读入（映射），顺序解析所有槽
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        return false;
+    }
+    size_t size = file.size();
+    if (size < HEADER_SIZE || (size - HEADER_SIZE) % sizeof(IndexRecord) != 0) {
+        LOG_WARNING("会话索引文件大小异常: " + path);
+        return false;
+    }
+    file.adviseSequential();
+
+    IndexHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    bool ok = std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+              header.version == INDEX_VERSION && header.record_size == sizeof(IndexRecord);
+
+    uint64_t count = (size - HEADER_SIZE) / sizeof(IndexRecord);
+    for (uint64_t slot = 0; ok && slot < count; ++slot) {
+        IndexRecord record;
+        std::memcpy(&record, file.data() + HEADER_SIZE + slot * sizeof(IndexRecord), sizeof(record));
+        if (record.state == SLOT_FREE) {
+            free_slots_.push_back(slot);
+            continue;
+        }
+        if (record.state != SLOT_USED || record.checksum != checksumOf(record) ||
+            record.title_length > sizeof(record.title)) {
+            LOG_WARNING("会话索引记录损坏: " + path + " 槽 " + std::to_string(slot));
+            ok = false;
+            break;
+        }
+
+        Entry entry;
+        entry.slot = slot;
+        entry.metadata.id.assign(record.id, strnlen(record.id, sizeof(record.id)));
+        entry.metadata.title.assign(record.title, record.title_length);
+        entry.metadata.created_at = fromMillis(record.created_at);
+        entry.metadata.updated_at = fromMillis(record.updated_at);
+        entry.metadata.message_count = record.message_count;
+
+        order_.emplace(record.updated_at, entry.metadata.id);
+        entries_[entry.metadata.id] = std::move(entry);
+    }
+    file.close();
+
+    int fd = ok ? openIndex(path) : -1;
+    if (fd < 0) {
+        if (ok) {
+            LOG_WARNING("无法打开会话索引: " + path + " - " + std::strerror(errno));
+        }
+        entries_.clear();
+        order_.clear();
+        free_slots_.clear();
+        return false;
+    }
+
+    fd_ = fd;
+    slot_count_ = count;
+    return true;
+}
+
+bool SessionIndex::rebuild(const std::string& path, const std::vector<SessionMetadata>& sessions) {
+    close();
+    entries_.clear();
+    order_.clear();
+    free_slots_.clear();
+    slot_count_ = 0;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.record_size = sizeof(IndexRecord);
+
+    std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& metadata : sessions) {
+        IndexRecord record;
+        int64_t updated = toMillis(metadata.updated_at);
+        if (!encode(metadata, toMillis(metadata.created_at), updated, record)) {
+            LOG_WARNING("会话ID无法写入索引（为空或超过 " + std::to_string(sizeof(record.id) - 1) +
+                        " 字节），已跳过: " + metadata.id);
+            continue;
+        }
+        if (entries_.count(metadata.id)) {
+            continue;
+        }
+        entries_[metadata.id] = Entry{metadata, slot_count_++};
+        order_.emplace(updated, metadata.id);
+        data.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+
+    // 原子替换（临时文件、fsync、rename、同步目录），再打开用于原地更新槽
+    std::string error;
+    if (!writeFileAtomic(path, data, error)) {
+        LOG_ERROR("写入会话索引失败: " + path + " - " + error);
+        return false;
+    }
+    fd_ = openIndex(path);
+    if (fd_ < 0) {
+        LOG_ERROR("无法打开会话索引: " + path + " - " + std::strerror(errno));
+        return false;
+    }
+
+    LOG_INFO("已重建会话索引: " + std::to_string(entries_.size()) + " 个会话");
+    return true;
+}
+
+bool SessionIndex::writeSlot(uint64_t slot, const SessionMetadata* metadata) {
+    if (fd_ < 0) {
+        LOG_WARNING("会话索引未打开，槽 " + std::to_string(slot) + " 的更新只保留在内存中");
+        return false;
+    }
+
+    IndexRecord record;
+    if (metadata) {
+        if (!encode(*metadata, toMillis(metadata->created_at), toMillis(metadata->updated_at), record)) {
+            LOG_WARNING("会话ID过长，未写入索引: " + metadata->id);
+            return false;
+        }
+    } else {
+        std::memset(&record, 0, sizeof(record));
+    }
+
+    if (!writeAt(fd_, &record, sizeof(record), HEADER_SIZE + slot * sizeof(IndexRecord))) {
+        LOG_ERROR(std::string("写入会话索引失败: ") + std::strerror(errno));
+        return false;
+    }
+
+    // 批量落盘
+    if (++unsynced_ >= 32) {
+        return sync();
+    }
+    return true;
+}
+
+bool SessionIndex::upsert(const SessionMetadata& metadata) {
+    if (metadata.id.empty()) {
+        return false;
+    }
+
+    auto it = entries_.find(metadata.id);
+    if (it != entries_.end()) {
+        order_.erase({toMillis(it->second.metadata.updated_at), metadata.id});
+        it->second.metadata = metadata;
+    } else {
+        uint64_t slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        } else {
+            slot = slot_count_++;
+        }
+        it = entries_.emplace(metadata.id, Entry{metadata, slot}).first;
+    }
+    order_.emplace(toMillis(metadata.updated_at), metadata.id);
+
+    return writeSlot(it->second.slot, &it->second.metadata);
+}
+
+bool SessionIndex::remove(const std::string& sessionId) {
+    auto it = entries_.find(sessionId);
+    if (it == entries_.end()) {
+        return false;
+    }
+
+    uint64_t slot = it->second.slot;
+    order_.erase({toMillis(it->second.metadata.updated_at), sessionId});
+    entries_.erase(it);
+    free_slots_.push_back(slot);
+    return writeSlot(slot, nullptr);
+}
+
+bool SessionIndex::get(const std::string& sessionId, SessionMetadata& metadata) const {
+    auto it = entries_.find(sessionId);
+    if (it == entries_.end()) {
+        return false;
+    }
+    metadata = it->second.metadata;
+    return true;
+}
+
+std::vector<SessionMetadata> SessionIndex::list(size_t offset, size_t limit) const {
+    std::vector<SessionMetadata> sessions;
+    if (offset >= order_.size()) {
+        return sessions;
+    }
+
+    size_t count = order_.size() - offset;
+    if (limit > 0) {
+        count = std::min(count, limit);
+    }
+    sessions.reserve(count);
+
+    auto it = std::next(order_.begin(), static_cast<std::ptrdiff_t>(offset));
+    for (; it != order_.end() && sessions.size() < count; ++it) {
+        sessions.push_back(entries_.at(it->second).metadata);
+    }
+    return sessions;
+}
+
+std::optional<SessionMetadata> SessionIndex::latest() const {
+    if (order_.empty()) {
+        return std::nullopt;
+    }
+    return entries_.at(order_.begin()->second).metadata;
+}
+
+bool SessionIndex::sync() {
+    unsynced_ = 0;
+    if (fd_ < 0) {
+        return true;
+    }
+    if (!syncData(fd_)) {
+        LOG_ERROR(std::string("会话索引落盘失败: ") + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void SessionIndex::close() {
+    if (fd_ >= 0) {
+        if (unsynced_ > 0) {
+            syncData(fd_);
+        }
+        closeIndex(fd_);
+        fd_ = -1;
+        unsynced_ = 0;
+    }
+}
+
+} // namespace roboclaw
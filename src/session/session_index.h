@@ -0,0 +1,135 @@
+// 会话索引 - SessionIndex
+// 所有会话元数据的单文件索引，启动时一次映射读入，按更新时间有序
+
+#ifndef ROBOCLAW_SESSION_SESSION_INDEX_H
+#define ROBOCLAW_SESSION_SESSION_INDEX_H
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace roboclaw {
+
+// 会话元数据
+struct SessionMetadata {
+    std::string id;
+    std::string title;
+    std::chrono::system_clock::time_point created_at;
+    std::chrono::system_clock::time_point updated_at;
+    int message_count;
+
+    SessionMetadata()
+        : message_count(0) {
+        created_at = updated_at = std::chrono::system_clock::now();
+    }
+
+    json toJson() const {
+        json j;
+        j["id"] = id;
+        j["title"] = title;
+        j["created_at"] = std::chrono::system_clock::to_time_t(created_at);
+        j["updated_at"] = std::chrono::system_clock::to_time_t(updated_at);
+        j["message_count"] = message_count;
+        return j;
+    }
+
+    static SessionMetadata fromJson(const json& j) {
+        SessionMetadata meta;
+        meta.id = j.value("id", "");
+        meta.title = j.value("title", "");
+
+        if (j.contains("created_at")) {
+            std::time_t time = j["created_at"];
+            meta.created_at = std::chrono::system_clock::from_time_t(time);
+        }
+
+        if (j.contains("updated_at")) {
+            std::time_t time = j["updated_at"];
+            meta.updated_at = std::chrono::system_clock::from_time_t(time);
+        }
+
+        meta.message_count = j.value("message_count", 0);
+        return meta;
+    }
+};
+
+// 会话索引
+//
+// 文件格式（index.bin）：64字节文件头 + 定长256字节的记录槽，
+// 每个会话占一个槽，更新时原地覆写该槽（pwrite），删除时标记为空闲供复用。
+// 每条记录带校验和，加载时发现损坏即返回失败，由调用方扫描会话目录重建。
+// 内存中按updated_at维护有序集合，列表、分页和最新会话查询不访问磁盘。
+// 标题超过索引槽容量时按UTF-8字符边界截断（完整标题仍在会话自己的元数据文件中）。
+//
+// 非线程安全，由调用方加锁。
+class SessionIndex {
+public:
+    SessionIndex() = default;
+    ~SessionIndex();
+
+    SessionIndex(const SessionIndex&) = delete;
+    SessionIndex& operator=(const SessionIndex&) = delete;
+
+    // 映射并加载索引文件（文件不存在或损坏时返回false）
+    bool open(const std::string& path);
+
+    // 用给定的元数据重写整个索引文件（原子替换）
+    bool rebuild(const std::string& path, const std::vector<SessionMetadata>& sessions);
+
+    // 插入或更新会话
+    bool upsert(const SessionMetadata& metadata);
+
+    // 删除会话
+    bool remove(const std::string& sessionId);
+
+    // 查询会话
+    bool get(const std::string& sessionId, SessionMetadata& metadata) const;
+    bool contains(const std::string& sessionId) const { return entries_.count(sessionId) > 0; }
+
+    // 按更新时间倒序分页列出（limit为0表示不限）
+    std::vector<SessionMetadata> list(size_t offset = 0, size_t limit = 0) const;
+
+    // 最近更新的会话
+    std::optional<SessionMetadata> latest() const;
+
+    // 会话数
+    size_t size() const { return entries_.size(); }
+
+    // 落盘
+    bool sync();
+
+    // 关闭文件（内存中的数据保留）
+    void close();
+
+private:
+    struct Entry {
+        SessionMetadata metadata;
+        uint64_t slot;
+    };
+
+    using OrderKey = std::pair<int64_t, std::string>;   // (updated_at毫秒, id)
+
+    // 写入一个槽
+    bool writeSlot(uint64_t slot, const SessionMetadata* metadata);
+
+    static int64_t toMillis(std::chrono::system_clock::time_point time);
+
+    int fd_ = -1;
+    uint64_t slot_count_ = 0;
+    std::vector<uint64_t> free_slots_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::set<OrderKey, std::greater<OrderKey>> order_;   // 最新的在前
+    size_t unsynced_ = 0;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_SESSION_SESSION_INDEX_H
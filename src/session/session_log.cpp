@@ -0,0 +1,283 @@
+// SessionLog实现
+
+#include "session_log.h"
+#include "../utils/atomic_file.h"
+#include "../utils/logger.h"
+#include <cerrno>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+
+#ifdef PLATFORM_WINDOWS
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace roboclaw {
+
+namespace {
+
+// 日志文件的平台相关操作（快照和正文通过writeFileAtomic写入）
+#ifdef PLATFORM_WINDOWS
+int openAppend(const std::string& path) {
+    return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | _O_NOINHERIT,
+                   _S_IREAD | _S_IWRITE);
+}
+
+long long writeSome(int fd, const char* data, size_t size) {
+    return ::_write(fd, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+}
+
+bool syncFile(int fd) { return ::_commit(fd) == 0; }
+bool truncateFile(int fd) { return ::_chsize_s(fd, 0) == 0; }
+void closeFile(int fd) { ::_close(fd); }
+#else
+int openAppend(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+long long writeSome(int fd, const char* data, size_t size) {
+    return ::write(fd, data, size);
+}
+
+bool syncFile(int fd) { return ::fsync(fd) == 0; }
+bool truncateFile(int fd) { return ::ftruncate(fd, 0) == 0; }
+void closeFile(int fd) { ::close(fd); }
+#endif
+
+// 完整写入（处理部分写入和EINTR）
+bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        long long n = writeSome(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+SessionLog::SessionLog(const std::string& dir, const SessionLogConfig& config)
+    : dir_(dir)
+    , config_(config)
+    , last_sync_(std::chrono::steady_clock::now()) {
+}
+
+SessionLog::~SessionLog() {
+    closeLog();
+}
+
+bool SessionLog::openLog() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+
+    fd_ = openAppend(logPath());
+    if (fd_ < 0) {
+        LOG_ERROR("无法打开会话日志: " + logPath() + " - " + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void SessionLog::closeLog() {
+    if (fd_ >= 0) {
+        if (unsynced_ > 0) {
+            syncFile(fd_);
+        }
+        closeFile(fd_);
+        fd_ = -1;
+        unsynced_ = 0;
+    }
+}
+
+bool SessionLog::recover(json& snapshot, std::vector<json>& records) {
+    closeLog();
+    records.clear();
+    record_count_ = 0;
+    bodies_file_.clear();
+
+    // 快照
+    std::ifstream snapshotFile(snapshotPath());
+    has_snapshot_ = snapshotFile.is_open();
+    if (has_snapshot_) {
+        try {
+            snapshot = json::parse(snapshotFile);
+        } catch (const json::parse_error& e) {
+            LOG_ERROR("解析会话快照失败: " + snapshotPath() + " - " + std::string(e.what()));
+            return false;
+        }
+        bodies_file_ = snapshot.value("bodies_file", "");
+        removeStaleBodies();
+    }
+
+    // 日志：逐行解析，遇到不完整或损坏的记录即停止
+    std::ifstream logFile(logPath(), std::ios::binary);
+    if (logFile.is_open()) {
+        std::stringstream buffer;
+        buffer << logFile.rdbuf();
+        const std::string content = buffer.str();
+
+        size_t valid = 0;
+        while (valid < content.size()) {
+            size_t newline = content.find('\n', valid);
+            if (newline == std::string::npos) {
+                break;
+            }
+            json record = json::parse(content.begin() + valid, content.begin() + newline, nullptr, false);
+            if (record.is_discarded() || !record.is_object()) {
+                break;
+            }
+            records.push_back(std::move(record));
+            valid = newline + 1;
+        }
+
+        if (valid < content.size()) {
+            LOG_WARNING("会话日志末尾有 " + std::to_string(content.size() - valid) +
+                        " 字节不完整的记录，已丢弃: " + logPath());
+            std::error_code ec;
+            std::filesystem::resize_file(logPath(), valid, ec);
+            if (ec) {
+                LOG_ERROR("截断会话日志失败: " + logPath() + " - " + ec.message());
+                return false;
+            }
+        }
+        record_count_ = records.size();
+    }
+
+    if (!has_snapshot_ && !records.empty()) {
+        LOG_ERROR("会话日志缺少快照: " + dir_);
+        return false;
+    }
+
+    return openLog();
+}
+
+bool SessionLog::append(const std::vector<json>& records) {
+    if (records.empty()) {
+        return true;
+    }
+    if (!openLog()) {
+        return false;
+    }
+
+    // 一次写入整批记录
+    std::string data;
+    for (const auto& record : records) {
+        data += record.dump();
+        data += '\n';
+    }
+    if (!writeAll(fd_, data)) {
+        LOG_ERROR("写入会话日志失败: " + logPath() + " - " + std::strerror(errno));
+        return false;
+    }
+
+    record_count_ += records.size();
+    unsynced_ += records.size();
+
+    // 批量fsync：记录数或时间达到阈值时才落盘
+    if (unsynced_ >= config_.sync_every_records ||
+        std::chrono::steady_clock::now() - last_sync_ >= config_.sync_interval) {
+        return sync();
+    }
+    return true;
+}
+
+bool SessionLog::sync() {
+    last_sync_ = std::chrono::steady_clock::now();
+    if (fd_ < 0 || unsynced_ == 0) {
+        return true;
+    }
+    if (!syncFile(fd_)) {
+        LOG_ERROR("会话日志fsync失败: " + logPath() + " - " + std::strerror(errno));
+        return false;
+    }
+    unsynced_ = 0;
+    return true;
+}
+
+bool SessionLog::compact(json snapshot, const std::string& bodies) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+
+    // 正文写入新文件名，快照替换前旧快照引用的文件保持不变
+    std::string bodiesFile;
+    if (!bodies.empty()) {
+        bodiesFile = nextBodiesFile();
+        std::string bodiesPath = dir_ + "/" + bodiesFile;
+        std::string error;
+        if (!writeFileAtomic(bodiesPath, bodies, error)) {
+            LOG_ERROR("写入会话正文失败: " + bodiesPath + " - " + error);
+            return false;
+        }
+        snapshot["bodies_file"] = bodiesFile;
+    }
+
+    // 快照完整写入临时文件并落盘后原子替换，再同步目录
+    std::string error;
+    if (!writeFileAtomic(snapshotPath(), snapshot.dump(), error)) {
+        LOG_ERROR("写入会话快照失败: " + snapshotPath() + " - " + error);
+        if (!bodiesFile.empty()) {
+            std::filesystem::remove(dir_ + "/" + bodiesFile, ec);
+        }
+        return false;
+    }
+    has_snapshot_ = true;
+
+    // 旧正文文件已不再被引用（已打开它的读者仍可继续读取）
+    if (!bodies_file_.empty() && bodies_file_ != bodiesFile) {
+        std::filesystem::remove(dir_ + "/" + bodies_file_, ec);
+    }
+    bodies_file_ = bodiesFile;
+
+    // 快照已包含日志中的全部记录，清空日志（此前崩溃时重放是幂等的）
+    if (!openLog() || !truncateFile(fd_)) {
+        LOG_ERROR("清空会话日志失败: " + logPath() + " - " + std::strerror(errno));
+        return false;
+    }
+    syncFile(fd_);
+    record_count_ = 0;
+    unsynced_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+std::string SessionLog::nextBodiesFile() {
+    // 首次使用时从目录中已有的文件确定编号，避免覆盖仍被引用的文件
+    if (bodies_generation_ == 0) {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("bodies-", 0) == 0) {
+                bodies_generation_ = std::max<uint64_t>(bodies_generation_, std::strtoull(name.c_str() + 7, nullptr, 10));
+            }
+        }
+    }
+    return "bodies-" + std::to_string(++bodies_generation_) + ".dat";
+}
+
+void SessionLog::removeStaleBodies() const {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("bodies-", 0) == 0 && name != bodies_file_) {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+} // namespace roboclaw
@@ -0,0 +1,102 @@
+// 会话日志 - SessionLog
+// 追加写入的会话预写日志（WAL），定期压缩为快照
+
+#ifndef ROBOCLAW_SESSION_SESSION_LOG_H
+#define ROBOCLAW_SESSION_SESSION_LOG_H
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace roboclaw {
+
+// 会话日志配置
+struct SessionLogConfig {
+    size_t sync_every_records;                 // 累计多少条记录后fsync
+    std::chrono::milliseconds sync_interval;   // 距上次fsync超过该时间后fsync
+    size_t compact_after_records;              // 日志超过该记录数时压缩为快照
+
+    SessionLogConfig()
+        : sync_every_records(32)
+        , sync_interval(1000)
+        , compact_after_records(1000) {}
+};
+
+// 会话日志
+//
+// 目录结构：
+// - tree.json：快照（对话树结构，紧凑JSON）
+// - bodies-<n>.dat：快照引用的消息正文，节点按偏移读取（可选，旧快照正文内联在tree.json中）
+// - log.jsonl：快照之后的增量记录，每行一条
+//
+// 写入只追加到log.jsonl，fsync按记录数和时间批量执行；
+// 压缩时先原子替换快照（写临时文件、fsync、rename），再截断日志。
+// 恢复时读取快照并重放日志中完整的记录，末尾写了一半的记录被截掉。
+// 记录的重放是幂等的，压缩中途崩溃导致的重复重放不影响结果。
+class SessionLog {
+public:
+    explicit SessionLog(const std::string& dir, const SessionLogConfig& config = SessionLogConfig());
+    ~SessionLog();
+
+    SessionLog(const SessionLog&) = delete;
+    SessionLog& operator=(const SessionLog&) = delete;
+
+    // 读取快照和日志记录（截掉末尾不完整的记录），并打开日志用于追加
+    bool recover(json& snapshot, std::vector<json>& records);
+
+    // 追加记录（按批量策略fsync）
+    bool append(const std::vector<json>& records);
+
+    // 立即fsync
+    bool sync();
+
+    // 写入新快照并清空日志；bodies非空时写入新的正文文件并由快照引用
+    bool compact(json snapshot, const std::string& bodies = std::string());
+
+    // 是否需要压缩
+    bool needsCompaction() const {
+        return !has_snapshot_ || record_count_ >= config_.compact_after_records;
+    }
+
+    // 日志中的记录数（上次压缩之后）
+    size_t recordCount() const { return record_count_; }
+
+    // 是否有快照
+    bool hasSnapshot() const { return has_snapshot_; }
+
+    // 文件路径
+    std::string snapshotPath() const { return dir_ + "/tree.json"; }
+    std::string logPath() const { return dir_ + "/log.jsonl"; }
+
+    // 当前快照引用的正文文件（没有时为空）
+    std::string bodiesPath() const { return bodies_file_.empty() ? std::string() : dir_ + "/" + bodies_file_; }
+
+private:
+    // 打开日志文件（追加模式）
+    bool openLog();
+    void closeLog();
+
+    // 下一个正文文件名
+    std::string nextBodiesFile();
+
+    // 删除快照未引用的正文文件
+    void removeStaleBodies() const;
+
+    std::string dir_;
+    SessionLogConfig config_;
+    int fd_ = -1;
+    bool has_snapshot_ = false;
+    size_t record_count_ = 0;
+    size_t unsynced_ = 0;
+    std::string bodies_file_;
+    uint64_t bodies_generation_ = 0;
+    std::chrono::steady_clock::time_point last_sync_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_SESSION_SESSION_LOG_H
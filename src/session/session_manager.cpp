@@ -18,11 +18,21 @@ SessionManager::SessionManager() {
     sessions_dir_ = ".roboclaw/conversations";
 }
 
+SessionManager::~SessionManager() {
+    flush();
+}
+
 void SessionManager::setSessionsDir(const std::string& dir) {
     std::unique_lock<std::shared_mutex> lock(session_mutex_);
     std::unique_lock<std::mutex> current_lock(current_session_mutex_, std::defer_lock);
     sessions_dir_ = dir;
 
+    // 已打开的日志属于旧目录
+    {
+        std::lock_guard<std::mutex> logs_lock(logs_mutex_);
+        logs_.clear();
+    }
+
     // 创建目录
     try {
         std::filesystem::create_directories(sessions_dir_);
@@ -34,8 +44,13 @@ void SessionManager::setSessionsDir(const std::string& dir) {
         LOG_ERROR("无法创建会话目录: " + sessions_dir_ + " - " + std::string(e.what()));
     }
 
-    // 扫描现有会话
-    scanSessionsDir();
+    // 加载会话索引，缺失或损坏时扫描会话目录重建
+    if (!index_.open(getIndexFilePath())) {
+        index_.rebuild(getIndexFilePath(), scanSessionsDir());
+    }
+
+    // 搜索索引在首次查询时加载
+    search_.open(sessions_dir_ + "/search.jsonl");
 }
 
 std::shared_ptr<ConversationTree> SessionManager::createSession(const std::string& title) {
@@ -55,7 +70,7 @@ std::shared_ptr<ConversationTree> SessionManager::createSession(const std::strin
 
     {
         std::unique_lock<std::shared_mutex> lock(session_mutex_);
-        sessions_cache_[metadata.id] = metadata;
+        index_.upsert(metadata);
     }
 
     // 保存会话
@@ -76,8 +91,7 @@ std::shared_ptr<ConversationTree> SessionManager::loadSession(const std::string&
     // 检查缓存
     {
         std::shared_lock<std::shared_mutex> lock(session_mutex_);
-        auto cachedIt = sessions_cache_.find(sessionId);
-        if (cachedIt != sessions_cache_.end()) {
+        if (index_.contains(sessionId)) {
             // 检查是否当前已加载
             std::shared_ptr<ConversationTree> current;
             {
@@ -90,36 +104,55 @@ std::shared_ptr<ConversationTree> SessionManager::loadSession(const std::string&
         }
     }
 
-    // 从文件加载
-    std::string sessionPath = getSessionFilePath(sessionId);
-    std::ifstream file(sessionPath);
-
-    if (!file.is_open()) {
-        LOG_ERROR("无法打开会话文件: " + sessionPath);
-        return nullptr;
+    auto session = loadTree(sessionId);
+    if (session) {
+        std::lock_guard<std::mutex> lock(current_session_mutex_);
+        current_session_ = session;
+        LOG_INFO("加载会话: " + sessionId);
     }
+    return session;
+}
 
+std::shared_ptr<ConversationTree> SessionManager::loadTree(const std::string& sessionId) {
+    // 从快照和日志恢复
     try {
-        std::string content((std::istreambuf_iterator<char>(file)),
-                           std::istreambuf_iterator<char>());
-        file.close();
+        json snapshot;
+        std::vector<json> records;
+        std::lock_guard<std::mutex> logs_lock(logs_mutex_);
+        SessionLog& log = getLogLocked(sessionId);
+
+        if (!log.recover(snapshot, records) || !log.hasSnapshot()) {
+            LOG_ERROR("无法打开会话文件: " + getSessionFilePath(sessionId));
+            logs_.erase(sessionId);
+            return nullptr;
+        }
 
-        json sessionJson = json::parse(content);
+        // 正文按需从正文文件读取
         auto session = std::make_shared<ConversationTree>();
+        if (!session->fromSnapshot(snapshot, log.bodiesPath())) {
+            LOG_ERROR("解析会话快照失败: " + sessionId);
+            logs_.erase(sessionId);
+            return nullptr;
+        }
 
-        if (session->fromJson(sessionJson)) {
-            {
-                std::lock_guard<std::mutex> lock(current_session_mutex_);
-                current_session_ = session;
+        size_t skipped = 0;
+        for (const auto& record : records) {
+            if (!session->applyRecord(record)) {
+                skipped++;
             }
-            LOG_INFO("加载会话: " + sessionId);
-            return session;
+        }
+        if (skipped > 0) {
+            LOG_WARNING("会话日志中有 " + std::to_string(skipped) + " 条记录无法重放: " + sessionId);
+        }
+        if (log.needsCompaction()) {
+            std::string bodies;
+            json compacted = session->toSnapshot(bodies);
+            log.compact(std::move(compacted), bodies);
         }
 
-    } catch (const json::parse_error& e) {
-        LOG_ERROR("解析会话文件JSON失败: " + sessionId + " - " + std::string(e.what()));
-    } catch (const std::ifstream::failure& e) {
-        LOG_ERROR("读取会话文件失败: " + sessionId + " - " + std::string(e.what()));
+        LOG_DEBUG("恢复会话: " + sessionId + " (重放 " + std::to_string(records.size()) + " 条记录)");
+        return session;
+
     } catch (const std::exception& e) {
         LOG_ERROR("加载会话失败: " + sessionId + " - " + std::string(e.what()));
     }
@@ -132,39 +165,72 @@ bool SessionManager::saveSession(std::shared_ptr<ConversationTree> session) {
         return false;
     }
 
-    try {
-        // 创建会话目录
-        std::string sessionDir = getSessionDirPath(session->getConversationId());
-        std::filesystem::create_directories(sessionDir);
+    const std::string sessionId = session->getConversationId();
 
-        // 保存会话树
-        std::string sessionPath = getSessionFilePath(session->getConversationId());
-        std::ofstream file(sessionPath);
-
-        if (!file.is_open()) {
-            LOG_ERROR("无法创建会话文件: " + sessionPath);
-            return false;
+    try {
+        bool compacted = false;
+        std::vector<json> records;
+        {
+            std::lock_guard<std::mutex> logs_lock(logs_mutex_);
+            SessionLog& log = getLogLocked(sessionId);
+
+            // 只追加自上次保存后的修改；没有快照或日志过长时压缩为快照
+            records = session->takeJournal();
+            bool ok = false;
+            try {
+                if (!log.needsCompaction()) {
+                    ok = log.append(records);
+                }
+                if (!ok) {
+                    std::string bodies;
+                    json snapshot = session->toSnapshot(bodies);
+                    ok = compacted = log.compact(std::move(snapshot), bodies);
+                }
+            } catch (...) {
+                session->restoreJournal(std::move(records));
+                throw;
+            }
+            if (!ok) {
+                // 追加和压缩都失败：记录放回日志队列，下次保存时重试，不能丢失
+                session->restoreJournal(std::move(records));
+                return false;
+            }
         }
 
-        json sessionJson = session->toJson();
-        file << sessionJson.dump(JSON_INDENT_WIDTH);
-        file.close();
-
-        // 更新元数据
-        SessionMetadata metadata = getSessionMetadata(session->getConversationId());
+        // 更新元数据（元数据文件只在压缩和flush时写入）
+        SessionMetadata metadata = getSessionMetadata(sessionId);
         if (metadata.id.empty()) {
-            metadata.id = session->getConversationId();
+            metadata.id = sessionId;
         }
         metadata.updated_at = std::chrono::system_clock::now();
-        metadata.message_count = session->getAllNodes().size();
-        saveMetadata(metadata);
+        metadata.message_count = static_cast<int>(session->getNodeCount());
+        {
+            std::unique_lock<std::shared_mutex> lock(session_mutex_);
+            index_.upsert(metadata);
+        }
+        if (compacted) {
+            writeMetadataFile(metadata);
+        }
+
+        // 更新搜索索引：本次保存中新增或收到回复的节点
+        std::vector<std::pair<std::string, std::string>> documents;
+        for (const auto& record : records) {
+            const std::string op = record.value("op", "");
+            const std::string nodeId = record.value("id", "");
+            if ((op == "node" || op == "assistant") &&
+                (documents.empty() || documents.back().first != nodeId)) {
+                NodeHandle node = session->findNode(nodeId);
+                std::string text = node != INVALID_NODE ? searchText(*session, node) : std::string();
+                if (!text.empty()) {
+                    documents.emplace_back(nodeId, std::move(text));
+                }
+            }
+        }
+        search_.update(sessionId, documents);
 
-        LOG_DEBUG("保存会话: " + session->getConversationId());
+        LOG_DEBUG("保存会话: " + sessionId);
         return true;
 
-    } catch (const std::ofstream::failure& e) {
-        LOG_ERROR("保存会话文件失败: " + std::string(e.what()));
-        return false;
     } catch (const std::filesystem::filesystem_error& e) {
         LOG_ERROR("创建会话目录失败: " + std::string(e.what()));
         return false;
@@ -174,18 +240,57 @@ bool SessionManager::saveSession(std::shared_ptr<ConversationTree> session) {
     }
 }
 
+void SessionManager::flush() {
+    std::vector<std::string> ids;
+    {
+        std::lock_guard<std::mutex> logs_lock(logs_mutex_);
+        for (auto& [id, log] : logs_) {
+            log->sync();
+            ids.push_back(id);
+        }
+    }
+
+    for (const auto& id : ids) {
+        SessionMetadata metadata;
+        {
+            std::shared_lock<std::shared_mutex> lock(session_mutex_);
+            if (!index_.get(id, metadata)) {
+                continue;
+            }
+        }
+        writeMetadataFile(metadata);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(session_mutex_);
+    index_.sync();
+}
+
+SessionLog& SessionManager::getLogLocked(const std::string& sessionId) {
+    auto it = logs_.find(sessionId);
+    if (it == logs_.end()) {
+        it = logs_.emplace(sessionId, std::make_unique<SessionLog>(getSessionDirPath(sessionId), log_config_)).first;
+    }
+    return *it->second;
+}
+
 bool SessionManager::deleteSession(const std::string& sessionId) {
     try {
         std::string sessionDir = getSessionDirPath(sessionId);
 
+        {
+            std::lock_guard<std::mutex> logs_lock(logs_mutex_);
+            logs_.erase(sessionId);
+        }
+
         if (std::filesystem::exists(sessionDir)) {
             std::filesystem::remove_all(sessionDir);
         }
 
         {
             std::unique_lock<std::shared_mutex> lock(session_mutex_);
-            sessions_cache_.erase(sessionId);
+            index_.remove(sessionId);
         }
+        search_.removeSession(sessionId);
 
         {
             std::unique_lock<std::mutex> current_lock(current_session_mutex_);
@@ -207,55 +312,93 @@ bool SessionManager::deleteSession(const std::string& sessionId) {
 }
 
 std::vector<SessionMetadata> SessionManager::listSessions() const {
-    std::shared_lock<std::shared_mutex> lock(session_mutex_);
-    std::vector<SessionMetadata> sessions;
-
-    for (const auto& pair : sessions_cache_) {
-        sessions.push_back(pair.second);
-    }
+    return listSessions(0, 0);
+}
 
-    // 按更新时间排序
-    std::sort(sessions.begin(), sessions.end(),
-        [](const SessionMetadata& a, const SessionMetadata& b) {
-            return a.updated_at > b.updated_at;
-        });
+std::vector<SessionMetadata> SessionManager::listSessions(size_t offset, size_t limit) const {
+    // 索引已按更新时间排序
+    std::shared_lock<std::shared_mutex> lock(session_mutex_);
+    return index_.list(offset, limit);
+}
 
-    return sessions;
+size_t SessionManager::getSessionCount() const {
+    std::shared_lock<std::shared_mutex> lock(session_mutex_);
+    return index_.size();
 }
 
 SessionMetadata SessionManager::getSessionMetadata(const std::string& sessionId) const {
     {
         std::shared_lock<std::shared_mutex> lock(session_mutex_);
-        auto it = sessions_cache_.find(sessionId);
-        if (it != sessions_cache_.end()) {
-            return it->second;
+        SessionMetadata metadata;
+        if (index_.get(sessionId, metadata)) {
+            return metadata;
         }
     }
 
     // 尝试从文件加载
     SessionMetadata metadata;
-    if (const_cast<SessionManager*>(this)->loadMetadata(sessionId, metadata)) {
-        // 更新缓存
+    if (loadMetadata(sessionId, metadata)) {
+        // 补入索引
         std::unique_lock<std::shared_mutex> lock(session_mutex_);
-        sessions_cache_[sessionId] = metadata;
+        index_.upsert(metadata);
         return metadata;
     }
 
     return SessionMetadata();
 }
 
+std::vector<SearchHit> SessionManager::searchSessions(const std::string& query, size_t limit) {
+    // 索引建立之前的会话需要先回填一次
+    if (search_.needsBackfill()) {
+        auto sessions = listSessions();
+        LOG_INFO("正在为 " + std::to_string(sessions.size()) + " 个会话建立搜索索引");
+        for (const auto& metadata : sessions) {
+            auto session = loadTree(metadata.id);
+            if (!session) {
+                continue;
+            }
+            std::vector<std::pair<std::string, std::string>> documents;
+            for (NodeHandle node = 0; node < session->getNodeCount(); ++node) {
+                std::string text = searchText(*session, node);
+                if (!text.empty()) {
+                    documents.emplace_back(session->nodeId(node), std::move(text));
+                }
+            }
+            search_.update(metadata.id, documents);
+        }
+        search_.markReady();
+    }
+
+    return search_.search(query, limit);
+}
+
+std::string SessionManager::searchText(const ConversationTree& session, NodeHandle node) {
+    const std::string& user = session.userMessageOf(node);
+    const std::string& reply = session.assistantMessageOf(node).content;
+    if (reply.empty()) {
+        return user;
+    }
+    return user.empty() ? reply : user + "\n" + reply;
+}
+
 std::shared_ptr<ConversationTree> SessionManager::getOrCreateLatestSession() {
     // 如果有当前会话，返回它
-    if (current_session_) {
-        return current_session_;
+    if (auto current = getCurrentSession()) {
+        return current;
     }
 
-    // 获取会话列表
-    auto sessions = listSessions();
+    // 从索引直接取最新会话，无需列出全部
+    std::optional<SessionMetadata> latest;
+    {
+        std::shared_lock<std::shared_mutex> lock(session_mutex_);
+        latest = index_.latest();
+    }
 
-    if (!sessions.empty()) {
+    if (latest) {
         // 加载最新会话
-        return loadSession(sessions[0].id);
+        if (auto session = loadSession(latest->id)) {
+            return session;
+        }
     }
 
     // 创建新会话
@@ -263,11 +406,16 @@ std::shared_ptr<ConversationTree> SessionManager::getOrCreateLatestSession() {
 }
 
 void SessionManager::cleanupEmptySessions() {
-    for (const auto& pair : sessions_cache_) {
-        if (pair.second.message_count == 0) {
-            deleteSession(pair.first);
+    // 先收集再删除，deleteSession会修改索引
+    std::vector<std::string> empty;
+    for (const auto& metadata : listSessions()) {
+        if (metadata.message_count == 0) {
+            empty.push_back(metadata.id);
         }
     }
+    for (const auto& id : empty) {
+        deleteSession(id);
+    }
 }
 
 std::string SessionManager::getSessionFilePath(const std::string& sessionId) const {
@@ -278,6 +426,10 @@ std::string SessionManager::getMetadataFilePath(const std::string& sessionId) co
     return getSessionDirPath(sessionId) + "/metadata.json";
 }
 
+std::string SessionManager::getIndexFilePath() const {
+    return sessions_dir_ + "/index.bin";
+}
+
 std::string SessionManager::getSessionDirPath(const std::string& sessionId) const {
     return sessions_dir_ + "/" + sessionId;
 }
@@ -344,12 +496,22 @@ bool SessionManager::saveMetadata(const SessionMetadata& metadata) const {
     }
 }
 
-void SessionManager::scanSessionsDir() {
-    sessions_cache_.clear();
+bool SessionManager::writeMetadataFile(SessionMetadata metadata) const {
+    // 索引中的标题可能被截断，以元数据文件中的完整标题为准
+    SessionMetadata stored;
+    if (loadMetadata(metadata.id, stored) && stored.title.size() > metadata.title.size() &&
+        stored.title.compare(0, metadata.title.size(), metadata.title) == 0) {
+        metadata.title = stored.title;
+    }
+    return saveMetadata(metadata);
+}
+
+std::vector<SessionMetadata> SessionManager::scanSessionsDir() const {
+    std::vector<SessionMetadata> sessions;
 
     try {
         if (!std::filesystem::exists(sessions_dir_)) {
-            return;
+            return sessions;
         }
 
         for (const auto& entry : std::filesystem::directory_iterator(sessions_dir_)) {
@@ -357,7 +519,7 @@ void SessionManager::scanSessionsDir() {
                 std::string sessionId = entry.path().filename().string();
                 SessionMetadata metadata;
                 if (loadMetadata(sessionId, metadata)) {
-                    sessions_cache_[sessionId] = metadata;
+                    sessions.push_back(metadata);
                 }
             }
         }
@@ -367,6 +529,8 @@ void SessionManager::scanSessionsDir() {
     } catch (const std::exception& e) {
         LOG_ERROR("扫描会话目录失败: " + std::string(e.what()));
     }
+
+    return sessions;
 }
 
 } // namespace roboclaw
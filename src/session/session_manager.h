@@ -5,6 +5,9 @@
 #define ROBOCLAW_SESSION_SESSION_MANAGER_H
 
 #include "conversation_tree.h"
+#include "session_index.h"
+#include "session_log.h"
+#include "session_search.h"
 #include <string>
 #include <map>
 #include <memory>
@@ -15,54 +18,11 @@
 
 namespace roboclaw {
 
-// 会话元数据
-struct SessionMetadata {
-    std::string id;
-    std::string title;
-    std::chrono::system_clock::time_point created_at;
-    std::chrono::system_clock::time_point updated_at;
-    int message_count;
-
-    SessionMetadata()
-        : message_count(0) {
-        created_at = updated_at = std::chrono::system_clock::now();
-    }
-
-    json toJson() const {
-        json j;
-        j["id"] = id;
-        j["title"] = title;
-        j["created_at"] = std::chrono::system_clock::to_time_t(created_at);
-        j["updated_at"] = std::chrono::system_clock::to_time_t(updated_at);
-        j["message_count"] = message_count;
-        return j;
-    }
-
-    static SessionMetadata fromJson(const json& j) {
-        SessionMetadata meta;
-        meta.id = j.value("id", "");
-        meta.title = j.value("title", "");
-
-        if (j.contains("created_at")) {
-            std::time_t time = j["created_at"];
-            meta.created_at = std::chrono::system_clock::from_time_t(time);
-        }
-
-        if (j.contains("updated_at")) {
-            std::time_t time = j["updated_at"];
-            meta.updated_at = std::chrono::system_clock::from_time_t(time);
-        }
-
-        meta.message_count = j.value("message_count", 0);
-        return meta;
-    }
-};
-
 // 会话管理器
 class SessionManager {
 public:
     SessionManager();
-    ~SessionManager() = default;
+    ~SessionManager();
 
     // 设置会话存储目录
     void setSessionsDir(const std::string& dir);
@@ -77,9 +37,18 @@ public:
     // 加载会话
     std::shared_ptr<ConversationTree> loadSession(const std::string& sessionId);
 
-    // 保存会话
+    // 保存会话（只追加自上次保存后的修改记录，日志过长时压缩为快照）
     bool saveSession(std::shared_ptr<ConversationTree> session);
 
+    // 将所有会话日志落盘并写入元数据
+    void flush();
+
+    // 设置会话日志配置（对之后打开的会话生效）
+    void setLogConfig(const SessionLogConfig& config) {
+        std::lock_guard<std::mutex> lock(logs_mutex_);
+        log_config_ = config;
+    }
+
     // 删除会话
     bool deleteSession(const std::string& sessionId);
 
@@ -95,12 +64,21 @@ public:
         current_session_ = session;
     }
 
-    // 列出所有会话
+    // 列出所有会话（按更新时间倒序）
     std::vector<SessionMetadata> listSessions() const;
 
+    // 分页列出会话（limit为0表示不限）
+    std::vector<SessionMetadata> listSessions(size_t offset, size_t limit) const;
+
+    // 会话数
+    size_t getSessionCount() const;
+
     // 获取会话元数据
     SessionMetadata getSessionMetadata(const std::string& sessionId) const;
 
+    // 全文搜索所有会话（BM25排序），返回最相关的limit条
+    std::vector<SearchHit> searchSessions(const std::string& query, size_t limit = 10);
+
     // 获取或创建最新会话
     std::shared_ptr<ConversationTree> getOrCreateLatestSession();
 
@@ -110,12 +88,27 @@ public:
 private:
     std::string sessions_dir_;
     std::shared_ptr<ConversationTree> current_session_;
-    mutable std::map<std::string, SessionMetadata> sessions_cache_;
+    mutable SessionIndex index_;   // 会话元数据索引（index.bin）
+    SessionSearchIndex search_;    // 全文搜索索引（search.jsonl，自带锁）
 
     // 读写锁保证线程安全
     mutable std::shared_mutex session_mutex_;
     mutable std::mutex current_session_mutex_;  // 当前会话专用锁
 
+    // 每个会话的追加日志
+    std::map<std::string, std::unique_ptr<SessionLog>> logs_;
+    SessionLogConfig log_config_;
+    std::mutex logs_mutex_;
+
+    // 从快照和日志恢复会话（不改变当前会话）
+    std::shared_ptr<ConversationTree> loadTree(const std::string& sessionId);
+
+    // 节点的搜索文本（用户消息 + AI回复）
+    static std::string searchText(const ConversationTree& session, NodeHandle node);
+
+    // 获取会话日志（调用方持有logs_mutex_）
+    SessionLog& getLogLocked(const std::string& sessionId);
+
     // 禁止拷贝
     SessionManager(const SessionManager&) = delete;
     SessionManager& operator=(const SessionManager&) = delete;
@@ -135,8 +128,14 @@ private:
     // 保存元数据
     bool saveMetadata(const SessionMetadata& metadata) const;
 
-    // 扫描会话目录
-    void scanSessionsDir();
+    // 用索引中的元数据更新元数据文件（保留文件中未截断的标题）
+    bool writeMetadataFile(SessionMetadata metadata) const;
+
+    // 获取索引文件路径
+    std::string getIndexFilePath() const;
+
+    // 扫描会话目录（索引缺失或损坏时用于重建）
+    std::vector<SessionMetadata> scanSessionsDir() const;
 };
 
 } // namespace roboclaw
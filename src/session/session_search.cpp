@@ -0,0 +1,550 @@
+// SessionSearchIndex实现
+
+#include "session_search.h"
+#include "../utils/atomic_file.h"
+#include "../utils/logger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using json = nlohmann::json;
+
+namespace roboclaw {
+
+namespace {
+
+// BM25参数
+constexpr double BM25_K1 = 1.2;
+constexpr double BM25_B = 0.75;
+
+// 单个词的最大字节数（更长的视为噪声，如base64）
+constexpr size_t MAX_TOKEN_BYTES = 64;
+
+// 片段在命中位置前后保留的字节数
+constexpr size_t SNIPPET_BEFORE = 60;
+constexpr size_t SNIPPET_AFTER = 120;
+
+// 解码一个UTF-8字符，返回码点和字节数（非法字节按单字节处理）
+uint32_t decodeUtf8(std::string_view text, size_t pos, size_t& length) {
+    unsigned char c = static_cast<unsigned char>(text[pos]);
+    uint32_t cp;
+    if (c < 0x80) {
+        length = 1;
+        return c;
+    } else if ((c & 0xE0) == 0xC0) {
+        length = 2;
+        cp = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        length = 3;
+        cp = c & 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        length = 4;
+        cp = c & 0x07;
+    } else {
+        length = 1;
+        return 0xFFFD;
+    }
+    if (pos + length > text.size()) {
+        length = 1;
+        return 0xFFFD;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            length = 1;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (next & 0x3F);
+    }
+    return cp;
+}
+
+// 中日韩文字（汉字、假名、谚文）
+bool isCjk(uint32_t cp) {
+    return (cp >= 0x4E00 && cp <= 0x9FFF) ||   // CJK统一汉字
+           (cp >= 0x3400 && cp <= 0x4DBF) ||   // 扩展A
+           (cp >= 0x20000 && cp <= 0x2FA1F) || // 扩展B及以后、兼容补充
+           (cp >= 0xF900 && cp <= 0xFAFF) ||   // 兼容汉字
+           (cp >= 0x3040 && cp <= 0x30FF) ||   // 平假名、片假名
+           (cp >= 0xAC00 && cp <= 0xD7AF);     // 谚文音节
+}
+
+// 中日韩标点、全角符号等视为分隔符
+bool isSeparator(uint32_t cp) {
+    if (cp < 0x80) {
+        return !std::isalnum(static_cast<int>(cp)) && cp != '_';
+    }
+    return (cp >= 0x2000 && cp <= 0x206F) ||   // 通用标点
+           (cp >= 0x3000 && cp <= 0x303F) ||   // 中日韩标点
+           (cp >= 0xFF00 && cp <= 0xFFEF) ||   // 全角字符
+           cp == 0xFFFD;
+}
+
+bool isContinuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+std::string lowerAscii(std::string_view text) {
+    std::string result(text);
+    for (char& c : result) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<std::string> SessionSearchIndex::tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    std::string word;
+    std::vector<std::string_view> cjk;   // 当前连续的中日韩字符
+
+    auto flushWord = [&]() {
+        if (!word.empty() && word.size() <= MAX_TOKEN_BYTES) {
+            tokens.push_back(word);
+        }
+        word.clear();
+    };
+    auto flushCjk = [&]() {
+        // 单字和相邻二元组：二元组提高短语精度，单字保证单字查询可命中
+        for (size_t i = 0; i < cjk.size(); ++i) {
+            tokens.emplace_back(cjk[i]);
+            if (i + 1 < cjk.size()) {
+                tokens.emplace_back(std::string(cjk[i]) + std::string(cjk[i + 1]));
+            }
+        }
+        cjk.clear();
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t length;
+        uint32_t cp = decodeUtf8(text, pos, length);
+
+        if (isCjk(cp)) {
+            flushWord();
+            cjk.push_back(text.substr(pos, length));
+        } else if (isSeparator(cp)) {
+            flushWord();
+            flushCjk();
+        } else {
+            flushCjk();
+            if (cp < 0x80) {
+                word += static_cast<char>(std::tolower(static_cast<int>(cp)));
+            } else {
+                word.append(text.substr(pos, length));
+            }
+        }
+        pos += length;
+    }
+    flushWord();
+    flushCjk();
+
+    return tokens;
+}
+
+void SessionSearchIndex::open(const std::string& path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    path_ = path;
+    loaded_ = false;
+    tail_checked_ = false;
+    ready_ = false;
+    log_records_ = 0;
+    documents_.clear();
+    by_key_.clear();
+    by_session_.clear();
+    terms_.clear();
+    alive_count_ = 0;
+    total_length_ = 0;
+}
+
+void SessionSearchIndex::ensureLoaded() {
+    if (loaded_) {
+        return;
+    }
+    loaded_ = true;
+
+    std::ifstream file(path_, std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+
+    // 先找出每个节点的最后一条记录和每个会话最后一次删除的位置，
+    // 只为最终存活的文档分词，避免被覆盖的记录反复建立和撤销倒排表
+    struct Pending {
+        std::string session_id;
+        std::string node_id;
+        std::string text;
+    };
+    std::vector<Pending> pending;
+    std::unordered_map<std::string, size_t> latest;      // 会话+节点 -> 最后一条记录
+    std::unordered_map<std::string, size_t> dropped;     // 会话 -> 最后一次删除之后的第一条记录
+
+    std::string line;
+    size_t skipped = 0;
+    while (std::getline(file, line)) {
+        json record = json::parse(line, nullptr, false);
+        if (record.is_discarded() || !record.is_object()) {
+            skipped++;
+            continue;
+        }
+        log_records_++;
+
+        const std::string op = record.value("op", "");
+        if (op == "doc") {
+            Pending doc{record.value("s", ""), record.value("n", ""), record.value("t", "")};
+            latest[documentKey(doc.session_id, doc.node_id)] = pending.size();
+            pending.push_back(std::move(doc));
+        } else if (op == "drop") {
+            dropped[record.value("s", "")] = pending.size();
+        } else if (op == "ready") {
+            ready_ = true;
+        }
+    }
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+        const Pending& doc = pending[i];
+        if (latest[documentKey(doc.session_id, doc.node_id)] != i) {
+            continue;
+        }
+        auto drop = dropped.find(doc.session_id);
+        if (drop != dropped.end() && i < drop->second) {
+            continue;
+        }
+        addDocument(doc.session_id, doc.node_id, doc.text);
+    }
+
+    if (skipped > 0) {
+        LOG_WARNING("搜索索引中有 " + std::to_string(skipped) + " 条记录无法解析: " + path_);
+    }
+    LOG_DEBUG("加载搜索索引: " + std::to_string(alive_count_) + " 篇文档");
+}
+
+void SessionSearchIndex::addDocument(const std::string& sessionId, const std::string& nodeId,
+                                     const std::string& text) {
+    std::string key = documentKey(sessionId, nodeId);
+    auto existing = by_key_.find(key);
+    if (existing != by_key_.end()) {
+        uint32_t old = existing->second;
+        if (documents_[old].text == text) {
+            return;
+        }
+        removeDocument(old);
+        auto& sessionDocs = by_session_[sessionId];
+        sessionDocs.erase(std::remove(sessionDocs.begin(), sessionDocs.end(), old), sessionDocs.end());
+    }
+
+    uint32_t doc = static_cast<uint32_t>(documents_.size());
+    std::vector<std::string> tokens = tokenize(text);
+
+    // 统计词频
+    std::unordered_map<std::string_view, uint32_t> frequencies;
+    for (const auto& token : tokens) {
+        frequencies[token]++;
+    }
+    for (const auto& [token, tf] : frequencies) {
+        Term& term = terms_[std::string(token)];
+        term.postings.push_back({doc, tf});
+        term.df++;
+    }
+
+    Document document;
+    document.session_id = sessionId;
+    document.node_id = nodeId;
+    document.text = text;
+    document.length = static_cast<uint32_t>(tokens.size());
+    documents_.push_back(std::move(document));
+
+    by_key_[key] = doc;
+    by_session_[sessionId].push_back(doc);
+    alive_count_++;
+    total_length_ += tokens.size();
+}
+
+void SessionSearchIndex::removeDocument(uint32_t doc) {
+    Document& document = documents_[doc];
+    if (!document.alive) {
+        return;
+    }
+    document.alive = false;
+    alive_count_--;
+    total_length_ -= document.length;
+    by_key_.erase(documentKey(document.session_id, document.node_id));
+
+    // 倒排表中的条目留到重建时清理，这里只维护文档频率
+    std::vector<std::string> tokens = tokenize(document.text);
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    for (const auto& token : tokens) {
+        auto it = terms_.find(token);
+        if (it != terms_.end() && it->second.df > 0) {
+            it->second.df--;
+        }
+    }
+    document.text.clear();
+    document.text.shrink_to_fit();
+}
+
+void SessionSearchIndex::rebuildPostings() {
+    // 丢弃已删除的文档并重新编号
+    std::vector<Document> documents;
+    documents.reserve(alive_count_);
+    for (auto& document : documents_) {
+        if (document.alive) {
+            documents.push_back(std::move(document));
+        }
+    }
+
+    documents_.clear();
+    by_key_.clear();
+    by_session_.clear();
+    terms_.clear();
+    alive_count_ = 0;
+    total_length_ = 0;
+    for (auto& document : documents) {
+        addDocument(document.session_id, document.node_id, document.text);
+    }
+}
+
+void SessionSearchIndex::appendRecords(const std::string& data) {
+    if (path_.empty() || data.empty()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), ec);
+
+    // 上次写入可能中断在行中间（崩溃或写入失败）：日志不以换行结尾时先补一个换行，
+    // 残缺的末行单独成行并在加载时被忽略，不会与本批第一条记录粘在一起
+    bool newline = false;
+    if (!tail_checked_) {
+        std::ifstream tail(path_, std::ios::binary | std::ios::ate);
+        if (tail.is_open() && tail.tellg() > 0) {
+            tail.seekg(-1, std::ios::end);
+            char last = '\n';
+            newline = tail.get(last) && last != '\n';
+        }
+        tail_checked_ = true;
+    }
+
+    // 一次写入整批记录
+    std::ofstream file(path_, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        LOG_ERROR("无法打开搜索索引: " + path_ + " - " + std::strerror(errno));
+        return;
+    }
+    if (newline) {
+        file.put('\n');
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.flush();
+    if (!file) {
+        LOG_ERROR("写入搜索索引失败: " + path_ + " - " + std::strerror(errno));
+        tail_checked_ = false;
+    }
+}
+
+void SessionSearchIndex::rewriteIfNeeded() {
+    // 日志中被覆盖或删除的记录超过存活文档数时重写
+    if (!loaded_ || log_records_ <= 2 * alive_count_ + 1024) {
+        return;
+    }
+
+    std::string data;
+    if (ready_) {
+        data += json{{"op", "ready"}}.dump();
+        data += '\n';
+    }
+    for (const auto& document : documents_) {
+        if (document.alive) {
+            data += json{{"op", "doc"}, {"s", document.session_id}, {"n", document.node_id},
+                         {"t", document.text}}.dump();
+            data += '\n';
+        }
+    }
+
+    std::string error;
+    if (!writeFileAtomic(path_, data, error)) {
+        LOG_ERROR("重写搜索索引失败: " + path_ + " - " + error);
+        return;
+    }
+    log_records_ = alive_count_ + (ready_ ? 1 : 0);
+
+    if (documents_.size() > 2 * alive_count_ + 1024) {
+        rebuildPostings();
+    }
+}
+
+void SessionSearchIndex::update(const std::string& sessionId,
+                                const std::vector<std::pair<std::string, std::string>>& documents) {
+    if (documents.empty()) {
+        return;
+    }
+
+    std::string data;
+    for (const auto& [nodeId, text] : documents) {
+        data += json{{"op", "doc"}, {"s", sessionId}, {"n", nodeId}, {"t", text}}
+                    .dump(-1, ' ', false, json::error_handler_t::replace);
+        data += '\n';
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    appendRecords(data);
+
+    // 内存索引尚未加载时只写日志，加载时会一并重放
+    if (loaded_) {
+        for (const auto& [nodeId, text] : documents) {
+            addDocument(sessionId, nodeId, text);
+        }
+        log_records_ += documents.size();
+        rewriteIfNeeded();
+    }
+}
+
+void SessionSearchIndex::removeSession(const std::string& sessionId) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    appendRecords(json{{"op", "drop"}, {"s", sessionId}}.dump() + "\n");
+
+    if (loaded_) {
+        auto it = by_session_.find(sessionId);
+        if (it != by_session_.end()) {
+            for (uint32_t doc : it->second) {
+                removeDocument(doc);
+            }
+            by_session_.erase(it);
+        }
+        log_records_++;
+        rewriteIfNeeded();
+    }
+}
+
+bool SessionSearchIndex::needsBackfill() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ensureLoaded();
+    return !ready_;
+}
+
+void SessionSearchIndex::markReady() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ensureLoaded();
+    if (!ready_) {
+        ready_ = true;
+        appendRecords(json{{"op", "ready"}}.dump() + "\n");
+        log_records_++;
+    }
+}
+
+size_t SessionSearchIndex::documentCount() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ensureLoaded();
+    return alive_count_;
+}
+
+std::vector<SearchHit> SessionSearchIndex::search(const std::string& query, size_t limit) {
+    std::vector<std::string> terms = tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (terms.empty() || limit == 0) {
+        return {};
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        ensureLoaded();
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (alive_count_ == 0) {
+        return {};
+    }
+
+    // BM25累加：稠密得分数组 + 命中文档列表
+    const double n = static_cast<double>(alive_count_);
+    const double avgLength = std::max(1.0, static_cast<double>(total_length_) / n);
+    std::vector<float> scores(documents_.size(), 0.0f);
+    std::vector<uint32_t> touched;
+
+    for (const auto& text : terms) {
+        auto it = terms_.find(text);
+        if (it == terms_.end() || it->second.df == 0) {
+            continue;
+        }
+        const Term& term = it->second;
+        const double df = term.df;
+        const double idf = std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+
+        for (const Posting& posting : term.postings) {
+            const Document& document = documents_[posting.doc];
+            if (!document.alive) {
+                continue;
+            }
+            const double tf = posting.tf;
+            const double norm = BM25_K1 * (1.0 - BM25_B + BM25_B * document.length / avgLength);
+            if (scores[posting.doc] == 0.0f) {
+                touched.push_back(posting.doc);
+            }
+            scores[posting.doc] += static_cast<float>(idf * tf * (BM25_K1 + 1.0) / (tf + norm));
+        }
+    }
+
+    size_t count = std::min(limit, touched.size());
+    std::partial_sort(touched.begin(), touched.begin() + static_cast<std::ptrdiff_t>(count), touched.end(),
+        [&scores](uint32_t a, uint32_t b) {
+            return scores[a] != scores[b] ? scores[a] > scores[b] : a > b;
+        });
+
+    std::vector<SearchHit> hits;
+    hits.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Document& document = documents_[touched[i]];
+        hits.push_back({document.session_id, document.node_id, scores[touched[i]],
+                        makeSnippet(document.text, terms)});
+    }
+    return hits;
+}
+
+std::string SessionSearchIndex::makeSnippet(const std::string& text, const std::vector<std::string>& terms) {
+    // 以最早出现的查询词为中心截取（ASCII转小写不改变字节位置）
+    std::string lower = lowerAscii(text);
+    size_t hit = std::string::npos;
+    for (const auto& term : terms) {
+        size_t pos = lower.find(term);
+        if (pos < hit) {
+            hit = pos;
+        }
+    }
+    if (hit == std::string::npos) {
+        hit = 0;
+    }
+
+    size_t start = hit > SNIPPET_BEFORE ? hit - SNIPPET_BEFORE : 0;
+    size_t end = std::min(text.size(), hit + SNIPPET_AFTER);
+    while (start > 0 && start < text.size() && isContinuation(text[start])) {
+        start--;
+    }
+    while (end < text.size() && isContinuation(text[end])) {
+        end--;
+    }
+
+    std::string snippet;
+    if (start > 0) {
+        snippet += "...";
+    }
+    for (size_t i = start; i < end; ++i) {
+        char c = text[i];
+        snippet += (c == '\n' || c == '\r' || c == '\t') ? ' ' : c;
+    }
+    if (end < text.size()) {
+        snippet += "...";
+    }
+    return snippet;
+}
+
+} // namespace roboclaw
@@ -0,0 +1,124 @@
+// 会话搜索 - SessionSearchIndex
+// 所有会话消息的全文倒排索引（BM25排序）
+
+#ifndef ROBOCLAW_SESSION_SESSION_SEARCH_H
+#define ROBOCLAW_SESSION_SESSION_SEARCH_H
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace roboclaw {
+
+// 搜索结果
+struct SearchHit {
+    std::string session_id;
+    std::string node_id;
+    double score;
+    std::string snippet;   // 命中位置附近的片段
+};
+
+// 会话搜索索引
+//
+// 每个对话节点（用户消息 + AI回复）是一篇文档。
+// 分词：ASCII字母数字按单词切分并转小写；中日韩文字切分为单字和相邻二元组，
+// 其他非ASCII字符视为单词的一部分。
+//
+// 持久化为search.jsonl追加日志：每次保存会话只追加变化的节点，
+// 同一节点的后一条记录覆盖前一条，删除会话追加一条drop记录；
+// 无效记录过多时整体重写。内存中的倒排表在首次查询时才从日志构建，
+// 之后随更新增量维护。
+//
+// 日志中没有ready记录表示尚未从已有会话回填，见needsBackfill()。
+//
+// 线程安全。
+class SessionSearchIndex {
+public:
+    SessionSearchIndex() = default;
+
+    SessionSearchIndex(const SessionSearchIndex&) = delete;
+    SessionSearchIndex& operator=(const SessionSearchIndex&) = delete;
+
+    // 设置索引文件（不立即读取）
+    void open(const std::string& path);
+
+    // 添加或替换一个会话中的若干节点（node_id, 文本）
+    void update(const std::string& sessionId,
+                const std::vector<std::pair<std::string, std::string>>& documents);
+
+    // 删除会话的所有节点
+    void removeSession(const std::string& sessionId);
+
+    // 查询，返回得分最高的limit条
+    std::vector<SearchHit> search(const std::string& query, size_t limit = 10);
+
+    // 是否需要从已有会话回填（索引文件创建之前的会话未被索引）
+    bool needsBackfill();
+
+    // 标记回填完成
+    void markReady();
+
+    // 文档数
+    size_t documentCount();
+
+    // 分词（公开以便测试）
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    struct Document {
+        std::string session_id;
+        std::string node_id;
+        std::string text;
+        uint32_t length = 0;   // 词数
+        bool alive = true;
+    };
+
+    struct Posting {
+        uint32_t doc;
+        uint32_t tf;
+    };
+
+    struct Term {
+        std::vector<Posting> postings;   // 包含已删除文档，查询时跳过
+        uint32_t df = 0;                 // 存活文档数
+    };
+
+    // 以下函数要求调用方持有写锁
+    void ensureLoaded();
+    void addDocument(const std::string& sessionId, const std::string& nodeId, const std::string& text);
+    void removeDocument(uint32_t doc);
+    void appendRecords(const std::string& data);
+    void rewriteIfNeeded();
+    void rebuildPostings();
+
+    static std::string documentKey(const std::string& sessionId, const std::string& nodeId) {
+        return sessionId + '\n' + nodeId;
+    }
+
+    // 生成片段
+    static std::string makeSnippet(const std::string& text, const std::vector<std::string>& terms);
+
+    std::string path_;
+    bool loaded_ = false;
+    bool tail_checked_ = false;  // 已确认日志以换行结尾（或已补上换行）
+    bool ready_ = false;
+    size_t log_records_ = 0;   // 日志中的记录数（用于判断是否重写）
+
+    std::vector<Document> documents_;
+    std::unordered_map<std::string, uint32_t> by_key_;                        // 会话+节点 -> 文档
+    std::unordered_map<std::string, std::vector<uint32_t>> by_session_;      // 会话 -> 文档
+    std::unordered_map<std::string, Term> terms_;
+    size_t alive_count_ = 0;
+    uint64_t total_length_ = 0;   // 存活文档的总词数
+
+    std::shared_mutex mutex_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_SESSION_SESSION_SEARCH_H
@@ -0,0 +1,66 @@
+// 字符串池 - StringPool
+// 驻留字符串，相同内容只存一份，用32位编号引用
+
+#ifndef ROBOCLAW_SESSION_STRING_POOL_H
+#define ROBOCLAW_SESSION_STRING_POOL_H
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace roboclaw {
+
+// 字符串池
+// 编号0固定为空字符串；deque保证已驻留字符串的地址不变，索引可以直接用string_view作键
+class StringPool {
+public:
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+    StringPool() {
+        strings_.emplace_back();
+        index_.emplace(strings_.front(), EMPTY);
+    }
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // 驻留字符串，返回编号
+    uint32_t intern(std::string_view text) {
+        auto it = index_.find(text);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        uint32_t atom = static_cast<uint32_t>(strings_.size());
+        strings_.emplace_back(text);
+        index_.emplace(strings_.back(), atom);
+        return atom;
+    }
+
+    // 查找编号（不驻留）
+    uint32_t find(std::string_view text) const {
+        auto it = index_.find(text);
+        return it != index_.end() ? it->second : NOT_FOUND;
+    }
+
+    const std::string& get(uint32_t atom) const { return strings_[atom]; }
+
+    size_t size() const { return strings_.size(); }
+
+    void clear() {
+        index_.clear();
+        strings_.resize(1);
+        index_.emplace(strings_.front(), EMPTY);
+    }
+
+private:
+    std::deque<std::string> strings_;
+    std::unordered_map<std::string_view, uint32_t> index_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_SESSION_STRING_POOL_H
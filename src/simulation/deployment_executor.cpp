@@ -0,0 +1,342 @@
+// src/simulation/deployment_executor.cpp
+#include "deployment_executor.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include <thread>
+
+namespace roboclaw::simulation {
+
+namespace {
+
+// Actuator authority of the simulated plant at 100% power (units/s^2)
+constexpr double SIM_PEAK_ACCELERATION = 50.0;
+
+// How often the calling thread drains telemetry and reports progress
+constexpr auto MONITOR_PERIOD = std::chrono::milliseconds(1);
+
+} // namespace
+
+//=============================================================================
+// SimulatedPlant
+//=============================================================================
+
+SimulatedPlant::SimulatedPlant(double time_constant)
+    : tau_(std::max(time_constant, 1e-3))
+    , max_acceleration_(SIM_PEAK_ACCELERATION)
+    , setpoint_(0.0)
+    , disturbance_(0.0)
+    , stopped_(false) {
+}
+
+bool SimulatedPlant::applyParameters(const nlohmann::json& params, const DeploymentStage& stage) {
+    if (stage.power_percentage <= 0 || stage.power_percentage > 100) {
+        return false;
+    }
+    max_acceleration_ = SIM_PEAK_ACCELERATION * stage.power_percentage / 100.0;
+
+    std::lock_guard<std::mutex> lock(params_mutex_);
+    applied_params_ = params;
+    applied_params_["power_percentage"] = stage.power_percentage;
+    return true;
+}
+
+void SimulatedPlant::commandVelocity(double velocity) {
+    setpoint_ = velocity;
+}
+
+PlantState SimulatedPlant::sample(double dt) {
+    double drive = stopped_.load() ? 0.0 : (setpoint_ - state_.velocity) / tau_;
+    drive = std::clamp(drive, -max_acceleration_, max_acceleration_);
+
+    state_.acceleration = drive + disturbance_.load();
+    state_.velocity += state_.acceleration * dt;
+    state_.position += state_.velocity * dt;
+    state_.effort = drive / SIM_PEAK_ACCELERATION;
+
+    if (stopped_.load() && std::abs(state_.velocity) < 1e-6) {
+        state_.velocity = 0.0;
+    }
+    return state_;
+}
+
+void SimulatedPlant::emergencyStop() {
+    stopped_.store(true);
+    setpoint_ = 0.0;
+}
+
+void SimulatedPlant::setDisturbance(double acceleration) {
+    disturbance_.store(acceleration);
+}
+
+nlohmann::json SimulatedPlant::getAppliedParameters() const {
+    std::lock_guard<std::mutex> lock(params_mutex_);
+    return applied_params_;
+}
+
+//=============================================================================
+// TelemetryRing
+//=============================================================================
+
+bool TelemetryRing::push(const TelemetrySample& sample) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= CAPACITY) {
+        return false;
+    }
+    buffer_[head & (CAPACITY - 1)] = sample;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool TelemetryRing::pop(TelemetrySample& sample) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    sample = buffer_[tail & (CAPACITY - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+//=============================================================================
+// DeploymentExecutor
+//=============================================================================
+
+DeploymentExecutor::DeploymentExecutor(std::shared_ptr<IDeploymentPlant> plant,
+                                       const DeploymentExecutorConfig& config)
+    : plant_(std::move(plant))
+    , config_(config)
+    , abort_requested_(false)
+    , max_good_stage_(INT_MAX)
+    , completed_stages_(0)
+    , control_done_(false) {
+    if (config_.control_rate_hz <= 0.0) {
+        config_.control_rate_hz = DeploymentExecutorConfig().control_rate_hz;
+    }
+    config_.violation_ticks = std::max(config_.violation_ticks, 1);
+}
+
+void DeploymentExecutor::setTelemetryCallback(TelemetryCallback callback) {
+    telemetry_callback_ = std::move(callback);
+}
+
+void DeploymentExecutor::abort() {
+    abort_requested_.store(true);
+}
+
+DeploymentReport DeploymentExecutor::run(const nlohmann::json& params,
+                                         const std::vector<DeploymentStage>& stages,
+                                         ProgressCallback progress_callback) {
+    DeploymentReport report;
+    if (!plant_) {
+        report.failure_reason = "No deployment plant attached";
+        return report;
+    }
+
+    abort_requested_.store(false);
+    max_good_stage_.store(INT_MAX);
+    completed_stages_.store(0);
+    control_done_.store(false);
+
+    ControlResult result;
+    std::thread control([&]() {
+        controlLoop(params, stages, result);
+        control_done_.store(true, std::memory_order_release);
+    });
+
+    auto drain = [&]() {
+        TelemetrySample sample;
+        while (telemetry_.pop(sample)) {
+            report.max_velocity = std::max(report.max_velocity, std::abs(sample.velocity));
+            report.max_acceleration = std::max(report.max_acceleration, std::abs(sample.acceleration));
+            if (telemetry_callback_) {
+                telemetry_callback_(sample);
+            }
+        }
+    };
+
+    int reported = 0;
+    int rejected_stage = -1;
+    auto report_progress = [&]() {
+        int completed = completed_stages_.load();
+        while (reported < completed && rejected_stage < 0) {
+            const auto& stage = stages[reported];
+            std::string message = "Stage " + std::to_string(reported + 1) + "/" +
+                                  std::to_string(stages.size()) + ": " + stage.description;
+            if (progress_callback && !progress_callback(reported, message)) {
+                // Callback requested abort: this stage is not accepted
+                rejected_stage = reported;
+                max_good_stage_.store(reported - 1);
+                abort();
+            }
+            ++reported;
+        }
+    };
+
+    while (!control_done_.load(std::memory_order_acquire)) {
+        drain();
+        report_progress();
+        std::this_thread::sleep_for(MONITOR_PERIOD);
+    }
+    control.join();
+    drain();
+    report_progress();
+
+    if (rejected_stage >= 0) {
+        // The callback can reject the final stage after the loop already finished
+        if (result.outcome == Outcome::Completed) {
+            rollback(params, stages, rejected_stage - 1);
+        }
+        result.outcome = Outcome::Aborted;
+        result.failed_stage = rejected_stage;
+        result.reason = "Aborted by progress callback";
+    }
+
+    report.success = result.outcome == Outcome::Completed;
+    report.rolled_back = !report.success;
+    report.completed_stages = report.success
+        ? static_cast<int>(stages.size())
+        : std::max(result.failed_stage, 0);
+    report.failed_stage = result.failed_stage;
+    report.failure_reason = result.reason;
+    report.ticks = result.ticks;
+    report.deadline_misses = result.deadline_misses;
+    report.max_jitter_ms = result.max_jitter_ms;
+    report.telemetry_dropped = result.telemetry_dropped;
+    return report;
+}
+
+void DeploymentExecutor::controlLoop(const nlohmann::json& params,
+                                     const std::vector<DeploymentStage>& stages,
+                                     ControlResult& result) {
+    using clock = std::chrono::steady_clock;
+
+    const double dt = 1.0 / config_.control_rate_hz;
+    const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
+    const double param_velocity = params.contains("max_velocity") && params["max_velocity"].is_number()
+        ? params["max_velocity"].get<double>()
+        : -1.0;
+
+    double time = 0.0;
+    double setpoint = 0.0;
+    int last_good = -1;
+    auto deadline = clock::now();
+
+    auto fail = [&](Outcome outcome, int stage, const std::string& reason) {
+        result.outcome = outcome;
+        result.failed_stage = stage;
+        result.reason = reason;
+        rollback(params, stages, std::min(last_good, max_good_stage_.load()));
+    };
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const auto& stage = stages[i];
+        const int stage_index = static_cast<int>(i);
+
+        if (!plant_->applyParameters(params, stage)) {
+            fail(Outcome::Rejected, stage_index, "Plant rejected parameters for stage " + std::to_string(i + 1));
+            return;
+        }
+
+        double target = stage.max_velocity * config_.cruise_fraction;
+        if (param_velocity >= 0.0) {
+            target = std::min(target, param_velocity * config_.cruise_fraction);
+        }
+        const double max_step = stage.max_acceleration * config_.cruise_fraction * dt;
+        const auto stage_ticks = std::max<long long>(1, std::llround(stage.duration * config_.control_rate_hz));
+        int violating = 0;
+
+        for (long long tick = 0; tick < stage_ticks; ++tick) {
+            if (config_.real_time) {
+                auto now = clock::now();
+                if (now < deadline) {
+                    std::this_thread::sleep_until(deadline);
+                    now = clock::now();
+                }
+                double jitter_ms = std::chrono::duration<double, std::milli>(now - deadline).count();
+                result.max_jitter_ms = std::max(result.max_jitter_ms, jitter_ms);
+                if (now - deadline > period) {
+                    // Missed a whole period: re-anchor instead of bursting to catch up
+                    ++result.deadline_misses;
+                    deadline = now;
+                }
+                deadline += period;
+            }
+
+            if (abort_requested_.load()) {
+                fail(Outcome::Aborted, stage_index, "Deployment aborted");
+                return;
+            }
+
+            setpoint += std::clamp(target - setpoint, -max_step, max_step);
+            plant_->commandVelocity(setpoint);
+            PlantState state = plant_->sample(dt);
+            time += dt;
+            ++result.ticks;
+
+            TelemetrySample sample;
+            sample.time = time;
+            sample.stage = stage_index;
+            sample.setpoint = setpoint;
+            sample.velocity = state.velocity;
+            sample.acceleration = state.acceleration;
+            sample.effort = state.effort;
+
+            if (!telemetry_.push(sample)) {
+                if (config_.real_time) {
+                    ++result.telemetry_dropped;
+                } else {
+                    // Simulated time has no deadline, so wait for the monitor rather than drop
+                    while (!telemetry_.push(sample) && !abort_requested_.load()) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            std::string violation = checkLimits(sample, stage, config_.limit_tolerance);
+            if (violation.empty()) {
+                violating = 0;
+            } else if (++violating >= config_.violation_ticks) {
+                fail(Outcome::Violation, stage_index, violation);
+                return;
+            }
+        }
+
+        last_good = stage_index;
+        completed_stages_.store(stage_index + 1);
+    }
+
+    plant_->commandVelocity(0.0);
+}
+
+void DeploymentExecutor::rollback(const nlohmann::json& params,
+                                  const std::vector<DeploymentStage>& stages,
+                                  int last_good_stage) {
+    plant_->commandVelocity(0.0);
+    if (last_good_stage >= 0 && last_good_stage < static_cast<int>(stages.size()) &&
+        plant_->applyParameters(params, stages[last_good_stage])) {
+        return;
+    }
+    plant_->emergencyStop();
+}
+
+std::string DeploymentExecutor::checkLimits(const TelemetrySample& sample,
+                                            const DeploymentStage& stage,
+                                            double tolerance) {
+    // Hot path: no formatting unless a limit is actually exceeded
+    if (std::abs(sample.velocity) > stage.max_velocity * (1.0 + tolerance)) {
+        std::stringstream ss;
+        ss << "velocity (" << sample.velocity << ") exceeds stage limit (" << stage.max_velocity << ")";
+        return ss.str();
+    }
+    if (std::abs(sample.acceleration) > stage.max_acceleration * (1.0 + tolerance)) {
+        std::stringstream ss;
+        ss << "acceleration (" << sample.acceleration << ") exceeds stage limit ("
+           << stage.max_acceleration << ")";
+        return ss.str();
+    }
+    return {};
+}
+
+} // namespace roboclaw::simulation
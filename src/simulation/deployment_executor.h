@@ -0,0 +1,252 @@
+// src/simulation/deployment_executor.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace roboclaw::simulation {
+
+/**
+ * @brief Deployment stage for progressive rollout
+ */
+struct DeploymentStage {
+    int power_percentage;      // Power limit (0-100)
+    double max_velocity;       // Velocity limit
+    double max_acceleration;   // Acceleration limit
+    double duration;           // Stage duration in seconds
+    std::string description;
+};
+
+/**
+ * @brief Snapshot of the plant state, sampled once per control tick
+ */
+struct TelemetrySample {
+    double time = 0.0;          // Seconds since deployment start
+    int stage = 0;              // Index of the active stage
+    double setpoint = 0.0;      // Commanded velocity
+    double velocity = 0.0;      // Measured velocity
+    double acceleration = 0.0;  // Measured acceleration
+    double effort = 0.0;        // Measured effort (current, torque, ...)
+};
+
+/**
+ * @brief Measured plant state returned by IDeploymentPlant::sample()
+ */
+struct PlantState {
+    double position = 0.0;
+    double velocity = 0.0;
+    double acceleration = 0.0;
+    double effort = 0.0;
+};
+
+/**
+ * @brief Target of a progressive deployment
+ *
+ * Implemented by hardware adapters and by SimulatedPlant. All methods are
+ * called from the control thread only.
+ */
+class IDeploymentPlant {
+public:
+    virtual ~IDeploymentPlant() = default;
+
+    /**
+     * @brief Push parameters with the stage's power limit applied
+     * @return false if the plant rejected the parameters
+     */
+    virtual bool applyParameters(const nlohmann::json& params, const DeploymentStage& stage) = 0;
+
+    /**
+     * @brief Command a velocity setpoint
+     */
+    virtual void commandVelocity(double velocity) = 0;
+
+    /**
+     * @brief Advance by dt seconds and read the measured state
+     *
+     * Hardware plants ignore dt and read their sensors; simulated plants
+     * integrate their dynamics.
+     */
+    virtual PlantState sample(double dt) = 0;
+
+    /**
+     * @brief Cut power immediately
+     */
+    virtual void emergencyStop() = 0;
+};
+
+/**
+ * @brief First-order velocity plant for dry runs and tests
+ *
+ * Velocity follows the setpoint with time constant tau; actuator authority
+ * is scaled by the stage power limit. An external disturbance acceleration can be injected
+ * to exercise the limit monitor.
+ */
+class SimulatedPlant : public IDeploymentPlant {
+public:
+    explicit SimulatedPlant(double time_constant = 0.05);
+
+    bool applyParameters(const nlohmann::json& params, const DeploymentStage& stage) override;
+    void commandVelocity(double velocity) override;
+    PlantState sample(double dt) override;
+    void emergencyStop() override;
+
+    /**
+     * @brief Inject a constant disturbance acceleration (thread-safe)
+     */
+    void setDisturbance(double acceleration);
+
+    /**
+     * @brief Whether emergencyStop() has been called
+     */
+    bool isStopped() const { return stopped_.load(); }
+
+    /**
+     * @brief Parameters of the last applyParameters() call
+     */
+    nlohmann::json getAppliedParameters() const;
+
+private:
+    double tau_;
+    double max_acceleration_;  // Power-limited actuator authority
+    double setpoint_;
+    PlantState state_;
+    std::atomic<double> disturbance_;
+    std::atomic<bool> stopped_;
+    mutable std::mutex params_mutex_;
+    nlohmann::json applied_params_;
+};
+
+/**
+ * @brief Single-producer/single-consumer telemetry ring
+ *
+ * The control thread pushes without locking or allocating; the monitor
+ * drains from another thread. push() fails instead of blocking when the
+ * ring is full, so a real-time loop never waits on a slow reader.
+ */
+class TelemetryRing {
+public:
+    static constexpr size_t CAPACITY = 4096;  // Must be a power of two
+
+    bool push(const TelemetrySample& sample);
+    bool pop(TelemetrySample& sample);
+
+private:
+    std::array<TelemetrySample, CAPACITY> buffer_;
+    alignas(64) std::atomic<size_t> head_{0};  // Written by producer
+    alignas(64) std::atomic<size_t> tail_{0};  // Written by consumer
+};
+
+/**
+ * @brief Executor configuration
+ */
+struct DeploymentExecutorConfig {
+    double control_rate_hz = 1000.0;   // Fixed control/monitor loop rate
+    double cruise_fraction = 0.8;      // Fraction of the stage velocity limit to drive at
+    double limit_tolerance = 0.05;     // Relative margin before a sample counts as a violation
+    int violation_ticks = 3;           // Consecutive violating ticks before rollback
+    bool real_time = true;             // false: run on simulated time without sleeping
+};
+
+/**
+ * @brief Outcome of a progressive deployment
+ */
+struct DeploymentReport {
+    bool success = false;
+    bool rolled_back = false;
+    int completed_stages = 0;
+    int failed_stage = -1;             // -1 if no stage failed
+    std::string failure_reason;
+    size_t ticks = 0;
+    size_t deadline_misses = 0;        // Ticks that started after their deadline
+    double max_jitter_ms = 0.0;
+    double max_velocity = 0.0;         // Peak |velocity| seen by the monitor
+    double max_acceleration = 0.0;     // Peak |acceleration| seen by the monitor
+    size_t telemetry_dropped = 0;      // Samples the monitor could not keep up with
+};
+
+/**
+ * @brief Fixed-rate closed-loop executor for DeploymentStage sequences
+ *
+ * A dedicated control thread ticks at control_rate_hz against absolute
+ * deadlines, ramps the velocity setpoint within the stage acceleration
+ * limit, and checks every measured sample against the stage limits. On a
+ * sustained violation (or an abort from the progress callback) it rolls
+ * back to the last stage that completed cleanly, or stops the plant if
+ * none did. Telemetry is published through a TelemetryRing and consumed
+ * on the calling thread, which also invokes the progress callback.
+ */
+class DeploymentExecutor {
+public:
+    using ProgressCallback = std::function<bool(int stage, const std::string&)>;
+    using TelemetryCallback = std::function<void(const TelemetrySample&)>;
+
+    DeploymentExecutor(std::shared_ptr<IDeploymentPlant> plant,
+                       const DeploymentExecutorConfig& config = DeploymentExecutorConfig());
+
+    // Disable copy
+    DeploymentExecutor(const DeploymentExecutor&) = delete;
+    DeploymentExecutor& operator=(const DeploymentExecutor&) = delete;
+
+    /**
+     * @brief Run all stages; blocks until done or rolled back
+     * @param params Parameters to deploy
+     * @param stages Deployment stages
+     * @param progress_callback Called once per completed stage; return false to abort
+     * @return Deployment report
+     */
+    DeploymentReport run(const nlohmann::json& params,
+                         const std::vector<DeploymentStage>& stages,
+                         ProgressCallback progress_callback = nullptr);
+
+    /**
+     * @brief Receive every drained telemetry sample on the calling thread
+     */
+    void setTelemetryCallback(TelemetryCallback callback);
+
+    /**
+     * @brief Request an abort from any thread; the control loop rolls back on its next tick
+     */
+    void abort();
+
+private:
+    enum class Outcome { Completed, Violation, Aborted, Rejected };
+
+    struct ControlResult {
+        Outcome outcome = Outcome::Completed;
+        int failed_stage = -1;
+        std::string reason;
+        size_t ticks = 0;
+        size_t deadline_misses = 0;
+        double max_jitter_ms = 0.0;
+        size_t telemetry_dropped = 0;
+    };
+
+    void controlLoop(const nlohmann::json& params,
+                     const std::vector<DeploymentStage>& stages,
+                     ControlResult& result);
+    void rollback(const nlohmann::json& params,
+                  const std::vector<DeploymentStage>& stages,
+                  int last_good_stage);
+    static std::string checkLimits(const TelemetrySample& sample,
+                                   const DeploymentStage& stage,
+                                   double tolerance);
+
+    std::shared_ptr<IDeploymentPlant> plant_;
+    DeploymentExecutorConfig config_;
+    TelemetryRing telemetry_;
+    TelemetryCallback telemetry_callback_;
+    std::atomic<bool> abort_requested_;
+    std::atomic<int> max_good_stage_;   // Upper bound on the rollback target
+    std::atomic<int> completed_stages_;
+    std::atomic<bool> control_done_;
+};
+
+} // namespace roboclaw::simulation
@@ -3,8 +3,6 @@
 #include <algorithm>
 #include <cmath>
 #include <sstream>
-#include <thread>
-#include <chrono>
 
 namespace roboclaw::simulation {
 
@@ -161,33 +159,26 @@ std::string Sim2RealTransfer::generateSafetyWarning(const std::string& param_nam
 // Progressive Deployment
 //=============================================================================
 
+void Sim2RealTransfer::setDeploymentPlant(std::shared_ptr<IDeploymentPlant> plant,
+                                          const DeploymentExecutorConfig& config) {
+    plant_ = std::move(plant);
+    executor_config_ = config;
+}
+
 bool Sim2RealTransfer::progressiveDeployment(const nlohmann::json& params,
                                               const std::vector<DeploymentStage>& stages,
                                               std::function<bool(int, const std::string&)> progress_callback) {
-    for (size_t i = 0; i < stages.size(); ++i) {
-        const auto& stage = stages[i];
-
-        // TODO: Implement actual deployment to hardware
-        // This would involve:
-        // - Sending parameters to hardware with power limits
-        // - Monitoring for errors
-        // - Collecting telemetry
-        // - Verifying expected behavior
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Simulate operation
-
-        // Call progress callback
-        if (progress_callback) {
-            std::string message = "Stage " + std::to_string(i + 1) + "/" + std::to_string(stages.size()) +
-                                 ": " + stage.description;
-            if (!progress_callback(static_cast<int>(i), message)) {
-                // Callback requested abort
-                return false;
-            }
-        }
+    std::shared_ptr<IDeploymentPlant> plant = plant_;
+    DeploymentExecutorConfig config = executor_config_;
+    if (!plant) {
+        // Dry run: validate the stage plan against the simulated plant
+        plant = std::make_shared<SimulatedPlant>();
+        config.real_time = false;
     }
 
-    return true;
+    DeploymentExecutor executor(plant, config);
+    last_report_ = executor.run(params, stages, std::move(progress_callback));
+    return last_report_.success;
 }
 
 //=============================================================================
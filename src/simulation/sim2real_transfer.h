@@ -1,10 +1,14 @@
 // src/simulation/sim2real_transfer.h
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
 
+#include "deployment_executor.h"
+
 namespace roboclaw::simulation {
 
 /**
@@ -28,17 +32,6 @@ struct SafetyCheckResult {
     nlohmann::json adjusted_params;  // Parameters adjusted for safety
 };
 
-/**
- * @brief Deployment stage for progressive rollout
- */
-struct DeploymentStage {
-    int power_percentage;      // Power limit (0-100)
-    double max_velocity;       // Velocity limit
-    double max_acceleration;   // Acceleration limit
-    double duration;           // Stage duration in seconds
-    std::string description;
-};
-
 /**
  * @brief Sim-to-Real Transfer Handler
  *
@@ -71,8 +64,20 @@ public:
      */
     SafetyCheckResult verifySafeDeployment(const nlohmann::json& hardware_params);
 
+    /**
+     * @brief Attach the plant used for progressive deployment
+     * @param plant Hardware adapter (or SimulatedPlant); nullptr restores dry-run mode
+     * @param config Control loop configuration
+     */
+    void setDeploymentPlant(std::shared_ptr<IDeploymentPlant> plant,
+                            const DeploymentExecutorConfig& config = DeploymentExecutorConfig());
+
     /**
      * @brief Progressive deployment with staged rollout
+     *
+     * Runs a DeploymentExecutor against the attached plant. Without a plant
+     * the stages are dry-run on a SimulatedPlant in simulated time.
+     *
      * @param params Parameters to deploy
      * @param stages Deployment stages
      * @param progress_callback Optional callback for progress updates
@@ -94,6 +99,11 @@ public:
      */
     std::vector<DeploymentStage> getDefaultDeploymentStages() const;
 
+    /**
+     * @brief Report of the last progressiveDeployment() call
+     */
+    DeploymentReport getLastDeploymentReport() const { return last_report_; }
+
     /**
      * @brief Apply calibration to single parameter
      * @param value Parameter value from simulation
@@ -105,6 +115,10 @@ public:
                            const CalibrationMatrix& calibration);
 
 private:
+    std::shared_ptr<IDeploymentPlant> plant_;
+    DeploymentExecutorConfig executor_config_;
+    DeploymentReport last_report_;
+
     /**
      * @brief Check if PID parameters are within safe range
      */
@@ -1,22 +1,109 @@
 // SkillDownloader实现 - Improved error handling
 
 #include "skill_downloader.h"
+#include "../utils/atomic_file.h"
 #include "../utils/logger.h"
 #include "../utils/code_quality_constants.h"
+#include "../utils/mapped_file.h"
+#include "../utils/sha256.h"
+#include "../utils/thread_pool.h"
 #include <fstream>
 #include <filesystem>
 #include <sstream>
 #include <regex>
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <system_error>
 
 namespace roboclaw {
 
+namespace {
+
+// 拆分URL和#sha256=片段
+void splitUrl(const std::string& url, std::string& requestUrl, std::string& sha256) {
+    size_t hash = url.find('#');
+    requestUrl = url.substr(0, hash);
+    sha256.clear();
+    if (hash != std::string::npos && url.compare(hash + 1, 7, "sha256=") == 0) {
+        sha256 = url.substr(hash + 8);
+    }
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+// 响应头查找（不区分大小写）
+std::string headerValue(const std::map<std::string, std::string>& headers, const std::string& name) {
+    for (const auto& pair : headers) {
+        if (pair.first.size() == name.size() && toLower(pair.first) == toLower(name)) {
+            return pair.second;
+        }
+    }
+    return "";
+}
+
+// 把src的内容追加到dest并落盘
+bool appendFile(const std::string& src, const std::string& dest) {
+    {
+        std::ifstream in(src, std::ios::binary);
+        std::ofstream out(dest, std::ios::binary | std::ios::app);
+        if (!in.is_open() || !out.is_open()) {
+            return false;
+        }
+        if (in.peek() != std::char_traits<char>::eof()) {
+            out << in.rdbuf();
+        }
+        out.flush();
+        if (!out) {
+            return false;
+        }
+    }
+    return syncFile(dest);
+}
+
+void removeFile(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+// 重命名（目标存在时替换），失败时error为原因
+bool renameFile(const std::string& from, const std::string& to, std::string& error) {
+    std::error_code ec;
+    std::filesystem::rename(from, to, ec);
+    if (ec) {
+        error = ec.message();
+        return false;
+    }
+    return true;
+}
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 目标文件名：URL最后一段（去掉查询串和片段）
+std::string fileNameFromUrl(const std::string& url) {
+    std::string path = url.substr(0, url.find_first_of("?#"));
+    size_t lastSlash = path.find_last_of('/');
+    return lastSlash == std::string::npos ? path : path.substr(lastSlash + 1);
+}
+
+} // namespace
+
 SkillDownloader::SkillDownloader(const std::string& cacheDir)
     : cache_dir_(cacheDir)
     , http_client_(std::make_shared<HttpClient>()) {
 
+    setTransport(nullptr);
+
     // 创建缓存目录
     try {
         std::filesystem::create_directories(cache_dir_);
@@ -43,6 +130,18 @@ void SkillDownloader::setCacheDir(const std::string& dir) {
     }
 }
 
+void SkillDownloader::setTransport(DownloadTransport transport) {
+    if (transport) {
+        transport_ = std::move(transport);
+        return;
+    }
+    transport_ = [client = http_client_](const std::string& url,
+                                         const std::map<std::string, std::string>& headers,
+                                         const DataCallback& onData) {
+        return client->getStream(url, headers, onData);
+    };
+}
+
 void SkillDownloader::addRepository(const SkillRepository& repo) {
     repositories_.push_back(repo);
     LOG_INFO("添加技能仓库: " + repo.name + " (" + repo.url + ")");
@@ -53,54 +152,258 @@ std::vector<SkillRepository> SkillDownloader::getRepositories() const {
 }
 
 bool SkillDownloader::downloadSkill(const std::string& url,
-                                     const std::string& destPath) {
-    // 检查缓存
-    std::string cacheKey = generateCacheKey(url);
-    std::string content;
-
-    if (isCacheValid(cacheKey)) {
-        if (loadFromCache(cacheKey, content)) {
-            LOG_INFO("从缓存加载: " + url);
+                                     const std::string& destPath,
+                                     const std::string& expectedSha256) {
+    std::string requestUrl;
+    std::string fragmentSha256;
+    splitUrl(url, requestUrl, fragmentSha256);
+    std::string expected = toLower(expectedSha256.empty() ? fragmentSha256 : expectedSha256);
+
+    std::string cacheKey = generateCacheKey(requestUrl);
+    auto keyLock = lockFor(cacheKey);
+    std::lock_guard<std::mutex> guard(*keyLock);
+
+    // 检查缓存：内容必须与记录的摘要（以及期望的摘要）一致
+    CacheEntry entry;
+    bool haveCache = false;
+    std::string cacheFile = cachePath(cacheKey, ".cache");
+    if (loadCacheEntry(cacheKey, entry) && !entry.sha256.empty() &&
+        std::filesystem::exists(cacheFile)) {
+        if (Sha256::hashFile(cacheFile) == entry.sha256 &&
+            (expected.empty() || expected == entry.sha256)) {
+            haveCache = true;
         } else {
-            LOG_WARNING("缓存加载失败，重新下载");
+            LOG_WARNING("缓存校验失败，重新下载: " + requestUrl);
         }
     }
+    if (!haveCache) {
+        entry.etag.clear();
+        entry.last_modified.clear();
+        entry.sha256.clear();
+    }
+    entry.url = requestUrl;
 
-    // 如果缓存无效，下载
-    if (content.empty()) {
+    if (haveCache && !auto_update_ && isCacheValid(entry, cache_ttl_hours_)) {
+        LOG_INFO("从缓存加载: " + requestUrl);
+    } else {
         std::string error;
-        if (!httpGet(url, content, error)) {
-            LOG_ERROR("下载失败: " + url + " - " + error);
+        if (!fetchToCache(requestUrl, cacheKey, expected, entry, haveCache, error)) {
+            if (!haveCache) {
+                LOG_ERROR("下载失败: " + requestUrl + " - " + error);
+                return false;
+            }
+            LOG_WARNING("更新失败，使用缓存: " + requestUrl + " - " + error);
+        }
+    }
+
+    if (!installFile(cacheFile, destPath)) {
+        return false;
+    }
+
+    LOG_INFO("技能已下载: " + destPath);
+    return true;
+}
+
+bool SkillDownloader::fetchToCache(const std::string& url,
+                                    const std::string& cacheKey,
+                                    const std::string& expectedSha256,
+                                    CacheEntry& entry,
+                                    bool haveCache,
+                                    std::string& error) {
+    std::string partPath = cachePath(cacheKey, ".part");
+    std::string tailPath = cachePath(cacheKey, ".tail");
+    std::string cacheFile = cachePath(cacheKey, ".cache");
+
+    auto discardPart = [&]() {
+        removeFile(partPath);
+        entry.part_etag.clear();
+        entry.part_last_modified.clear();
+    };
+
+    // 第二次尝试只在续传被服务器拒绝时发生
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::map<std::string, std::string> headers;
+
+        // 有验证器的未完成下载：续传，If-Range保证内容未变（变了服务器返回完整的200）
+        std::error_code ec;
+        uintmax_t resumeFrom = 0;
+        bool hasValidator = !entry.part_etag.empty() || !entry.part_last_modified.empty();
+        if (hasValidator) {
+            resumeFrom = std::filesystem::file_size(partPath, ec);
+            if (ec) {
+                resumeFrom = 0;
+            }
+        }
+        bool resuming = resumeFrom > 0;
+        if (resuming) {
+            headers["Range"] = "bytes=" + std::to_string(resumeFrom) + "-";
+            headers["If-Range"] = !entry.part_etag.empty() ? entry.part_etag : entry.part_last_modified;
+        } else if (haveCache) {
+            // 条件请求：内容未变时服务器返回304
+            if (!entry.etag.empty()) {
+                headers["If-None-Match"] = entry.etag;
+            }
+            if (!entry.last_modified.empty()) {
+                headers["If-Modified-Since"] = entry.last_modified;
+            }
+        }
+
+        // 续传时新数据先写到.tail，收到状态码后再决定追加还是替换
+        std::string receivePath = resuming ? tailPath : partPath;
+        std::ofstream out(receivePath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            error = "无法创建文件: " + receivePath + " - " + std::strerror(errno);
+            return false;
+        }
+
+        Sha256 hasher;
+        uintmax_t received = 0;
+        bool writeFailed = false;
+        HttpResponse response;
+        try {
+            response = transport_(url, headers, [&](std::string_view chunk) {
+                out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                if (!out) {
+                    writeFailed = true;
+                    return false;
+                }
+                hasher.update(chunk);
+                received += chunk.size();
+                return true;
+            });
+        } catch (const std::exception& e) {
+            response = HttpResponse::error(std::string("HTTP请求异常: ") + e.what());
+        }
+
+        int status = response.status_code;
+        out.close();
+        writeFailed = writeFailed || out.fail();
+        bool complete = !writeFailed && (status == 200 || (resuming && status == 206));
+        bool synced = complete && syncFile(receivePath);
+
+        if (writeFailed || (complete && !synced)) {
+            removeFile(receivePath);
+            if (!resuming) {
+                discardPart();
+            }
+            error = "写入文件失败: " + receivePath + " - " + std::strerror(errno);
             return false;
         }
 
-        // 保存到缓存
-        saveToCache(cacheKey, content);
+        // 304：缓存仍然有效
+        if (status == 304 && haveCache && !resuming) {
+            removeFile(receivePath);
+            std::string etag = headerValue(response.headers, "ETag");
+            if (!etag.empty()) {
+                entry.etag = etag;
+            }
+            entry.checked_at = nowSeconds();
+            saveCacheEntry(cacheKey, entry);
+            LOG_INFO("技能未变化: " + url);
+            return true;
+        }
+
+        // 续传范围不被接受：丢弃未完成的下载，从头再来
+        if (resuming && status == 416) {
+            removeFile(tailPath);
+            discardPart();
+            continue;
+        }
+
+        if (!complete) {
+            if (resuming) {
+                // 本次收到的数据状态未知，丢弃；.part仍可用于下次续传
+                removeFile(tailPath);
+            } else {
+                // 连接中断且响应带验证器时保留.part以便续传
+                std::string etag = headerValue(response.headers, "ETag");
+                std::string lastModified = headerValue(response.headers, "Last-Modified");
+                if (status == 0 && received > 0 && (!etag.empty() || !lastModified.empty())) {
+                    entry.part_etag = etag;
+                    entry.part_last_modified = lastModified;
+                } else {
+                    discardPart();
+                }
+            }
+            saveCacheEntry(cacheKey, entry);
+            error = !response.error_message.empty() ? response.error_message
+                                                    : "HTTP状态码 " + std::to_string(status);
+            return false;
+        }
+
+        std::string digest;
+        if (resuming && status == 206) {
+            // Content-Range必须从续传位置开始
+            std::string range = headerValue(response.headers, "Content-Range");
+            std::string expectedPrefix = "bytes " + std::to_string(resumeFrom) + "-";
+            bool ok = range.rfind(expectedPrefix, 0) == 0 && appendFile(tailPath, partPath);
+            removeFile(tailPath);
+            if (!ok) {
+                discardPart();
+                continue;
+            }
+            digest = Sha256::hashFile(partPath);
+            LOG_INFO("续传完成: " + url + " (从 " + std::to_string(resumeFrom) + " 字节)");
+        } else {
+            std::string renameError;
+            if (resuming && !renameFile(tailPath, partPath, renameError)) {
+                removeFile(tailPath);
+                discardPart();
+                error = "重命名失败: " + partPath + " - " + renameError;
+                return false;
+            }
+            digest = hasher.hexdigest();
+        }
+
+        // 完整性校验
+        if (digest.empty() || (!expectedSha256.empty() && digest != expectedSha256)) {
+            discardPart();
+            saveCacheEntry(cacheKey, entry);
+            error = "SHA-256不匹配: 期望 " + expectedSha256 + "，实际 " + digest;
+            return false;
+        }
+
+        std::string renameError;
+        if (!renameFile(partPath, cacheFile, renameError)) {
+            discardPart();
+            error = "重命名失败: " + cacheFile + " - " + renameError;
+            return false;
+        }
+        syncDirectory(cache_dir_);
+
+        entry.etag = headerValue(response.headers, "ETag");
+        entry.last_modified = headerValue(response.headers, "Last-Modified");
+        entry.sha256 = digest;
+        entry.checked_at = nowSeconds();
+        entry.part_etag.clear();
+        entry.part_last_modified.clear();
+        saveCacheEntry(cacheKey, entry);
+        return true;
     }
 
-    // 写入目标文件
+    error = "续传失败";
+    return false;
+}
+
+bool SkillDownloader::installFile(const std::string& sourcePath, const std::string& destPath) {
     try {
         // 确保目标目录存在
         std::filesystem::path dest(destPath);
-        std::filesystem::create_directories(dest.parent_path());
+        if (!dest.parent_path().empty()) {
+            std::filesystem::create_directories(dest.parent_path());
+        }
 
-        std::ofstream file(destPath);
-        if (!file.is_open()) {
-            LOG_ERROR("无法创建文件: " + destPath);
+        // 写入同目录的临时文件，fsync后原子替换并同步目录
+        MappedFile source;
+        std::string error;
+        if (!source.open(sourcePath, error) || !writeFileAtomic(destPath, source.view(), error)) {
+            LOG_ERROR("无法写入文件: " + destPath + " - " + error);
             return false;
         }
-
-        file << content;
-        file.close();
-
-        LOG_INFO("技能已下载: " + destPath);
         return true;
 
-    } catch (const std::ofstream::failure& e) {
-        LOG_ERROR("写入文件失败: " + std::string(e.what()));
-        return false;
     } catch (const std::filesystem::filesystem_error& e) {
-        LOG_ERROR("创建目录失败: " + std::string(e.what()));
+        LOG_ERROR("写入文件失败: " + std::string(e.what()));
         return false;
     } catch (const std::exception& e) {
         LOG_ERROR("写入文件失败: " + std::string(e.what()));
@@ -108,6 +411,20 @@ bool SkillDownloader::downloadSkill(const std::string& url,
     }
 }
 
+std::shared_ptr<std::mutex> SkillDownloader::lockFor(const std::string& cacheKey) {
+    std::lock_guard<std::mutex> lock(locks_mutex_);
+    auto& slot = key_locks_[cacheKey];
+    auto mutex = slot.lock();
+    if (!mutex) {
+        mutex = std::make_shared<std::mutex>();
+        slot = mutex;
+    }
+    if (key_locks_.size() > 1024) {
+        std::erase_if(key_locks_, [](const auto& pair) { return pair.second.expired(); });
+    }
+    return mutex;
+}
+
 bool SkillDownloader::downloadFromGitHub(const std::string& repo,
                                           const std::string& skillFile,
                                           const std::string& destPath) {
@@ -146,35 +463,61 @@ std::vector<std::string> SkillDownloader::searchSkills(const std::string& keywor
 int SkillDownloader::downloadSkills(const std::vector<std::string>& urls,
                                      const std::string& destDir,
                                      DownloadProgressCallback callback) {
-    int downloaded = 0;
-    int total = static_cast<int>(urls.size());
-
-    for (int i = 0; i < total; ++i) {
-        const std::string& url = urls[i];
+    std::vector<SkillDownloadRequest> requests;
+    requests.reserve(urls.size());
+    for (const auto& url : urls) {
+        requests.push_back({url, destDir + "/" + fileNameFromUrl(url), ""});
+    }
+    return downloadSkills(requests, callback);
+}
 
-        // 从URL提取文件名
-        std::string filename = url;
-        size_t lastSlash = url.find_last_of('/');
-        if (lastSlash != std::string::npos) {
-            filename = url.substr(lastSlash + 1);
-        }
+int SkillDownloader::downloadSkills(const std::vector<SkillDownloadRequest>& requests,
+                                     DownloadProgressCallback callback) {
+    int total = static_cast<int>(requests.size());
+    if (total == 0) {
+        return 0;
+    }
 
-        std::string destPath = destDir + "/" + filename;
+    std::atomic<size_t> next{0};
+    std::atomic<int> downloaded{0};
+    std::mutex callbackMutex;
+    int completed = 0;
+
+    // 每个工作线程循环领取下一个请求
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < requests.size(); i = next.fetch_add(1)) {
+            const auto& request = requests[i];
+            if (downloadSkill(request.url, request.dest_path, request.sha256)) {
+                downloaded++;
+            }
 
-        if (downloadSkill(url, destPath)) {
-            downloaded++;
+            // 回调进度
+            if (callback) {
+                std::lock_guard<std::mutex> lock(callbackMutex);
+                callback(std::filesystem::path(request.dest_path).filename().string(), ++completed, total);
+            }
         }
-
-        // 回调进度
-        if (callback) {
-            callback(filename, i + 1, total);
+    };
+
+    size_t workers = std::min(max_parallel_, requests.size());
+    if (workers <= 1) {
+        worker();
+    } else {
+        ThreadPool pool(workers);
+        std::vector<std::future<void>> futures;
+        futures.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            futures.push_back(pool.submitWithResult(worker));
+        }
+        for (auto& future : futures) {
+            future.get();
         }
     }
 
-    LOG_INFO("批量下载完成: " + std::to_string(downloaded) + "/" +
+    LOG_INFO("批量下载完成: " + std::to_string(downloaded.load()) + "/" +
              std::to_string(total));
 
-    return downloaded;
+    return downloaded.load();
 }
 
 void SkillDownloader::clearCache() {
@@ -242,110 +585,57 @@ bool SkillDownloader::parseGitHubUrl(const std::string& url,
 }
 
 std::string SkillDownloader::generateCacheKey(const std::string& url) const {
-    // 简单哈希：使用URL的文件名部分
-    std::string filename = url;
-    size_t lastSlash = url.find_last_of('/');
-    if (lastSlash != std::string::npos) {
-        filename = url.substr(lastSlash + 1);
-    }
-
-    // 添加扩展名.cache
-    return filename + ".cache";
+    // URL摘要的前32位十六进制，避免同名文件互相覆盖
+    return Sha256::hash(url).substr(0, 32);
 }
 
-bool SkillDownloader::isCacheValid(const std::string& cacheKey,
-                                    int maxAgeHours) const {
-    std::string cachePath = cache_dir_ + "/" + cacheKey;
-
-    if (!std::filesystem::exists(cachePath)) {
-        return false;
-    }
-
-    try {
-        auto ftime = std::filesystem::last_write_time(cachePath);
-        auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-            ftime - std::filesystem::file_time_type::clock::now()
-                     + std::chrono::system_clock::now());
-        auto age = std::chrono::system_clock::now() - sctp;
-        auto ageHours = std::chrono::duration_cast<std::chrono::hours>(age).count();
-
-        return ageHours < maxAgeHours;
-
-    } catch (const std::filesystem::filesystem_error& e) {
-        LOG_ERROR("检查缓存有效性失败: " + std::string(e.what()));
-        return false;
-    } catch (const std::exception& e) {
-        LOG_ERROR("检查缓存有效性失败: " + std::string(e.what()));
-        return false;
-    }
+bool SkillDownloader::isCacheValid(const CacheEntry& entry, int maxAgeHours) const {
+    return nowSeconds() - entry.checked_at < static_cast<int64_t>(maxAgeHours) * 3600;
 }
 
-bool SkillDownloader::loadFromCache(const std::string& cacheKey,
-                                     std::string& content) const {
-    std::string cachePath = cache_dir_ + "/" + cacheKey;
-
+bool SkillDownloader::loadCacheEntry(const std::string& cacheKey, CacheEntry& entry) const {
     try {
-        std::ifstream file(cachePath);
+        std::ifstream file(cachePath(cacheKey, ".json"));
         if (!file.is_open()) {
             return false;
         }
 
-        std::string str((std::istreambuf_iterator<char>(file)),
-                        std::istreambuf_iterator<char>());
-        file.close();
-
-        content = str;
+        json j = json::parse(file);
+        entry.url = j.value("url", "");
+        entry.etag = j.value("etag", "");
+        entry.last_modified = j.value("last_modified", "");
+        entry.sha256 = j.value("sha256", "");
+        entry.checked_at = j.value("checked_at", static_cast<int64_t>(0));
+        entry.part_etag = j.value("part_etag", "");
+        entry.part_last_modified = j.value("part_last_modified", "");
         return true;
 
-    } catch (const std::ifstream::failure& e) {
-        LOG_ERROR("从缓存加载失败: " + std::string(e.what()));
-        return false;
     } catch (const std::exception& e) {
-        LOG_ERROR("从缓存加载失败: " + std::string(e.what()));
+        LOG_WARNING("读取缓存元数据失败: " + cacheKey + " - " + std::string(e.what()));
         return false;
     }
 }
 
-void SkillDownloader::saveToCache(const std::string& cacheKey,
-                                   const std::string& content) {
-    std::string cachePath = cache_dir_ + "/" + cacheKey;
-
-    try {
-        std::ofstream file(cachePath);
-        if (!file.is_open()) {
-            LOG_WARNING("无法创建缓存文件: " + cachePath);
-            return;
-        }
-
-        file << content;
-        file.close();
-
-    } catch (const std::ofstream::failure& e) {
-        LOG_WARNING("保存缓存失败: " + std::string(e.what()));
-    } catch (const std::exception& e) {
-        LOG_WARNING("保存缓存失败: " + std::string(e.what()));
+bool SkillDownloader::saveCacheEntry(const std::string& cacheKey, const CacheEntry& entry) const {
+    json j;
+    j["url"] = entry.url;
+    j["etag"] = entry.etag;
+    j["last_modified"] = entry.last_modified;
+    j["sha256"] = entry.sha256;
+    j["checked_at"] = entry.checked_at;
+    if (!entry.part_etag.empty() || !entry.part_last_modified.empty()) {
+        j["part_etag"] = entry.part_etag;
+        j["part_last_modified"] = entry.part_last_modified;
     }
-}
 
-bool SkillDownloader::httpGet(const std::string& url,
-                               std::string& response,
-                               std::string& error) {
-    try {
-        // 使用HttpClient进行GET请求
-        HttpResponse httpResponse = http_client_->get(url);
-
-        if (httpResponse.success) {
-            response = httpResponse.body;
-            return true;
-        } else {
-            error = httpResponse.error_message;
-            return false;
-        }
-
-    } catch (const std::exception& e) {
-        error = std::string("HTTP请求异常: ") + e.what();
+    // 元数据丢失只会导致重新下载，rename即可，不需要fsync
+    std::string path = cachePath(cacheKey, ".json");
+    std::string error;
+    if (!writeFileAtomic(path, j.dump(), error, false)) {
+        LOG_WARNING("保存缓存失败: " + path + " - " + error);
         return false;
     }
+    return true;
 }
 
 } // namespace roboclaw
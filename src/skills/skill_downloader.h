@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace roboclaw {
 
@@ -18,12 +20,32 @@ struct SkillRepository {
     bool enabled;         // 是否启用
 };
 
+// 单个下载请求
+struct SkillDownloadRequest {
+    std::string url;
+    std::string dest_path;
+    std::string sha256;   // 期望的内容摘要（可选；也可在URL末尾写#sha256=<摘要>）
+};
+
 // 下载进度回调
 using DownloadProgressCallback = std::function<void(const std::string& skillName,
                                                      int current,
                                                      int total)>;
 
+// 下载传输：发出GET请求并把响应体交给onData
+// 默认使用HttpClient::getStream，可替换（如测试）
+using DownloadTransport = std::function<HttpResponse(const std::string& url,
+                                                      const std::map<std::string, std::string>& headers,
+                                                      const DataCallback& onData)>;
+
 // 技能下载器
+//
+// 下载内容先流式写入缓存目录中的<键>.part，校验摘要后fsync并原子rename为<键>.cache，
+// 再以同样方式安装到目标路径。缓存旁的<键>.json记录ETag/Last-Modified和SHA-256：
+// 缓存未过期时直接使用（auto_update时总是重新验证），过期后发送条件请求，304时沿用缓存。
+// 中断的下载保留.part和验证器，下次用Range + If-Range续传。
+//
+// downloadSkills以有限并发（默认8）同时下载；同一URL的下载互斥。线程安全。
 class SkillDownloader {
 public:
     SkillDownloader(const std::string& cacheDir = ".roboclaw/skills/cache");
@@ -32,15 +54,28 @@ public:
     // 设置缓存目录
     void setCacheDir(const std::string& dir);
 
+    // 设置最大并发下载数
+    void setMaxParallel(size_t count) { max_parallel_ = count > 0 ? count : 1; }
+
+    // 自动更新：每次使用缓存前都向服务器验证（条件请求）
+    void setAutoUpdate(bool enabled) { auto_update_ = enabled; }
+
+    // 缓存有效期（小时），过期后重新验证
+    void setCacheTtlHours(int hours) { cache_ttl_hours_ = hours; }
+
+    // 替换下载传输
+    void setTransport(DownloadTransport transport);
+
     // 添加仓库
     void addRepository(const SkillRepository& repo);
 
     // 获取所有仓库
     std::vector<SkillRepository> getRepositories() const;
 
-    // 从URL下载单个技能
+    // 从URL下载单个技能（expectedSha256为空时只校验URL片段中的摘要）
     bool downloadSkill(const std::string& url,
-                       const std::string& destPath);
+                       const std::string& destPath,
+                       const std::string& expectedSha256 = "");
 
     // 从GitHub下载技能
     bool downloadFromGitHub(const std::string& repo,
@@ -50,11 +85,15 @@ public:
     // 从仓库搜索技能
     std::vector<std::string> searchSkills(const std::string& keyword);
 
-    // 批量下载技能
+    // 批量下载技能（目标文件名取URL最后一段）
     int downloadSkills(const std::vector<std::string>& urls,
                        const std::string& destDir,
                        DownloadProgressCallback callback = nullptr);
 
+    // 批量下载技能（并发），返回成功数；回调按完成顺序串行调用
+    int downloadSkills(const std::vector<SkillDownloadRequest>& requests,
+                       DownloadProgressCallback callback = nullptr);
+
     // 清理缓存
     void clearCache();
 
@@ -62,35 +101,62 @@ public:
     size_t getCacheSize() const;
 
 private:
+    // 缓存条目元数据
+    struct CacheEntry {
+        std::string url;
+        std::string etag;
+        std::string last_modified;
+        std::string sha256;          // 缓存内容的摘要
+        int64_t checked_at = 0;      // 上次向服务器确认的时间（秒）
+        std::string part_etag;       // 未完成下载的验证器
+        std::string part_last_modified;
+    };
+
     // 解析GitHub URL
     bool parseGitHubUrl(const std::string& url,
                         std::string& owner,
                         std::string& repo,
                         std::string& path);
 
-    // 生成缓存键
+    // 生成缓存键（URL的摘要）
     std::string generateCacheKey(const std::string& url) const;
 
-    // 检查缓存是否有效
-    bool isCacheValid(const std::string& cacheKey,
-                      int maxAgeHours = 168) const; // 默认7天
+    // 检查缓存是否有效（未超过有效期）
+    bool isCacheValid(const CacheEntry& entry, int maxAgeHours) const;
+
+    // 读写缓存元数据
+    bool loadCacheEntry(const std::string& cacheKey, CacheEntry& entry) const;
+    bool saveCacheEntry(const std::string& cacheKey, const CacheEntry& entry) const;
 
-    // 从缓存加载
-    bool loadFromCache(const std::string& cacheKey,
-                       std::string& content) const;
+    // 下载到缓存（支持续传和条件请求），成功后entry更新为新内容
+    bool fetchToCache(const std::string& url,
+                      const std::string& cacheKey,
+                      const std::string& expectedSha256,
+                      CacheEntry& entry,
+                      bool haveCache,
+                      std::string& error);
 
-    // 保存到缓存
-    void saveToCache(const std::string& cacheKey,
-                     const std::string& content);
+    // 把缓存文件原子地安装到目标路径
+    bool installFile(const std::string& sourcePath, const std::string& destPath);
 
-    // 执行HTTP GET请求
-    bool httpGet(const std::string& url,
-                 std::string& response,
-                 std::string& error);
+    // 同一缓存键的下载互斥
+    std::shared_ptr<std::mutex> lockFor(const std::string& cacheKey);
+
+    std::string cachePath(const std::string& cacheKey, const char* suffix) const {
+        return cache_dir_ + "/" + cacheKey + suffix;
+    }
 
     std::string cache_dir_;
     std::vector<SkillRepository> repositories_;
     std::shared_ptr<HttpClient> http_client_;
+    DownloadTransport transport_;
+
+    size_t max_parallel_ = 8;
+    bool auto_update_ = false;
+    int cache_ttl_hours_ = 168;   // 默认7天
+
+    std::mutex locks_mutex_;
+    std::unordered_map<std::string, std::weak_ptr<std::mutex>> key_locks_;
 };
 
 } // namespace roboclaw
@@ -44,6 +44,14 @@ namespace {
             return defaultVal;
         }
     }
+
+    double parseDouble(const std::string& str, double defaultVal = 0.0) {
+        try {
+            return std::stod(str);
+        } catch (...) {
+            return defaultVal;
+        }
+    }
 }
 
 // ProviderInfo实现
@@ -127,6 +135,7 @@ void ConfigManager::initializeDefaults() {
     // 默认配置
     config_.default_config.provider = ProviderType::ANTHROPIC;
     config_.default_config.model = "claude-sonnet-4-20250514";
+    config_.default_config.temperature = -1.0;  // 使用提供商默认值
 
     // 行为设置
     config_.behavior.max_retries = 3;
@@ -153,11 +162,20 @@ void ConfigManager::initializeDefaults() {
     config_.optimization.max_tool_result_length = 5000;
     config_.optimization.show_token_stats = true;
     config_.optimization.stats_update_interval = 1;
+    config_.optimization.background_compression = true;
+    config_.optimization.tokenizer_vocab = "";
+    config_.optimization.tokenizer_merges = "";
 
     // 缓存设置
     config_.cache.skills_cache_dir = ".roboclaw/skills/cache";
     config_.cache.skill_cache_ttl = 168;
     config_.cache.prompt_cache_size = 100;
+    config_.cache.enable_response_cache = false;
+    config_.cache.response_cache_size = 256;
+    config_.cache.response_cache_ttl = 86400;
+    config_.cache.response_cache_dir = "";
+    config_.cache.response_cache_similarity = false;
+    config_.cache.response_cache_threshold = 0.92;
 
     // 初始化所有提供商
     for (int i = 0; i <= 5; ++i) {
@@ -248,6 +266,8 @@ bool ConfigManager::parseToml(const std::string& content) {
                     config_.default_config.provider = stringToProvider(value);
                 } else if (key == "model") {
                     config_.default_config.model = value;
+                } else if (key == "temperature") {
+                    config_.default_config.temperature = parseDouble(value, -1.0);
                 } else if (key == "language") {
                     config_.language = stringToLanguage(value);
                 }
@@ -292,6 +312,12 @@ bool ConfigManager::parseToml(const std::string& content) {
                     config_.optimization.show_token_stats = parseBool(value);
                 } else if (key == "stats_update_interval") {
                     config_.optimization.stats_update_interval = parseInt(value);
+                } else if (key == "background_compression") {
+                    config_.optimization.background_compression = parseBool(value);
+                } else if (key == "tokenizer_vocab") {
+                    config_.optimization.tokenizer_vocab = value;
+                } else if (key == "tokenizer_merges") {
+                    config_.optimization.tokenizer_merges = value;
                 }
             } else if (currentSection == "cache") {
                 if (key == "skills_cache_dir") {
@@ -300,6 +326,18 @@ bool ConfigManager::parseToml(const std::string& content) {
                     config_.cache.skill_cache_ttl = parseInt(value);
                 } else if (key == "prompt_cache_size") {
                     config_.cache.prompt_cache_size = parseInt(value);
+                } else if (key == "enable_response_cache") {
+                    config_.cache.enable_response_cache = parseBool(value);
+                } else if (key == "response_cache_size") {
+                    config_.cache.response_cache_size = parseInt(value, 256);
+                } else if (key == "response_cache_ttl") {
+                    config_.cache.response_cache_ttl = parseInt(value);
+                } else if (key == "response_cache_dir") {
+                    config_.cache.response_cache_dir = value;
+                } else if (key == "response_cache_similarity") {
+                    config_.cache.response_cache_similarity = parseBool(value);
+                } else if (key == "response_cache_threshold") {
+                    config_.cache.response_cache_threshold = parseDouble(value, 0.92);
                 }
             } else if (currentSection.find("providers.") == 0) {
                 // 提供商配置
@@ -356,6 +394,7 @@ std::string ConfigManager::generateToml() const {
     ss << "[default]\n";
     ss << "provider = \"" << providerToString(config_.default_config.provider) << "\"\n";
     ss << "model = \"" << config_.default_config.model << "\"\n";
+    ss << "temperature = " << config_.default_config.temperature << "\n";
     ss << "language = \"" << languageToString(config_.language) << "\"\n\n";
 
     // 提供商配置
@@ -425,7 +464,10 @@ std::string ConfigManager::generateToml() const {
     ss << "compress_tool_results = " << (config_.optimization.compress_tool_results ? "true" : "false") << "\n";
     ss << "max_tool_result_length = " << config_.optimization.max_tool_result_length << "\n";
     ss << "show_token_stats = " << (config_.optimization.show_token_stats ? "true" : "false") << "\n";
-    ss << "stats_update_interval = " << config_.optimization.stats_update_interval << "\n\n";
+    ss << "stats_update_interval = " << config_.optimization.stats_update_interval << "\n";
+    ss << "background_compression = " << (config_.optimization.background_compression ? "true" : "false") << "\n";
+    ss << "tokenizer_vocab = \"" << config_.optimization.tokenizer_vocab << "\"\n";
+    ss << "tokenizer_merges = \"" << config_.optimization.tokenizer_merges << "\"\n\n";
 
     // 缓存配置
     ss << "# ============================================\n";
@@ -436,6 +478,12 @@ std::string ConfigManager::generateToml() const {
     ss << "skills_cache_dir = \"" << config_.cache.skills_cache_dir << "\"\n";
     ss << "skill_cache_ttl = " << config_.cache.skill_cache_ttl << "\n";
     ss << "prompt_cache_size = " << config_.cache.prompt_cache_size << "\n";
+    ss << "enable_response_cache = " << (config_.cache.enable_response_cache ? "true" : "false") << "\n";
+    ss << "response_cache_size = " << config_.cache.response_cache_size << "\n";
+    ss << "response_cache_ttl = " << config_.cache.response_cache_ttl << "\n";
+    ss << "response_cache_dir = \"" << config_.cache.response_cache_dir << "\"\n";
+    ss << "response_cache_similarity = " << (config_.cache.response_cache_similarity ? "true" : "false") << "\n";
+    ss << "response_cache_threshold = " << config_.cache.response_cache_threshold << "\n";
 
     return ss.str();
 }
@@ -40,6 +40,7 @@ struct ProviderInfo {
 struct DefaultConfig {
     ProviderType provider;
     std::string model;
+    double temperature;    // 采样温度（负数表示使用提供商默认值）
 };
 
 // 行为设置
@@ -82,6 +83,11 @@ struct OptimizationConfig {
     int max_tool_result_length;
     bool show_token_stats;
     int stats_update_interval;
+    bool background_compression;   // 在后台预先生成早期对话摘要，作为持久上下文的稳定前缀
+
+    // BPE词表（为空时使用启发式估算；merges为空时vocab视为tiktoken格式）
+    std::string tokenizer_vocab;
+    std::string tokenizer_merges;
 };
 
 // 缓存设置
@@ -89,6 +95,14 @@ struct CacheConfig {
     std::string skills_cache_dir;
     int skill_cache_ttl;
     int prompt_cache_size;
+
+    // LLM响应缓存
+    bool enable_response_cache;
+    int response_cache_size;             // 内存条目数
+    int response_cache_ttl;              // 有效期（秒，0表示永不过期）
+    std::string response_cache_dir;      // 磁盘持久化目录（为空时不持久化）
+    bool response_cache_similarity;      // 是否启用相似问题匹配
+    double response_cache_threshold;     // 相似度阈值
 };
 
 // 配置类
@@ -4,12 +4,16 @@
 #include <sstream>
 #include <algorithm>
 #include <regex>
+#include <chrono>
 
 #ifdef PLATFORM_UNIX
 #include <unistd.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
+#include <poll.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <cerrno>
 #endif
 
 #ifdef PLATFORM_WINDOWS
@@ -19,6 +23,145 @@
 
 namespace roboclaw {
 
+// ==================== OutputBuffer ====================
+
+namespace {
+
+// UTF-8续字节（10xxxxxx）
+bool isContinuationByte(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// 去掉末尾不完整的UTF-8字符
+std::string_view trimIncompleteTail(std::string_view s) {
+    size_t back = 0;
+    while (back < s.size() && back < 4 && isContinuationByte(s[s.size() - 1 - back])) {
+        ++back;
+    }
+    if (back >= s.size()) {
+        return s;
+    }
+    unsigned char lead = static_cast<unsigned char>(s[s.size() - 1 - back]);
+    size_t expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if (expected > back + 1) {
+        s.remove_suffix(back + 1);
+    }
+    return s;
+}
+
+// 去掉开头不完整的UTF-8字符
+std::string_view trimIncompleteHead(std::string_view s) {
+    size_t skip = 0;
+    while (skip < s.size() && skip < 3 && isContinuationByte(s[skip])) {
+        ++skip;
+    }
+    s.remove_prefix(skip);
+    return s;
+}
+
+// 将输出数据切分为行交给输出回调；过长的行分段回调
+class LineEmitter {
+public:
+    static constexpr size_t MAX_LINE = 4096;
+
+    LineEmitter(const BashTool::OutputCallback& callback, const std::string& command, bool isStderr)
+        : callback_(callback), command_(command), is_stderr_(isStderr) {}
+
+    void feed(std::string_view data) {
+        if (!callback_) {
+            return;
+        }
+        while (!data.empty()) {
+            size_t newline = data.find('\n');
+            if (newline == std::string_view::npos) {
+                pending_.append(data);
+                if (pending_.size() >= MAX_LINE) {
+                    flush();
+                }
+                return;
+            }
+            if (pending_.empty()) {
+                callback_(command_, is_stderr_, data.substr(0, newline));
+            } else {
+                pending_.append(data.substr(0, newline));
+                flush();
+            }
+            data.remove_prefix(newline + 1);
+        }
+    }
+
+    void finish() {
+        if (callback_ && !pending_.empty()) {
+            flush();
+        }
+    }
+
+private:
+    void flush() {
+        callback_(command_, is_stderr_, pending_);
+        pending_.clear();
+    }
+
+    const BashTool::OutputCallback& callback_;
+    const std::string& command_;
+    bool is_stderr_;
+    std::string pending_;
+};
+
+} // namespace
+
+OutputBuffer::OutputBuffer(size_t limit)
+    : head_limit_(limit / 2)
+    , tail_limit_(limit - limit / 2) {
+}
+
+void OutputBuffer::append(std::string_view data) {
+    total_bytes_ += data.size();
+
+    if (head_.size() < head_limit_) {
+        size_t n = std::min(head_limit_ - head_.size(), data.size());
+        head_.append(data.substr(0, n));
+        data.remove_prefix(n);
+    }
+    if (data.empty() || tail_limit_ == 0) {
+        return;
+    }
+
+    // 数据块本身超过结尾容量：只保留其最后部分
+    if (data.size() >= tail_limit_) {
+        tail_.assign(data.substr(data.size() - tail_limit_));
+        tail_pos_ = 0;
+        return;
+    }
+
+    if (tail_.size() < tail_limit_) {
+        size_t n = std::min(tail_limit_ - tail_.size(), data.size());
+        tail_.append(data.substr(0, n));
+        data.remove_prefix(n);
+    }
+    while (!data.empty()) {
+        size_t n = std::min(tail_limit_ - tail_pos_, data.size());
+        tail_.replace(tail_pos_, n, data.substr(0, n));
+        tail_pos_ = (tail_pos_ + n) % tail_limit_;
+        data.remove_prefix(n);
+    }
+}
+
+std::string OutputBuffer::str() const {
+    std::string tail = tail_.substr(tail_pos_) + tail_.substr(0, tail_pos_);
+    size_t dropped = droppedBytes();
+    if (dropped == 0) {
+        return head_ + tail;
+    }
+
+    std::string result(trimIncompleteTail(head_));
+    result += "\n... [已省略 " + std::to_string(dropped) + " 字节] ...\n";
+    result += trimIncompleteHead(tail);
+    return result;
+}
+
+// ==================== BashTool ====================
+
 BashTool::BashTool()
     : ToolBase("bash", "执行shell命令")
     , default_timeout_(30)  // 默认30秒超时
@@ -90,30 +233,39 @@ ToolResult BashTool::execute(const json& params) {
 
     LOG_DEBUG("执行命令: " + command + " (timeout=" + std::to_string(timeout) + "s)");
 
-    std::string stdout, stderr, error;
-    int exitCode;
+    CommandOutput output(output_limit_);
+    std::string error;
 
-    if (!executeCommand(command, timeout, stdout, stderr, exitCode, error)) {
+    if (!executeCommand(command, timeout, output, error)) {
         return ToolResult::error(error);
     }
 
     // 构建元数据
     json metadata;
     metadata["command"] = command;
-    metadata["exit_code"] = exitCode;
+    metadata["exit_code"] = output.exit_code;
     metadata["timeout"] = timeout;
-    metadata["timed_out"] = (exitCode == -1);
+    metadata["timed_out"] = output.timed_out;
+    metadata["stdout_bytes"] = output.stdout_buffer.totalBytes();
+    metadata["stderr_bytes"] = output.stderr_buffer.totalBytes();
+    metadata["truncated_bytes"] = output.stdout_buffer.droppedBytes() + output.stderr_buffer.droppedBytes();
 
     // 构建输出内容
     std::stringstream content;
-    if (!stdout.empty()) {
-        content << "标准输出:\n" << stdout << "\n";
+    if (!output.stdout_buffer.empty()) {
+        content << "标准输出:\n" << output.stdout_buffer.str() << "\n";
+    }
+    if (!output.stderr_buffer.empty()) {
+        content << "标准错误:\n" << output.stderr_buffer.str() << "\n";
     }
-    if (!stderr.empty()) {
-        content << "标准错误:\n" << stderr << "\n";
+
+    // 超时：命令已被终止，附带终止前的输出
+    if (output.timed_out) {
+        LOG_WARNING("命令执行超时: " + command);
+        return ToolResult::error("命令执行超时（" + std::to_string(timeout) + "秒），已终止\n" + content.str());
     }
 
-    LOG_DEBUG("命令执行完成: exit_code=" + std::to_string(exitCode));
+    LOG_DEBUG("命令执行完成: exit_code=" + std::to_string(output.exit_code));
 
     return ToolResult::ok(content.str(), metadata);
 }
@@ -143,14 +295,62 @@ bool BashTool::isCommandForbidden(const std::string& command) const {
 }
 
 #ifdef PLATFORM_UNIX
+namespace {
+
+constexpr int TERMINATE_GRACE_MS = 2000;    // SIGTERM后等待进程退出的时间，之后SIGKILL
+constexpr int REAP_INTERVAL_MS = 20;        // 没有pidfd时检查子进程状态的间隔
+constexpr size_t READ_CHUNK = 64 * 1024;
+constexpr int FINAL_DRAIN_READS = 16;       // 进程退出后读取剩余数据的最大次数
+
+// 创建管道：两端close-on-exec（避免并发创建的子进程继承彼此的写端而收不到EOF），读端非阻塞
+bool createPipe(int fds[2]) {
+#ifdef PLATFORM_LINUX
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        return false;
+    }
+#else
+    if (pipe(fds) == -1) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+// 打开进程退出通知fd（Linux 5.3+）；不支持时返回-1，改为定期waitpid
+int openPidFd(pid_t pid) {
+#if defined(PLATFORM_LINUX) && defined(SYS_pidfd_open)
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+void closeFd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace
+
 bool BashTool::executeCommandUnix(const std::string& command, int timeout,
-                                  std::string& stdout, std::string& stderr,
-                                  int& exitCode, std::string& error) {
+                                  CommandOutput& output, std::string& error) {
     int stdout_pipe[2], stderr_pipe[2];
-    if (pipe(stdout_pipe) == -1 || pipe(stderr_pipe) == -1) {
+    if (!createPipe(stdout_pipe)) {
         error = "无法创建管道";
         return false;
     }
+    if (!createPipe(stderr_pipe)) {
+        error = "无法创建管道";
+        close(stdout_pipe[0]);
+        close(stdout_pipe[1]);
+        return false;
+    }
 
     pid_t pid = fork();
     if (pid == -1) {
@@ -166,70 +366,158 @@ bool BashTool::executeCommandUnix(const std::string& command, int timeout,
         // 设置进程组
         setpgid(0, 0);
 
-        // 重定向标准输出和标准错误
+        // 标准输入指向/dev/null，避免命令等待终端输入
+        int devNull = open("/dev/null", O_RDONLY);
+        if (devNull >= 0) {
+            dup2(devNull, STDIN_FILENO);
+            if (devNull != STDIN_FILENO) {
+                close(devNull);
+            }
+        }
+
+        // 重定向标准输出和标准错误（管道本身在exec时关闭）
         dup2(stdout_pipe[1], STDOUT_FILENO);
         dup2(stderr_pipe[1], STDERR_FILENO);
 
-        // 关闭不需要的管道端
-        close(stdout_pipe[0]);
-        close(stdout_pipe[1]);
-        close(stderr_pipe[0]);
-        close(stderr_pipe[1]);
-
         // 执行命令
         execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
         _exit(127);  // 执行失败
     }
 
-    // 父进程
+    // 父进程：与子进程中的调用重复，保证kill(-pid)时进程组已建立
+    setpgid(pid, pid);
     close(stdout_pipe[1]);
     close(stderr_pipe[1]);
 
-    // 设置超时
-    alarm(timeout);
+    using Clock = std::chrono::steady_clock;
+
+    int fds[2] = {stdout_pipe[0], stderr_pipe[0]};
+    OutputBuffer* buffers[2] = {&output.stdout_buffer, &output.stderr_buffer};
+    LineEmitter emitters[2] = {LineEmitter(output_callback_, command, false),
+                               LineEmitter(output_callback_, command, true)};
+    int pidFd = openPidFd(pid);
+    std::vector<char> chunk(READ_CHUNK);
+
+    // 读取管道中已有的数据（最多maxReads次）；EOF或出错时关闭该管道
+    auto drain = [&](int i, int maxReads) {
+        for (int reads = 0; fds[i] >= 0 && reads < maxReads; ++reads) {
+            ssize_t count = read(fds[i], chunk.data(), chunk.size());
+            if (count > 0) {
+                std::string_view data(chunk.data(), static_cast<size_t>(count));
+                buffers[i]->append(data);
+                emitters[i].feed(data);
+            } else if (count == -1 && errno == EINTR) {
+                continue;
+            } else if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            } else {
+                closeFd(fds[i]);
+            }
+        }
+    };
 
-    // 读取输出
-    char buffer[4096];
-    ssize_t count;
+    auto deadline = Clock::now() + std::chrono::seconds(timeout);
+    auto killDeadline = Clock::time_point::max();
+    bool terminating = false;
+    bool exited = false;
+    bool failed = false;
+    int status = 0;
+
+    while (true) {
+        pid_t result = waitpid(pid, &status, WNOHANG);
+        if (result == pid) {
+            exited = true;
+        } else if (result == -1 && errno != EINTR) {
+            error = "等待子进程失败";
+            failed = true;
+            break;
+        }
 
-    while ((count = read(stdout_pipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[count] = '\0';
-        stdout += buffer;
-    }
-    close(stdout_pipe[0]);
+        if (exited) {
+            // 读完管道中剩余的数据；后台进程可能仍持有写端，不等待其EOF
+            drain(0, FINAL_DRAIN_READS);
+            drain(1, FINAL_DRAIN_READS);
+            break;
+        }
 
-    while ((count = read(stderr_pipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[count] = '\0';
-        stderr += buffer;
-    }
-    close(stderr_pipe[0]);
+        // 超时：先SIGTERM整个进程组，宽限期后SIGKILL
+        auto now = Clock::now();
+        if (!terminating && now >= deadline) {
+            output.timed_out = true;
+            terminating = true;
+            kill(-pid, SIGTERM);
+            killDeadline = now + std::chrono::milliseconds(TERMINATE_GRACE_MS);
+        } else if (terminating && now >= killDeadline) {
+            kill(-pid, SIGKILL);
+            killDeadline = Clock::time_point::max();
+        }
+
+        auto wake = terminating ? killDeadline : deadline;
+        int waitMs = -1;
+        if (wake != Clock::time_point::max()) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wake - now).count();
+            waitMs = static_cast<int>(std::max<long long>(0, remaining));
+        }
+        if (pidFd < 0 && (waitMs < 0 || waitMs > REAP_INTERVAL_MS)) {
+            waitMs = REAP_INTERVAL_MS;
+        }
 
-    // 等待子进程结束
-    int status;
-    pid_t result = waitpid(pid, &status, 0);
+        struct pollfd pfds[3];
+        int indices[3];
+        nfds_t count = 0;
+        for (int i = 0; i < 2; ++i) {
+            if (fds[i] >= 0) {
+                pfds[count] = {fds[i], POLLIN, 0};
+                indices[count++] = i;
+            }
+        }
+        if (pidFd >= 0) {
+            pfds[count] = {pidFd, POLLIN, 0};
+            indices[count++] = -1;
+        }
 
-    // 取消超时
-    alarm(0);
+        int ready = poll(pfds, count, waitMs);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = "等待命令输出失败";
+            failed = true;
+            break;
+        }
 
-    if (result == -1) {
-        if (errno == EINTR) {
-            // 超时，杀死进程组
-            kill(-pid, SIGKILL);
-            waitpid(pid, &status, 0);
-            exitCode = -1;  // 超时标记
-            error = "命令执行超时";
-            return false;
+        // 两个管道轮流读取，任何一个写满都不会阻塞子进程
+        for (nfds_t k = 0; k < count; ++k) {
+            if (indices[k] >= 0 && (pfds[k].revents & (POLLIN | POLLHUP | POLLERR))) {
+                drain(indices[k], 1);
+            }
         }
-        error = "等待子进程失败";
+    }
+
+    if (failed) {
+        kill(-pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    } else if (output.timed_out) {
+        // 清理进程组中残留的进程
+        kill(-pid, SIGKILL);
+    }
+
+    closeFd(fds[0]);
+    closeFd(fds[1]);
+    closeFd(pidFd);
+    emitters[0].finish();
+    emitters[1].finish();
+
+    if (failed) {
         return false;
     }
 
     if (WIFEXITED(status)) {
-        exitCode = WEXITSTATUS(status);
+        output.exit_code = WEXITSTATUS(status);
     } else if (WIFSIGNALED(status)) {
-        exitCode = 128 + WTERMSIG(status);
+        output.exit_code = 128 + WTERMSIG(status);
     } else {
-        exitCode = -1;
+        output.exit_code = -1;
     }
 
     return true;
@@ -238,8 +526,7 @@ bool BashTool::executeCommandUnix(const std::string& command, int timeout,
 
 #ifdef PLATFORM_WINDOWS
 bool BashTool::executeCommandWindows(const std::string& command, int timeout,
-                                    std::string& stdout, std::string& stderr,
-                                    int& exitCode, std::string& error) {
+                                    CommandOutput& output, std::string& error) {
     SECURITY_ATTRIBUTES sa;
     sa.nLength = sizeof(SECURITY_ATTRIBUTES);
     sa.bInheritHandle = TRUE;
@@ -289,33 +576,36 @@ bool BashTool::executeCommandWindows(const std::string& command, int timeout,
 
     if (waitResult == WAIT_TIMEOUT) {
         TerminateProcess(pi.hProcess, 1);
-        exitCode = -1;
-        error = "命令执行超时";
-        CloseHandle(stdout_read);
-        CloseHandle(stderr_read);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        return false;
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        output.timed_out = true;
     }
 
     // 读取输出
     char buffer[4096];
     DWORD bytesRead;
 
-    while (ReadFile(stdout_read, buffer, sizeof(buffer) - 1, &bytesRead, nullptr) && bytesRead > 0) {
-        buffer[bytesRead] = '\0';
-        stdout += buffer;
+    LineEmitter stdoutLines(output_callback_, command, false);
+    while (ReadFile(stdout_read, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
+        std::string_view data(buffer, bytesRead);
+        output.stdout_buffer.append(data);
+        stdoutLines.feed(data);
     }
+    stdoutLines.finish();
     CloseHandle(stdout_read);
 
-    while (ReadFile(stderr_read, buffer, sizeof(buffer) - 1, &bytesRead, nullptr) && bytesRead > 0) {
-        buffer[bytesRead] = '\0';
-        stderr += buffer;
+    LineEmitter stderrLines(output_callback_, command, true);
+    while (ReadFile(stderr_read, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
+        std::string_view data(buffer, bytesRead);
+        output.stderr_buffer.append(data);
+        stderrLines.feed(data);
     }
+    stderrLines.finish();
     CloseHandle(stderr_read);
 
     // 获取退出码
-    GetExitCodeProcess(pi.hProcess, (DWORD*)&exitCode);
+    DWORD exitCode = 0;
+    GetExitCodeProcess(pi.hProcess, &exitCode);
+    output.exit_code = static_cast<int>(exitCode);
 
     CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
@@ -325,12 +615,11 @@ bool BashTool::executeCommandWindows(const std::string& command, int timeout,
 #endif
 
 bool BashTool::executeCommand(const std::string& command, int timeout,
-                              std::string& stdout, std::string& stderr,
-                              int& exitCode, std::string& error) {
+                              CommandOutput& output, std::string& error) {
     #ifdef PLATFORM_UNIX
-        return executeCommandUnix(command, timeout, stdout, stderr, exitCode, error);
+        return executeCommandUnix(command, timeout, output, error);
     #elif defined(PLATFORM_WINDOWS)
-        return executeCommandWindows(command, timeout, stdout, stderr, exitCode, error);
+        return executeCommandWindows(command, timeout, output, error);
     #else
         error = "不支持的平台";
         return false;
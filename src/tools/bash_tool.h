@@ -4,7 +4,9 @@
 #define ROBOCLAW_TOOLS_BASH_TOOL_H
 
 #include "tool_base.h"
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // 平台检测宏
@@ -14,8 +16,52 @@
 
 namespace roboclaw {
 
+// 有界输出缓冲
+//
+// 保留输出开头的一半容量和结尾的一半容量（结尾部分为环形缓冲），
+// 中间超出的部分丢弃并计数。内存占用与命令输出总量无关。
+class OutputBuffer {
+public:
+    static constexpr size_t DEFAULT_LIMIT = 256 * 1024;
+
+    explicit OutputBuffer(size_t limit = DEFAULT_LIMIT);
+
+    void append(std::string_view data);
+
+    // 保留的内容；有丢弃时在开头和结尾之间插入省略标记（截断点对齐到UTF-8字符边界）
+    std::string str() const;
+
+    bool empty() const { return total_bytes_ == 0; }
+    size_t totalBytes() const { return total_bytes_; }
+    size_t droppedBytes() const { return total_bytes_ - head_.size() - tail_.size(); }
+
+private:
+    size_t head_limit_;
+    size_t tail_limit_;
+    std::string head_;
+    std::string tail_;          // 环形缓冲，写满后从tail_pos_处覆盖最旧的数据
+    size_t tail_pos_ = 0;
+    size_t total_bytes_ = 0;
+};
+
+// 命令执行结果
+struct CommandOutput {
+    OutputBuffer stdout_buffer;
+    OutputBuffer stderr_buffer;
+    int exit_code = -1;
+    bool timed_out = false;
+
+    explicit CommandOutput(size_t limit = OutputBuffer::DEFAULT_LIMIT)
+        : stdout_buffer(limit), stderr_buffer(limit) {}
+};
+
 class BashTool : public ToolBase {
 public:
+    // 输出回调：命令运行期间按行回调（不含换行符），isStderr区分输出流
+    // 并发的工具调用会从不同线程同时回调
+    using OutputCallback = std::function<void(const std::string& command, bool isStderr,
+                                              std::string_view line)>;
+
     BashTool();
     ~BashTool() override = default;
 
@@ -36,11 +82,16 @@ public:
         forbidden_commands_ = commands;
     }
 
+    // 设置每个输出流保留的最大字节数（开头和结尾各占一半）
+    void setOutputLimit(size_t bytes) { output_limit_ = bytes; }
+
+    // 设置实时输出回调（在执行任何命令之前设置）
+    void setOutputCallback(OutputCallback callback) { output_callback_ = std::move(callback); }
+
 private:
     // 执行命令
     bool executeCommand(const std::string& command, int timeout,
-                       std::string& stdout, std::string& stderr,
-                       int& exitCode, std::string& error);
+                       CommandOutput& output, std::string& error);
 
     // 检查命令是否被禁止
     bool isCommandForbidden(const std::string& command) const;
@@ -48,19 +99,19 @@ private:
     // 执行命令（Unix）
     #ifdef PLATFORM_UNIX
     bool executeCommandUnix(const std::string& command, int timeout,
-                           std::string& stdout, std::string& stderr,
-                           int& exitCode, std::string& error);
+                           CommandOutput& output, std::string& error);
     #endif
 
     // 执行命令（Windows）
     #ifdef PLATFORM_WINDOWS
     bool executeCommandWindows(const std::string& command, int timeout,
-                              std::string& stdout, std::string& stderr,
-                              int& exitCode, std::string& error);
+                              CommandOutput& output, std::string& error);
     #endif
 
     int default_timeout_;
     std::vector<std::string> forbidden_commands_;
+    size_t output_limit_ = OutputBuffer::DEFAULT_LIMIT;
+    OutputCallback output_callback_;
 };
 
 } // namespace roboclaw
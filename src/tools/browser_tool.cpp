@@ -15,10 +15,12 @@
 #endif
 
 #ifdef PLATFORM_LINUX
+#include "webdriver_client.h"
 #include <cstdlib>
 #include <fstream>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <signal.h>
 #endif
 
@@ -145,7 +147,7 @@ private:
 #endif // PLATFORM_MACOS
 
 // ============================================================
-// Linux Chrome/Firefox 实现 (使用 WebDriver)
+// Linux Chrome/Firefox 实现 (进程内 WebDriver 客户端，Chrome 另用 DevTools 协议)
 // ============================================================
 
 #ifdef PLATFORM_LINUX
@@ -153,7 +155,7 @@ private:
 class LinuxBrowserHandle : public BrowserHandle {
 public:
     LinuxBrowserHandle(const std::string& browser_name, int port)
-        : BrowserHandle(browser_name, port), connected_(false), process_id_(0) {
+        : BrowserHandle(browser_name, port), connected_(false), process_id_(0), driver_("127.0.0.1", port) {
         connected_ = startWebDriver();
     }
 
@@ -166,90 +168,217 @@ public:
     }
 
     bool navigate(const std::string& url) override {
-        return sendCommand("{\"url\":\"" + url + "\"}");
+        if (cdp_.isConnected()) {
+            // 由本次导航之后的load事件判断导航完成
+            cdp_.clearEvents();
+            navigation_sequence_ = cdp_.eventSequence();
+            json result = cdp_.call("Page.navigate", {{"url", url}});
+            if (result.is_null() || result.contains("errorText")) {
+                return false;
+            }
+            return waitForLoad(PAGE_LOAD_TIMEOUT_MS);
+        }
+        return driver_.command("POST", driver_.sessionPath("/url"), {{"url", url}}).ok;
     }
 
     bool click(const Selector& selector) override {
-        std::string cmd = "document.querySelector('" + selector.value + "').click()";
-        return executeScript(cmd).find("true") != std::string::npos;
+        std::string element = findElement(selector);
+        if (element.empty()) {
+            return false;
+        }
+        return driver_.command("POST", driver_.sessionPath("/element/" + element + "/click")).ok;
     }
 
     bool type(const Selector& selector, const std::string& text) override {
-        std::string cmd = "document.querySelector('" + selector.value + "').value='" + text + "'";
-        return executeScript(cmd).find("true") != std::string::npos;
+        std::string element = findElement(selector);
+        if (element.empty()) {
+            return false;
+        }
+        // 清空和输入一次发出
+        std::string path = driver_.sessionPath("/element/" + element);
+        auto replies = driver_.pipeline({
+            {"POST", path + "/clear", nullptr},
+            {"POST", path + "/value", {{"text", text}}}
+        });
+        return replies[0].ok && replies[1].ok;
     }
 
     std::string screenshot() override {
-        return sendCommand("{\"screenshot\":true}");
+        // 截图数据（base64 PNG）直接在内存中返回
+        if (cdp_.isConnected()) {
+            json result = cdp_.call("Page.captureScreenshot", {{"format", "png"}});
+            return result.is_object() ? result.value("data", "") : "";
+        }
+        WebDriverReply reply = driver_.command("GET", driver_.sessionPath("/screenshot"));
+        return reply.ok && reply.value.is_string() ? reply.value.get<std::string>() : "";
     }
 
     std::string getText(const Selector& selector) override {
-        std::string cmd = "document.querySelector('" + selector.value + "').textContent";
-        return executeScript(cmd);
+        std::string element = findElement(selector);
+        if (element.empty()) {
+            return "";
+        }
+        WebDriverReply reply = driver_.command("GET", driver_.sessionPath("/element/" + element + "/text"));
+        return reply.ok && reply.value.is_string() ? reply.value.get<std::string>() : "";
     }
 
     std::string executeScript(const std::string& script) override {
-        return sendCommand("{\"script\":\"" + script + "\"}");
+        // 按表达式求值（与其他平台一致），返回值转为文本
+        json value;
+        if (cdp_.isConnected()) {
+            json result = cdp_.call("Runtime.evaluate", {
+                {"expression", script}, {"returnByValue", true}, {"awaitPromise", true}
+            });
+            if (result.is_null() || result.contains("exceptionDetails")) {
+                return "";
+            }
+            value = result["result"].value("value", json());
+        } else {
+            WebDriverReply reply = driver_.command("POST", driver_.sessionPath("/execute/sync"), {
+                {"script", "return eval(arguments[0]);"}, {"args", json::array({script})}
+            });
+            if (!reply.ok) {
+                return "";
+            }
+            value = reply.value;
+        }
+        if (value.is_null()) {
+            return "";
+        }
+        return value.is_string() ? value.get<std::string>() : value.dump();
     }
 
     bool scroll(int x, int y) override {
-        std::string cmd = "window.scrollBy(" + std::to_string(x) + "," + std::to_string(y) + ")";
-        return executeScript(cmd).find("true") != std::string::npos;
+        std::string cmd = "window.scrollBy(" + std::to_string(x) + "," + std::to_string(y) + "); true";
+        return executeScript(cmd) == "true";
+    }
+
+    bool supportsPageEvents() const override {
+        return cdp_.isConnected();
+    }
+
+    bool waitForLoad(int timeoutMs) override {
+        // 上次导航（本端发起或页面内跳转）之后已经加载完成时立即返回
+        return cdp_.isConnected() &&
+               cdp_.waitForEventAfter("Page.loadEventFired", "Page.frameNavigated",
+                                      navigation_sequence_, timeoutMs);
+    }
+
+    bool waitForNetworkIdle(int timeoutMs) override {
+        return cdp_.isConnected() && cdp_.waitForNetworkIdle(NETWORK_IDLE_MS, timeoutMs);
     }
 
     void close() override {
         if (connected_) {
-            sendCommand("{\"quit\":true}");
-            if (process_id_ > 0) {
-                kill(process_id_, SIGTERM);
-            }
+            cdp_.close();
+            driver_.deleteSession();
             connected_ = false;
         }
+        if (process_id_ > 0) {
+            kill(process_id_, SIGTERM);
+            waitpid(process_id_, nullptr, 0);
+            process_id_ = 0;
+        }
     }
 
 private:
+    static constexpr int DRIVER_START_TIMEOUT_MS = 10000;
+    static constexpr int PAGE_LOAD_TIMEOUT_MS = 30000;
+    static constexpr int NETWORK_IDLE_MS = 500;
+
     bool connected_;
     pid_t process_id_;
+    WebDriverClient driver_;
+    CdpClient cdp_;
+    uint64_t navigation_sequence_ = 0;  // 最近一次本端发起导航时的事件序号
 
     bool startWebDriver() {
         // 启动 ChromeDriver 或 geckodriver
-        std::string driver_cmd;
-        if (browser_name_.find("Chrome") != std::string::npos) {
-            driver_cmd = "chromedriver --port=" + std::to_string(port_);
-        } else if (browser_name_.find("Firefox") != std::string::npos) {
-            driver_cmd = "geckodriver --port=" + std::to_string(port_);
+        std::string driver;
+        json capabilities;
+        if (browser_name_.find("chrome") != std::string::npos) {
+            driver = "chromedriver";
+            capabilities["browserName"] = "chrome";
+        } else if (browser_name_.find("firefox") != std::string::npos) {
+            driver = "geckodriver";
+            capabilities["browserName"] = "firefox";
         } else {
             return false;
         }
 
+        std::string port_arg = "--port=" + std::to_string(port_);
         process_id_ = fork();
         if (process_id_ == 0) {
             // 子进程
-            execlp("sh", "sh", "-c", driver_cmd.c_str(), nullptr);
-            exit(1);
-        } else if (process_id_ > 0) {
-            // 父进程
-            usleep(1000000);  // 等待 1 秒
-            connected_ = true;
-            return true;
+            execlp(driver.c_str(), driver.c_str(), port_arg.c_str(), nullptr);
+            _exit(127);
+        } else if (process_id_ < 0) {
+            process_id_ = 0;
+            return false;
         }
-        return false;
+
+        // 轮询驱动状态代替固定等待
+        json returned;
+        if (!driver_.waitUntilReady(DRIVER_START_TIMEOUT_MS) ||
+            !driver_.createSession({{"alwaysMatch", capabilities}}, &returned)) {
+            LOG_ERROR("WebDriver启动失败 / WebDriver failed to start: " + driver);
+            close();
+            return false;
+        }
+
+        connectDevTools(returned);
+        return true;
     }
 
-    std::string sendCommand(const std::string& cmd) {
-        // 使用 curl 发送 WebDriver 命令
-        std::string curl_cmd = "curl -s http://localhost:" + std::to_string(port_) + "/session -d '" + cmd + "'";
-        char buffer[4096];
-        std::string result;
+    // Chrome通过DevTools协议提供加载/网络事件；不可用时只使用WebDriver
+    void connectDevTools(const json& capabilities) {
+        std::string address;
+        if (capabilities.contains("goog:chromeOptions")) {
+            address = capabilities["goog:chromeOptions"].value("debuggerAddress", "");
+        }
+        size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            return;
+        }
 
-        FILE* pipe = popen(curl_cmd.c_str(), "r");
-        if (pipe) {
-            while (fgets(buffer, sizeof(buffer), pipe)) {
-                result += buffer;
-            }
-            pclose(pipe);
+        std::string url = CdpClient::findPageWebSocketUrl(address.substr(0, colon),
+                                                          std::atoi(address.c_str() + colon + 1));
+        if (url.empty() || !cdp_.connect(url)) {
+            LOG_WARNING("DevTools不可用，使用WebDriver / DevTools unavailable, using WebDriver only");
+            return;
         }
-        return result;
+
+        auto results = cdp_.callBatch({{"Page.enable", json::object()},
+                                       {"Network.enable", json::object()},
+                                       {"Runtime.enable", json::object()}});
+        if (std::any_of(results.begin(), results.end(), [](const json& r) { return r.is_null(); })) {
+            LOG_WARNING("DevTools初始化失败 / DevTools setup failed: " + cdp_.lastError());
+            cdp_.close();
+        }
+    }
+
+    // 查找元素，返回WebDriver元素ID
+    std::string findElement(const Selector& selector) {
+        std::string strategy = "css selector";
+        std::string value = selector.value;
+        if (selector.type == "xpath") {
+            strategy = "xpath";
+        } else if (selector.type == "id") {
+            value = "[id=\"" + value + "\"]";
+        } else if (selector.type == "name") {
+            value = "[name=\"" + value + "\"]";
+        } else if (selector.type == "class") {
+            value = "." + value;
+        }
+
+        WebDriverReply reply = driver_.command("POST", driver_.sessionPath("/element"),
+                                               {{"using", strategy}, {"value", value}});
+        if (!reply.ok || !reply.value.is_object() || reply.value.empty()) {
+            return "";
+        }
+        // W3C元素引用：{"element-6066-11e4-a52e-4f735466cecf": "<id>"}
+        const json& id = reply.value.begin().value();
+        return id.is_string() ? id.get<std::string>() : "";
     }
 };
 
@@ -390,7 +519,7 @@ ToolDescription BrowserTool::getToolDescription() const {
     desc.description = "浏览器自动化工具，类似 OpenClaw 的可视化操作功能。支持打开、导航、点击、输入、截图等操作 / Browser automation tool like OpenClaw visual control. Supports open, navigate, click, type, screenshot operations.";
 
     desc.parameters = {
-        {"action", "string", "操作类型 / Action: open, close, navigate, screenshot, click, type, scroll, execute, get_text, find_element, list_tabs, new_tab, close_tab, switch_tab", true, ""},
+        {"action", "string", "操作类型 / Action: open, close, navigate, screenshot, click, type, scroll, wait, execute, get_text, find_element, list_tabs, new_tab, close_tab, switch_tab", true, ""},
         {"browser", "string", "浏览器类型 / Browser type: chrome, firefox, safari, edge (default: auto)", false, "auto"},
         {"url", "string", "目标 URL / Target URL (for navigate action)", false, ""},
         {"selector_type", "string", "定位器类型 / Selector type: css, xpath, id, name, class", false, "css"},
@@ -399,7 +528,8 @@ ToolDescription BrowserTool::getToolDescription() const {
         {"script", "string", "JavaScript 代码 / JavaScript code", false, ""},
         {"x", "integer", "X 方向滚动 / X scroll amount", false, "0"},
         {"y", "integer", "Y 方向滚动 / Y scroll amount", false, "0"},
-        {"wait_ms", "integer", "等待毫秒数 / Wait milliseconds", false, "1000"},
+        {"wait_ms", "integer", "等待毫秒数（有wait_for时为超时） / Wait milliseconds (timeout when wait_for is set)", false, "1000"},
+        {"wait_for", "string", "等待条件 / Wait condition: load, network_idle (default: fixed delay)", false, ""},
         {"tab_index", "integer", "标签页索引 / Tab index", false, "0"}
     };
     return desc;
@@ -413,7 +543,7 @@ bool BrowserTool::validateParams(const json& params) const {
     std::string action_str = getStringParam(params, "action");
     std::vector<std::string> valid_actions = {
         "open", "close", "navigate", "screenshot", "click", "type",
-        "scroll", "execute", "get_text", "find_element", "list_tabs",
+        "scroll", "wait", "execute", "get_text", "find_element", "list_tabs",
         "new_tab", "close_tab", "switch_tab"
     };
 
@@ -452,7 +582,7 @@ ToolResult BrowserTool::execute(const json& params) {
     } else if (action_str == "get_text") {
         return getText(parseSelector(params));
     } else if (action_str == "wait") {
-        return wait(getIntParam(params, "wait_ms", 1000));
+        return wait(getIntParam(params, "wait_ms", 1000), getStringParam(params, "wait_for", ""));
     } else if (action_str == "list_tabs") {
         return listTabs();
     } else if (action_str == "new_tab") {
@@ -644,7 +774,21 @@ ToolResult BrowserTool::getText(const Selector& selector) {
     return ToolResult::ok(text);
 }
 
-ToolResult BrowserTool::wait(int milliseconds) {
+ToolResult BrowserTool::wait(int milliseconds, const std::string& condition) {
+    if (condition == "load" || condition == "network_idle") {
+        std::shared_lock<std::shared_mutex> lock(browsers_mutex_);
+        auto it = open_browsers_.find(current_browser_id_);
+        if (it != open_browsers_.end() && it->second->supportsPageEvents()) {
+            bool reached = condition == "load" ? it->second->waitForLoad(milliseconds)
+                                               : it->second->waitForNetworkIdle(milliseconds);
+            if (!reached) {
+                return ToolResult::error("等待超时 / Timed out waiting for " + condition);
+            }
+            return ToolResult::ok("已满足等待条件 / Reached " + condition);
+        }
+    }
+
+    // 不支持页面事件时按固定时长等待
     std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
     return ToolResult::ok("已等待 / Waited " + std::to_string(milliseconds) + "ms");
 }
@@ -67,6 +67,11 @@ public:
     virtual bool scroll(int x, int y) = 0;
     virtual void close() = 0;
 
+    // 页面事件（加载完成、网络空闲）；不支持的实现由调用方退回固定等待
+    virtual bool supportsPageEvents() const { return false; }
+    virtual bool waitForLoad(int timeoutMs) { (void)timeoutMs; return false; }
+    virtual bool waitForNetworkIdle(int timeoutMs) { (void)timeoutMs; return false; }
+
     std::string getBrowserName() const { return browser_name_; }
     int getPort() const { return port_; }
 
@@ -121,8 +126,8 @@ public:
     // 获取文本
     ToolResult getText(const Selector& selector);
 
-    // 等待
-    ToolResult wait(int milliseconds);
+    // 等待（condition为load/network_idle时等待页面事件，milliseconds为超时）
+    ToolResult wait(int milliseconds, const std::string& condition = "");
 
     // 查找元素
     ToolResult findElement(const Selector& selector);
@@ -1,8 +1,11 @@
 // EditTool实现
 
 #include "edit_tool.h"
-#include <sstream>
+#include "../utils/atomic_file.h"
+#include "../utils/mapped_file.h"
+#include "../utils/string_search.h"
 #include <algorithm>
+#include <string_view>
 
 namespace roboclaw {
 
@@ -17,8 +20,13 @@ ToolDescription EditTool::getToolDescription() const {
 
     desc.parameters = {
         {"path", "string", "文件路径（必需）", true, ""},
-        {"old_string", "string", "要替换的内容（必需）", true, ""},
-        {"new_string", "string", "替换后的内容（必需）", true, ""}
+        {"old_string", "string", "要替换的内容（不使用edits时必需），所有出现都会被替换", false, ""},
+        {"new_string", "string", "替换后的内容（不使用edits时必需）", false, ""},
+        {"edits", "array", "批量编辑（可选）：每项包含old_string和new_string，"
+                           "都针对原始文件内容匹配，匹配范围不能重叠，全部成功才写入", false, "",
+         json{{"type", "object"},
+              {"properties", {{"old_string", {{"type", "string"}}}, {"new_string", {{"type", "string"}}}}},
+              {"required", {"old_string", "new_string"}}}}
     };
 
     return desc;
@@ -28,22 +36,35 @@ bool EditTool::validateParams(const json& params) const {
     if (!hasRequiredParam(params, "path")) {
         return false;
     }
-    if (!hasRequiredParam(params, "old_string")) {
-        return false;
-    }
-    if (!hasRequiredParam(params, "new_string")) {
-        return false;
-    }
 
     std::string path = getStringParam(params, "path");
-    std::string oldString = getStringParam(params, "old_string");
-
     if (path.empty()) {
         return false;
     }
 
-    if (oldString.empty()) {
-        return false;
+    if (params.contains("edits")) {
+        const auto& edits = params["edits"];
+        if (!edits.is_array() || edits.empty()) {
+            return false;
+        }
+        for (const auto& edit : edits) {
+            if (!edit.is_object() ||
+                !edit.contains("old_string") || !edit["old_string"].is_string() ||
+                !edit.contains("new_string") || !edit["new_string"].is_string() ||
+                edit["old_string"].get_ref<const std::string&>().empty()) {
+                return false;
+            }
+        }
+    } else {
+        if (!hasRequiredParam(params, "old_string")) {
+            return false;
+        }
+        if (!hasRequiredParam(params, "new_string")) {
+            return false;
+        }
+        if (getStringParam(params, "old_string").empty()) {
+            return false;
+        }
     }
 
     // 检查文件是否存在
@@ -56,26 +77,20 @@ bool EditTool::validateParams(const json& params) const {
 
 ToolResult EditTool::execute(const json& params) {
     if (!validateParams(params)) {
-        return ToolResult::error("参数验证失败：path、old_string和new_string都是必需参数");
+        return ToolResult::error("参数验证失败：path、old_string和new_string（或edits）都是必需参数");
     }
 
     std::string path = getStringParam(params, "path");
-    std::string oldString = getStringParam(params, "old_string");
-    std::string newString = getStringParam(params, "new_string");
+    std::vector<EditOperation> edits = parseEdits(params);
 
-    LOG_DEBUG("编辑文件: " + path);
-
-    // 验证old_string在文件中存在
-    if (!validateOldStringExists(path, oldString)) {
-        return ToolResult::error("未找到要替换的内容: " + oldString.substr(0, 50) + "...");
-    }
+    LOG_DEBUG("编辑文件: " + path + " (" + std::to_string(edits.size()) + " 处编辑)");
 
     // 执行编辑
     std::string error;
     int replaceCount = 0;
     std::vector<int> affectedLines;
 
-    if (!editFile(path, oldString, newString, error, replaceCount, affectedLines)) {
+    if (!editFile(path, edits, error, replaceCount, affectedLines)) {
         return ToolResult::error(error);
     }
 
@@ -84,127 +99,98 @@ ToolResult EditTool::execute(const json& params) {
     metadata["path"] = path;
     metadata["replace_count"] = replaceCount;
     metadata["affected_lines"] = affectedLines;
+    metadata["edit_count"] = edits.size();
 
     LOG_DEBUG("文件编辑成功: " + path + " (" + std::to_string(replaceCount) + " 处替换)");
 
     return ToolResult::ok("已成功编辑文件: " + path + "，替换了 " + std::to_string(replaceCount) + " 处", metadata);
 }
 
-bool EditTool::editFile(const std::string& path, const std::string& oldString,
-                        const std::string& newString, std::string& error,
-                        int& replaceCount, std::vector<int>& affectedLines) {
-    try {
-        // 读取所有行
-        std::vector<std::string> lines;
-        std::ifstream file(path);
-        if (!file.is_open()) {
-            error = "无法打开文件: " + path;
-            return false;
-        }
-
-        std::string line;
-        while (std::getline(file, line)) {
-            lines.push_back(line);
-        }
-        file.close();
-
-        // 查找old_string出现的位置
-        std::vector<size_t> occurrences = findStringOccurrences(lines, oldString);
-
-        if (occurrences.empty()) {
-            error = "未找到要替换的内容";
-            return false;
-        }
-
-        // 执行替换
-        replaceCount = 0;
-        for (size_t pos : occurrences) {
-            size_t lineIndex = pos;
-            size_t charIndex = 0;
-
-            // 找到具体是哪一行
-            size_t currentPos = 0;
-            for (size_t i = 0; i < lines.size(); ++i) {
-                size_t lineLen = lines[i].length() + 1;  // +1 for newline
-                if (currentPos + lineLen > pos) {
-                    lineIndex = i;
-                    charIndex = pos - currentPos;
-                    break;
-                }
-                currentPos += lineLen;
-            }
-
-            // 在该行中替换
-            if (lineIndex < lines.size()) {
-                size_t findPos = lines[lineIndex].find(oldString, charIndex);
-                if (findPos != std::string::npos) {
-                    lines[lineIndex].replace(findPos, oldString.length(), newString);
-                    replaceCount++;
-                    affectedLines.push_back(static_cast<int>(lineIndex) + 1);  // 1-based line number
-                }
-            }
-        }
-
-        // 写回文件
-        std::ofstream outFile(path);
-        if (!outFile.is_open()) {
-            error = "无法写入文件: " + path;
-            return false;
-        }
+ToolAccess EditTool::describeAccess(const json& params) const {
+    // 编辑先读后写，按写入处理；缺少路径时无法判断访问范围，保守串行
+    std::string path = getStringParam(params, "path");
+    if (path.empty()) {
+        return ToolAccess::unknown();
+    }
+    return ToolAccess().writes(path);
+}
 
-        for (const auto& l : lines) {
-            outFile << l << "\n";
+std::vector<EditTool::EditOperation> EditTool::parseEdits(const json& params) const {
+    std::vector<EditOperation> edits;
+    if (params.contains("edits")) {
+        for (const auto& edit : params["edits"]) {
+            edits.push_back({edit["old_string"].get<std::string>(), edit["new_string"].get<std::string>()});
         }
-        outFile.close();
-
-        return true;
-
-    } catch (const std::exception& e) {
-        error = std::string("编辑文件失败: ") + e.what();
-        return false;
+    } else {
+        edits.push_back({getStringParam(params, "old_string"), getStringParam(params, "new_string")});
     }
+    return edits;
 }
 
-std::vector<size_t> EditTool::findStringOccurrences(const std::vector<std::string>& lines,
-                                                     const std::string& searchString) {
-    std::vector<size_t> occurrences;
-    size_t currentPos = 0;
+bool EditTool::editFile(const std::string& path, const std::vector<EditOperation>& edits,
+                        std::string& error, int& replaceCount, std::vector<int>& affectedLines) {
+    MappedFile source;
+    if (!source.open(path, error)) {
+        return false;
+    }
+    std::string_view content = source.view();
 
-    for (const auto& line : lines) {
-        size_t pos = 0;
-        while ((pos = line.find(searchString, pos)) != std::string::npos) {
-            occurrences.push_back(currentPos + pos);
-            pos += searchString.length();
+    // 在原始内容中查找每处编辑的所有出现（同一编辑的匹配互不重叠）
+    struct Match {
+        size_t offset;
+        size_t length;
+        size_t edit;
+    };
+    std::vector<Match> matches;
+    for (size_t i = 0; i < edits.size(); ++i) {
+        const std::string& oldString = edits[i].old_string;
+        size_t found = 0;
+        for (size_t pos = findSubstring(content, oldString); pos != std::string_view::npos;
+             pos = findSubstring(content, oldString, pos + oldString.size())) {
+            matches.push_back({pos, oldString.size(), i});
+            ++found;
+        }
+        if (found == 0) {
+            std::string prefix = edits.size() > 1 ? "第" + std::to_string(i + 1) + "处编辑" : "";
+            error = prefix + "未找到要替换的内容: " + oldString.substr(0, 50) + "...";
+            return false;
         }
-        currentPos += line.length() + 1;  // +1 for newline
     }
 
-    return occurrences;
-}
-
-int EditTool::getLineNumber(const std::vector<std::string>& lines, size_t position) {
-    size_t currentPos = 0;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        size_t lineLen = lines[i].length() + 1;  // +1 for newline
-        if (currentPos + lineLen > position) {
-            return static_cast<int>(i) + 1;  // 1-based line number
+    // 不同编辑的匹配范围不能重叠
+    if (edits.size() > 1) {
+        std::sort(matches.begin(), matches.end(),
+                  [](const Match& a, const Match& b) { return a.offset < b.offset; });
+        for (size_t i = 1; i < matches.size(); ++i) {
+            if (matches[i].offset < matches[i - 1].offset + matches[i - 1].length) {
+                error = "第" + std::to_string(matches[i - 1].edit + 1) + "处和第" +
+                        std::to_string(matches[i].edit + 1) + "处编辑的匹配内容重叠";
+                return false;
+            }
         }
-        currentPos += lineLen;
     }
-    return -1;
-}
 
-bool EditTool::validateOldStringExists(const std::string& path, const std::string& oldString) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        return false;
+    // 片段表：未修改的部分直接引用映射的原文件，替换部分引用new_string
+    std::vector<std::string_view> pieces;
+    pieces.reserve(matches.size() * 2 + 1);
+    size_t cursor = 0;
+    int line = 1;
+    replaceCount = 0;
+    for (const auto& match : matches) {
+        pieces.push_back(content.substr(cursor, match.offset - cursor));
+        pieces.push_back(edits[match.edit].new_string);
+
+        line += static_cast<int>(std::count(content.begin() + cursor, content.begin() + match.offset, '\n'));
+        affectedLines.push_back(line);  // 1-based line number
+        line += static_cast<int>(std::count(content.begin() + match.offset,
+                                            content.begin() + match.offset + match.length, '\n'));
+        cursor = match.offset + match.length;
+        ++replaceCount;
     }
+    pieces.push_back(content.substr(cursor));
 
-    std::string content((std::istreambuf_iterator<char>(file)),
-                        std::istreambuf_iterator<char>());
-    file.close();
-
-    return content.find(oldString) != std::string::npos;
+    // 写入临时文件后替换，保留原文件权限
+    return writeFileAtomic(path, pieces, error);
 }
 
 } // namespace roboclaw
@@ -24,21 +24,22 @@ public:
     // 执行工具
     ToolResult execute(const json& params) override;
 
-private:
-    // 编辑文件（替换内容）
-    bool editFile(const std::string& path, const std::string& oldString,
-                  const std::string& newString, std::string& error,
-                  int& replaceCount, std::vector<int>& affectedLines);
-
-    // 查找字符串在文件中的位置
-    std::vector<size_t> findStringOccurrences(const std::vector<std::string>& lines,
-                                              const std::string& searchString);
+    // 描述资源访问（用于并发冲突分析）
+    ToolAccess describeAccess(const json& params) const override;
 
-    // 获取行号
-    int getLineNumber(const std::vector<std::string>& lines, size_t position);
-
-    // 验证old_string存在
-    bool validateOldStringExists(const std::string& path, const std::string& oldString);
+private:
+    // 一处编辑：将old_string的所有出现替换为new_string
+    struct EditOperation {
+        std::string old_string;
+        std::string new_string;
+    };
+
+    // 从参数中取出编辑列表（edits数组，或单个old_string/new_string）
+    std::vector<EditOperation> parseEdits(const json& params) const;
+
+    // 编辑文件：所有编辑都针对原始内容匹配，一次生成输出并原子替换文件
+    bool editFile(const std::string& path, const std::vector<EditOperation>& edits,
+                  std::string& error, int& replaceCount, std::vector<int>& affectedLines);
 };
 
 } // namespace roboclaw
@@ -1,7 +1,6 @@
 // ReadTool实现
 
 #include "read_tool.h"
-#include <sstream>
 #include <algorithm>
 
 namespace roboclaw {
@@ -58,88 +57,102 @@ ToolResult ReadTool::execute(const json& params) {
 
     LOG_DEBUG("读取文件: " + path + " (offset=" + std::to_string(offset) + ", limit=" + std::to_string(limit) + ")");
 
-    // 检查文件是否存在
-    if (!std::filesystem::exists(path)) {
-        return ToolResult::error("文件不存在: " + path);
+    // 打开并映射文件（同时检查存在性和文件类型）
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        return ToolResult::error(error);
     }
 
-    // 检查是否是文件
-    if (!std::filesystem::is_regular_file(path)) {
-        return ToolResult::error("路径不是常规文件: " + path);
+    // 读取整个文件时限制大小，指定limit的窗口读取不受限制
+    if (limit == 0 && file.size() > MAX_FULL_READ_BYTES) {
+        return ToolResult::error("文件过大，超过" + std::to_string(MAX_FULL_READ_BYTES / (1024 * 1024)) +
+                                 "MB限制，请使用offset和limit分段读取");
     }
 
-    // 检查文件大小（10MB限制）
-    const size_t MAX_SIZE_MB = 10;
-    if (!checkFileSize(path, MAX_SIZE_MB)) {
-        return ToolResult::error("文件过大，超过" + std::to_string(MAX_SIZE_MB) + "MB限制");
+    auto index = getLineIndex(path, file);
+    if (!index) {
+        return ToolResult::error("文件在读取期间被截断: " + path);
+    }
+    size_t totalLines = index->lineCount();
+    size_t startLine = static_cast<size_t>(offset);
+    if (totalLines > 0 && startLine >= totalLines) {
+        return ToolResult::error("offset超出文件行数");
     }
 
-    // 读取文件
-    int totalLines = 0;
-    std::string error;
-    std::string content = readFile(path, offset, limit, totalLines, error);
+    // 窗口内的行在文件中是连续的，一次读出；不访问映射，文件被截断时不会触发SIGBUS
+    size_t endLine = limit > 0 ? std::min(startLine + static_cast<size_t>(limit), totalLines) : totalLines;
+    size_t begin = index->lineStart(file, startLine);
+    size_t end = std::max(begin, index->lineStart(file, endLine));
 
-    if (!error.empty()) {
-        return ToolResult::error(error);
+    std::string content;
+    content.reserve(end - begin + 1);
+    content.resize(end - begin);
+    if (file.read(begin, content.size(), content.data()) != content.size()) {
+        return ToolResult::error("文件在读取期间被截断: " + path);
+    }
+    if (!content.empty() && content.back() != '\n') {
+        content += '\n';
     }
 
     // 构建元数据
+    int lines_read = static_cast<int>(endLine > startLine ? endLine - startLine : 0);
     json metadata;
     metadata["path"] = path;
     metadata["total_lines"] = totalLines;
-    int lines_read = limit > 0 ? std::min(limit, totalLines - offset) : totalLines - offset;
     metadata["lines_read"] = lines_read;
     metadata["offset"] = offset;
     metadata["encoding"] = detectEncoding(path);
-    metadata["file_size"] = std::filesystem::file_size(path);
+    metadata["file_size"] = file.size();
 
     LOG_DEBUG("文件读取成功: " + std::to_string(lines_read) + " 行");
 
     return ToolResult::ok(content, metadata);
 }
 
-std::string ReadTool::readFile(const std::string& path, int offset, int limit,
-                                int& totalLines, std::string& error) {
-    std::vector<std::string> lines = readLines(path, offset, limit);
-    totalLines = lines.size();
-
-    if (lines.empty()) {
-        return "";
+ToolAccess ReadTool::describeAccess(const json& params) const {
+    std::string path = getStringParam(params, "path");
+    if (path.empty()) {
+        return ToolAccess::unknown();
     }
+    return ToolAccess().reads(path);
+}
 
-    // 如果指定了offset和limit，实际读取的行数可能不同
-    if (offset >= static_cast<int>(lines.size())) {
-        error = "offset超出文件行数";
-        return "";
+std::shared_ptr<const LineIndex> ReadTool::getLineIndex(const std::string& path, const MappedFile& file) {
+    std::error_code ec;
+    std::string key = std::filesystem::absolute(path, ec).lexically_normal().string();
+    if (ec) {
+        key = path;
     }
 
-    // 构建内容
-    std::stringstream ss;
-    int startLine = offset;
-    int endLine = limit > 0 ? std::min(offset + limit, static_cast<int>(lines.size()))
-                            : static_cast<int>(lines.size());
-
-    for (int i = startLine; i < endLine; ++i) {
-        ss << lines[i] << "\n";
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        auto it = index_cache_.find(key);
+        if (it != index_cache_.end() && it->second.stamp == file.stamp()) {
+            it->second.last_used = ++index_clock_;
+            return it->second.index;
+        }
     }
 
-    return ss.str();
-}
-
-std::vector<std::string> ReadTool::readLines(const std::string& path, int offset, int limit) {
-    std::vector<std::string> lines;
-    std::ifstream file(path);
-
-    if (!file.is_open()) {
-        return lines;
+    // 在锁外扫描文件，不阻塞其他文件的读取
+    file.adviseSequential();
+    LineIndex built;
+    if (!LineIndex::build(file, built)) {
+        return nullptr;
     }
+    auto index = std::make_shared<const LineIndex>(std::move(built));
+
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_cache_[key] = IndexCacheEntry{file.stamp(), index, ++index_clock_};
 
-    std::string line;
-    while (std::getline(file, line)) {
-        lines.push_back(line);
+    // 淘汰最久未使用的索引
+    if (index_cache_.size() > MAX_CACHED_INDEXES) {
+        auto oldest = std::min_element(index_cache_.begin(), index_cache_.end(),
+            [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+        index_cache_.erase(oldest);
     }
 
-    return lines;
+    return index;
 }
 
 std::string ReadTool::detectEncoding(const std::string& path) {
@@ -148,14 +161,4 @@ std::string ReadTool::detectEncoding(const std::string& path) {
     return "UTF-8";
 }
 
-bool ReadTool::checkFileSize(const std::string& path, size_t maxSizeMB) {
-    try {
-        size_t fileSize = std::filesystem::file_size(path);
-        size_t maxSizeBytes = maxSizeMB * 1024 * 1024;
-        return fileSize <= maxSizeBytes;
-    } catch (...) {
-        return false;
-    }
-}
-
 } // namespace roboclaw
@@ -4,8 +4,13 @@
 #define ROBOCLAW_TOOLS_READ_TOOL_H
 
 #include "tool_base.h"
+#include "../utils/mapped_file.h"
+#include <cstdint>
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace roboclaw {
@@ -24,19 +29,31 @@ public:
     // 执行工具
     ToolResult execute(const json& params) override;
 
+    // 描述资源访问（用于并发冲突分析）
+    ToolAccess describeAccess(const json& params) const override;
+
 private:
-    // 读取文件内容
-    std::string readFile(const std::string& path, int offset, int limit,
-                        int& totalLines, std::string& error);
+    // 不指定limit时读取整个文件的大小上限
+    static constexpr uint64_t MAX_FULL_READ_BYTES = 10 * 1024 * 1024;
+
+    // 行索引缓存的最大文件数
+    static constexpr size_t MAX_CACHED_INDEXES = 32;
+
+    // 获取文件的行索引（按路径缓存，文件大小、修改时间或inode变化时重建）；文件在扫描期间被截断时返回nullptr
+    std::shared_ptr<const LineIndex> getLineIndex(const std::string& path, const MappedFile& file);
 
     // 检测文件编码
     std::string detectEncoding(const std::string& path);
 
-    // 读取文件的指定行
-    std::vector<std::string> readLines(const std::string& path, int offset, int limit);
+    struct IndexCacheEntry {
+        FileStamp stamp;
+        std::shared_ptr<const LineIndex> index;
+        uint64_t last_used = 0;
+    };
 
-    // 检查文件大小
-    bool checkFileSize(const std::string& path, size_t maxSizeMB);
+    std::mutex index_mutex_;
+    std::unordered_map<std::string, IndexCacheEntry> index_cache_;
+    uint64_t index_clock_ = 0;
 };
 
 } // namespace roboclaw
@@ -376,6 +376,21 @@ ToolResult SerialTool::execute(const json& params) {
     return ToolResult::error("Unknown action: " + action_str);
 }
 
+ToolAccess SerialTool::describeAccess(const json& params) const {
+    // 列出串口不占用设备；其他操作独占所访问的端口
+    std::string action = getStringParam(params, "action");
+    if (action == "list") {
+        return ToolAccess::pureAccess();
+    }
+    std::string port = getStringParam(params, "port");
+    if (port.empty()) {
+        return ToolAccess::unknown();
+    }
+    // 同一端口可能有多种写法（如 /dev/serial/by-id/ 下的符号链接），
+    // 同时按设备节点路径声明写入，解析链接后相同的端口也会判为冲突
+    return ToolAccess().exclusive(port).writes(port);
+}
+
 SerialConfig SerialTool::parseConfig(const json& params) const {
     SerialConfig config;
     config.baud_rate = getIntParam(params, "baud_rate", 115200);
@@ -69,6 +69,9 @@ public:
     // 执行工具
     ToolResult execute(const json& params) override;
 
+    // 描述资源访问（用于并发冲突分析）
+    ToolAccess describeAccess(const json& params) const override;
+
     // 列出可用串口
     ToolResult listPorts();
 
@@ -5,10 +5,100 @@
 #include <shared_mutex>
 #include <nlohmann/json.hpp>
 #include <typeinfo>
+#include <filesystem>
 
 namespace roboclaw {
 
+// ToolAccess实现
+ToolAccess ToolAccess::pureAccess() {
+    ToolAccess access;
+    access.pure = true;
+    return access;
+}
+
+ToolAccess ToolAccess::unknown() {
+    ToolAccess access;
+    access.global = true;
+    return access;
+}
+
+ToolAccess& ToolAccess::reads(const std::string& path) {
+    resources.push_back({Mode::READ, "path:" + normalizePath(path)});
+    return *this;
+}
+
+ToolAccess& ToolAccess::writes(const std::string& path) {
+    resources.push_back({Mode::WRITE, "path:" + normalizePath(path)});
+    return *this;
+}
+
+ToolAccess& ToolAccess::exclusive(const std::string& device) {
+    resources.push_back({Mode::EXCLUSIVE, "device:" + device});
+    return *this;
+}
+
+namespace {
+
+// 两个资源是否重叠（路径资源：相同或存在父子目录关系）
+bool resourcesOverlap(const std::string& a, const std::string& b) {
+    if (a == b) {
+        return true;
+    }
+    if (a.compare(0, 5, "path:") != 0 || b.compare(0, 5, "path:") != 0) {
+        return false;
+    }
+    const std::string& shorter = a.size() < b.size() ? a : b;
+    const std::string& longer = a.size() < b.size() ? b : a;
+    return longer.compare(0, shorter.size(), shorter) == 0 &&
+           (shorter.back() == '/' || longer[shorter.size()] == '/');
+}
+
+} // namespace
+
+bool ToolAccess::conflictsWith(const ToolAccess& other) const {
+    if (pure || other.pure) {
+        return false;
+    }
+    if (global || other.global) {
+        return true;
+    }
+    for (const auto& mine : resources) {
+        for (const auto& theirs : other.resources) {
+            if (mine.mode == Mode::READ && theirs.mode == Mode::READ) {
+                continue;
+            }
+            if (resourcesOverlap(mine.key, theirs.key)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string ToolAccess::normalizePath(const std::string& path) {
+    // 解析符号链接，避免同一文件的不同写法被判为不冲突
+    std::error_code ec;
+    std::filesystem::path resolved = std::filesystem::weakly_canonical(path, ec);
+    if (ec) {
+        resolved = std::filesystem::absolute(path, ec);
+        if (ec) {
+            return path;
+        }
+    }
+    std::string normalized = resolved.lexically_normal().generic_string();
+    // 去掉目录路径结尾的 '/'（根目录除外）
+    while (normalized.size() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
 // ToolBase实现
+ToolAccess ToolBase::describeAccess(const json& params) const {
+    (void)params;
+    return ToolAccess::unknown();
+}
+
 bool ToolBase::validateParams(const json& params) const {
     // 默认实现：子类可以覆盖
     return true;
@@ -96,6 +186,7 @@ ToolRegistry& ToolRegistry::getInstance() {
 void ToolRegistry::registerTool(const std::string& name, std::shared_ptr<ToolBase> tool) {
     std::unique_lock<std::shared_mutex> lock(tools_mutex_);
     tools_[name] = tool;
+    version_.fetch_add(1, std::memory_order_release);
     LOG_DEBUG("工具已注册: " + name);
 }
 
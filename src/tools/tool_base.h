@@ -5,10 +5,13 @@
 #define ROBOCLAW_TOOLS_TOOL_BASE_H
 
 #include <string>
+#include <vector>
 #include <map>
 #include <functional>
 #include <memory>
 #include <shared_mutex>
+#include <atomic>
+#include <cstdint>
 #include "../utils/logger.h"
 
 // 使用nlohmann/json处理参数
@@ -60,10 +63,11 @@ struct ToolResult {
 // 工具参数描述
 struct ToolParam {
     std::string name;
-    std::string type;      // "string", "integer", "boolean"
+    std::string type;      // "string", "integer", "boolean", "array"
     std::string description;
     bool required;
     std::string default_value;  // 默认值（字符串形式）
+    json items = nullptr;       // type为"array"时元素的JSON Schema
 
     json toJson() const {
         json j;
@@ -74,6 +78,9 @@ struct ToolParam {
         if (!default_value.empty()) {
             j["default"] = default_value;
         }
+        if (!items.is_null()) {
+            j["items"] = items;
+        }
         return j;
     }
 };
@@ -99,6 +106,49 @@ struct ToolDescription {
     }
 };
 
+// 工具调用的资源访问声明（用于并发冲突分析）
+//
+// 资源以 "命名空间:标识" 表示，例如 "path:/abs/file" 或 "device:/dev/ttyUSB0"。
+// 两个调用访问同一资源（路径资源包含父子目录关系）且至少一方为写或独占时冲突，
+// 冲突的调用必须按原始顺序执行，其余调用可以并行。
+struct ToolAccess {
+    enum class Mode {
+        READ,       // 只读，可与其他读并行
+        WRITE,      // 写入，与任何访问冲突
+        EXCLUSIVE   // 独占设备，与任何访问冲突
+    };
+
+    struct Resource {
+        Mode mode;
+        std::string key;
+    };
+
+    bool pure = false;     // 无副作用，不与任何调用冲突
+    bool global = false;   // 副作用未知，与所有非pure调用冲突
+    std::vector<Resource> resources;
+
+    // 无副作用
+    static ToolAccess pureAccess();
+
+    // 副作用未知（保守：串行执行）
+    static ToolAccess unknown();
+
+    // 读取路径
+    ToolAccess& reads(const std::string& path);
+
+    // 写入路径
+    ToolAccess& writes(const std::string& path);
+
+    // 独占设备
+    ToolAccess& exclusive(const std::string& device);
+
+    // 是否与另一个调用冲突
+    bool conflictsWith(const ToolAccess& other) const;
+
+    // 规范化路径（绝对路径，消除 . 和 ..）
+    static std::string normalizePath(const std::string& path);
+};
+
 // 工具基类
 class ToolBase {
 public:
@@ -122,6 +172,9 @@ public:
     // 执行工具
     virtual ToolResult execute(const json& params) = 0;
 
+    // 描述一次调用将访问的资源（默认副作用未知，保守串行）
+    virtual ToolAccess describeAccess(const json& params) const;
+
 protected:
     std::string name_;
     std::string description_;
@@ -162,10 +215,14 @@ public:
     // 检查工具是否存在
     bool hasTool(const std::string& name) const;
 
+    // 获取注册表版本（每次注册工具递增，用于失效工具Schema缓存）
+    uint64_t getVersion() const { return version_.load(std::memory_order_acquire); }
+
 private:
     ToolRegistry() = default;
 
     std::map<std::string, std::shared_ptr<ToolBase>> tools_;
+    std::atomic<uint64_t> version_{1};
 
     // 读写锁保证线程安全
     mutable std::shared_mutex tools_mutex_;
@@ -0,0 +1,930 @@
+// WebDriver / CDP 客户端实现
+
+#include "webdriver_client.h"
+#include "../utils/logger.h"
+
+#ifndef PLATFORM_WINDOWS
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace roboclaw {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// SOCK_CLOEXEC和MSG_NOSIGNAL是Linux扩展；macOS上改用fcntl(FD_CLOEXEC)和SO_NOSIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+int openSocket(int family, int type, int protocol) {
+#ifdef SOCK_CLOEXEC
+    return ::socket(family, type | SOCK_CLOEXEC, protocol);
+#else
+    int fd = ::socket(family, type, protocol);
+    if (fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#endif
+}
+
+int remainingMs(Clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+// HTTP响应
+struct HttpReply {
+    int status = 0;
+    std::map<std::string, std::string> headers;   // 键为小写
+    std::string body;
+};
+
+enum class ParseResult { INCOMPLETE, DONE, FAILED };
+
+// 从buffer开头解析一个完整的HTTP响应，成功时移除已解析的数据
+// eof表示连接已关闭（无Content-Length时以关闭为结束）
+ParseResult parseReply(std::string& buffer, HttpReply& reply, bool eof) {
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return eof ? ParseResult::FAILED : ParseResult::INCOMPLETE;
+    }
+
+    reply = HttpReply();
+    size_t lineEnd = buffer.find("\r\n");
+    std::string statusLine = buffer.substr(0, lineEnd);
+    size_t space = statusLine.find(' ');
+    if (statusLine.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+        return ParseResult::FAILED;
+    }
+    reply.status = std::atoi(statusLine.c_str() + space + 1);
+
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = buffer.find("\r\n", pos);
+        size_t colon = buffer.find(':', pos);
+        if (colon != std::string::npos && colon < end) {
+            std::string name = buffer.substr(pos, colon - pos);
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            size_t valueStart = buffer.find_first_not_of(' ', colon + 1);
+            reply.headers[name] = valueStart < end ? buffer.substr(valueStart, end - valueStart) : "";
+        }
+        pos = end + 2;
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    auto header = [&](const char* name) {
+        auto it = reply.headers.find(name);
+        return it == reply.headers.end() ? std::string() : it->second;
+    };
+
+    if (header("transfer-encoding").find("chunked") != std::string::npos) {
+        size_t cursor = bodyStart;
+        std::string body;
+        while (true) {
+            size_t sizeEnd = buffer.find("\r\n", cursor);
+            if (sizeEnd == std::string::npos) {
+                return eof ? ParseResult::FAILED : ParseResult::INCOMPLETE;
+            }
+            size_t chunkSize = std::strtoul(buffer.c_str() + cursor, nullptr, 16);
+            size_t dataStart = sizeEnd + 2;
+            if (chunkSize == 0) {
+                // 末尾块之后可能有trailer，以空行结束
+                size_t trailerEnd = buffer.find("\r\n", dataStart);
+                while (trailerEnd != std::string::npos && trailerEnd != dataStart) {
+                    dataStart = trailerEnd + 2;
+                    trailerEnd = buffer.find("\r\n", dataStart);
+                }
+                if (trailerEnd == std::string::npos) {
+                    return eof ? ParseResult::FAILED : ParseResult::INCOMPLETE;
+                }
+                reply.body = std::move(body);
+                buffer.erase(0, trailerEnd + 2);
+                return ParseResult::DONE;
+            }
+            if (buffer.size() < dataStart + chunkSize + 2) {
+                return eof ? ParseResult::FAILED : ParseResult::INCOMPLETE;
+            }
+            body.append(buffer, dataStart, chunkSize);
+            cursor = dataStart + chunkSize + 2;
+        }
+    }
+
+    std::string contentLength = header("content-length");
+    if (!contentLength.empty()) {
+        size_t length = std::strtoul(contentLength.c_str(), nullptr, 10);
+        if (buffer.size() < bodyStart + length) {
+            return eof ? ParseResult::FAILED : ParseResult::INCOMPLETE;
+        }
+        reply.body = buffer.substr(bodyStart, length);
+        buffer.erase(0, bodyStart + length);
+        return ParseResult::DONE;
+    }
+
+    if (reply.status == 101 || reply.status == 204 || reply.status == 304 || reply.status / 100 == 1) {
+        buffer.erase(0, bodyStart);
+        return ParseResult::DONE;
+    }
+
+    // 没有长度信息：读到连接关闭为止
+    if (!eof) {
+        return ParseResult::INCOMPLETE;
+    }
+    reply.body = buffer.substr(bodyStart);
+    buffer.clear();
+    return ParseResult::DONE;
+}
+
+// 读取一个完整响应
+bool readReply(TcpConnection& connection, std::string& buffer, HttpReply& reply,
+               Clock::time_point deadline, std::string& error) {
+    while (true) {
+        bool eof = !connection.isOpen();
+        ParseResult result = parseReply(buffer, reply, eof);
+        if (result == ParseResult::DONE) {
+            return true;
+        }
+        if (result == ParseResult::FAILED) {
+            error = eof ? "连接已关闭" : "无效的HTTP响应";
+            return false;
+        }
+        if (!connection.receive(buffer, remainingMs(deadline)) && connection.isOpen()) {
+            error = "等待响应超时";
+            return false;
+        }
+    }
+}
+
+std::string buildRequest(const std::string& method, const std::string& host, int port,
+                         const std::string& path, const std::string& body, bool keepAlive) {
+    std::string request;
+    request.reserve(160 + path.size() + body.size());
+    request += method + " " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host + ":" + std::to_string(port) + "\r\n";
+    request += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    if (method == "POST" || !body.empty()) {
+        request += "Content-Type: application/json; charset=utf-8\r\n";
+        request += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    request += "\r\n";
+    request += body;
+    return request;
+}
+
+WebDriverReply toWebDriverReply(const HttpReply& http) {
+    WebDriverReply reply;
+    reply.status = http.status;
+
+    json body = json::parse(http.body, nullptr, false);
+    if (body.is_discarded()) {
+        reply.error = "无效的响应内容 (HTTP " + std::to_string(http.status) + ")";
+        return reply;
+    }
+    if (body.is_object() && body.contains("value")) {
+        reply.value = body["value"];
+    }
+
+    // W3C错误：{"value": {"error": ..., "message": ...}}
+    if (reply.value.is_object() && reply.value.contains("error")) {
+        reply.error = reply.value.value("error", "") + ": " + reply.value.value("message", "");
+    } else if (http.status != 200) {
+        reply.error = "HTTP " + std::to_string(http.status);
+    }
+    reply.ok = reply.error.empty();
+    return reply;
+}
+
+std::string base64Encode(std::string_view data) {
+    static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t n = (static_cast<uint8_t>(data[i]) << 16) | (static_cast<uint8_t>(data[i + 1]) << 8) |
+                     static_cast<uint8_t>(data[i + 2]);
+        out += table[(n >> 18) & 63];
+        out += table[(n >> 12) & 63];
+        out += table[(n >> 6) & 63];
+        out += table[n & 63];
+    }
+    if (i < data.size()) {
+        uint32_t n = static_cast<uint8_t>(data[i]) << 16;
+        if (i + 1 < data.size()) {
+            n |= static_cast<uint8_t>(data[i + 1]) << 8;
+        }
+        out += table[(n >> 18) & 63];
+        out += table[(n >> 12) & 63];
+        out += i + 1 < data.size() ? table[(n >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+std::mt19937& randomEngine() {
+    thread_local std::mt19937 engine{std::random_device{}()};
+    return engine;
+}
+
+// 解析ws://host:port/path
+bool parseWebSocketUrl(const std::string& url, std::string& host, int& port, std::string& path) {
+    const std::string scheme = "ws://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+    size_t hostStart = scheme.size();
+    size_t pathStart = url.find('/', hostStart);
+    std::string authority = url.substr(hostStart, pathStart - hostStart);
+    path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+
+    size_t colon = authority.rfind(':');
+    if (colon == std::string::npos) {
+        host = authority;
+        port = 80;
+    } else {
+        host = authority.substr(0, colon);
+        port = std::atoi(authority.c_str() + colon + 1);
+    }
+    return !host.empty() && port > 0;
+}
+
+} // namespace
+
+// ==================== TcpConnection ====================
+
+bool TcpConnection::connect(const std::string& host, int port, int timeoutMs) {
+    close();
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        int fd = openSocket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        int noSigpipe = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+
+        // 非阻塞connect以支持超时
+        int flags = ::fcntl(fd, F_GETFL, 0);
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int rc = ::connect(fd, address->ai_addr, address->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            pollfd pfd{fd, POLLOUT, 0};
+            int soError = 0;
+            socklen_t length = sizeof(soError);
+            rc = (::poll(&pfd, 1, timeoutMs) == 1 &&
+                  ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &soError, &length) == 0 && soError == 0) ? 0 : -1;
+        }
+        if (rc != 0) {
+            ::close(fd);
+            continue;
+        }
+
+        ::fcntl(fd, F_SETFL, flags);
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fd_ = fd;
+        break;
+    }
+
+    ::freeaddrinfo(addresses);
+    return fd_ >= 0;
+}
+
+void TcpConnection::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool TcpConnection::sendAll(std::string_view data) {
+    while (!data.empty()) {
+        if (fd_ < 0) {
+            return false;
+        }
+        ssize_t n = ::send(fd_, data.data(), data.size(), SEND_FLAGS);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close();
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+bool TcpConnection::receive(std::string& buffer, int timeoutMs) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    pollfd pfd{fd_, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&pfd, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0) {
+        return false;
+    }
+
+    char chunk[64 * 1024];
+    ssize_t n;
+    do {
+        n = ::recv(fd_, chunk, sizeof(chunk), 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        close();
+        return false;
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+    return true;
+}
+
+// ==================== WebDriverClient ====================
+
+WebDriverClient::WebDriverClient(const std::string& host, int port)
+    : host_(host), port_(port) {
+}
+
+bool WebDriverClient::ensureConnected() {
+    if (connection_.isOpen()) {
+        return true;
+    }
+    buffer_.clear();
+    if (!connection_.connect(host_, port_, std::min(timeout_ms_, 5000))) {
+        return false;
+    }
+    connection_count_++;
+    return true;
+}
+
+bool WebDriverClient::roundTrip(const std::vector<WebDriverCommand>& commands,
+                                std::vector<WebDriverReply>& replies,
+                                bool& answered) {
+    answered = false;
+    if (!ensureConnected()) {
+        for (size_t i = replies.size(); i < commands.size(); ++i) {
+            WebDriverReply failed;
+            failed.error = "无法连接WebDriver: " + host_ + ":" + std::to_string(port_);
+            replies.push_back(failed);
+        }
+        return false;
+    }
+
+    // 一次写出全部请求
+    std::string requests;
+    for (const auto& command : commands) {
+        std::string body = command.body.is_null() ? (command.method == "POST" ? "{}" : "")
+                                                  : command.body.dump();
+        requests += buildRequest(command.method, host_, port_, command.path, body, true);
+    }
+    if (!connection_.sendAll(requests)) {
+        return false;
+    }
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms_);
+    for (size_t i = 0; i < commands.size(); ++i) {
+        HttpReply http;
+        std::string error;
+        if (!readReply(connection_, buffer_, http, deadline, error)) {
+            // 响应流已不同步，断开连接
+            connection_.close();
+            for (; i < commands.size(); ++i) {
+                WebDriverReply failed;
+                failed.error = error;
+                replies.push_back(failed);
+            }
+            return false;
+        }
+        answered = true;
+        replies.push_back(toWebDriverReply(http));
+        auto connectionHeader = http.headers.find("connection");
+        if (connectionHeader != http.headers.end() && connectionHeader->second == "close") {
+            connection_.close();
+        }
+    }
+    return true;
+}
+
+WebDriverReply WebDriverClient::command(const std::string& method, const std::string& path, const json& body) {
+    return pipeline({{method, path, body}})[0];
+}
+
+std::vector<WebDriverReply> WebDriverClient::pipeline(const std::vector<WebDriverCommand>& commands) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<WebDriverReply> replies;
+    if (commands.empty()) {
+        return replies;
+    }
+
+    // 复用的连接可能已被驱动关闭：尚未收到任何响应时重连重试一次
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool reused = connection_.isOpen();
+        bool answered = false;
+        replies.clear();
+        if (roundTrip(commands, replies, answered)) {
+            break;
+        }
+        if (!reused || answered) {
+            break;
+        }
+        connection_.close();
+    }
+
+    // 失败时补齐结果
+    while (replies.size() < commands.size()) {
+        WebDriverReply failed;
+        failed.error = "连接已断开";
+        replies.push_back(failed);
+    }
+    return replies;
+}
+
+bool WebDriverClient::waitUntilReady(int timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        WebDriverReply reply = command("GET", "/status");
+        if (reply.ok && reply.value.value("ready", true)) {
+            return true;
+        }
+        if (Clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+bool WebDriverClient::createSession(const json& capabilities, json* returned) {
+    WebDriverReply reply = command("POST", "/session", {{"capabilities", capabilities}});
+    if (!reply.ok || !reply.value.is_object() || !reply.value.contains("sessionId")) {
+        LOG_ERROR("创建WebDriver会话失败: " + reply.error);
+        return false;
+    }
+    session_id_ = reply.value["sessionId"].get<std::string>();
+    if (returned) {
+        *returned = reply.value.value("capabilities", json::object());
+    }
+    return true;
+}
+
+bool WebDriverClient::deleteSession() {
+    if (session_id_.empty()) {
+        return true;
+    }
+    WebDriverReply reply = command("DELETE", sessionPath(""));
+    session_id_.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    connection_.close();
+    return reply.ok;
+}
+
+std::string WebDriverClient::sessionPath(const std::string& suffix) const {
+    return "/session/" + session_id_ + suffix;
+}
+
+// ==================== CdpClient ====================
+
+bool CdpClient::connect(const std::string& webSocketUrl, int timeoutMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string host;
+    std::string path;
+    int port = 0;
+    if (!parseWebSocketUrl(webSocketUrl, host, port, path)) {
+        last_error_ = "无效的WebSocket地址: " + webSocketUrl;
+        return false;
+    }
+    if (!connection_.connect(host, port, timeoutMs)) {
+        last_error_ = "无法连接DevTools: " + webSocketUrl;
+        return false;
+    }
+
+    std::string key(16, '\0');
+    for (auto& c : key) {
+        c = static_cast<char>(randomEngine()() & 0xff);
+    }
+    std::string request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + host + ":" + std::to_string(port) + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + base64Encode(key) + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+
+    // 本机端点，只检查101状态，不校验Sec-WebSocket-Accept
+    buffer_.clear();
+    fragments_.clear();
+    HttpReply reply;
+    std::string error;
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    if (!connection_.sendAll(request) || !readReply(connection_, buffer_, reply, deadline, error) ||
+        reply.status != 101) {
+        last_error_ = "WebSocket握手失败: " + (error.empty() ? "HTTP " + std::to_string(reply.status) : error);
+        connection_.close();
+        return false;
+    }
+
+    results_.clear();
+    events_.clear();
+    inflight_.clear();
+    last_network_activity_ = Clock::now();
+    return true;
+}
+
+void CdpClient::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (connection_.isOpen()) {
+        sendFrame(0x8, "");
+        connection_.close();
+    }
+}
+
+std::string CdpClient::findPageWebSocketUrl(const std::string& host, int port, int timeoutMs) {
+    TcpConnection connection;
+    if (!connection.connect(host, port, timeoutMs)) {
+        return "";
+    }
+
+    std::string buffer;
+    HttpReply reply;
+    std::string error;
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    if (!connection.sendAll(buildRequest("GET", host, port, "/json/list", "", false)) ||
+        !readReply(connection, buffer, reply, deadline, error) || reply.status != 200) {
+        return "";
+    }
+
+    json targets = json::parse(reply.body, nullptr, false);
+    if (!targets.is_array()) {
+        return "";
+    }
+    for (const auto& target : targets) {
+        if (target.value("type", "") == "page" && target.contains("webSocketDebuggerUrl")) {
+            return target["webSocketDebuggerUrl"].get<std::string>();
+        }
+    }
+    return "";
+}
+
+bool CdpClient::sendFrame(uint8_t opcode, std::string_view payload) {
+    std::string frame;
+    frame.reserve(payload.size() + 14);
+    frame += static_cast<char>(0x80 | opcode);
+
+    // 客户端帧必须带掩码
+    if (payload.size() < 126) {
+        frame += static_cast<char>(0x80 | payload.size());
+    } else if (payload.size() <= 0xffff) {
+        frame += static_cast<char>(0x80 | 126);
+        frame += static_cast<char>((payload.size() >> 8) & 0xff);
+        frame += static_cast<char>(payload.size() & 0xff);
+    } else {
+        frame += static_cast<char>(0x80 | 127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xff);
+        }
+    }
+
+    uint32_t maskKey = randomEngine()();
+    char mask[4] = {static_cast<char>(maskKey >> 24), static_cast<char>(maskKey >> 16),
+                    static_cast<char>(maskKey >> 8), static_cast<char>(maskKey)};
+    frame.append(mask, 4);
+    size_t start = frame.size();
+    frame.append(payload);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame[start + i] ^= mask[i & 3];
+    }
+    return connection_.sendAll(frame);
+}
+
+bool CdpClient::sendText(const std::string& payload) {
+    if (!sendFrame(0x1, payload)) {
+        last_error_ = "DevTools连接已断开";
+        return false;
+    }
+    return true;
+}
+
+bool CdpClient::nextMessage(std::string& message, Clock::time_point deadline) {
+    while (true) {
+        // 尝试从缓冲区解析一帧
+        if (buffer_.size() >= 2) {
+            const auto* bytes = reinterpret_cast<const uint8_t*>(buffer_.data());
+            bool fin = bytes[0] & 0x80;
+            uint8_t opcode = bytes[0] & 0x0f;
+            bool masked = bytes[1] & 0x80;
+            uint64_t length = bytes[1] & 0x7f;
+            size_t pos = 2;
+            bool complete = true;
+            if (length == 126) {
+                complete = buffer_.size() >= 4;
+                if (complete) {
+                    length = (static_cast<uint64_t>(bytes[2]) << 8) | bytes[3];
+                }
+                pos = 4;
+            } else if (length == 127) {
+                complete = buffer_.size() >= 10;
+                if (complete) {
+                    length = 0;
+                    for (int i = 0; i < 8; ++i) {
+                        length = (length << 8) | bytes[2 + i];
+                    }
+                }
+                pos = 10;
+            }
+            size_t maskPos = pos;
+            if (masked) {
+                pos += 4;
+            }
+            complete = complete && buffer_.size() >= pos + length;
+
+            if (complete) {
+                std::string payload = buffer_.substr(pos, length);
+                if (masked) {
+                    for (size_t i = 0; i < payload.size(); ++i) {
+                        payload[i] ^= buffer_[maskPos + (i & 3)];
+                    }
+                }
+                buffer_.erase(0, pos + length);
+
+                switch (opcode) {
+                    case 0x0:   // 续帧
+                        fragments_ += payload;
+                        if (fin) {
+                            message = std::move(fragments_);
+                            fragments_.clear();
+                            return true;
+                        }
+                        break;
+                    case 0x1:
+                    case 0x2:
+                        if (fin) {
+                            message = std::move(payload);
+                            return true;
+                        }
+                        fragments_ = std::move(payload);
+                        break;
+                    case 0x8:   // 关闭
+                        sendFrame(0x8, "");
+                        connection_.close();
+                        last_error_ = "DevTools连接已关闭";
+                        return false;
+                    case 0x9:   // ping
+                        sendFrame(0xA, payload);
+                        break;
+                    default:
+                        break;
+                }
+                continue;
+            }
+        }
+
+        if (!connection_.isOpen()) {
+            last_error_ = "DevTools连接已断开";
+            return false;
+        }
+        int wait = remainingMs(deadline);
+        if (!connection_.receive(buffer_, wait)) {
+            last_error_ = connection_.isOpen() ? "等待DevTools响应超时" : "DevTools连接已断开";
+            return false;
+        }
+    }
+}
+
+void CdpClient::dispatch(const std::string& message) {
+    json j = json::parse(message, nullptr, false);
+    if (!j.is_object()) {
+        return;
+    }
+
+    if (j.contains("id")) {
+        // 本端发出的id都是整数；其他id的消息不可能是本端调用的结果，忽略
+        if (!j["id"].is_number_integer()) {
+            LOG_DEBUG("忽略id不是整数的CDP消息: " + j["id"].dump());
+            return;
+        }
+        int id = j["id"].get<int>();
+        results_[id] = std::move(j);
+        return;
+    }
+
+    std::string method = j.value("method", "");
+    if (method.empty()) {
+        return;
+    }
+
+    // 网络事件只用于跟踪进行中的请求，不进入队列
+    if (method.compare(0, 8, "Network.") == 0) {
+        json params = j.value("params", json::object());
+        std::string requestId = params.is_object() ? params.value("requestId", "") : "";
+        if (method == "Network.requestWillBeSent") {
+            inflight_.insert(requestId);
+            last_network_activity_ = Clock::now();
+        } else if (method == "Network.loadingFinished" || method == "Network.loadingFailed") {
+            inflight_.erase(requestId);
+            last_network_activity_ = Clock::now();
+        }
+        return;
+    }
+
+    json params = j.value("params", json::object());
+
+    // 记录每种事件最近一次的序号；子框架的导航不算页面导航
+    ++event_sequence_;
+    bool subframe = method == "Page.frameNavigated" && params.is_object() &&
+                    params.contains("frame") && params["frame"].is_object() &&
+                    params["frame"].contains("parentId");
+    if (!subframe) {
+        last_event_sequence_[method] = event_sequence_;
+    }
+
+    events_.emplace_back(std::move(method), std::move(params));
+    if (events_.size() > MAX_QUEUED_EVENTS) {
+        events_.pop_front();
+    }
+}
+
+bool CdpClient::pump(Clock::time_point deadline) {
+    std::string message;
+    if (!nextMessage(message, deadline)) {
+        return false;
+    }
+    dispatch(message);
+    return true;
+}
+
+bool CdpClient::takeEvent(const std::string& method, json* params) {
+    for (auto it = events_.begin(); it != events_.end(); ++it) {
+        if (it->first == method) {
+            if (params) {
+                *params = std::move(it->second);
+            }
+            events_.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CdpClient::awaitResults(const std::vector<int>& ids, std::vector<json>& results,
+                             Clock::time_point deadline) {
+    for (int id : ids) {
+        while (results_.find(id) == results_.end()) {
+            if (!pump(deadline)) {
+                return false;
+            }
+        }
+    }
+
+    for (int id : ids) {
+        auto it = results_.find(id);
+        json& reply = it->second;
+        if (reply.contains("error")) {
+            last_error_ = reply["error"].value("message", "CDP错误");
+            results.push_back(nullptr);
+        } else {
+            results.push_back(reply.value("result", json::object()));
+        }
+        results_.erase(it);
+    }
+    return true;
+}
+
+json CdpClient::call(const std::string& method, const json& params, int timeoutMs) {
+    return callBatch({{method, params}}, timeoutMs)[0];
+}
+
+std::vector<json> CdpClient::callBatch(const std::vector<std::pair<std::string, json>>& commands,
+                                       int timeoutMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    // 先全部发出，再统一等待结果
+    std::vector<int> ids;
+    ids.reserve(commands.size());
+    for (const auto& [method, params] : commands) {
+        int id = next_id_++;
+        json message = {{"id", id}, {"method", method}, {"params", params}};
+        if (!sendText(message.dump())) {
+            break;
+        }
+        ids.push_back(id);
+    }
+
+    std::vector<json> results;
+    results.reserve(commands.size());
+    if (ids.size() != commands.size() || !awaitResults(ids, results, deadline)) {
+        // 超时后到达的结果不再需要
+        for (int id : ids) {
+            results_.erase(id);
+        }
+        results.clear();
+    }
+    results.resize(commands.size(), nullptr);
+    return results;
+}
+
+bool CdpClient::waitForEvent(const std::string& method, int timeoutMs, json* params) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!takeEvent(method, params)) {
+        if (!pump(deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CdpClient::waitForEventAfter(const std::string& method, const std::string& after,
+                                  uint64_t since, int timeoutMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (lastSequence(method) <= std::max(lastSequence(after), since)) {
+        if (!pump(deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t CdpClient::eventSequence() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return event_sequence_;
+}
+
+uint64_t CdpClient::lastSequence(const std::string& method) const {
+    auto it = last_event_sequence_.find(method);
+    return it != last_event_sequence_.end() ? it->second : 0;
+}
+
+bool CdpClient::waitForNetworkIdle(int idleMs, int timeoutMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    auto idle = std::chrono::milliseconds(idleMs);
+
+    while (true) {
+        auto now = Clock::now();
+        if (inflight_.empty() && now - last_network_activity_ >= idle) {
+            return true;
+        }
+        if (now >= deadline) {
+            last_error_ = "等待网络空闲超时";
+            return false;
+        }
+
+        // 没有进行中的请求时只需等到空闲窗口结束
+        auto wake = inflight_.empty() ? std::min(last_network_activity_ + idle, deadline) : deadline;
+        if (!pump(wake) && !connection_.isOpen()) {
+            return false;
+        }
+    }
+}
+
+void CdpClient::clearEvents() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    inflight_.clear();
+    last_network_activity_ = Clock::now();
+}
+
+size_t CdpClient::getInflightRequests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inflight_.size();
+}
+
+std::string CdpClient::lastError() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+} // namespace roboclaw
+
+#endif // PLATFORM_WINDOWS
@@ -0,0 +1,193 @@
+// WebDriver / Chrome DevTools Protocol 客户端
+// 进程内实现，替代每条命令fork一次curl的方式
+
+#ifndef ROBOCLAW_TOOLS_WEBDRIVER_CLIENT_H
+#define ROBOCLAW_TOOLS_WEBDRIVER_CLIENT_H
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace roboclaw {
+
+// 阻塞TCP连接（读操作用poll实现超时；仅POSIX）
+class TcpConnection {
+public:
+    TcpConnection() = default;
+    ~TcpConnection() { close(); }
+
+    TcpConnection(const TcpConnection&) = delete;
+    TcpConnection& operator=(const TcpConnection&) = delete;
+
+    bool connect(const std::string& host, int port, int timeoutMs);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    // 发送全部数据
+    bool sendAll(std::string_view data);
+
+    // 读取可用数据追加到buffer；超时、断开或出错返回false（断开时连接被关闭）
+    bool receive(std::string& buffer, int timeoutMs);
+
+private:
+    int fd_ = -1;
+};
+
+// WebDriver命令
+struct WebDriverCommand {
+    std::string method;    // GET / POST / DELETE
+    std::string path;      // 如 /session/<id>/url
+    json body;             // null表示无请求体
+};
+
+// WebDriver命令结果
+struct WebDriverReply {
+    bool ok = false;
+    int status = 0;        // HTTP状态码，0表示连接错误
+    json value;            // 响应中的value字段
+    std::string error;     // 失败原因
+};
+
+// WebDriver客户端（W3C协议）
+//
+// 与驱动（chromedriver/geckodriver）保持一条HTTP/1.1长连接，
+// pipeline()先写出全部请求再按顺序读取响应。连接被驱动关闭时自动重连一次。
+// 线程安全。
+class WebDriverClient {
+public:
+    WebDriverClient(const std::string& host, int port);
+
+    // 轮询/status直到驱动就绪（替代固定等待）
+    bool waitUntilReady(int timeoutMs);
+
+    // 创建会话，返回驱动给出的capabilities
+    bool createSession(const json& capabilities, json* returned = nullptr);
+
+    // 删除会话
+    bool deleteSession();
+
+    const std::string& sessionId() const { return session_id_; }
+
+    // 会话内路径：/session/<id><suffix>
+    std::string sessionPath(const std::string& suffix) const;
+
+    // 执行一条命令
+    WebDriverReply command(const std::string& method, const std::string& path, const json& body = nullptr);
+
+    // 流水线执行多条命令（互不依赖），结果与命令一一对应
+    std::vector<WebDriverReply> pipeline(const std::vector<WebDriverCommand>& commands);
+
+    // 单条命令超时（毫秒）
+    void setTimeout(int milliseconds) { timeout_ms_ = milliseconds; }
+
+    // 已建立的TCP连接数（用于观察连接复用）
+    int getConnectionCount() const { return connection_count_; }
+
+private:
+    // 发送并读取响应，要求调用方持有mutex_
+    bool roundTrip(const std::vector<WebDriverCommand>& commands, std::vector<WebDriverReply>& replies,
+                   bool& answered);
+    bool ensureConnected();
+
+    std::string host_;
+    int port_;
+    TcpConnection connection_;
+    std::string buffer_;          // 已读取但未解析的响应数据
+    std::string session_id_;
+    int timeout_ms_ = 30000;
+    int connection_count_ = 0;
+    std::mutex mutex_;
+};
+
+// Chrome DevTools Protocol客户端（WebSocket）
+//
+// 命令可以流水线发出（callBatch），结果按id匹配。事件在等待结果时一并读取：
+// Network.*事件用于跟踪进行中的请求（网络空闲判断），其余事件进入有界队列供waitForEvent使用。
+// 线程安全（同一时刻只有一个线程读取连接）。
+class CdpClient {
+public:
+    CdpClient() = default;
+
+    CdpClient(const CdpClient&) = delete;
+    CdpClient& operator=(const CdpClient&) = delete;
+
+    // 连接ws://host:port/path
+    bool connect(const std::string& webSocketUrl, int timeoutMs = 5000);
+    void close();
+    bool isConnected() const { return connection_.isOpen(); }
+
+    // 从DevTools HTTP端点（/json/list）查找第一个页面的WebSocket地址
+    static std::string findPageWebSocketUrl(const std::string& host, int port, int timeoutMs = 5000);
+
+    // 调用方法并等待结果；失败返回null，原因见lastError()
+    json call(const std::string& method, const json& params = json::object(), int timeoutMs = 30000);
+
+    // 一次发出多条命令再收集结果，失败的项为null
+    std::vector<json> callBatch(const std::vector<std::pair<std::string, json>>& commands,
+                                int timeoutMs = 30000);
+
+    // 等待事件（包括调用前已到达、尚未被取走的事件）
+    bool waitForEvent(const std::string& method, int timeoutMs, json* params = nullptr);
+
+    // 等待method事件晚于after事件和序号since到达；已经到达时立即返回。
+    // 按事件序号判断，不取走队列中的事件（例如"上次导航之后页面是否已加载"）
+    bool waitForEventAfter(const std::string& method, const std::string& after,
+                           uint64_t since, int timeoutMs);
+
+    // 当前事件序号（每收到一个非网络事件递增）
+    uint64_t eventSequence();
+
+    // 等待网络空闲：没有进行中的请求且持续idleMs
+    bool waitForNetworkIdle(int idleMs, int timeoutMs);
+
+    // 丢弃已到达的事件并重置请求跟踪（导航前调用）
+    void clearEvents();
+
+    // 进行中的网络请求数
+    size_t getInflightRequests();
+
+    std::string lastError();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 以下函数要求调用方持有mutex_
+    bool sendText(const std::string& payload);
+    bool sendFrame(uint8_t opcode, std::string_view payload);
+    bool pump(Clock::time_point deadline);   // 读取并分发至少一条消息
+    bool nextMessage(std::string& message, Clock::time_point deadline);
+    void dispatch(const std::string& message);
+    bool takeEvent(const std::string& method, json* params);
+    uint64_t lastSequence(const std::string& method) const;
+    bool awaitResults(const std::vector<int>& ids, std::vector<json>& results, Clock::time_point deadline);
+
+    static constexpr size_t MAX_QUEUED_EVENTS = 1024;
+
+    TcpConnection connection_;
+    std::string buffer_;        // 未解析的帧数据
+    std::string fragments_;     // 分片消息
+    int next_id_ = 1;
+    std::unordered_map<int, json> results_;
+    std::deque<std::pair<std::string, json>> events_;
+    uint64_t event_sequence_ = 0;
+    std::unordered_map<std::string, uint64_t> last_event_sequence_;  // 每种事件最近一次的序号
+    std::unordered_set<std::string> inflight_;
+    Clock::time_point last_network_activity_ = Clock::now();
+    std::string last_error_;
+    std::mutex mutex_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_TOOLS_WEBDRIVER_CLIENT_H
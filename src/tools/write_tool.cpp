@@ -1,8 +1,10 @@
 // WriteTool实现
 
 #include "write_tool.h"
-#include <sstream>
+#include "../utils/sha256.h"
 #include <algorithm>
+#include <chrono>
+#include <future>
 
 namespace roboclaw {
 
@@ -13,17 +15,47 @@ WriteTool::WriteTool()
 ToolDescription WriteTool::getToolDescription() const {
     ToolDescription desc;
     desc.name = name_;
-    desc.description = description_;
+    desc.description = description_ + "（支持一次写入多个文件）";
 
     desc.parameters = {
-        {"path", "string", "文件路径（必需）", true, ""},
-        {"content", "string", "文件内容（必需）", true, ""}
+        {"path", "string", "文件路径（不使用files时必需）", false, ""},
+        {"content", "string", "文件内容（不使用files时必需）", false, ""},
+        {"files", "array", "批量写入（可选）：每项包含path和content，全部写出成功后才替换文件，"
+                           "内容未变化的文件会被跳过", false, "",
+         json{{"type", "object"},
+              {"properties", {{"path", {{"type", "string"}}}, {"content", {{"type", "string"}}}}},
+              {"required", {"path", "content"}}}}
     };
 
     return desc;
 }
 
 bool WriteTool::validateParams(const json& params) const {
+    if (params.contains("files")) {
+        const auto& files = params["files"];
+        if (!files.is_array() || files.empty()) {
+            return false;
+        }
+
+        std::unordered_map<std::string, bool> seen;
+        for (const auto& file : files) {
+            if (!file.is_object() ||
+                !file.contains("path") || !file["path"].is_string() ||
+                !file.contains("content") || !file["content"].is_string()) {
+                return false;
+            }
+            const auto& path = file["path"].get_ref<const std::string&>();
+            if (path.empty() || !isValidPath(path)) {
+                return false;
+            }
+            // 同一批次不能重复写入同一文件
+            if (!seen.emplace(ToolAccess::normalizePath(path), true).second) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     if (!hasRequiredParam(params, "path")) {
         return false;
     }
@@ -41,87 +73,256 @@ bool WriteTool::validateParams(const json& params) const {
 
 ToolResult WriteTool::execute(const json& params) {
     if (!validateParams(params)) {
-        return ToolResult::error("参数验证失败：path和content都是必需参数");
+        return ToolResult::error("参数验证失败：path和content（或不重复路径的files）都是必需参数");
     }
 
-    std::string path = getStringParam(params, "path");
-    std::string content = getStringParam(params, "content");
+    std::vector<FileWrite> files = parseFiles(params);
+    bool batch = params.contains("files");
 
-    LOG_DEBUG("写入文件: " + path + " (" + std::to_string(content.length()) + " 字节)");
+    size_t totalBytes = 0;
+    for (const auto& file : files) {
+        totalBytes += file.content.size();
+    }
+    LOG_DEBUG("写入 " + std::to_string(files.size()) + " 个文件 (" + std::to_string(totalBytes) + " 字节)");
 
     // 确保目录存在
-    if (!ensureDirectoryExists(path)) {
-        return ToolResult::error("无法创建目录: " + path);
+    for (const auto& file : files) {
+        if (!ensureDirectoryExists(file.path)) {
+            return ToolResult::error("无法创建目录: " + file.path);
+        }
     }
 
     // 写入文件
     std::string error;
-    if (!writeFile(path, content, error)) {
+    json timings;
+    if (!writeFiles(files, error, timings)) {
         return ToolResult::error(error);
     }
 
     // 构建元数据
+    size_t bytesWritten = 0;
+    size_t written = 0;
+    json fileList = json::array();
+    for (const auto& file : files) {
+        if (!file.unchanged) {
+            bytesWritten += file.content.size();
+            ++written;
+        }
+        fileList.push_back({{"path", file.path},
+                            {"bytes", file.content.size()},
+                            {"status", file.unchanged ? "unchanged" : (file.existed ? "overwritten" : "created")}});
+    }
+
     json metadata;
-    metadata["path"] = path;
-    metadata["bytes_written"] = content.length();
-    metadata["overwrite"] = std::filesystem::exists(path);
+    metadata["bytes_written"] = bytesWritten;
+    metadata["files_written"] = written;
+    metadata["files_unchanged"] = files.size() - written;
+    metadata["timings_ms"] = timings;
+
+    if (!batch) {
+        const auto& file = files.front();
+        metadata["path"] = file.path;
+        metadata["overwrite"] = file.existed;
+        metadata["unchanged"] = file.unchanged;
+
+        LOG_DEBUG("文件写入成功: " + file.path);
+        if (file.unchanged) {
+            return ToolResult::ok("文件内容未变化，未重新写入: " + file.path, metadata);
+        }
+        return ToolResult::ok("文件已成功写入: " + file.path, metadata);
+    }
+
+    metadata["files"] = fileList;
+
+    std::string content = "已写入 " + std::to_string(written) + " 个文件（" + std::to_string(bytesWritten) + " 字节）";
+    if (written < files.size()) {
+        content += "，" + std::to_string(files.size() - written) + " 个文件内容未变化";
+    }
+    content += ":\n";
+    for (const auto& file : files) {
+        content += (file.unchanged ? "  = " : "  + ") + file.path + "\n";
+    }
 
-    LOG_DEBUG("文件写入成功: " + path);
+    LOG_DEBUG("批量写入成功: " + std::to_string(written) + " 个文件");
 
-    return ToolResult::ok("文件已成功写入: " + path, metadata);
+    return ToolResult::ok(content, metadata);
 }
 
-bool WriteTool::writeFile(const std::string& path, const std::string& content, std::string& error) {
-    // 使用原子写入策略：先写临时文件，成功后重命名
-    std::filesystem::path filePath(path);
-    std::filesystem::path tempPath = filePath.parent_path() / (filePath.filename().string() + ".tmp");
+ToolAccess WriteTool::describeAccess(const json& params) const {
+    // 任一文件缺少路径时无法判断访问范围，保守串行
+    ToolAccess access;
+    if (params.contains("files")) {
+        if (!params["files"].is_array() || params["files"].empty()) {
+            return ToolAccess::unknown();
+        }
+        for (const auto& file : params["files"]) {
+            if (!file.is_object() || !file.contains("path") || !file["path"].is_string() ||
+                file["path"].get<std::string>().empty()) {
+                return ToolAccess::unknown();
+            }
+            access.writes(file["path"].get<std::string>());
+        }
+        return access;
+    }
+    std::string path = getStringParam(params, "path");
+    if (path.empty()) {
+        return ToolAccess::unknown();
+    }
+    return access.writes(path);
+}
 
-    try {
-        // 写入临时文件
-        std::ofstream tempFile(tempPath, std::ios::binary);
-        if (!tempFile.is_open()) {
-            error = "无法创建临时文件: " + tempPath.string();
-            return false;
+std::vector<WriteTool::FileWrite> WriteTool::parseFiles(const json& params) const {
+    std::vector<FileWrite> files;
+    auto add = [&files](std::string path, std::string content) {
+        FileWrite file;
+        file.key = ToolAccess::normalizePath(path);
+        file.path = std::move(path);
+        file.content = std::move(content);
+        files.push_back(std::move(file));
+    };
+
+    if (params.contains("files")) {
+        for (const auto& file : params["files"]) {
+            add(file["path"].get<std::string>(), file["content"].get<std::string>());
         }
+    } else {
+        add(getStringParam(params, "path"), getStringParam(params, "content"));
+    }
+    return files;
+}
+
+bool WriteTool::writeFiles(std::vector<FileWrite>& files, std::string& error, json& timings) {
+    using Clock = std::chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+    };
+
+    auto start = Clock::now();
+
+    // 第一阶段：并行写出（并同步）临时文件
+    if (files.size() > 1) {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            if (!pool_) {
+                pool_ = std::make_shared<ThreadPool>(BATCH_THREADS);
+            }
+        }
+        std::vector<std::future<void>> pending;
+        pending.reserve(files.size());
+        for (auto& file : files) {
+            pending.push_back(pool_->submitWithResult([this, &file] { stageFile(file); }));
+        }
+        for (auto& future : pending) {
+            future.get();
+        }
+    } else {
+        stageFile(files.front());
+    }
 
-        tempFile << content;
-        tempFile.close();
+    double stageMs = elapsedMs(start);
 
-        // 检查是否成功写入
-        if (tempFile.fail()) {
-            error = "写入临时文件失败";
-            std::filesystem::remove(tempPath);
+    // 任一文件失败则放弃整批（临时文件随StagedFile析构删除）
+    for (auto& file : files) {
+        if (!file.error.empty()) {
+            error = file.error;
+            for (auto& other : files) {
+                other.staged.discard();
+            }
             return false;
         }
+    }
 
-        // 如果目标文件已存在，先备份
-        std::filesystem::path backupPath;
-        if (std::filesystem::exists(filePath)) {
-            backupPath = filePath.parent_path() / (filePath.filename().string() + ".bak");
-            std::filesystem::copy_file(filePath, backupPath,
-                std::filesystem::copy_options::overwrite_existing);
+    // 第二阶段：依次rename，最后每个目录同步一次
+    auto commitStart = Clock::now();
+    std::vector<std::filesystem::path> directories;
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto& file = files[i];
+        if (file.unchanged) {
+            continue;
+        }
+        if (!file.staged.commit(error)) {
+            if (i > 0) {
+                error += "（之前的文件已写入）";
+            }
+            for (auto& other : files) {
+                other.staged.discard();
+            }
+            return false;
         }
 
-        // 重命名临时文件为目标文件
-        std::filesystem::rename(tempPath, filePath);
+        auto dir = file.staged.target().parent_path();
+        if (std::find(directories.begin(), directories.end(), dir) == directories.end()) {
+            directories.push_back(dir);
+        }
 
-        // 成功后删除备份
-        if (!backupPath.empty() && std::filesystem::exists(backupPath)) {
-            std::filesystem::remove(backupPath);
+        // 记录新内容的摘要，下次写入相同内容时只需stat
+        FileStamp stamp;
+        if (readFileStamp(file.path, stamp)) {
+            std::lock_guard<std::mutex> lock(hash_mutex_);
+            if (hash_cache_.size() >= MAX_HASH_CACHE) {
+                hash_cache_.clear();
+            }
+            hash_cache_[file.key] = HashCacheEntry{stamp, file.sha256};
         }
+    }
+    if (sync_) {
+        for (const auto& dir : directories) {
+            syncDirectory(dir);
+        }
+    }
 
-        return true;
+    timings["stage"] = stageMs;
+    timings["commit"] = elapsedMs(commitStart);
+    timings["total"] = elapsedMs(start);
+    return true;
+}
 
+void WriteTool::stageFile(FileWrite& file) {
+    try {
+        file.sha256 = Sha256::hash(file.content);
+        if (isUnchanged(file)) {
+            file.unchanged = true;
+            return;
+        }
+        std::string error;
+        if (!file.staged.stage(file.path, {file.content}, error, sync_)) {
+            file.error = "写入文件失败: " + error;
+        }
     } catch (const std::exception& e) {
-        error = std::string("写入文件失败: ") + e.what();
+        file.error = std::string("写入文件失败: ") + e.what();
+    }
+}
 
-        // 清理临时文件
-        if (std::filesystem::exists(tempPath)) {
-            std::filesystem::remove(tempPath);
+bool WriteTool::isUnchanged(FileWrite& file) {
+    FileStamp stamp;
+    if (!readFileStamp(file.path, stamp)) {
+        return false;
+    }
+    file.existed = true;
+
+    if (stamp.size != file.content.size()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(hash_mutex_);
+        auto it = hash_cache_.find(file.key);
+        if (it != hash_cache_.end() && it->second.stamp == stamp) {
+            return it->second.sha256 == file.sha256;
         }
+    }
 
+    std::string existing = Sha256::hashFile(file.path);
+    if (existing.empty()) {
         return false;
     }
+
+    std::lock_guard<std::mutex> lock(hash_mutex_);
+    if (hash_cache_.size() >= MAX_HASH_CACHE) {
+        hash_cache_.clear();
+    }
+    hash_cache_[file.key] = HashCacheEntry{stamp, existing};
+    return existing == file.sha256;
 }
 
 bool WriteTool::ensureDirectoryExists(const std::string& path) {
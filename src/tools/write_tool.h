@@ -4,8 +4,15 @@
 #define ROBOCLAW_TOOLS_WRITE_TOOL_H
 
 #include "tool_base.h"
+#include "../utils/atomic_file.h"
+#include "../utils/mapped_file.h"
+#include "../utils/thread_pool.h"
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace roboclaw {
 
@@ -23,15 +30,61 @@ public:
     // 执行工具
     ToolResult execute(const json& params) override;
 
+    // 描述资源访问（用于并发冲突分析）
+    ToolAccess describeAccess(const json& params) const override;
+
+    // 设置批量写入使用的线程池（未设置时首次批量写入时创建）
+    void setThreadPool(std::shared_ptr<ThreadPool> pool) { pool_ = std::move(pool); }
+
+    // 是否在rename前后fsync文件和目录（默认开启）
+    void setSync(bool sync) { sync_ = sync; }
+
 private:
-    // 写入文件（使用临时文件+重命名实现原子写入）
-    bool writeFile(const std::string& path, const std::string& content, std::string& error);
+    // 一个待写入的文件
+    struct FileWrite {
+        std::string path;
+        std::string content;
+        std::string key;            // 规范化路径（摘要缓存的键）
+        std::string sha256;
+        bool existed = false;
+        bool unchanged = false;
+        StagedFile staged;
+        std::string error;
+    };
+
+    // 已知文件内容的摘要（按FileStamp判断是否仍然有效）
+    struct HashCacheEntry {
+        FileStamp stamp;
+        std::string sha256;
+    };
+
+    static constexpr size_t MAX_HASH_CACHE = 4096;
+    static constexpr size_t BATCH_THREADS = 4;
+
+    // 从参数中取出文件列表（files数组，或单个path/content）
+    std::vector<FileWrite> parseFiles(const json& params) const;
+
+    // 批量写入：并行写出并同步临时文件，全部成功后依次rename，每个目录同步一次
+    // 任一文件写出失败时不替换任何文件
+    bool writeFiles(std::vector<FileWrite>& files, std::string& error, json& timings);
+
+    // 写出单个文件的临时文件；内容与磁盘上相同时标记unchanged并跳过
+    void stageFile(FileWrite& file);
+
+    // 磁盘上的内容是否与file.content相同（先比较大小，再比较SHA-256）
+    bool isUnchanged(FileWrite& file);
 
     // 创建目录（如果不存在）
     bool ensureDirectoryExists(const std::string& path);
 
     // 检查路径是否有效
     bool isValidPath(const std::string& path) const;
+
+    bool sync_ = true;
+    std::shared_ptr<ThreadPool> pool_;
+    std::mutex pool_mutex_;
+    std::mutex hash_mutex_;
+    std::unordered_map<std::string, HashCacheEntry> hash_cache_;
 };
 
 } // namespace roboclaw
@@ -0,0 +1,262 @@
+// StagedFile / writeFileAtomic实现
+
+#include "atomic_file.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef PLATFORM_WINDOWS
+#include <fstream>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace roboclaw {
+
+namespace {
+
+// 解析符号链接，写入链接指向的文件而不是替换链接本身
+std::filesystem::path resolveTarget(const std::string& path) {
+    std::error_code ec;
+    if (std::filesystem::is_symlink(path, ec)) {
+        auto resolved = std::filesystem::canonical(path, ec);
+        if (!ec) {
+            return resolved;
+        }
+    }
+    return std::filesystem::path(path);
+}
+
+} // namespace
+
+std::filesystem::path tempPathFor(const std::filesystem::path& target) {
+    static std::atomic<unsigned> counter{0};
+#ifdef PLATFORM_WINDOWS
+    unsigned long pid = static_cast<unsigned long>(_getpid());
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    return target.parent_path() / ("." + target.filename().string() + ".tmp." +
+                                   std::to_string(pid) + "." + std::to_string(counter.fetch_add(1)));
+}
+
+StagedFile::StagedFile(StagedFile&& other) noexcept
+    : target_(std::move(other.target_))
+    , temp_(std::move(other.temp_)) {
+    other.temp_.clear();
+}
+
+StagedFile& StagedFile::operator=(StagedFile&& other) noexcept {
+    if (this != &other) {
+        discard();
+        target_ = std::move(other.target_);
+        temp_ = std::move(other.temp_);
+        other.temp_.clear();
+    }
+    return *this;
+}
+
+void StagedFile::discard() {
+    if (!temp_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(temp_, ec);
+        temp_.clear();
+    }
+}
+
+bool StagedFile::commit(std::string& error) {
+    if (temp_.empty()) {
+        error = "没有待提交的临时文件";
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_, target_, ec);
+    if (ec) {
+        error = "无法替换文件: " + target_.string() + " (" + ec.message() + ")";
+        discard();
+        return false;
+    }
+    temp_.clear();
+    return true;
+}
+
+#ifdef PLATFORM_WINDOWS
+
+bool StagedFile::stage(const std::string& path, const std::vector<std::string_view>& pieces,
+                       std::string& error, bool sync) {
+    (void)sync;
+    discard();
+    target_ = resolveTarget(path);
+    std::filesystem::path tmpPath = tempPathFor(target_);
+
+    std::error_code ec;
+    auto status = std::filesystem::status(target_, ec);
+    if (std::filesystem::exists(status) && !std::filesystem::is_regular_file(status)) {
+        error = "目标不是常规文件: " + target_.string();
+        return false;
+    }
+
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            error = "无法创建临时文件: " + tmpPath.string();
+            return false;
+        }
+        for (auto piece : pieces) {
+            out.write(piece.data(), static_cast<std::streamsize>(piece.size()));
+        }
+        out.flush();
+        if (!out) {
+            error = "写入临时文件失败: " + tmpPath.string();
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    if (std::filesystem::exists(status)) {
+        std::filesystem::permissions(tmpPath, status.permissions(), ec);
+    }
+
+    temp_ = tmpPath;
+    return true;
+}
+
+bool syncDirectory(const std::filesystem::path& dir) {
+    (void)dir;
+    return true;
+}
+
+bool syncFile(const std::filesystem::path& path) {
+    (void)path;
+    return true;
+}
+
+#else
+
+bool StagedFile::stage(const std::string& path, const std::vector<std::string_view>& pieces,
+                       std::string& error, bool sync) {
+    discard();
+    target_ = resolveTarget(path);
+    std::filesystem::path tmpPath = tempPathFor(target_);
+
+    struct stat existing;
+    bool exists = ::stat(target_.c_str(), &existing) == 0;
+    if (exists && !S_ISREG(existing.st_mode)) {
+        error = "目标不是常规文件: " + target_.string();
+        return false;
+    }
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        error = "无法创建临时文件: " + tmpPath.string() + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+
+    auto fail = [&](const std::string& message) {
+        error = message + " (" + std::strerror(errno) + ")";
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        ::unlink(tmpPath.c_str());
+        return false;
+    };
+
+    // 沿用原文件的权限和属主（非root时改属主通常会失败，忽略）
+    if (exists) {
+        if (fchmod(fd, existing.st_mode & 07777) != 0) {
+            return fail("无法设置文件权限: " + tmpPath.string());
+        }
+        if (existing.st_uid != geteuid() || existing.st_gid != getegid()) {
+            (void)!fchown(fd, existing.st_uid, existing.st_gid);
+        }
+    }
+
+    // 一次writev写出多个片段，处理部分写入
+    std::vector<struct iovec> iov;
+    iov.reserve(pieces.size());
+    for (auto piece : pieces) {
+        if (!piece.empty()) {
+            iov.push_back({const_cast<char*>(piece.data()), piece.size()});
+        }
+    }
+    constexpr size_t IOV_BATCH = 1024;
+    size_t index = 0;
+    while (index < iov.size()) {
+        int count = static_cast<int>(std::min(iov.size() - index, IOV_BATCH));
+        ssize_t written = ::writev(fd, &iov[index], count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return fail("写入临时文件失败: " + tmpPath.string());
+        }
+        size_t remaining = static_cast<size_t>(written);
+        while (remaining > 0) {
+            if (remaining >= iov[index].iov_len) {
+                remaining -= iov[index].iov_len;
+                ++index;
+            } else {
+                iov[index].iov_base = static_cast<char*>(iov[index].iov_base) + remaining;
+                iov[index].iov_len -= remaining;
+                remaining = 0;
+            }
+        }
+    }
+
+    if (sync && ::fsync(fd) != 0) {
+        return fail("无法同步临时文件: " + tmpPath.string());
+    }
+    int closed = ::close(fd);
+    fd = -1;
+    if (closed != 0) {
+        return fail("写入临时文件失败: " + tmpPath.string());
+    }
+
+    temp_ = tmpPath;
+    return true;
+}
+
+bool syncDirectory(const std::filesystem::path& dir) {
+    int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(dirFd) == 0;
+    ::close(dirFd);
+    return ok;
+}
+
+bool syncFile(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+#endif
+
+bool writeFileAtomic(const std::string& path, const std::vector<std::string_view>& pieces,
+                     std::string& error, bool sync) {
+    StagedFile staged;
+    if (!staged.stage(path, pieces, error, sync) || !staged.commit(error)) {
+        return false;
+    }
+    if (sync) {
+        syncDirectory(staged.target().parent_path());
+    }
+    return true;
+}
+
+} // namespace roboclaw
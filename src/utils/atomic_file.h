@@ -0,0 +1,69 @@
+// 原子文件写入 - writeFileAtomic / StagedFile
+// 先写同目录下的临时文件再rename覆盖目标，读者不会看到写了一半的文件
+
+#ifndef ROBOCLAW_UTILS_ATOMIC_FILE_H
+#define ROBOCLAW_UTILS_ATOMIC_FILE_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace roboclaw {
+
+// 已写入临时文件、等待提交的文件
+//
+// 用于批量写入：先并行stage所有文件，全部成功后再逐个commit，最后每个目录syncDirectory一次。
+// 未提交就销毁时删除临时文件。
+class StagedFile {
+public:
+    StagedFile() = default;
+    ~StagedFile() { discard(); }
+
+    StagedFile(const StagedFile&) = delete;
+    StagedFile& operator=(const StagedFile&) = delete;
+    StagedFile(StagedFile&& other) noexcept;
+    StagedFile& operator=(StagedFile&& other) noexcept;
+
+    // 将pieces按顺序拼接写入path旁的临时文件
+    // 目标已存在时沿用其权限位（权限允许时也沿用属主）；目标是符号链接时最终写入链接指向的文件。
+    // sync为true时在返回前fsync临时文件
+    bool stage(const std::string& path, const std::vector<std::string_view>& pieces,
+               std::string& error, bool sync = true);
+
+    // 将临时文件rename为目标文件（不同步目录）
+    bool commit(std::string& error);
+
+    // 删除尚未提交的临时文件
+    void discard();
+
+    // 最终写入的文件（已解析符号链接）
+    const std::filesystem::path& target() const { return target_; }
+
+private:
+    std::filesystem::path target_;
+    std::filesystem::path temp_;
+};
+
+// 持久化目录项（rename之后调用）；不支持的平台上为空操作
+bool syncDirectory(const std::filesystem::path& dir);
+
+// 持久化已写入并关闭的文件内容（流式写入的文件rename前调用）；不支持的平台上为空操作
+bool syncFile(const std::filesystem::path& path);
+
+// target同目录下的唯一临时文件名（含进程号和进程内计数，多进程、多线程并发写同一文件也不冲突）
+std::filesystem::path tempPathFor(const std::filesystem::path& target);
+
+// 原子写入单个文件：stage、commit，sync为true时再同步所在目录，保证掉电后不会留下空文件。
+// 目录必须已存在。失败时目标保持不变，error为原因。
+bool writeFileAtomic(const std::string& path, const std::vector<std::string_view>& pieces,
+                     std::string& error, bool sync = true);
+
+inline bool writeFileAtomic(const std::string& path, std::string_view content,
+                            std::string& error, bool sync = true) {
+    return writeFileAtomic(path, std::vector<std::string_view>{content}, error, sync);
+}
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_UTILS_ATOMIC_FILE_H
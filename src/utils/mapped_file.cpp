@@ -0,0 +1,365 @@
+// MappedFile / LineIndex实现
+
+#include "mapped_file.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifdef PLATFORM_WINDOWS
+#include <filesystem>
+#include <fstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace roboclaw {
+
+namespace {
+
+// 对data中每个'\n'的偏移调用onNewline
+// x86-64每次比较64字节（SSE2），ARM每次16字节（NEON），其余平台逐字节
+template <typename Fn>
+void forEachNewline(const char* data, size_t size, Fn&& onNewline) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 64 <= size; i += 64) {
+        auto block = [&](size_t at) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + at));
+            return static_cast<uint64_t>(static_cast<uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline))));
+        };
+        uint64_t mask = block(i) | (block(i + 16) << 16) | (block(i + 32) << 32) | (block(i + 48) << 48);
+        while (mask != 0) {
+            onNewline(i + static_cast<size_t>(__builtin_ctzll(mask)));
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(data + i)), newline);
+        // 每个字节压缩为4位：匹配的字节对应0xF
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask != 0) {
+            int bit = __builtin_ctzll(mask);
+            onNewline(i + static_cast<size_t>(bit >> 2));
+            mask &= ~(0xFULL << bit);
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (data[i] == '\n') {
+            onNewline(i);
+        }
+    }
+}
+
+} // namespace
+
+// ==================== MappedFile ====================
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+#ifdef PLATFORM_WINDOWS
+        buffer_ = std::move(other.buffer_);
+        data_ = buffer_.data();
+#else
+        data_ = other.data_;
+        fd_ = other.fd_;
+        other.fd_ = -1;
+#endif
+        size_ = other.size_;
+        stamp_ = other.stamp_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+#ifdef PLATFORM_WINDOWS
+
+bool readFileStamp(const std::string& path, FileStamp& stamp) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        return false;
+    }
+    stamp = FileStamp();
+    stamp.size = std::filesystem::file_size(path, ec);
+    stamp.mtime_ns = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    std::error_code ec;
+    auto status = std::filesystem::status(path, ec);
+    if (!std::filesystem::exists(status)) {
+        error = "文件不存在: " + path;
+        return false;
+    }
+    if (!std::filesystem::is_regular_file(status)) {
+        error = "路径不是常规文件: " + path;
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "无法打开文件: " + path;
+        return false;
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    stamp_.size = size_;
+    stamp_.mtime_ns = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return true;
+}
+
+void MappedFile::close() {
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+    data_ = nullptr;
+    size_ = 0;
+    stamp_ = FileStamp();
+}
+
+size_t MappedFile::read(uint64_t offset, size_t length, char* out) const {
+    if (offset >= size_) {
+        return 0;
+    }
+    length = std::min<size_t>(length, size_ - static_cast<size_t>(offset));
+    std::memcpy(out, data_ + offset, length);
+    return length;
+}
+
+void MappedFile::adviseSequential() const {
+}
+
+#else
+
+namespace {
+
+FileStamp stampFromStat(const struct stat& st) {
+    FileStamp stamp;
+    stamp.size = static_cast<uint64_t>(st.st_size);
+    stamp.inode = static_cast<uint64_t>(st.st_ino);
+#ifdef PLATFORM_MACOS
+    stamp.mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return stamp;
+}
+
+} // namespace
+
+bool readFileStamp(const std::string& path, FileStamp& stamp) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    stamp = stampFromStat(st);
+    return true;
+}
+
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = (errno == ENOENT ? "文件不存在: " : "无法打开文件: ") + path;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error = "无法获取文件信息: " + path;
+        ::close(fd);
+        return false;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        error = "路径不是常规文件: " + path;
+        ::close(fd);
+        return false;
+    }
+
+    stamp_ = stampFromStat(st);
+    fd_ = fd;
+
+    // 空文件不能映射
+    if (st.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            error = "无法映射文件: " + path + " (" + std::strerror(errno) + ")";
+            close();
+            return false;
+        }
+        data_ = static_cast<const char*>(mapped);
+        size_ = static_cast<size_t>(st.st_size);
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    data_ = nullptr;
+    size_ = 0;
+    stamp_ = FileStamp();
+}
+
+size_t MappedFile::read(uint64_t offset, size_t length, char* out) const {
+    if (fd_ < 0 || offset >= size_) {
+        return 0;
+    }
+    length = std::min<size_t>(length, size_ - static_cast<size_t>(offset));
+
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(fd_, out + done, length - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;   // 读到当前文件末尾（文件已被截断）或出错
+        }
+        done += static_cast<size_t>(n);
+    }
+    return done;
+}
+
+void MappedFile::adviseSequential() const {
+    if (data_ != nullptr) {
+        posix_madvise(const_cast<char*>(data_), size_, POSIX_MADV_SEQUENTIAL);
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (fd_ >= 0) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+}
+
+#endif
+
+// ==================== LineIndex ====================
+
+namespace {
+
+// 分块扫描的块大小
+constexpr size_t SCAN_CHUNK_BYTES = 1 << 20;
+
+} // namespace
+
+void LineIndex::begin(size_t size) {
+    checkpoints_.clear();
+    line_count_ = 0;
+    size_ = size;
+    if (size > 0) {
+        checkpoints_.push_back(0);
+        line_count_ = 1;
+    }
+}
+
+void LineIndex::scan(const char* chunk, size_t length, size_t base) {
+    forEachNewline(chunk, length, [&](size_t offset) {
+        // 最后一个字符是换行符时不开始新的一行
+        size_t position = base + offset;
+        if (position + 1 < size_) {
+            if (line_count_ % CHECKPOINT_INTERVAL == 0) {
+                checkpoints_.push_back(position + 1);
+            }
+            ++line_count_;
+        }
+    });
+}
+
+LineIndex LineIndex::build(std::string_view data) {
+    LineIndex index;
+    index.begin(data.size());
+    index.scan(data.data(), data.size(), 0);
+    index.checkpoints_.shrink_to_fit();
+    return index;
+}
+
+bool LineIndex::build(const MappedFile& file, LineIndex& index) {
+    index.begin(file.size());
+    std::vector<char> buffer(std::min(file.size(), SCAN_CHUNK_BYTES));
+    for (size_t offset = 0; offset < file.size();) {
+        size_t want = std::min(buffer.size(), file.size() - offset);
+        size_t got = file.read(offset, want, buffer.data());
+        if (got != want) {
+            index = LineIndex();
+            return false;
+        }
+        index.scan(buffer.data(), got, offset);
+        offset += got;
+    }
+    index.checkpoints_.shrink_to_fit();
+    return true;
+}
+
+size_t LineIndex::lineStart(std::string_view data, size_t line) const {
+    if (line >= line_count_) {
+        return size_;
+    }
+
+    size_t position = checkpoints_[line / CHECKPOINT_INTERVAL];
+    for (size_t remaining = line % CHECKPOINT_INTERVAL; remaining > 0; --remaining) {
+        const void* newline = std::memchr(data.data() + position, '\n', size_ - position);
+        position = static_cast<size_t>(static_cast<const char*>(newline) - data.data()) + 1;
+    }
+    return position;
+}
+
+size_t LineIndex::lineStart(const MappedFile& file, size_t line) const {
+    if (line >= line_count_) {
+        return size_;
+    }
+
+    // 检查点之后最多CHECKPOINT_INTERVAL-1行，按小块读取查找换行符
+    size_t position = checkpoints_[line / CHECKPOINT_INTERVAL];
+    size_t remaining = line % CHECKPOINT_INTERVAL;
+    char buffer[4096];
+    while (remaining > 0) {
+        size_t got = file.read(position, std::min(sizeof(buffer), size_ - position), buffer);
+        if (got == 0) {
+            return position;
+        }
+        const char* cursor = buffer;
+        const char* end = buffer + got;
+        while (remaining > 0) {
+            const void* newline = std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+            if (newline == nullptr) {
+                break;
+            }
+            cursor = static_cast<const char*>(newline) + 1;
+            --remaining;
+        }
+        position += remaining > 0 ? got : static_cast<size_t>(cursor - buffer);
+    }
+    return position;
+}
+
+} // namespace roboclaw
@@ -0,0 +1,110 @@
+// 内存映射文件 - MappedFile / LineIndex
+// 只读映射整个文件，配合行索引按行号随机访问（用于读取大文件的片段）
+//
+// 映射期间文件可能被其他进程原地截断（如日志轮转），此时访问映射中已不存在的
+// 部分会触发SIGBUS。读取别人可能正在改写的文件时应使用read()，它读到文件末尾
+// 即停止，不会访问映射。
+
+#ifndef ROBOCLAW_UTILS_MAPPED_FILE_H
+#define ROBOCLAW_UTILS_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace roboclaw {
+
+// 文件标识：打开时取得，用于判断缓存的索引是否仍然有效
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint64_t inode = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return size == other.size && mtime_ns == other.mtime_ns && inode == other.inode;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// 读取文件标识（不打开文件）；文件不存在或不是常规文件时返回false
+bool readFileStamp(const std::string& path, FileStamp& stamp);
+
+// 只读内存映射文件（Windows上退化为读入内存）
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // 打开并映射文件；失败时error为原因
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+    const FileStamp& stamp() const { return stamp_; }
+
+    // 从文件读取[offset, offset + length)到out，返回实际读取的字节数
+    // 文件在打开后被截断时返回值小于length
+    size_t read(uint64_t offset, size_t length, char* out) const;
+
+    // 提示内核将顺序读取整个文件（建立索引前调用）
+    void adviseSequential() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    FileStamp stamp_;
+#ifdef PLATFORM_WINDOWS
+    std::string buffer_;
+#else
+    int fd_ = -1;   // 保持打开供read()使用
+#endif
+};
+
+// 行索引
+//
+// 每CHECKPOINT_INTERVAL行记录一次起始偏移，定位任意行只需从最近的检查点向后扫描，
+// 内存占用约为完整偏移表的1/CHECKPOINT_INTERVAL。行的划分与std::getline一致：
+// 末尾没有换行符的最后一行也算一行，空文件为0行。
+class LineIndex {
+public:
+    static constexpr size_t CHECKPOINT_INTERVAL = 64;
+
+    // 扫描数据建立索引（按平台使用SSE2/NEON查找换行符）
+    static LineIndex build(std::string_view data);
+
+    // 通过MappedFile::read()分块扫描建立索引；文件在扫描期间被截断时返回false
+    static bool build(const MappedFile& file, LineIndex& index);
+
+    size_t lineCount() const { return line_count_; }
+
+    // 第line行（从0开始）的起始偏移；line >= lineCount()时返回数据长度
+    // data必须是建立索引时的同一份内容
+    size_t lineStart(std::string_view data, size_t line) const;
+
+    // 同上，通过MappedFile::read()读取；文件已被截断时返回读到的末尾
+    size_t lineStart(const MappedFile& file, size_t line) const;
+
+    size_t memoryUsage() const { return checkpoints_.capacity() * sizeof(uint64_t); }
+
+private:
+    // 分块扫描：begin()设定总长度，scan()处理从base开始的一块
+    void begin(size_t size);
+    void scan(const char* chunk, size_t length, size_t base);
+
+    std::vector<uint64_t> checkpoints_;   // 第k*CHECKPOINT_INTERVAL行的起始偏移
+    size_t line_count_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_UTILS_MAPPED_FILE_H
@@ -0,0 +1,44 @@
+// SHA-256 - Sha256
+// 增量计算SHA-256摘要（用于下载内容的完整性校验）
+
+#ifndef ROBOCLAW_UTILS_SHA256_H
+#define ROBOCLAW_UTILS_SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace roboclaw {
+
+class Sha256 {
+public:
+    Sha256();
+
+    // 追加数据
+    void update(const void* data, size_t length);
+    void update(std::string_view data) { update(data.data(), data.size()); }
+
+    // 结束计算，返回小写十六进制摘要（之后对象被重置，可重新使用）
+    std::string hexdigest();
+
+    // 计算字符串的摘要
+    static std::string hash(std::string_view data);
+
+    // 计算文件的摘要，读取失败返回空字符串
+    static std::string hashFile(const std::string& path);
+
+private:
+    void reset();
+    void transform(const uint8_t* block);
+
+    std::array<uint32_t, 8> state_;
+    std::array<uint8_t, 64> buffer_;
+    size_t buffered_;
+    uint64_t total_length_;
+};
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_UTILS_SHA256_H
@@ -0,0 +1,69 @@
+// findSubstring实现
+
+#include "string_search.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace roboclaw {
+
+size_t findSubstring(std::string_view haystack, std::string_view needle, size_t from) {
+    if (from > haystack.size()) {
+        return std::string_view::npos;
+    }
+    if (needle.size() < 2 || needle.size() > haystack.size() - from) {
+        return haystack.find(needle, from);
+    }
+
+    const char* text = haystack.data() + from;
+    const size_t length = haystack.size() - from;
+    const size_t k = needle.size();
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+    for (; i + k - 1 + 16 <= length; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + k - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+        while (mask != 0) {
+            size_t candidate = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (std::memcmp(text + candidate + 1, needle.data() + 1, k - 2) == 0) {
+                return from + candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(needle.front()));
+    const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(needle.back()));
+    for (; i + k - 1 + 16 <= length; i += 16) {
+        uint8x16_t blockFirst = vld1q_u8(reinterpret_cast<const uint8_t*>(text + i));
+        uint8x16_t blockLast = vld1q_u8(reinterpret_cast<const uint8_t*>(text + i + k - 1));
+        uint8x16_t eq = vandq_u8(vceqq_u8(blockFirst, first), vceqq_u8(blockLast, last));
+        // 每个字节压缩为4位：候选位置对应0xF
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask != 0) {
+            int bit = __builtin_ctzll(mask);
+            size_t candidate = i + static_cast<size_t>(bit >> 2);
+            if (std::memcmp(text + candidate + 1, needle.data() + 1, k - 2) == 0) {
+                return from + candidate;
+            }
+            mask &= ~(0xFULL << bit);
+        }
+    }
+#endif
+
+    // 剩余不足一个向量的部分
+    size_t rest = std::string_view(text + i, length - i).find(needle);
+    return rest == std::string_view::npos ? rest : from + i + rest;
+}
+
+} // namespace roboclaw
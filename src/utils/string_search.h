@@ -0,0 +1,20 @@
+// 子串查找 - findSubstring
+// 向量化的子串查找，用于在大文件中定位编辑目标
+
+#ifndef ROBOCLAW_UTILS_STRING_SEARCH_H
+#define ROBOCLAW_UTILS_STRING_SEARCH_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace roboclaw {
+
+// 返回needle在haystack中从from开始第一次出现的位置，未找到返回std::string_view::npos
+//
+// x86-64（SSE2）和ARM（NEON）上一次比较16个候选位置的首字节和尾字节，
+// 只对两者都匹配的位置做完整比较；其他平台使用std::string_view::find。
+size_t findSubstring(std::string_view haystack, std::string_view needle, size_t from = 0);
+
+} // namespace roboclaw
+
+#endif // ROBOCLAW_UTILS_STRING_SEARCH_H
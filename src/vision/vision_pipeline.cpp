@@ -61,6 +61,22 @@ void VisionPipeline::removeSource(std::shared_ptr<roboclaw::plugins::IVisionDevi
     }
 }
 
+bool VisionPipeline::replaceSource(const std::shared_ptr<roboclaw::plugins::IVisionDevice>& old_device,
+                                   std::shared_ptr<roboclaw::plugins::IVisionDevice> new_device) {
+    if (!old_device || !new_device) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+
+    auto it = std::find(sources_.begin(), sources_.end(), old_device);
+    if (it == sources_.end()) {
+        return false;
+    }
+    *it = std::move(new_device);
+    return true;
+}
+
 size_t VisionPipeline::getSourceCount() const {
     std::lock_guard<std::mutex> lock(sources_mutex_);
     return sources_.size();
@@ -130,27 +146,30 @@ bool VisionPipeline::isRunning() const {
 }
 
 roboclaw::plugins::FrameData VisionPipeline::captureFrame() {
-    std::lock_guard<std::mutex> lock(sources_mutex_);
+    // Pick the source under the lock, capture outside it: the local
+    // reference keeps the device (and its plugin library) alive even if
+    // it is replaced or removed mid-frame
+    std::shared_ptr<roboclaw::plugins::IVisionDevice> source;
+    {
+        std::lock_guard<std::mutex> lock(sources_mutex_);
+        for (auto& candidate : sources_) {
+            if (candidate && candidate->isOpen()) {
+                source = candidate;
+                break;
+            }
+        }
+    }
 
-    if (sources_.empty()) {
+    if (!source) {
         // Return empty frame
         return roboclaw::plugins::FrameData{};
     }
 
-    // Get frame from first available source
-    for (auto& source : sources_) {
-        if (source && source->isOpen()) {
-            // Capture frame from device
-            auto deviceFrame = source->captureFrame();
-
-            // Process through processors
-            roboclaw::plugins::FrameData processedFrame = processFrame(deviceFrame);
-
-            return processedFrame;
-        }
-    }
+    // Capture frame from device
+    auto deviceFrame = source->captureFrame();
 
-    return roboclaw::plugins::FrameData{};
+    // Process through processors
+    return processFrame(deviceFrame);
 }
 
 void VisionPipeline::setPipelineMode(PipelineMode mode) {
@@ -64,6 +64,21 @@ public:
      */
     void removeSource(std::shared_ptr<roboclaw::plugins::IVisionDevice> device);
 
+    /**
+     * @brief Atomically swap a source for a replacement instance
+     *
+     * Used for plugin hot reload (see PluginManager::addReloadListener).
+     * The replacement takes the old source's position. Frames already
+     * being captured from the old source finish on it; it is released
+     * when the last of them completes.
+     *
+     * @param old_device Source currently in the pipeline
+     * @param new_device Replacement source
+     * @return true if old_device was found and replaced
+     */
+    bool replaceSource(const std::shared_ptr<roboclaw::plugins::IVisionDevice>& old_device,
+                       std::shared_ptr<roboclaw::plugins::IVisionDevice> new_device);
+
     /**
      * @brief Get number of sources
      * @return Source count
@@ -0,0 +1,159 @@
+// 本地模拟HTTP服务器 / Local mock HTTP server for provider tests
+// 监听127.0.0.1的随机端口，每个连接一个线程，按处理函数返回的延迟和内容应答
+
+#ifndef ROBOCLAW_TESTS_MOCK_HTTP_SERVER_H
+#define ROBOCLAW_TESTS_MOCK_HTTP_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace roboclaw::test {
+
+class MockHttpServer {
+public:
+    struct Reply {
+        int status = 200;
+        std::string body;
+        std::chrono::milliseconds delay{0};
+    };
+
+    using Handler = std::function<Reply(const std::string& path, const std::string& body)>;
+
+    explicit MockHttpServer(Handler handler) : handler_(std::move(handler)) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        ::listen(listen_fd_, 16);
+
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        accept_thread_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~MockHttpServer() {
+        running_ = false;
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        ::close(listen_fd_);
+        if (accept_thread_.joinable()) {
+            accept_thread_.join();
+        }
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(port_);
+    }
+
+    int requestCount() const { return requests_.load(); }
+
+    // 客户端在应答前断开的次数（被取消的请求）
+    int abortedCount() const { return aborted_.load(); }
+
+private:
+    void acceptLoop() {
+        while (running_) {
+            int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(workers_mutex_);
+            workers_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string request;
+        char buffer[4096];
+        size_t headerEnd = std::string::npos;
+        size_t contentLength = 0;
+
+        // 读取请求头和Content-Length指定的请求体
+        while (true) {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                ::close(fd);
+                return;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+            if (headerEnd == std::string::npos) {
+                headerEnd = request.find("\r\n\r\n");
+                if (headerEnd != std::string::npos) {
+                    size_t pos = request.find("Content-Length:");
+                    if (pos == std::string::npos) {
+                        pos = request.find("content-length:");
+                    }
+                    if (pos != std::string::npos && pos < headerEnd) {
+                        contentLength = std::stoul(request.substr(pos + 15));
+                    }
+                }
+            }
+            if (headerEnd != std::string::npos && request.size() >= headerEnd + 4 + contentLength) {
+                break;
+            }
+        }
+        ++requests_;
+
+        size_t pathStart = request.find(' ') + 1;
+        std::string path = request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+        Reply reply = handler_(path, request.substr(headerEnd + 4, contentLength));
+
+        // 延迟期间监测客户端是否断开
+        auto deadline = std::chrono::steady_clock::now() + reply.delay;
+        while (std::chrono::steady_clock::now() < deadline) {
+            pollfd pfd{fd, POLLIN, 0};
+            if (::poll(&pfd, 1, 5) > 0) {
+                char probe;
+                if (::recv(fd, &probe, 1, MSG_PEEK) <= 0) {
+                    ++aborted_;
+                    ::close(fd);
+                    return;
+                }
+            }
+        }
+
+        std::string response = "HTTP/1.1 " + std::to_string(reply.status) + " OK\r\n"
+                               "Content-Type: application/json\r\n"
+                               "Content-Length: " + std::to_string(reply.body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + reply.body;
+        ::send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+        ::close(fd);
+    }
+
+    Handler handler_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{true};
+    std::atomic<int> requests_{0};
+    std::atomic<int> aborted_{0};
+    std::thread accept_thread_;
+    std::mutex workers_mutex_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace roboclaw::test
+
+#endif // ROBOCLAW_TESTS_MOCK_HTTP_SERVER_H
@@ -0,0 +1,174 @@
+// 对冲请求提供商测试 / Hedged provider tests
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "mock_http_server.h"
+#include "../../src/llm/hedged_provider.h"
+#include "../../src/llm/openai_provider.h"
+
+using namespace roboclaw;
+using roboclaw::test::MockHttpServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+// 构造OpenAI格式的成功响应 / Build an OpenAI-style success body
+std::string completion(const std::string& content) {
+    json body = {
+        {"choices", json::array({{
+            {"message", {{"role", "assistant"}, {"content", content}}},
+            {"finish_reason", "stop"}
+        }})},
+        {"usage", {{"prompt_tokens", 5}, {"completion_tokens", 2}}}
+    };
+    return body.dump();
+}
+
+MockHttpServer::Handler replyWith(const std::string& content,
+                                  std::chrono::milliseconds delay,
+                                  int status = 200) {
+    return [content, delay, status](const std::string&, const std::string&) {
+        return MockHttpServer::Reply{status, status == 200 ? completion(content) : "{}", delay};
+    };
+}
+
+std::shared_ptr<LLMProvider> endpointFor(const MockHttpServer& server) {
+    return std::make_shared<OpenAIProvider>("test-key", "gpt-4o", server.url());
+}
+
+HedgeConfig fastConfig() {
+    HedgeConfig config;
+    config.initial_delay = 100ms;
+    config.min_delay = 10ms;
+    config.min_samples = 4;
+    return config;
+}
+
+std::vector<ChatMessage> prompt() {
+    return {ChatMessage(MessageRole::USER, "hello")};
+}
+
+} // namespace
+
+// 测试主端点慢时发起对冲并采用备用端点 / A slow primary is hedged and the backup wins
+TEST(HedgedProviderTest, SlowPrimaryIsHedged) {
+    MockHttpServer primary(replyWith("primary", 2000ms));
+    MockHttpServer backup(replyWith("backup", 0ms));
+    HedgedProvider provider({{"primary", endpointFor(primary)}, {"backup", endpointFor(backup)}},
+                            fastConfig());
+
+    auto start = std::chrono::steady_clock::now();
+    auto response = provider.chat(prompt());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(response.success) << response.error;
+    EXPECT_EQ(response.content, "backup");
+    EXPECT_LT(elapsed, 1500ms);
+
+    auto stats = provider.getEndpointStats();
+    EXPECT_EQ(stats[1].hedges, 1u);
+    EXPECT_EQ(stats[1].wins, 1u);
+    EXPECT_EQ(stats[0].failures, 0u);
+
+    // 落败请求被取消，服务器观察到连接断开 / The loser is cancelled mid-flight
+    auto deadline = std::chrono::steady_clock::now() + 1500ms;
+    while (primary.abortedCount() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(primary.abortedCount(), 1);
+}
+
+// 测试取消落败请求不影响同一端点上的其他请求 / Cancelling a loser spares other requests on its endpoint
+TEST(HedgedProviderTest, LoserCancellationSparesOtherRequests) {
+    MockHttpServer primary(replyWith("primary", 600ms));
+    MockHttpServer backup(replyWith("backup", 0ms));
+    auto shared = endpointFor(primary);
+    HedgedProvider provider({{"primary", shared}, {"backup", endpointFor(backup)}}, fastConfig());
+
+    // 另一个调用方直接使用同一端点 / Another caller uses the same endpoint directly
+    LLMResponse direct;
+    std::thread other([&] { direct = shared->chat(prompt()); });
+    std::this_thread::sleep_for(20ms);
+
+    auto response = provider.chat(prompt());
+    ASSERT_TRUE(response.success) << response.error;
+    EXPECT_EQ(response.content, "backup");
+
+    other.join();
+    ASSERT_TRUE(direct.success) << direct.error;
+    EXPECT_EQ(direct.content, "primary");
+    EXPECT_EQ(primary.abortedCount(), 1);
+}
+
+// 测试主端点足够快时不发起对冲 / A fast primary never triggers a hedge
+TEST(HedgedProviderTest, FastPrimaryIsNotHedged) {
+    MockHttpServer primary(replyWith("primary", 0ms));
+    MockHttpServer backup(replyWith("backup", 0ms));
+    HedgedProvider provider({{"primary", endpointFor(primary)}, {"backup", endpointFor(backup)}},
+                            fastConfig());
+
+    for (int i = 0; i < 3; ++i) {
+        auto response = provider.chat(prompt());
+        ASSERT_TRUE(response.success) << response.error;
+        EXPECT_EQ(response.content, "primary");
+    }
+    EXPECT_EQ(backup.requestCount(), 0);
+    EXPECT_EQ(provider.getEndpointStats()[0].wins, 3u);
+}
+
+// 测试主端点出错时立即转向备用端点 / A failing primary fails over without waiting
+TEST(HedgedProviderTest, ErrorFailsOverImmediately) {
+    MockHttpServer primary(replyWith("", 0ms, 500));
+    MockHttpServer backup(replyWith("backup", 0ms));
+    HedgeConfig config = fastConfig();
+    config.initial_delay = 5000ms;
+    HedgedProvider provider({{"primary", endpointFor(primary)}, {"backup", endpointFor(backup)}},
+                            config);
+
+    auto start = std::chrono::steady_clock::now();
+    auto response = provider.chat(prompt());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(response.success) << response.error;
+    EXPECT_EQ(response.content, "backup");
+    EXPECT_LT(elapsed, 2000ms);
+    EXPECT_EQ(provider.getEndpointStats()[0].failures, 1u);
+
+    // 连续失败的端点排到最后 / The failing endpoint is ranked last afterwards
+    provider.chat(prompt());
+    EXPECT_EQ(primary.requestCount(), 1);
+    EXPECT_EQ(backup.requestCount(), 2);
+}
+
+// 测试对冲胜出后路由转向更快的端点 / After a hedge win, routing prefers the faster endpoint
+TEST(HedgedProviderTest, RoutesToFasterEndpoint) {
+    MockHttpServer slow(replyWith("slow", 300ms));
+    MockHttpServer fast(replyWith("fast", 0ms));
+    HedgedProvider provider({{"slow", endpointFor(slow)}, {"fast", endpointFor(fast)}},
+                            fastConfig());
+
+    // 冷启动按配置顺序，慢端点被对冲 / Cold start follows the configured order and gets hedged
+    EXPECT_EQ(provider.chat(prompt()).content, "fast");
+    // 之后直接路由到有样本且更快的端点 / Afterwards the measured faster endpoint goes first
+    EXPECT_EQ(provider.chat(prompt()).content, "fast");
+    EXPECT_EQ(provider.chat(prompt()).content, "fast");
+
+    EXPECT_EQ(slow.requestCount(), 1);
+    EXPECT_EQ(fast.requestCount(), 3);
+    EXPECT_EQ(provider.getEndpointStats()[1].hedges, 1u);
+}
+
+// 测试所有端点失败时返回错误 / All endpoints failing returns an error
+TEST(HedgedProviderTest, AllEndpointsFail) {
+    MockHttpServer first(replyWith("", 0ms, 500));
+    MockHttpServer second(replyWith("", 0ms, 503));
+    HedgedProvider provider({{"first", endpointFor(first)}, {"second", endpointFor(second)}},
+                            fastConfig());
+
+    auto response = provider.chat(prompt());
+    EXPECT_FALSE(response.success);
+    EXPECT_FALSE(response.error.empty());
+    EXPECT_EQ(first.requestCount(), 1);
+    EXPECT_EQ(second.requestCount(), 1);
+}
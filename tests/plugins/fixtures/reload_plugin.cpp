@@ -0,0 +1,42 @@
+// tests/plugins/fixtures/reload_plugin.cpp
+//
+// Minimal shared library used by the hot reload tests. It is built twice
+// with different RELOAD_PLUGIN_VERSION values so a test can swap the file
+// on disk and reload it.
+#include "plugins/plugin.h"
+
+#ifndef RELOAD_PLUGIN_VERSION
+#define RELOAD_PLUGIN_VERSION "1.0.0"
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define RELOAD_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+    #define RELOAD_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace {
+
+class ReloadPlugin : public roboclaw::plugins::IPlugin {
+public:
+    std::string getName() const override { return "reload_fixture"; }
+    std::string getVersion() const override { return RELOAD_PLUGIN_VERSION; }
+    bool initialize(const nlohmann::json&) override { return true; }
+    void shutdown() override {}
+
+    // Counts reloads so the test can see state crossing library versions
+    nlohmann::json exportState() const override { return {{"reloads", reloads_}}; }
+    bool importState(const nlohmann::json& state) override {
+        reloads_ = state.value("reloads", 0) + 1;
+        return true;
+    }
+
+private:
+    int reloads_ = 0;
+};
+
+} // namespace
+
+RELOAD_PLUGIN_EXPORT roboclaw::plugins::IPlugin* create_plugin() {
+    return new ReloadPlugin();
+}
@@ -1,6 +1,9 @@
 // tests/plugins/test_plugin_interface.cpp
 #include <catch2/catch.hpp>
+#include <filesystem>
+#include <random>
 #include "plugins/plugin.h"
+#include "plugins/plugin_manager.h"
 #include "test_plugin_utils.h"
 
 using namespace roboclaw::plugins;
@@ -30,3 +33,66 @@ TEST_CASE("Plugin shutdown completes without throwing", "[plugin]") {
     plugin.initialize(config);
     REQUIRE_NOTHROW(plugin.shutdown());
 }
+
+TEST_CASE("Plugin state hooks default to a stateless no-op", "[plugin]") {
+    MockPlugin old_instance;
+    MockPlugin new_instance;
+    auto state = old_instance.exportState();
+    REQUIRE(state.is_null());
+    REQUIRE(new_instance.importState(state));
+}
+
+TEST_CASE("Reload of an unknown plugin fails", "[plugin][reload]") {
+    PluginManager manager;
+    REQUIRE_FALSE(manager.reloadPlugin("missing"));
+    REQUIRE_FALSE(manager.reloadPlugin(""));
+    REQUIRE(manager.getPluginGeneration("missing") == 0);
+}
+
+#if defined(RELOAD_PLUGIN_V1) && defined(RELOAD_PLUGIN_V2)
+TEST_CASE("Reload swaps in a rebuilt shared library", "[plugin][reload]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("roboclaw_reload_test_" + std::to_string(std::random_device{}()));
+    fs::create_directories(dir);
+    fs::path library = dir / ("reload_fixture" + fs::path(RELOAD_PLUGIN_V1).extension().string());
+
+    // Install like a build would: write beside the library, then rename over it
+    auto install = [&](const char* built) {
+        fs::path staged = library;
+        staged += ".new";
+        fs::copy_file(built, staged, fs::copy_options::overwrite_existing);
+        fs::rename(staged, library);
+    };
+
+    {
+        PluginManager manager;
+        install(RELOAD_PLUGIN_V1);
+        REQUIRE(manager.loadPlugin(library.string()));
+        auto before = manager.getPlugin("reload_fixture");
+        REQUIRE(before);
+        REQUIRE(before->getVersion() == "1.0.0");
+
+        install(RELOAD_PLUGIN_V2);
+        REQUIRE(manager.reloadPlugin("reload_fixture"));
+        auto after = manager.getPlugin("reload_fixture");
+        REQUIRE(after->getVersion() == "2.0.0");
+        REQUIRE(after->exportState()["reloads"] == 1);
+        REQUIRE(manager.getPluginGeneration("reload_fixture") == 1);
+
+        // The replaced instance keeps its own code mapped
+        REQUIRE(before->getVersion() == "1.0.0");
+        before.reset();
+        after.reset();
+
+        // Restarting keeps counting, so later shadow copies never reuse a name
+        manager.shutdown();
+        REQUIRE(manager.loadPlugin(library.string()));
+        install(RELOAD_PLUGIN_V1);
+        REQUIRE(manager.reloadPlugin("reload_fixture"));
+        REQUIRE(manager.getPlugin("reload_fixture")->getVersion() == "1.0.0");
+        REQUIRE(manager.getPluginGeneration("reload_fixture") == 2);
+    }
+
+    fs::remove_all(dir);
+}
+#endif
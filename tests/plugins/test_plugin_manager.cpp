@@ -263,7 +263,7 @@ TEST_CASE("Concurrent load and unload operations", "[plugin_manager][thread-safe
 
     // Unload threads
     for (int t = 0; t < num_threads; ++t) {
-        threads.emplace_back([&manager, &stop]() {
+        threads.emplace_back([&manager, &stop, t]() {
             int counter = 0;
             while (!stop && counter < 50) {
                 std::string id = "libplugin" + std::to_string(t) + "_" + std::to_string(counter++);
@@ -410,3 +410,113 @@ TEST_CASE("Edge case: Rapid load/unload cycles", "[plugin_manager]") {
     // Manager should still be functional
     REQUIRE(manager.listPlugins().empty());
 }
+
+// ============================================================================
+// Manifest Index and Lazy Loading Tests
+// ============================================================================
+
+namespace {
+
+std::string makeTempPluginDir(const std::string& tag) {
+    std::string dir = "/tmp/roboclaw_test_" + tag + "_" + std::to_string(std::time(nullptr));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+} // namespace
+
+TEST_CASE("Manifest index lists plugins without loading them", "[plugin_manager][manifest]") {
+    std::string dir = makeTempPluginDir("manifest_index");
+    // Not a real shared library: indexing must not need to dlopen it
+    writeFile(dir + "/libfake_camera.so", "not an elf file");
+    writeFile(dir + "/libfake_camera.manifest.json", R"({
+        "name": "fake_camera",
+        "version": "2.1.0",
+        "interface": "vision_device",
+        "capabilities": ["rgb", "depth"]
+    })");
+
+    PluginManager manager;
+    REQUIRE(manager.loadPluginsFromDirectory(dir) == 1);
+
+    SECTION("Indexed plugin is queryable but not loaded") {
+        REQUIRE(manager.listPlugins().empty());
+        REQUIRE_FALSE(manager.isLoaded("libfake_camera"));
+
+        auto manifest = manager.getManifest("libfake_camera");
+        REQUIRE(manifest.has_value());
+        REQUIRE(manifest->name == "fake_camera");
+        REQUIRE(manifest->version == "2.1.0");
+        REQUIRE(manifest->capabilities == std::vector<std::string>{"rgb", "depth"});
+
+        REQUIRE(manager.findPluginsByInterface("vision_device") == std::vector<std::string>{"libfake_camera"});
+        REQUIRE(manager.findPluginsByInterface("simulation_tool").empty());
+        REQUIRE(manager.listAvailablePlugins().size() == 1);
+    }
+
+    SECTION("Failed lazy load drops the plugin from the index") {
+        REQUIRE(manager.getPlugin("libfake_camera") == nullptr);
+        REQUIRE_FALSE(manager.getManifest("libfake_camera").has_value());
+    }
+
+    SECTION("Shutdown forgets the index") {
+        manager.shutdown();
+        REQUIRE(manager.listAvailablePlugins().empty());
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Manifest cache keyed by mtime, size and hash", "[plugin_manager][manifest]") {
+    std::string dir = makeTempPluginDir("manifest_cache");
+    std::string lib = dir + "/libcached.so";
+    std::string cache_path = dir + "/cache.json";
+    writeFile(lib, "library contents v1");
+
+    auto size = std::filesystem::file_size(lib);
+    int64_t mtime = 1000;
+
+    PluginManifest manifest;
+    manifest.id = "libcached";
+    manifest.path = lib;
+    manifest.name = "cached";
+    manifest.interface_type = "embedded_platform";
+    manifest.mtime = mtime;
+    manifest.size = size;
+    manifest.hash = PluginManifestCache::hashFile(lib);
+
+    {
+        PluginManifestCache cache;
+        cache.load(cache_path);
+        cache.put(manifest);
+        REQUIRE(cache.save());
+    }
+
+    PluginManifestCache cache;
+    cache.load(cache_path);
+    REQUIRE(cache.size() == 1);
+
+    SECTION("Unchanged file hits") {
+        auto hit = cache.lookup(lib, mtime, size);
+        REQUIRE(hit.has_value());
+        REQUIRE(hit->interface_type == "embedded_platform");
+    }
+
+    SECTION("Touched file with identical contents hits") {
+        auto hit = cache.lookup(lib, mtime + 1, size);
+        REQUIRE(hit.has_value());
+        REQUIRE(hit->mtime == mtime + 1);
+    }
+
+    SECTION("Rewritten file misses") {
+        writeFile(lib, "library contents v2");
+        REQUIRE_FALSE(cache.lookup(lib, mtime + 1, std::filesystem::file_size(lib)).has_value());
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -3,10 +3,14 @@
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <algorithm>
+#include <chrono>
 #include "plugins/plugin_registry.h"
 #include "plugins/plugin.h"
+#include "test_plugin_utils.h"
 
 using namespace roboclaw::plugins;
+using namespace roboclaw::plugins::test;
 
 TEST_CASE("Register and retrieve plugin", "[registry]") {
     PluginRegistry<IPlugin> registry;
@@ -392,3 +396,132 @@ TEST_CASE("Stress test: Rapid concurrent operations", "[registry][thread-safety]
     // At minimum, we should be able to list plugins
     REQUIRE(plugins.size() < 1000); // Sanity check
 }
+
+// ============================================================================
+// Snapshot and Handle Tests
+// ============================================================================
+
+TEST_CASE("Handle stays valid after unregistration", "[registry][handle]") {
+    PluginRegistry<IPlugin> registry;
+    REQUIRE(registry.registerPlugin("mock", std::make_shared<MockPlugin>()));
+
+    auto handle = registry.getHandle("mock");
+    REQUIRE(handle);
+    REQUIRE(registry.isCurrent(handle));
+
+    registry.unregisterPlugin("mock");
+
+    // Shared ownership keeps the plugin alive for the cached handle
+    REQUIRE_FALSE(registry.isCurrent(handle));
+    REQUIRE(handle->getName() == "mock");
+    REQUIRE(handle.get().use_count() == 1);
+
+    // Refreshing observes the unregistration
+    REQUIRE_FALSE(registry.refresh(handle, "mock"));
+    REQUIRE_FALSE(handle);
+}
+
+TEST_CASE("Refresh picks up a replaced plugin", "[registry][handle]") {
+    PluginRegistry<IPlugin> registry;
+    auto first = std::make_shared<MockPlugin>();
+    auto second = std::make_shared<MockPlugin>();
+    REQUIRE(registry.registerPlugin("mock", first));
+
+    auto handle = registry.getHandle("mock");
+    uint64_t version = registry.version();
+
+    // No change: refresh keeps the cached plugin
+    REQUIRE(registry.refresh(handle, "mock"));
+    REQUIRE(handle.get() == first);
+    REQUIRE(registry.version() == version);
+
+    REQUIRE(registry.registerPlugin("mock", second));
+    REQUIRE(registry.refresh(handle, "mock"));
+    REQUIRE(handle.get() == second);
+    REQUIRE(registry.isCurrent(handle));
+}
+
+TEST_CASE("Snapshot is immutable across writes", "[registry][snapshot]") {
+    PluginRegistry<IPlugin> registry;
+    REQUIRE(registry.registerPlugin("a", std::make_shared<MockPlugin>()));
+
+    auto before = registry.snapshot();
+    REQUIRE(registry.registerPlugin("b", std::make_shared<MockPlugin>()));
+    registry.unregisterPlugin("a");
+
+    REQUIRE(before->size() == 1);
+    REQUIRE(before->count("a") == 1);
+    REQUIRE(registry.snapshot()->size() == 1);
+    REQUIRE(registry.snapshot()->count("b") == 1);
+}
+
+TEST_CASE("No-op writes do not bump the version", "[registry][snapshot]") {
+    PluginRegistry<IPlugin> registry;
+    uint64_t version = registry.version();
+
+    registry.unregisterPlugin("missing");
+    registry.clear();
+
+    REQUIRE(registry.version() == version);
+}
+
+// Contention benchmark: hidden by default, run with `test_plugin_registry "[benchmark]"`
+TEST_CASE("Benchmark: lookups under writer contention", "[.][benchmark][registry]") {
+    PluginRegistry<IPlugin> registry;
+    constexpr int num_plugins = 40;
+    for (int i = 0; i < num_plugins; ++i) {
+        REQUIRE(registry.registerPlugin("plugin_" + std::to_string(i), std::make_shared<MockPlugin>()));
+    }
+
+    const int num_readers = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+    constexpr auto duration = std::chrono::milliseconds(500);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> lookups{0};
+    std::atomic<uint64_t> cached_calls{0};
+    std::atomic<uint64_t> writes{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_readers; ++t) {
+        threads.emplace_back([&, t]() {
+            uint64_t local_lookups = 0;
+            uint64_t local_cached = 0;
+            std::string id = "plugin_" + std::to_string(t % num_plugins);
+            auto handle = registry.getHandle(id);
+            while (!stop.load(std::memory_order_relaxed)) {
+                // Half the readers look up per call, half use a cached handle
+                if (t % 2 == 0) {
+                    if (registry.getPlugin(id)) ++local_lookups;
+                } else {
+                    if (registry.refresh(handle, id)) ++local_cached;
+                }
+            }
+            lookups += local_lookups;
+            cached_calls += local_cached;
+        });
+    }
+
+    // One writer churning a plugin that no reader uses
+    threads.emplace_back([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            (void)registry.registerPlugin("churn", std::make_shared<MockPlugin>());
+            registry.unregisterPlugin("churn");
+            writes += 2;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(duration).count();
+    WARN("readers: " << num_readers
+         << ", lookups/s: " << static_cast<uint64_t>(lookups / seconds)
+         << ", cached handle calls/s: " << static_cast<uint64_t>(cached_calls / seconds)
+         << ", writes/s: " << static_cast<uint64_t>(writes / seconds));
+    REQUIRE(lookups + cached_calls > 0);
+    REQUIRE(writes > 0);
+}
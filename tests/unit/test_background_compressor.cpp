@@ -0,0 +1,180 @@
+// 后台压缩器测试 / Background compressor tests
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include "../../src/optimization/background_compressor.h"
+
+using namespace roboclaw;
+
+namespace {
+
+std::vector<ChatMessage> makeHistory(size_t count) {
+    std::vector<ChatMessage> history;
+    for (size_t i = 0; i < count; ++i) {
+        history.emplace_back(i % 2 == 0 ? MessageRole::USER : MessageRole::ASSISTANT,
+                             "message " + std::to_string(i) + " " + std::string(200, 'x'));
+    }
+    return history;
+}
+
+BackgroundCompressionConfig smallConfig() {
+    BackgroundCompressionConfig config;
+    config.soft_threshold = 100;
+    config.keep_recent = 4;
+    config.min_segment_messages = 2;
+    return config;
+}
+
+} // namespace
+
+// 测试低于软阈值时原样返回 / History below the soft threshold passes through
+TEST(BackgroundCompressorTest, BelowThresholdPassesThrough) {
+    BackgroundCompressor compressor(std::make_shared<ThreadPool>(1), std::make_shared<TokenOptimizer>());
+    auto history = makeHistory(6);
+    auto messages = compressor.apply(history);
+    EXPECT_EQ(messages.size(), history.size());
+    EXPECT_EQ(compressor.getStats().jobs_started, 0u);
+}
+
+// 测试请求路径不等待摘要，完成后原子替换 / The request path never waits; the summary swaps in once ready
+TEST(BackgroundCompressorTest, SummaryIsComputedOffTheRequestPath) {
+    BackgroundCompressor compressor(std::make_shared<ThreadPool>(1), std::make_shared<TokenOptimizer>(),
+                                    smallConfig());
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::atomic<size_t> summarized{0};
+    compressor.setSummarizer([&](const std::vector<ChatMessage>& messages) {
+        gate.wait();
+        summarized = messages.size();
+        return std::string("[summary]");
+    });
+
+    auto history = makeHistory(12);
+    auto start = std::chrono::steady_clock::now();
+    auto first = compressor.apply(history);
+    auto second = compressor.apply(history);   // 任务进行中不重复调度 / no duplicate job while one runs
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(first.size(), history.size());
+    EXPECT_EQ(second.size(), history.size());
+    EXPECT_EQ(compressor.getStats().jobs_started, 1u);
+    EXPECT_EQ(compressor.version(), 0u);
+
+    release.set_value();
+    ASSERT_TRUE(compressor.waitIdle());
+    EXPECT_EQ(summarized.load(), 8u);
+    EXPECT_EQ(compressor.version(), 1u);
+
+    // 摘要 + 最近4条，新消息追加在后面 / Summary plus the 4 most recent messages, new messages appended
+    history.emplace_back(MessageRole::USER, "new");
+    auto third = compressor.apply(history);
+    ASSERT_EQ(third.size(), 6u);
+    EXPECT_EQ(third[0].role, MessageRole::SYSTEM);
+    EXPECT_EQ(third[0].content, "[summary]");
+    EXPECT_EQ(third[1].content, history[8].content);
+    EXPECT_EQ(third.back().content, "new");
+}
+
+// 测试不拆开工具调用和工具结果 / Tool results are never separated from their call
+TEST(BackgroundCompressorTest, KeepsToolResultsWithTheirCall) {
+    auto config = smallConfig();
+    BackgroundCompressor compressor(std::make_shared<ThreadPool>(1), std::make_shared<TokenOptimizer>(), config);
+    compressor.setSummarizer([](const std::vector<ChatMessage>&) { return std::string("[summary]"); });
+
+    auto history = makeHistory(8);
+    history[7].tool_calls.push_back({"call_1", "read", json::object()});
+    for (int i = 0; i < 3; ++i) {
+        ChatMessage result(MessageRole::TOOL, std::string(200, 'y'));
+        result.tool_call_id = "call_1";
+        history.push_back(result);
+    }
+    history.emplace_back(MessageRole::ASSISTANT, "done");
+
+    compressor.apply(history);
+    ASSERT_TRUE(compressor.waitIdle());
+    auto messages = compressor.apply(history);
+    // 边界8落在工具结果上，向后移到11 / Boundary 8 lands on a tool result and moves to 11
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[1].content, "done");
+}
+
+// 测试清空历史后丢弃进行中的结果 / Resetting discards an in-flight result
+TEST(BackgroundCompressorTest, ResetDiscardsInFlightJob) {
+    BackgroundCompressor compressor(std::make_shared<ThreadPool>(1), std::make_shared<TokenOptimizer>(),
+                                    smallConfig());
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    compressor.setSummarizer([gate](const std::vector<ChatMessage>&) {
+        gate.wait();
+        return std::string("[stale]");
+    });
+
+    auto history = makeHistory(12);
+    compressor.apply(history);
+    compressor.reset();
+    release.set_value();
+    ASSERT_TRUE(compressor.waitIdle());
+
+    EXPECT_EQ(compressor.version(), 0u);
+    EXPECT_EQ(compressor.getStats().jobs_discarded, 1u);
+
+    // 改写过的历史不会套用旧快照 / A rewritten history never picks up an old snapshot
+    compressor.setSummarizer([](const std::vector<ChatMessage>&) { return std::string("[fresh]"); });
+    compressor.apply(history);
+    ASSERT_TRUE(compressor.waitIdle());
+    history[7].content = "rewritten";
+    EXPECT_EQ(compressor.apply(history).size(), history.size());
+}
+
+// 测试段数超过上限时合并 / Old segments are merged once the limit is exceeded
+TEST(BackgroundCompressorTest, MergesOldestSegments) {
+    auto config = smallConfig();
+    config.max_segments = 2;
+    BackgroundCompressor compressor(std::make_shared<ThreadPool>(1), std::make_shared<TokenOptimizer>(), config);
+
+    auto history = makeHistory(8);
+    for (int round = 0; round < 3; ++round) {
+        compressor.apply(history);
+        ASSERT_TRUE(compressor.waitIdle());
+        auto more = makeHistory(4);
+        history.insert(history.end(), more.begin(), more.end());
+    }
+
+    auto stats = compressor.getStats();
+    EXPECT_EQ(stats.jobs_completed, 3u);
+    EXPECT_EQ(stats.segments, 2u);
+    EXPECT_EQ(stats.summarized_messages, 12u);
+
+    size_t summaryCount = 0;
+    auto messages = compressor.apply(history, &summaryCount);
+    EXPECT_EQ(summaryCount, 2u);
+    EXPECT_EQ(messages[0].role, MessageRole::SYSTEM);
+    EXPECT_EQ(messages[1].role, MessageRole::SYSTEM);
+    EXPECT_EQ(messages.size(), 2u + history.size() - 12u);
+}
+
+// 测试由调用方维护组合结果时的快照与调度 / Snapshot and scheduling when the caller keeps the composed context
+TEST(BackgroundCompressorTest, ObserveSchedulesFromComposedContext) {
+    BackgroundCompressor compressor(std::make_shared<ThreadPool>(1), std::make_shared<TokenOptimizer>(),
+                                    smallConfig());
+    compressor.setSummarizer([](const std::vector<ChatMessage>&) { return std::string("[summary]"); });
+
+    auto history = makeHistory(12);
+    EXPECT_EQ(compressor.current(history), nullptr);
+
+    // 组合结果未超过软阈值时不调度 / Nothing is scheduled while the composed context is small
+    compressor.observe(history, nullptr, makeHistory(1));
+    EXPECT_EQ(compressor.getStats().jobs_started, 0u);
+
+    compressor.observe(history, nullptr, history);
+    ASSERT_TRUE(compressor.waitIdle());
+    auto snapshot = compressor.current(history);
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->covered, 8u);
+    ASSERT_EQ(snapshot->segments.size(), 1u);
+    EXPECT_EQ(snapshot->segments[0].summary.content, "[summary]");
+
+    history[7].content = "rewritten";
+    EXPECT_EQ(compressor.current(history), nullptr);
+}
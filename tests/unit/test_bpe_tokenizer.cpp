@@ -0,0 +1,130 @@
+// BPE分词器测试 / BPE tokenizer tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include "../../src/optimization/bpe_tokenizer.h"
+#include "../../src/optimization/token_optimizer.h"
+#include "../../src/optimization/token_constants.h"
+
+using namespace roboclaw;
+
+namespace {
+
+std::filesystem::path writeFile(const std::string& name, const std::string& content) {
+    auto dir = std::filesystem::temp_directory_path() / "roboclaw_bpe_test";
+    std::filesystem::create_directories(dir);
+    auto path = dir / name;
+    std::ofstream(path, std::ios::binary) << content;
+    return path;
+}
+
+// 小型GPT-2格式词表（"Ġ"表示空格） / Tiny GPT-2 style vocabulary ("Ġ" encodes a space)
+std::shared_ptr<BpeTokenizer> makeGpt2Tokenizer() {
+    auto vocab = writeFile("vocab.json", R"({
+        "l": 0, "o": 1, "w": 2, "e": 3, "r": 4, "Ġ": 5, "!": 6,
+        "lo": 7, "low": 8, "er": 9, "Ġlow": 10
+    })");
+    auto merges = writeFile("merges.txt", "#version: 0.2\nl o\nlo w\ne r\nĠ low\n");
+    auto tokenizer = std::make_shared<BpeTokenizer>();
+    EXPECT_TRUE(tokenizer->load(vocab.string(), merges.string()));
+    return tokenizer;
+}
+
+// 小型tiktoken格式词表 / Tiny tiktoken style vocabulary
+std::shared_ptr<BpeTokenizer> makeTiktokenTokenizer() {
+    // a=0 b=1 c=2 ab=3 bc=4 abc=5
+    auto path = writeFile("vocab.tiktoken", "YQ== 0\nYg== 1\nYw== 2\nYWI= 3\nYmM= 4\nYWJj 5\n");
+    auto tokenizer = std::make_shared<BpeTokenizer>();
+    EXPECT_TRUE(tokenizer->loadTiktoken(path.string()));
+    return tokenizer;
+}
+
+} // namespace
+
+// 测试按合并优先级合并 / Merges are applied in rank order
+TEST(BpeTokenizerTest, Gpt2MergesByRank) {
+    auto tokenizer = makeGpt2Tokenizer();
+    EXPECT_EQ(tokenizer->vocabSize(), 11u);
+
+    EXPECT_EQ(tokenizer->encode("low"), (std::vector<uint32_t>{8}));
+    EXPECT_EQ(tokenizer->encode(" lower"), (std::vector<uint32_t>{10, 9}));
+    EXPECT_EQ(tokenizer->encode("low lower!"), (std::vector<uint32_t>{8, 10, 9, 6}));
+    EXPECT_EQ(tokenizer->decode(tokenizer->encode("low lower!")), "low lower!");
+    EXPECT_EQ(tokenizer->count("rowel"), 5u);  // 没有可用的合并 / no applicable merges
+}
+
+// 测试tiktoken格式的优先级即rank / tiktoken ranks double as merge priorities
+TEST(BpeTokenizerTest, TiktokenMerges) {
+    auto tokenizer = makeTiktokenTokenizer();
+    EXPECT_EQ(tokenizer->encode("abc"), (std::vector<uint32_t>{5}));
+    EXPECT_EQ(tokenizer->encode("abcb"), (std::vector<uint32_t>{5, 1}));
+    EXPECT_EQ(tokenizer->encode("bcab"), (std::vector<uint32_t>{4, 3}));
+    EXPECT_EQ(tokenizer->decode({4, 3}), "bcab");
+
+    // 第二次编码命中每线程缓存 / A second encode hits the per-thread cache
+    size_t misses = tokenizer->getCacheMisses();
+    tokenizer->count("bcab");
+    EXPECT_EQ(tokenizer->getCacheMisses(), misses);
+    EXPECT_GT(tokenizer->getCacheHits(), 0u);
+}
+
+// 测试预分词规则 / Pre-tokenizer splits like cl100k
+TEST(BpeTokenizerTest, Pretokenize) {
+    auto pieces = BpeTokenizer::pretokenize("Hello world's 12345  foo\n\nbar!!");
+    std::vector<std::string> actual(pieces.begin(), pieces.end());
+    EXPECT_EQ(actual, (std::vector<std::string>{
+        "Hello", " world", "'s", " ", "123", "45", " ", " foo", "\n\n", "bar", "!!"}));
+
+    pieces = BpeTokenizer::pretokenize("机器人，控制 motor");
+    actual.assign(pieces.begin(), pieces.end());
+    EXPECT_EQ(actual, (std::vector<std::string>{"机器人", "，控制", " motor"}));
+}
+
+// 测试并行批量计数与逐条结果一致 / Parallel batch counts match sequential counts
+TEST(BpeTokenizerTest, BatchMatchesSequential) {
+    auto tokenizer = makeGpt2Tokenizer();
+    tokenizer->setThreadPool(std::make_shared<ThreadPool>(4));
+
+    std::mt19937 rng(7);
+    const std::string alphabet = "lowerlow !";
+    std::vector<std::string> texts;
+    for (int i = 0; i < 200; ++i) {
+        std::string text;
+        size_t length = rng() % 64;
+        for (size_t j = 0; j < length; ++j) {
+            text += alphabet[rng() % alphabet.size()];
+        }
+        texts.push_back(text);
+    }
+
+    auto counts = tokenizer->countBatch(texts);
+    ASSERT_EQ(counts.size(), texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        EXPECT_EQ(counts[i], tokenizer->encode(texts[i]).size()) << texts[i];
+    }
+}
+
+// 测试TokenOptimizer使用分词器精确计数 / TokenOptimizer reports exact counts with a tokenizer
+TEST(BpeTokenizerTest, TokenOptimizerUsesTokenizer) {
+    auto tokenizer = makeGpt2Tokenizer();
+    TokenOptimizer optimizer;
+    optimizer.setTokenizer(tokenizer);
+    EXPECT_TRUE(optimizer.isExact());
+
+    std::vector<ChatMessage> history;
+    history.emplace_back(MessageRole::USER, "low lower");
+    history.emplace_back(MessageRole::ASSISTANT, "lower!");
+    history.back().tool_calls.push_back({"id", "low", json::object()});
+
+    int expected = 3 + 3 + 2 * TokenConstants::BPE_TOKENS_PER_MESSAGE +
+                   TokenConstants::BPE_TOKENS_PER_TOOL_CALL + 1 +
+                   static_cast<int>(tokenizer->count("{}"));
+    EXPECT_EQ(optimizer.estimateTokens(history), expected);
+    EXPECT_EQ(optimizer.estimateTokens(std::string("low lower")), 3);
+
+    // 工具参数变化使缓存失效 / Changing tool arguments invalidates the cached count
+    history.back().tool_calls[0].arguments = {{"w", "low"}};
+    EXPECT_GT(optimizer.estimateTokens(history), expected);
+}
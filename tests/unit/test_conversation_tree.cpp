@@ -0,0 +1,127 @@
+// 对话树测试 / Conversation tree tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "../../src/session/session_manager.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 添加一轮对话并切换过去 / Append one turn and move to it
+NodeHandle addTurn(ConversationTree& tree, const std::string& user, const std::string& reply) {
+    auto node = tree.addNode(tree.getCurrentNodeId(), user);
+    tree.switchToNode(node->getId());
+    ConversationNode::AssistantMessage message;
+    message.content = reply;
+    tree.setAssistantMessage(node->getId(), message);
+    return tree.findNode(node->getId());
+}
+
+} // namespace
+
+// 测试句柄路径与字符串路径一致 / Handle paths match the string-id path
+TEST(ConversationTreeTest, PathToFollowsParents) {
+    ConversationTree tree;
+    NodeHandle a = addTurn(tree, "a", "1");
+    NodeHandle b = addTurn(tree, "b", "2");
+    tree.switchToNode(tree.nodeId(a));
+    NodeHandle c = addTurn(tree, "c", "3");
+
+    std::vector<NodeHandle> path;
+    tree.pathTo(c, path);
+    EXPECT_EQ(path, (std::vector<NodeHandle>{tree.getRootHandle(), a, c}));
+    EXPECT_EQ(tree.depthOf(c), 2u);
+    EXPECT_EQ(tree.depthOf(b), 2u);
+
+    // 复用缓冲区 / The buffer is reused
+    path.reserve(16);
+    const NodeHandle* data = path.data();
+    tree.pathTo(b, path);
+    EXPECT_EQ(path.data(), data);
+    EXPECT_EQ(path, (std::vector<NodeHandle>{tree.getRootHandle(), a, b}));
+
+    EXPECT_EQ(tree.getPath(), (std::vector<std::string>{tree.nodeId(tree.getRootHandle()), tree.nodeId(a), tree.nodeId(c)}));
+    EXPECT_EQ(tree.getConversationHistory(), (std::vector<std::string>{"a", "c"}));
+    ASSERT_EQ(tree.childrenOf(a).size(), 2u);
+    EXPECT_EQ(tree.childrenOf(a)[0], b);
+    EXPECT_EQ(tree.parentOf(c), a);
+    EXPECT_EQ(tree.findNode("missing"), INVALID_NODE);
+}
+
+// 测试旧格式JSON往返 / The inline JSON format still round-trips
+TEST(ConversationTreeTest, InlineJsonRoundTrip) {
+    ConversationTree tree("conv");
+    addTurn(tree, "hello", "world");
+    auto branch = tree.createBranch(tree.getCurrentNodeId(), "alt");
+    tree.switchToNode(branch->getId());
+
+    ConversationTree copy;
+    ASSERT_TRUE(copy.fromJson(tree.toJson()));
+    EXPECT_EQ(copy.getConversationId(), "conv");
+    EXPECT_EQ(copy.getNodeCount(), 3u);
+    EXPECT_EQ(copy.getCurrentNodeId(), branch->getId());
+    EXPECT_EQ(copy.getBranchNames(), (std::vector<std::string>{"alt"}));
+    EXPECT_EQ(copy.getConversationHistory(), (std::vector<std::string>{"hello"}));
+    auto parent = copy.getNode(copy.getCurrentNode()->getParentId());
+    EXPECT_EQ(parent->getAssistantMessage().content, "world");
+    EXPECT_EQ(copy.getAllNodes().size(), 3u);
+}
+
+// 测试快照加载时正文按需读取 / Snapshot loads read message bodies on demand
+TEST(ConversationTreeTest, LoadsBodiesLazily) {
+    fs::path dir = fs::temp_directory_path() / "roboclaw_conversation_tree_test";
+    fs::remove_all(dir);
+
+    std::string id;
+    {
+        SessionManager manager;
+        manager.setSessionsDir(dir.string());
+        auto session = manager.createSession();
+        id = session->getConversationId();
+        for (int i = 0; i < 10; ++i) {
+            addTurn(*session, "question " + std::to_string(i), "answer " + std::to_string(i));
+        }
+        auto branch = session->createBranch(session->getRoot()->getId(), "side");
+        session->switchToNode(branch->getId());
+        addTurn(*session, "side question", "side answer");
+
+        // 压缩为快照+正文文件 / Compact into a snapshot plus a body file
+        SessionLog log((dir / id).string());
+        json snapshot;
+        std::vector<json> records;
+        ASSERT_TRUE(manager.saveSession(session));
+        manager.flush();
+        ASSERT_TRUE(log.recover(snapshot, records));
+        std::string bodies;
+        ASSERT_TRUE(log.compact(session->toSnapshot(bodies), bodies));
+        EXPECT_FALSE(log.bodiesPath().empty());
+    }
+
+    SessionManager manager;
+    manager.setSessionsDir(dir.string());
+    auto session = manager.loadSession(id);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->getNodeCount(), 13u);
+    // 根节点和分支起点没有正文 / The root and the branch point have no body
+    EXPECT_EQ(session->getLoadedBodyCount(), 2u);
+
+    // 只读取当前路径上的正文 / Only bodies on the current path are read
+    EXPECT_EQ(session->getConversationHistory(), (std::vector<std::string>{"side question"}));
+    EXPECT_EQ(session->getLoadedBodyCount(), 3u);
+    EXPECT_EQ(session->assistantMessageOf(session->getCurrentHandle()).content, "side answer");
+
+    // 再次压缩时未加载的正文原样复制 / Unloaded bodies are copied as-is on recompaction
+    std::string bodies;
+    json snapshot = session->toSnapshot(bodies);
+    EXPECT_EQ(snapshot["nodes"].size(), 13u);
+    EXPECT_EQ(session->getLoadedBodyCount(), 3u);
+    ConversationTree copy;
+    ASSERT_TRUE(copy.fromJson(session->toJson()));
+    NodeHandle first = copy.childrenOf(copy.getRootHandle())[0];
+    EXPECT_EQ(copy.userMessageOf(first), "question 0");
+    EXPECT_EQ(copy.assistantMessageOf(first).content, "answer 0");
+
+    fs::remove_all(dir);
+}
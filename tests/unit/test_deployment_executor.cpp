@@ -0,0 +1,120 @@
+// tests/unit/test_deployment_executor.cpp
+// Unit tests for the closed-loop progressive deployment executor
+
+#include <gtest/gtest.h>
+#include "../../src/simulation/deployment_executor.h"
+#include "../../src/simulation/sim2real_transfer.h"
+
+using namespace roboclaw::simulation;
+
+namespace {
+
+std::vector<DeploymentStage> shortStages() {
+    return {
+        {30, 0.5, 2.0, 0.05, "Low power"},
+        {60, 1.0, 4.0, 0.05, "Medium power"},
+        {100, 2.0, 8.0, 0.05, "Full power"}
+    };
+}
+
+DeploymentExecutorConfig simulatedTime() {
+    DeploymentExecutorConfig config;
+    config.real_time = false;
+    return config;
+}
+
+} // namespace
+
+TEST(DeploymentExecutorTest, CompletesAllStagesWithinLimits) {
+    auto plant = std::make_shared<SimulatedPlant>();
+    DeploymentExecutor executor(plant, simulatedTime());
+
+    std::vector<int> reported;
+    auto report = executor.run({{"max_velocity", 2.0}}, shortStages(),
+        [&](int stage, const std::string&) {
+            reported.push_back(stage);
+            return true;
+        });
+
+    EXPECT_TRUE(report.success);
+    EXPECT_FALSE(report.rolled_back);
+    EXPECT_EQ(report.completed_stages, 3);
+    EXPECT_EQ(report.failed_stage, -1);
+    EXPECT_EQ(report.ticks, 150u);
+    EXPECT_EQ(reported, (std::vector<int>{0, 1, 2}));
+    EXPECT_LE(report.max_velocity, 2.0);
+    EXPECT_GT(report.max_velocity, 0.0);
+    EXPECT_FALSE(plant->isStopped());
+}
+
+TEST(DeploymentExecutorTest, RollsBackOnAccelerationViolation) {
+    auto plant = std::make_shared<SimulatedPlant>();
+    plant->setDisturbance(100.0);
+    DeploymentExecutor executor(plant, simulatedTime());
+
+    auto report = executor.run({}, shortStages());
+
+    EXPECT_FALSE(report.success);
+    EXPECT_TRUE(report.rolled_back);
+    EXPECT_EQ(report.failed_stage, 0);
+    EXPECT_NE(report.failure_reason.find("acceleration"), std::string::npos);
+    // Reacts within the debounce window, not at the end of the stage
+    EXPECT_EQ(report.ticks, 3u);
+    // No stage completed, so the plant is stopped rather than rolled back
+    EXPECT_TRUE(plant->isStopped());
+}
+
+TEST(DeploymentExecutorTest, RollsBackToLastGoodStage) {
+    auto plant = std::make_shared<SimulatedPlant>();
+    auto stages = shortStages();
+    stages[1].power_percentage = 0;  // Rejected by the plant
+    DeploymentExecutor executor(plant, simulatedTime());
+
+    auto report = executor.run({}, stages);
+
+    EXPECT_FALSE(report.success);
+    EXPECT_EQ(report.failed_stage, 1);
+    EXPECT_EQ(report.completed_stages, 1);
+    EXPECT_FALSE(plant->isStopped());
+    EXPECT_EQ(plant->getAppliedParameters()["power_percentage"], 30);
+}
+
+TEST(DeploymentExecutorTest, ProgressCallbackAbortRollsBack) {
+    auto plant = std::make_shared<SimulatedPlant>();
+    DeploymentExecutor executor(plant);
+
+    auto report = executor.run({}, shortStages(),
+        [](int stage, const std::string&) { return stage < 1; });
+
+    EXPECT_FALSE(report.success);
+    EXPECT_TRUE(report.rolled_back);
+    EXPECT_EQ(report.failed_stage, 1);
+    EXPECT_EQ(plant->getAppliedParameters()["power_percentage"], 30);
+}
+
+TEST(DeploymentExecutorTest, RealTimeLoopRunsAtFixedRate) {
+    auto plant = std::make_shared<SimulatedPlant>();
+    DeploymentExecutor executor(plant);
+
+    size_t samples = 0;
+    executor.setTelemetryCallback([&](const TelemetrySample&) { ++samples; });
+
+    auto start = std::chrono::steady_clock::now();
+    auto report = executor.run({}, shortStages());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(report.ticks, 150u);
+    EXPECT_EQ(samples + report.telemetry_dropped, 150u);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(140));
+}
+
+TEST(DeploymentExecutorTest, Sim2RealDryRunWithoutPlant) {
+    Sim2RealTransfer transfer;
+    auto stages = transfer.getDefaultDeploymentStages();
+
+    EXPECT_TRUE(transfer.progressiveDeployment({{"max_velocity", 2.0}}, stages));
+    auto report = transfer.getLastDeploymentReport();
+    EXPECT_EQ(report.completed_stages, static_cast<int>(stages.size()));
+    EXPECT_EQ(report.telemetry_dropped, 0u);
+}
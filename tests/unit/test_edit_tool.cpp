@@ -0,0 +1,140 @@
+// 编辑引擎测试 / Edit engine tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "../../src/tools/edit_tool.h"
+#include "../../src/utils/atomic_file.h"
+#include "../../src/utils/string_search.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+class EditToolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / ("roboclaw_edit_tool_test_" + std::to_string(std::random_device{}()));
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string writeFile(const std::string& name, const std::string& content) {
+        std::string path = (dir_ / name).string();
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    fs::path dir_;
+};
+
+// 测试向量化查找与std::string_view::find一致 / Test vectorized search matches std::string_view::find
+TEST_F(EditToolTest, FindSubstringMatchesStdFind) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter('a', 'c');
+    std::string haystack;
+    for (int i = 0; i < 5000; ++i) {
+        haystack += static_cast<char>(letter(rng));
+    }
+
+    for (size_t length : {1u, 2u, 3u, 5u, 17u, 40u}) {
+        for (int trial = 0; trial < 50; ++trial) {
+            size_t start = std::uniform_int_distribution<size_t>(0, haystack.size() - length)(rng);
+            std::string needle = trial % 2 ? haystack.substr(start, length) : std::string(length, 'a');
+            size_t from = std::uniform_int_distribution<size_t>(0, haystack.size())(rng);
+            ASSERT_EQ(findSubstring(haystack, needle, from), std::string_view(haystack).find(needle, from))
+                << "needle=" << needle << " from=" << from;
+        }
+    }
+    EXPECT_EQ(findSubstring("abc", "abcd"), std::string_view::npos);
+    EXPECT_EQ(findSubstring("abc", "c", 5), std::string_view::npos);
+}
+
+// 测试原子写入保留权限并写穿符号链接 / Test atomic writes keep permissions and follow symlinks
+TEST_F(EditToolTest, AtomicWritePreservesPermissions) {
+    std::string path = writeFile("script.sh", "old");
+    fs::permissions(path, fs::perms::owner_all | fs::perms::group_read);
+
+    std::string error;
+    ASSERT_TRUE(writeFileAtomic(path, std::vector<std::string_view>{"#!/bin/sh", "\n", "echo hi\n"}, error)) << error;
+    EXPECT_EQ(readFile(path), "#!/bin/sh\necho hi\n");
+    EXPECT_EQ(fs::status(path).permissions() & fs::perms::all, fs::perms::owner_all | fs::perms::group_read);
+
+    fs::path link = dir_ / "link.sh";
+    fs::create_symlink(path, link);
+    ASSERT_TRUE(writeFileAtomic(link.string(), "via link\n", error)) << error;
+    EXPECT_TRUE(fs::is_symlink(link));
+    EXPECT_EQ(readFile(path), "via link\n");
+
+    // 没有残留的临时文件 / No temporary files are left behind
+    size_t entries = std::distance(fs::directory_iterator(dir_), fs::directory_iterator());
+    EXPECT_EQ(entries, 2u);
+}
+
+// 测试跨行匹配且保留原始字节 / Test matches spanning lines keep the other bytes exact
+TEST_F(EditToolTest, ReplacesAcrossLinesExactly) {
+    std::string path = writeFile("main.c", "int a;\r\nvoid f(void)\r\n{\r\n}\r\nvoid f(void)\r\n{\r\n}");
+
+    EditTool tool;
+    ToolResult result = tool.execute({{"path", path},
+                                      {"old_string", "void f(void)\r\n{\r\n}"},
+                                      {"new_string", "void g(void) {}"}});
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(result.metadata["replace_count"], 2);
+    EXPECT_EQ(result.metadata["affected_lines"], (std::vector<int>{2, 5}));
+    EXPECT_EQ(readFile(path), "int a;\r\nvoid g(void) {}\r\nvoid g(void) {}");
+}
+
+// 测试批量编辑一次完成 / Test batched edits apply in one pass
+TEST_F(EditToolTest, AppliesBatchedEdits) {
+    std::string path = writeFile("hal.c", "HAL_Init();\nMX_GPIO_Init();\nMX_USART1_Init();\n");
+
+    EditTool tool;
+    json edits = json::array({{{"old_string", "MX_GPIO_Init"}, {"new_string", "MX_USART1_Init"}},
+                              {{"old_string", "MX_USART1_Init"}, {"new_string", "MX_GPIO_Init"}}});
+    ToolResult result = tool.execute({{"path", path}, {"edits", edits}});
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(result.metadata["replace_count"], 2);
+    EXPECT_EQ(result.metadata["affected_lines"], (std::vector<int>{2, 3}));
+    // 都针对原始内容匹配，互换不会相互影响 / Edits match the original, so a swap works
+    EXPECT_EQ(readFile(path), "HAL_Init();\nMX_USART1_Init();\nMX_GPIO_Init();\n");
+}
+
+// 测试批量编辑失败时不修改文件 / Test failed batches leave the file untouched
+TEST_F(EditToolTest, RejectsMissingOrOverlappingEdits) {
+    const std::string original = "abcdef\n";
+    std::string path = writeFile("data.txt", original);
+
+    EditTool tool;
+    ToolResult missing = tool.execute({{"path", path},
+        {"edits", json::array({{{"old_string", "abc"}, {"new_string", "x"}},
+                               {{"old_string", "zzz"}, {"new_string", "y"}}})}});
+    EXPECT_FALSE(missing.success);
+    EXPECT_NE(missing.error_message.find("第2处"), std::string::npos);
+
+    ToolResult overlap = tool.execute({{"path", path},
+        {"edits", json::array({{{"old_string", "abcd"}, {"new_string", "x"}},
+                               {{"old_string", "cdef"}, {"new_string", "y"}}})}});
+    EXPECT_FALSE(overlap.success);
+    EXPECT_NE(overlap.error_message.find("重叠"), std::string::npos);
+
+    EXPECT_FALSE(tool.execute({{"path", path}, {"edits", json::array()}}).success);
+    EXPECT_EQ(readFile(path), original);
+}
+
+} // namespace
@@ -0,0 +1,250 @@
+// tests/unit/test_flash_scheduler.cpp
+// Unit tests for parallel multi-target firmware flashing
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include "../../src/embedded/flash_scheduler.h"
+
+using namespace roboclaw::embedded;
+using roboclaw::plugins::ProgrammerInfo;
+
+namespace {
+
+class FlashSchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("roboclaw_flash_scheduler_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::string writeImage(const std::string& name, size_t size, uint8_t seed) {
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>((i * 31 + seed) & 0xFF);
+        }
+        std::string path = (dir_ / name).string();
+        std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+        return path;
+    }
+
+    static std::vector<ProgrammerInfo> programmers(int count) {
+        std::vector<ProgrammerInfo> result;
+        for (int i = 0; i < count; ++i) {
+            result.push_back({"stlink_" + std::to_string(i), "ST-Link V2",
+                              "/dev/ttyACM" + std::to_string(i), true});
+        }
+        return result;
+    }
+
+    std::filesystem::path dir_;
+};
+
+// Platform plugin whose boards report their own flash checksum
+class ReadbackPlatform : public roboclaw::plugins::IEmbeddedPlatform {
+public:
+    std::string getName() const override { return "readback"; }
+    std::string getVersion() const override { return "1.0.0"; }
+    bool initialize(const nlohmann::json&) override { return true; }
+    void shutdown() override {}
+
+    bool configureProject(const roboclaw::plugins::ProjectConfig&) override { return true; }
+    bool generateCode(const roboclaw::plugins::DriverSpec&) override { return true; }
+    bool buildProject() override { return true; }
+    nlohmann::json optimizeParameters(const std::string&, const nlohmann::json& current,
+                                      const std::vector<roboclaw::plugins::TestResult>&) override {
+        return current;
+    }
+    std::vector<std::string> getOptimizationMethods() const override { return {}; }
+    std::vector<ProgrammerInfo> detectProgrammers() override { return {}; }
+    std::vector<ProgrammerInfo> scanConnectedHardware() override { return {}; }
+
+    bool flashFirmware(const std::string& firmware_path, const std::string& programmer_id) override {
+        std::ifstream file(firmware_path, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (on_flash) {
+            on_flash();
+        }
+        if (programmer_id == corrupt_id && !data.empty()) {
+            data[0] ^= 0x01;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        flash[programmer_id] = std::move(data);
+        return true;
+    }
+
+    // Board-agnostic check that cannot catch a single bad board
+    bool verifyFirmware(const std::string&) override { return true; }
+
+    std::optional<uint32_t> readFlashChecksum(const std::string& programmer_id, size_t length) override {
+        if (!readback) {
+            return std::nullopt;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto& data = flash[programmer_id];
+        return FirmwareImage::computeCrc32(data.data(), std::min(length, data.size()));
+    }
+
+    std::string corrupt_id;
+    bool readback = true;
+    std::function<void()> on_flash;
+    std::mutex mutex;
+    std::map<std::string, std::vector<uint8_t>> flash;
+};
+
+} // namespace
+
+TEST(FirmwareImageTest, Crc32MatchesReferenceValue) {
+    const std::string check = "123456789";
+    EXPECT_EQ(FirmwareImage::computeCrc32(reinterpret_cast<const uint8_t*>(check.data()), check.size()),
+              0xCBF43926u);
+}
+
+TEST_F(FlashSchedulerTest, FlashesAllBoardsConcurrently) {
+    auto path = writeImage("app.bin", 64 * 1024, 7);
+    auto backend = std::make_shared<SimulatedFlashBackend>(4096, std::chrono::microseconds(500));
+    FlashScheduler scheduler(backend);
+
+    auto report = scheduler.flashAll(programmers(8), path);
+
+    EXPECT_TRUE(report.allSucceeded());
+    EXPECT_EQ(report.succeeded, 8u);
+    EXPECT_GT(backend->getPeakConcurrency(), 1);
+    for (const auto& result : report.results) {
+        EXPECT_TRUE(result.verification_passed);
+        EXPECT_EQ(result.bytes_written, 64 * 1024);
+    }
+    EXPECT_EQ(backend->getMemory("stlink_3").size(), 64u * 1024u);
+}
+
+TEST_F(FlashSchedulerTest, SharedImageIsReadOnce) {
+    auto app = writeImage("app.bin", 8192, 1);
+    auto boot = writeImage("boot.bin", 1024, 2);
+    FlashScheduler scheduler(std::make_shared<SimulatedFlashBackend>());
+
+    std::vector<FlashJob> jobs;
+    for (const auto& programmer : programmers(6)) {
+        jobs.push_back({programmer, jobs.size() % 3 == 0 ? boot : app});
+    }
+
+    auto report = scheduler.run(jobs);
+    EXPECT_TRUE(report.allSucceeded());
+    EXPECT_EQ(report.images_loaded, 2u);
+
+    // Unchanged files stay cached for the next batch
+    report = scheduler.run(jobs);
+    EXPECT_EQ(report.images_loaded, 0u);
+    EXPECT_EQ(scheduler.getImageCache().loadCount(), 2u);
+}
+
+TEST_F(FlashSchedulerTest, ChecksumMismatchFailsOnlyThatBoard) {
+    auto path = writeImage("app.bin", 4096, 3);
+    auto backend = std::make_shared<SimulatedFlashBackend>(512);
+    backend->setCorruption("stlink_1", true);
+    backend->setFailure("stlink_2", true);
+    FlashScheduler scheduler(backend);
+
+    auto report = scheduler.flashAll(programmers(4), path);
+
+    EXPECT_EQ(report.succeeded, 2u);
+    EXPECT_EQ(report.failed, 2u);
+    ASSERT_EQ(report.results.size(), 4u);
+    EXPECT_TRUE(report.results[0].success);
+    EXPECT_FALSE(report.results[1].success);
+    EXPECT_NE(report.results[1].messages.back().find("Checksum mismatch"), std::string::npos);
+    EXPECT_FALSE(report.results[2].success);
+    EXPECT_TRUE(report.results[3].success);
+}
+
+TEST_F(FlashSchedulerTest, ReportsPerDeviceProgress) {
+    auto path = writeImage("app.bin", 4096, 4);
+    FlashScheduler scheduler(std::make_shared<SimulatedFlashBackend>(1024));
+
+    std::map<std::string, std::vector<std::string>> phases;
+    auto report = scheduler.flashAll(programmers(3), path, FlashOptions{},
+        [&](const FlashProgress& event) { phases[event.programmer_id].push_back(event.phase); });
+
+    EXPECT_TRUE(report.allSucceeded());
+    ASSERT_EQ(phases.size(), 3u);
+    for (const auto& [id, sequence] : phases) {
+        EXPECT_EQ(sequence.front(), "erase") << id;
+        EXPECT_EQ(std::count(sequence.begin(), sequence.end(), "write"), 4) << id;
+        EXPECT_EQ(sequence.back(), "done") << id;
+    }
+}
+
+TEST_F(FlashSchedulerTest, RespectsParallelLimitAndMissingFiles) {
+    auto path = writeImage("app.bin", 8192, 5);
+    auto backend = std::make_shared<SimulatedFlashBackend>(1024, std::chrono::microseconds(200));
+    FlashSchedulerConfig config;
+    config.max_parallel = 2;
+    FlashScheduler scheduler(backend, config);
+
+    auto boards = programmers(5);
+    std::vector<FlashJob> jobs;
+    for (const auto& programmer : boards) {
+        jobs.push_back({programmer, path});
+    }
+    jobs.back().firmware_path = (dir_ / "missing.bin").string();
+
+    auto report = scheduler.run(jobs);
+
+    EXPECT_LE(backend->getPeakConcurrency(), 2);
+    EXPECT_EQ(report.succeeded, 4u);
+    EXPECT_FALSE(report.results.back().success);
+    EXPECT_TRUE(backend->getMemory(boards.back().id).empty());
+}
+
+TEST_F(FlashSchedulerTest, PlatformBackendVerifiesEachBoardAgainstImageCrc) {
+    auto path = writeImage("app.bin", 2048, 9);
+    auto platform = std::make_shared<ReadbackPlatform>();
+    platform->corrupt_id = "stlink_2";
+    FlashScheduler scheduler(std::make_shared<PlatformFlashBackend>(platform));
+
+    auto report = scheduler.flashAll(programmers(3), path);
+
+    EXPECT_EQ(report.succeeded, 2u);
+    ASSERT_EQ(report.results.size(), 3u);
+    EXPECT_TRUE(report.results[0].verification_passed);
+    EXPECT_FALSE(report.results[2].success);
+    EXPECT_NE(report.results[2].messages.back().find("Checksum mismatch"), std::string::npos);
+}
+
+TEST_F(FlashSchedulerTest, PlatformBackendFlashesTheLoadedImage) {
+    auto path = writeImage("app.bin", 2048, 9);
+    auto platform = std::make_shared<ReadbackPlatform>();
+    // The file is rebuilt while the batch is running
+    std::once_flag rebuilt;
+    platform->on_flash = [&] { std::call_once(rebuilt, [&] { writeImage("app.bin", 1024, 42); }); };
+    FlashScheduler scheduler(std::make_shared<PlatformFlashBackend>(platform));
+
+    auto report = scheduler.flashAll(programmers(3), path);
+
+    EXPECT_TRUE(report.allSucceeded());
+    for (const auto& board : programmers(3)) {
+        EXPECT_EQ(platform->flash[board.id].size(), 2048u);
+    }
+}
+
+TEST_F(FlashSchedulerTest, PlatformBackendNeverPassesUnsupportedVerification) {
+    auto path = writeImage("app.bin", 2048, 9);
+    auto platform = std::make_shared<ReadbackPlatform>();
+    platform->readback = false;
+    FlashScheduler scheduler(std::make_shared<PlatformFlashBackend>(platform));
+
+    auto report = scheduler.flashAll(programmers(2), path);
+
+    EXPECT_EQ(report.succeeded, 0u);
+    for (const auto& result : report.results) {
+        EXPECT_FALSE(result.verification_passed);
+        EXPECT_NE(result.messages.back().find("cannot read back or verify"), std::string::npos);
+    }
+}
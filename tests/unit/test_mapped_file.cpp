@@ -0,0 +1,175 @@
+// 内存映射文件与行索引测试 / Mapped file and line index tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "../../src/utils/mapped_file.h"
+#include "../../src/tools/read_tool.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / ("roboclaw_mapped_file_test_" + std::to_string(std::random_device{}()));
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string writeFile(const std::string& name, const std::string& content) {
+        std::string path = (dir_ / name).string();
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    // 参照实现：std::getline逐行读取 / Reference: split with std::getline
+    static std::vector<std::string> getlines(const std::string& content) {
+        std::vector<std::string> lines;
+        std::istringstream in(content);
+        std::string line;
+        while (std::getline(in, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    fs::path dir_;
+};
+
+// 测试行划分与getline一致 / Test line splitting matches std::getline
+TEST_F(MappedFileTest, LineIndexMatchesGetline) {
+    std::mt19937 rng(42);
+    for (std::string content : {std::string(), std::string("\n"), std::string("a"), std::string("a\n"),
+                                std::string("\n\n\nx"), std::string("a\r\nb\r\n")}) {
+        auto index = LineIndex::build(content);
+        auto expected = getlines(content);
+        ASSERT_EQ(index.lineCount(), expected.size()) << content;
+    }
+
+    // 跨越SIMD块和检查点边界的随机内容 / Random content crossing SIMD blocks and checkpoints
+    std::string content;
+    std::uniform_int_distribution<int> length(0, 150);
+    for (int i = 0; i < 2000; ++i) {
+        content.append(static_cast<size_t>(length(rng)), static_cast<char>('a' + i % 26));
+        content += '\n';
+    }
+    content += "tail";
+
+    auto index = LineIndex::build(content);
+    auto expected = getlines(content);
+    ASSERT_EQ(index.lineCount(), expected.size());
+    for (size_t line = 0; line < expected.size(); ++line) {
+        size_t start = index.lineStart(content, line);
+        ASSERT_EQ(content.compare(start, expected[line].size(), expected[line]), 0) << "line " << line;
+    }
+    EXPECT_EQ(index.lineStart(content, expected.size()), content.size());
+    EXPECT_LT(index.memoryUsage(), expected.size() * sizeof(uint64_t));
+}
+
+// 测试文件映射 / Test mapping files
+TEST_F(MappedFileTest, MapsRegularFilesOnly) {
+    std::string path = writeFile("data.txt", "hello\nworld\n");
+
+    MappedFile file;
+    std::string error;
+    ASSERT_TRUE(file.open(path, error)) << error;
+    EXPECT_EQ(file.view(), "hello\nworld\n");
+    EXPECT_EQ(file.stamp().size, 12u);
+
+    MappedFile empty;
+    ASSERT_TRUE(empty.open(writeFile("empty.txt", ""), error));
+    EXPECT_EQ(empty.size(), 0u);
+
+    MappedFile missing;
+    EXPECT_FALSE(missing.open((dir_ / "missing.txt").string(), error));
+    EXPECT_NE(error.find("不存在"), std::string::npos);
+
+    MappedFile directory;
+    EXPECT_FALSE(directory.open(dir_.string(), error));
+}
+
+// 测试窗口读取不受整文件大小限制 / Test windowed reads are not limited by file size
+TEST_F(MappedFileTest, ReadToolReadsWindowsOfLargeFiles) {
+    std::string content;
+    const int totalLines = 400000;
+    for (int i = 0; i < totalLines; ++i) {
+        content += "robot log line " + std::to_string(i) + " ........................\n";
+    }
+    ASSERT_GT(content.size(), 10u * 1024 * 1024);
+    std::string path = writeFile("robot.log", content);
+
+    ReadTool tool;
+    ToolResult full = tool.execute({{"path", path}});
+    EXPECT_FALSE(full.success);
+
+    ToolResult window = tool.execute({{"path", path}, {"offset", 300000}, {"limit", 3}});
+    ASSERT_TRUE(window.success) << window.error_message;
+    EXPECT_EQ(window.content,
+              "robot log line 300000 ........................\n"
+              "robot log line 300001 ........................\n"
+              "robot log line 300002 ........................\n");
+    EXPECT_EQ(window.metadata["total_lines"], totalLines);
+    EXPECT_EQ(window.metadata["lines_read"], 3);
+
+    ToolResult last = tool.execute({{"path", path}, {"offset", totalLines - 1}, {"limit", 10}});
+    ASSERT_TRUE(last.success);
+    EXPECT_EQ(last.metadata["lines_read"], 1);
+
+    EXPECT_FALSE(tool.execute({{"path", path}, {"offset", totalLines}, {"limit", 1}}).success);
+}
+
+// 测试文件被原地截断后读取不会访问映射 / Test reads after an in-place truncation do not touch the mapping
+TEST_F(MappedFileTest, ReadsStopAtTruncatedEnd) {
+    std::string content;
+    for (int i = 0; i < 1000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    std::string path = writeFile("rotated.log", content);
+
+    MappedFile file;
+    std::string error;
+    ASSERT_TRUE(file.open(path, error)) << error;
+
+    LineIndex index;
+    ASSERT_TRUE(LineIndex::build(file, index));
+    auto reference = LineIndex::build(content);
+    ASSERT_EQ(index.lineCount(), reference.lineCount());
+    for (size_t line : {0u, 1u, 63u, 64u, 65u, 500u, 999u, 1000u}) {
+        EXPECT_EQ(index.lineStart(file, line), reference.lineStart(content, line)) << "line " << line;
+    }
+
+    // 日志轮转：原地截断到一半 / Log rotation truncates the file in place
+    fs::resize_file(path, content.size() / 2);
+
+    std::string tail(100, '\0');
+    EXPECT_EQ(file.read(content.size() - 100, tail.size(), tail.data()), 0u);
+    EXPECT_EQ(file.read(content.size() / 2 - 10, tail.size(), tail.data()), 10u);
+    EXPECT_FALSE(LineIndex::build(file, index));
+}
+
+// 测试文件变化后重建索引 / Test the cached index is rebuilt after the file changes
+TEST_F(MappedFileTest, ReadToolRebuildsIndexWhenFileChanges) {
+    std::string path = writeFile("changing.txt", "one\ntwo");
+
+    ReadTool tool;
+    ToolResult first = tool.execute({{"path", path}});
+    ASSERT_TRUE(first.success);
+    EXPECT_EQ(first.content, "one\ntwo\n");
+    EXPECT_EQ(first.metadata["total_lines"], 2);
+
+    writeFile("changing.txt", "one\ntwo\nthree\nfour\n");
+    ToolResult second = tool.execute({{"path", path}, {"offset", 2}});
+    ASSERT_TRUE(second.success);
+    EXPECT_EQ(second.content, "three\nfour\n");
+    EXPECT_EQ(second.metadata["total_lines"], 4);
+}
+
+} // namespace
@@ -0,0 +1,178 @@
+// 增量请求体序列化测试 / Incremental request serializer tests
+
+#include <gtest/gtest.h>
+#include "../../src/llm/request_serializer.h"
+#include "../../src/llm/llm_provider.h"
+
+using namespace roboclaw;
+
+namespace {
+
+json convert(const ChatMessage& msg, bool breakpoint = false) {
+    json j = msg.toJson();
+    if (breakpoint) {
+        j["cache_control"] = {{"type", "ephemeral"}};
+    }
+    return j;
+}
+
+std::vector<ChatMessage> conversation(int count) {
+    std::vector<ChatMessage> messages;
+    for (int i = 0; i < count; ++i) {
+        messages.emplace_back(i % 2 == 0 ? MessageRole::USER : MessageRole::ASSISTANT,
+                              "message " + std::to_string(i));
+    }
+    return messages;
+}
+
+// 参照实现：完整转换并序列化 / Reference: full conversion and dump
+std::string fullDump(const json& fields, const std::vector<ChatMessage>& messages) {
+    json request = fields;
+    json converted = json::array();
+    for (const auto& msg : messages) {
+        converted.push_back(convert(msg));
+    }
+    request["messages"] = converted;
+    return request.dump();
+}
+
+} // namespace
+
+// 测试输出与完整序列化等价 / Output matches a full serialization
+TEST(RequestSerializerTest, MatchesFullSerialization) {
+    RequestSerializer serializer;
+    json fields = {{"model", "test-model"}, {"max_tokens", 1024}};
+    auto messages = conversation(5);
+
+    std::string body = serializer.build(fields, messages, convert);
+    EXPECT_EQ(json::parse(body), json::parse(fullDump(fields, messages)));
+
+    // 空字段与空消息 / Empty fields and messages
+    std::string empty = serializer.build(json::object(), {}, convert);
+    EXPECT_EQ(json::parse(empty), json::parse(R"({"messages":[]})"));
+}
+
+// 测试只编码新增消息 / Only new messages are encoded
+TEST(RequestSerializerTest, ReusesSentPrefix) {
+    RequestSerializer serializer;
+    json fields = {{"model", "test-model"}};
+    auto messages = conversation(10);
+
+    serializer.build(fields, messages, convert);
+    EXPECT_EQ(serializer.getStats().encoded, 10u);
+
+    ChatMessage toolMsg(MessageRole::TOOL, "result");
+    toolMsg.tool_call_id = "call_1";
+    messages.push_back(toolMsg);
+    messages.emplace_back(MessageRole::USER, "next");
+
+    std::string body = serializer.build(fields, messages, convert);
+    EXPECT_EQ(serializer.getStats().reused, 10u);
+    EXPECT_EQ(serializer.getStats().encoded, 2u);
+    EXPECT_EQ(json::parse(body), json::parse(fullDump(fields, messages)));
+}
+
+// 测试历史被改写时从改写处重新编码 / Rewritten history is re-encoded from the change
+TEST(RequestSerializerTest, ReencodesFromFirstChange) {
+    RequestSerializer serializer;
+    auto messages = conversation(8);
+    serializer.build(json::object(), messages, convert);
+
+    // 模拟压缩：第3条之后被摘要替换 / Simulate compression after message 3
+    messages.resize(3);
+    messages.emplace_back(MessageRole::USER, "summary of earlier turns");
+
+    std::string body = serializer.build(json::object(), messages, convert);
+    EXPECT_EQ(serializer.getStats().reused, 3u);
+    EXPECT_EQ(serializer.getStats().encoded, 1u);
+    EXPECT_EQ(json::parse(body), json::parse(fullDump(json::object(), messages)));
+
+    serializer.reset();
+    serializer.build(json::object(), messages, convert);
+    EXPECT_EQ(serializer.getStats().reused, 0u);
+}
+
+// 测试原始字段拼接 / Raw fields are spliced verbatim
+TEST(RequestSerializerTest, SplicesRawFields) {
+    RequestSerializer serializer;
+    auto tools = std::make_shared<const std::string>(R"([{"name":"read"}])");
+
+    std::string body = serializer.build({{"model", "m"}}, conversation(1), convert,
+                                        {{"tools", tools}, {"skipped", nullptr}});
+    json parsed = json::parse(body);
+    EXPECT_EQ(parsed["tools"][0]["name"], "read");
+    EXPECT_FALSE(parsed.contains("skipped"));
+    EXPECT_EQ(serializer.getStats().bytes, body.size());
+}
+
+// 测试指纹区分工具调用 / Fingerprint covers tool calls
+TEST(RequestSerializerTest, FingerprintCoversToolCalls) {
+    ChatMessage a(MessageRole::ASSISTANT, "");
+    a.tool_calls.push_back({"call_1", "read", {{"path", "/a"}}});
+    ChatMessage b = a;
+    b.tool_calls[0].arguments["path"] = "/b";
+
+    EXPECT_NE(RequestSerializer::fingerprint(a), RequestSerializer::fingerprint(b));
+    EXPECT_EQ(RequestSerializer::fingerprint(a), RequestSerializer::fingerprint(ChatMessage(a)));
+}
+
+// 测试缓存断点放在上次请求末尾和本次末尾 / Breakpoints mark the previous and current request ends
+TEST(RequestSerializerTest, PlacesCacheBreakpoints) {
+    RequestSerializer serializer;
+    auto messages = conversation(4);
+
+    json first = json::parse(serializer.build(json::object(), messages, convert, {}, true));
+    EXPECT_TRUE(first["messages"][3].contains("cache_control"));
+    EXPECT_FALSE(first["messages"][2].contains("cache_control"));
+
+    messages.emplace_back(MessageRole::ASSISTANT, "reply");
+    messages.emplace_back(MessageRole::USER, "follow-up");
+
+    json second = json::parse(serializer.build(json::object(), messages, convert, {}, true));
+    EXPECT_EQ(serializer.getStats().prefix, 4u);
+    EXPECT_TRUE(second["messages"][3].contains("cache_control"));
+    EXPECT_FALSE(second["messages"][4].contains("cache_control"));
+    EXPECT_TRUE(second["messages"][5].contains("cache_control"));
+    // 前缀内断点未变，直接复用 / Unchanged prefix breakpoints are reused
+    EXPECT_EQ(serializer.getStats().reused, 4u);
+    EXPECT_EQ(serializer.getStats().encoded, 2u);
+
+    // 断点移动时只重新编码受影响的消息 / Moving breakpoints re-encodes only affected messages
+    messages.emplace_back(MessageRole::ASSISTANT, "done");
+    json third = json::parse(serializer.build(json::object(), messages, convert, {}, true));
+    EXPECT_FALSE(third["messages"][3].contains("cache_control"));
+    EXPECT_TRUE(third["messages"][5].contains("cache_control"));
+    EXPECT_TRUE(third["messages"][6].contains("cache_control"));
+    EXPECT_EQ(serializer.getStats().reused, 5u);
+    EXPECT_EQ(serializer.getStats().encoded, 2u);
+}
+
+// 测试修订号：只追加时复用前缀，修订号变化时重新比对 / Revisions: append-only reuse, re-check on change
+TEST(RequestSerializerTest, RevisionSkipsComparingAppendOnlyPrefix) {
+    RequestSerializer serializer;
+    json fields = {{"model", "test-model"}};
+    auto messages = conversation(6);
+
+    serializer.setRevision(1);
+    serializer.build(fields, messages, convert);
+
+    messages.emplace_back(MessageRole::USER, "appended");
+    serializer.setRevision(1);
+    std::string body = serializer.build(fields, messages, convert);
+    EXPECT_EQ(json::parse(body), json::parse(fullDump(fields, messages)));
+    EXPECT_EQ(serializer.getStats().reused, 6u);
+    EXPECT_EQ(serializer.getStats().encoded, 1u);
+
+    // 改写后换修订号，从第一条不同的消息开始重新编码 / A rewrite under a new revision is detected
+    messages[2].content = "rewritten";
+    serializer.setRevision(2);
+    body = serializer.build(fields, messages, convert);
+    EXPECT_EQ(json::parse(body), json::parse(fullDump(fields, messages)));
+    EXPECT_EQ(serializer.getStats().reused, 2u);
+
+    // 修订号只对下一次构建有效 / The revision applies to the next build only
+    messages[0].content = "changed";
+    body = serializer.build(fields, messages, convert);
+    EXPECT_EQ(json::parse(body), json::parse(fullDump(fields, messages)));
+    EXPECT_EQ(serializer.getStats().reused, 0u);
+}
@@ -0,0 +1,231 @@
+// 响应缓存测试 / Response cache tests
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include "../../src/llm/cached_provider.h"
+
+using namespace roboclaw;
+
+namespace {
+
+// 计数的假提供商 / Fake provider that counts network calls
+class CountingProvider : public LLMProvider {
+public:
+    CountingProvider() : LLMProvider("test-key") { model_ = "test-model"; }
+
+    LLMResponse chat(const std::vector<ChatMessage>& messages,
+                     const std::vector<ToolDefinition>& tools = {}) override {
+        (void)tools;
+        ++calls;
+        LLMResponse response;
+        response.success = !fail;
+        if (fail) {
+            response.error = "boom";
+            return response;
+        }
+        response.content = "answer to: " + messages.back().content;
+        response.tool_calls = next_tool_calls;
+        response.input_tokens = 10;
+        response.output_tokens = 5;
+        return response;
+    }
+
+    bool chatStream(const std::vector<ChatMessage>&, const std::vector<ToolDefinition>&,
+                    StreamCallback callback) override {
+        ++calls;
+        callback("streamed");
+        return true;
+    }
+
+    std::string getModelName() const override { return model_; }
+
+    std::atomic<int> calls{0};
+    bool fail = false;
+    std::vector<ChatMessage::ToolCall> next_tool_calls;
+};
+
+std::vector<ChatMessage> ask(const std::string& question) {
+    return {ChatMessage(MessageRole::SYSTEM, "You are a robot."),
+            ChatMessage(MessageRole::USER, question)};
+}
+
+struct Fixture {
+    explicit Fixture(const ResponseCacheConfig& config = ResponseCacheConfig(), double temperature = 0.0)
+        : inner(std::make_shared<CountingProvider>())
+        , cache(std::make_shared<ResponseCache>(config))
+        , provider(inner, cache) {
+        provider.setTemperature(temperature);
+    }
+
+    std::shared_ptr<CountingProvider> inner;
+    std::shared_ptr<ResponseCache> cache;
+    CachedProvider provider;
+};
+
+} // namespace
+
+// 测试确定性请求不重复付费 / Zero-temperature queries never pay twice
+TEST(ResponseCacheTest, DeterministicQueryHitsCache) {
+    Fixture f;
+    auto first = f.provider.chat(ask("battery status?"));
+    auto second = f.provider.chat(ask("battery status?"));
+
+    EXPECT_EQ(f.inner->calls.load(), 1);
+    EXPECT_FALSE(first.from_cache);
+    EXPECT_TRUE(second.from_cache);
+    EXPECT_EQ(second.content, first.content);
+    EXPECT_EQ(second.input_tokens, 0);
+
+    auto stats = f.cache->getStats();
+    EXPECT_EQ(stats.memory_hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_DOUBLE_EQ(stats.hitRate(), 0.5);
+}
+
+// 测试键覆盖模型、温度、工具和消息 / The key covers model, temperature, tools and messages
+TEST(ResponseCacheTest, KeyIsCanonical) {
+    auto base = ResponseCache::makeKey("m", 0.0, 100, ask("hi"), {});
+    EXPECT_EQ(base.exact, ResponseCache::makeKey("m", 0.0, 100, ask("hi"), {}).exact);
+    EXPECT_NE(base.exact, ResponseCache::makeKey("other", 0.0, 100, ask("hi"), {}).exact);
+    EXPECT_NE(base.exact, ResponseCache::makeKey("m", 0.5, 100, ask("hi"), {}).exact);
+    EXPECT_NE(base.exact, ResponseCache::makeKey("m", 0.0, 200, ask("hi"), {}).exact);
+    EXPECT_NE(base.exact, ResponseCache::makeKey("m", 0.0, 100, ask("hello"), {}).exact);
+
+    ToolDefinition tool{"read", "Read a file", {{"type", "object"}, {"properties", json::object()}}};
+    ToolDefinition reordered{"read", "Read a file", {{"properties", json::object()}, {"type", "object"}}};
+    auto withTool = ResponseCache::makeKey("m", 0.0, 100, ask("hi"), {tool});
+    EXPECT_NE(base.exact, withTool.exact);
+    EXPECT_EQ(withTool.exact, ResponseCache::makeKey("m", 0.0, 100, ask("hi"), {reordered}).exact);
+
+    // 上下文键不含最后一条用户消息 / The context key ignores the final user message
+    EXPECT_EQ(base.context, ResponseCache::makeKey("m", 0.0, 100, ask("hello"), {}).context);
+    EXPECT_TRUE(base.deterministic);
+    EXPECT_FALSE(ResponseCache::makeKey("m", std::nullopt, 100, ask("hi"), {}).deterministic);
+}
+
+// 测试非确定性请求默认不缓存 / Non-deterministic queries bypass the cache by default
+TEST(ResponseCacheTest, NondeterministicBypassesCache) {
+    Fixture f(ResponseCacheConfig(), 0.7);
+    f.provider.chat(ask("tell me a joke"));
+    f.provider.chat(ask("tell me a joke"));
+    EXPECT_EQ(f.inner->calls.load(), 2);
+    EXPECT_EQ(f.cache->getStats().bypassed, 2u);
+
+    ResponseCacheConfig config;
+    config.cache_nondeterministic = true;
+    Fixture g(config, 0.7);
+    g.provider.chat(ask("tell me a joke"));
+    g.provider.chat(ask("tell me a joke"));
+    EXPECT_EQ(g.inner->calls.load(), 1);
+}
+
+// 测试失败响应不缓存 / Failed responses are not cached
+TEST(ResponseCacheTest, FailuresAreNotCached) {
+    Fixture f;
+    f.inner->fail = true;
+    EXPECT_FALSE(f.provider.chat(ask("status")).success);
+    f.inner->fail = false;
+    EXPECT_TRUE(f.provider.chat(ask("status")).success);
+    EXPECT_EQ(f.inner->calls.load(), 2);
+}
+
+// 测试LRU淘汰和TTL过期 / LRU eviction and TTL expiry
+TEST(ResponseCacheTest, EvictionAndExpiry) {
+    ResponseCacheConfig config;
+    config.max_entries = 2;
+    Fixture f(config);
+    f.provider.chat(ask("a"));
+    f.provider.chat(ask("b"));
+    f.provider.chat(ask("a"));   // a成为最近使用 / a becomes most recent
+    f.provider.chat(ask("c"));   // 淘汰b / evicts b
+    f.provider.chat(ask("a"));
+    f.provider.chat(ask("b"));
+    EXPECT_EQ(f.inner->calls.load(), 4);
+    EXPECT_GE(f.cache->getStats().evictions, 1u);
+
+    ResponseCacheConfig shortLived;
+    shortLived.ttl = std::chrono::seconds(1);
+    Fixture g(shortLived);
+    g.provider.chat(ask("a"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    g.provider.chat(ask("a"));
+    EXPECT_EQ(g.inner->calls.load(), 2);
+    EXPECT_EQ(g.cache->getStats().expirations, 1u);
+}
+
+// 测试磁盘层跨实例持久化 / The disk tier survives a restart
+TEST(ResponseCacheTest, DiskTierPersists) {
+    auto dir = std::filesystem::temp_directory_path() / "roboclaw_response_cache_test";
+    std::filesystem::remove_all(dir);
+
+    ResponseCacheConfig config;
+    config.disk_dir = dir.string();
+    {
+        Fixture f(config);
+        f.inner->next_tool_calls = {{"call_1", "read", {{"path", "/tmp/x"}}}};
+        f.provider.chat(ask("read x"));
+    }
+    // 只留下条目文件，没有残留的临时文件 / Only entry files remain, no temporary files
+    for (const auto& file : std::filesystem::directory_iterator(dir)) {
+        EXPECT_EQ(file.path().extension(), ".json") << file.path();
+    }
+
+    Fixture g(config);
+    auto response = g.provider.chat(ask("read x"));
+    EXPECT_EQ(g.inner->calls.load(), 0);
+    EXPECT_TRUE(response.from_cache);
+    ASSERT_EQ(response.tool_calls.size(), 1u);
+    EXPECT_EQ(response.tool_calls[0].arguments["path"], "/tmp/x");
+    EXPECT_EQ(g.cache->getStats().disk_hits, 1u);
+
+    g.cache->clear();
+    Fixture h(config);
+    h.provider.chat(ask("read x"));
+    EXPECT_EQ(h.inner->calls.load(), 1);
+
+    std::filesystem::remove_all(dir);
+}
+
+// 测试相似问题命中，数字不同或带工具调用时不命中 / Similar questions hit unless numbers differ or tools were called
+TEST(ResponseCacheTest, SimilarityTier) {
+    ResponseCacheConfig config;
+    config.enable_similarity = true;
+    config.similarity_threshold = 0.8;
+    Fixture f(config);
+
+    f.provider.chat(ask("What is the robot battery status?"));
+    auto similar = f.provider.chat(ask("what is the robot battery status"));
+    EXPECT_TRUE(similar.from_cache);
+    EXPECT_EQ(f.inner->calls.load(), 1);
+    EXPECT_EQ(f.cache->getStats().similar_hits, 1u);
+
+    f.provider.chat(ask("Move joint 1 to 30 degrees"));
+    auto otherNumber = f.provider.chat(ask("Move joint 1 to 45 degrees"));
+    EXPECT_FALSE(otherNumber.from_cache);
+
+    f.inner->next_tool_calls = {{"call_1", "serial", {{"action", "write"}}}};
+    f.provider.chat(ask("please start the motor now"));
+    auto action = f.provider.chat(ask("Please start the motor now!"));
+    EXPECT_FALSE(action.from_cache);
+    EXPECT_EQ(f.inner->calls.load(), 5);
+}
+
+// 测试命中时回调工具调用 / Cached tool calls are replayed through the callback
+TEST(ResponseCacheTest, ReplaysToolCallbacks) {
+    Fixture f;
+    f.inner->next_tool_calls = {{"call_1", "read", {{"path", "/a"}}}, {"call_2", "read", {{"path", "/b"}}}};
+
+    ToolSchema schema;
+    std::vector<std::string> seen;
+    auto onToolCall = [&](const ChatMessage::ToolCall& call) { seen.push_back(call.id); };
+    f.provider.chatWithToolCallbacks(ask("read both"), schema, onToolCall);
+    f.provider.chatWithToolCallbacks(ask("read both"), schema, onToolCall);
+
+    EXPECT_EQ(f.inner->calls.load(), 1);
+    ASSERT_EQ(seen.size(), 4u);
+    EXPECT_EQ(seen[2], "call_1");
+    EXPECT_EQ(seen[3], "call_2");
+}
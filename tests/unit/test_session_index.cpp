@@ -0,0 +1,183 @@
+// 会话索引测试 / Session metadata index tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "../../src/session/session_manager.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+class SessionIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / "roboclaw_session_index_test";
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    static SessionMetadata makeMetadata(const std::string& id, int secondsAgo, int messages = 0) {
+        SessionMetadata metadata;
+        metadata.id = id;
+        metadata.title = "title " + id;
+        metadata.created_at = std::chrono::system_clock::now() - std::chrono::hours(1);
+        metadata.updated_at = std::chrono::system_clock::now() - std::chrono::seconds(secondsAgo);
+        metadata.message_count = messages;
+        return metadata;
+    }
+
+    static std::vector<std::string> ids(const std::vector<SessionMetadata>& sessions) {
+        std::vector<std::string> result;
+        for (const auto& session : sessions) {
+            result.push_back(session.id);
+        }
+        return result;
+    }
+
+    std::string indexPath() const { return (dir_ / "index.bin").string(); }
+
+    fs::path dir_;
+};
+
+} // namespace
+
+// 测试更新后重新打开索引内容不变 / Upserts persist across a reopen
+TEST_F(SessionIndexTest, PersistsAcrossReopen) {
+    {
+        SessionIndex index;
+        ASSERT_FALSE(index.open(indexPath()));
+        ASSERT_TRUE(index.rebuild(indexPath(), {}));
+        ASSERT_TRUE(index.upsert(makeMetadata("a", 30, 1)));
+        ASSERT_TRUE(index.upsert(makeMetadata("b", 20, 2)));
+        auto updated = makeMetadata("a", 10, 5);
+        ASSERT_TRUE(index.upsert(updated));
+    }
+
+    SessionIndex index;
+    ASSERT_TRUE(index.open(indexPath()));
+    EXPECT_EQ(index.size(), 2u);
+    SessionMetadata metadata;
+    ASSERT_TRUE(index.get("a", metadata));
+    EXPECT_EQ(metadata.message_count, 5);
+    EXPECT_EQ(metadata.title, "title a");
+    EXPECT_EQ(ids(index.list()), (std::vector<std::string>{"a", "b"}));
+    // 原地更新，不增加槽 / Updated in place without growing the file
+    EXPECT_EQ(fs::file_size(indexPath()), 64u + 2 * 256u);
+}
+
+// 测试按更新时间倒序分页和最新会话 / Pagination in updated_at order and latest lookup
+TEST_F(SessionIndexTest, OrdersAndPaginates) {
+    SessionIndex index;
+    ASSERT_TRUE(index.rebuild(indexPath(), {makeMetadata("old", 50), makeMetadata("mid", 30)}));
+    ASSERT_TRUE(index.upsert(makeMetadata("new", 10)));
+    ASSERT_TRUE(index.upsert(makeMetadata("older", 60)));
+
+    EXPECT_EQ(ids(index.list()), (std::vector<std::string>{"new", "mid", "old", "older"}));
+    EXPECT_EQ(ids(index.list(1, 2)), (std::vector<std::string>{"mid", "old"}));
+    EXPECT_EQ(ids(index.list(3, 10)), (std::vector<std::string>{"older"}));
+    EXPECT_TRUE(index.list(4, 1).empty());
+    ASSERT_TRUE(index.latest().has_value());
+    EXPECT_EQ(index.latest()->id, "new");
+
+    ASSERT_TRUE(index.remove("new"));
+    EXPECT_EQ(index.latest()->id, "mid");
+}
+
+// 测试删除后槽被复用 / Removed slots are reused
+TEST_F(SessionIndexTest, ReusesFreedSlots) {
+    {
+        SessionIndex index;
+        ASSERT_TRUE(index.rebuild(indexPath(), {makeMetadata("a", 3), makeMetadata("b", 2)}));
+        ASSERT_TRUE(index.remove("a"));
+    }
+    {
+        SessionIndex index;
+        ASSERT_TRUE(index.open(indexPath()));
+        EXPECT_EQ(index.size(), 1u);
+        EXPECT_FALSE(index.contains("a"));
+        ASSERT_TRUE(index.upsert(makeMetadata("c", 1)));
+    }
+    EXPECT_EQ(fs::file_size(indexPath()), 64u + 2 * 256u);
+
+    SessionIndex index;
+    ASSERT_TRUE(index.open(indexPath()));
+    EXPECT_EQ(ids(index.list()), (std::vector<std::string>{"c", "b"}));
+}
+
+// 测试过长标题在字符边界截断 / Long titles are truncated on a UTF-8 boundary
+TEST_F(SessionIndexTest, TruncatesLongTitles) {
+    std::string title;
+    for (int i = 0; i < 100; ++i) {
+        title += "对话";
+    }
+    auto metadata = makeMetadata("long", 1);
+    metadata.title = title;
+    {
+        SessionIndex index;
+        ASSERT_TRUE(index.rebuild(indexPath(), {}));
+        ASSERT_TRUE(index.upsert(metadata));
+    }
+
+    SessionIndex index;
+    ASSERT_TRUE(index.open(indexPath()));
+    SessionMetadata loaded;
+    ASSERT_TRUE(index.get("long", loaded));
+    EXPECT_EQ(loaded.title.size(), 174u);
+    EXPECT_EQ(title.compare(0, loaded.title.size(), loaded.title), 0);
+}
+
+// 测试超过槽宽度的会话ID不写入索引 / Ids wider than a slot are not written to the index
+TEST_F(SessionIndexTest, SkipsIdsWiderThanSlot) {
+    std::string wide(60, 'x');
+    SessionIndex index;
+    ASSERT_TRUE(index.rebuild(indexPath(), {makeMetadata(wide, 2), makeMetadata("ok", 1)}));
+    EXPECT_FALSE(index.contains(wide));
+    EXPECT_EQ(fs::file_size(indexPath()), 64u + 256u);
+    EXPECT_FALSE(index.upsert(makeMetadata(wide, 1)));
+
+    // 未打开文件时更新失败 / Updates fail while no file is open
+    index.close();
+    EXPECT_FALSE(index.upsert(makeMetadata("later", 1)));
+}
+
+// 测试索引损坏时从会话目录重建 / A corrupt index is rebuilt from the session directories
+TEST_F(SessionIndexTest, ManagerRebuildsCorruptIndex) {
+    std::string first;
+    std::string second;
+    {
+        SessionManager manager;
+        manager.setSessionsDir(dir_.string());
+        first = manager.createSession("first")->getConversationId();
+        second = manager.createSession("second")->getConversationId();
+        EXPECT_EQ(manager.getSessionCount(), 2u);
+    }
+
+    // 破坏第一条记录 / Corrupt the first record
+    {
+        std::fstream file(indexPath(), std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + 100);
+        file.put('\x7f');
+    }
+    SessionIndex corrupt;
+    EXPECT_FALSE(corrupt.open(indexPath()));
+
+    SessionManager manager;
+    manager.setSessionsDir(dir_.string());
+    EXPECT_EQ(manager.getSessionCount(), 2u);
+    EXPECT_EQ(manager.getSessionMetadata(first).title, "first");
+    EXPECT_EQ(manager.getSessionMetadata(second).title, "second");
+
+    // 重建后的索引可以直接打开 / The rebuilt index opens cleanly
+    SessionIndex rebuilt;
+    EXPECT_TRUE(rebuilt.open(indexPath()));
+
+    ASSERT_TRUE(manager.deleteSession(first));
+    EXPECT_EQ(ids(manager.listSessions()), (std::vector<std::string>{second}));
+}
+
@@ -0,0 +1,210 @@
+// 会话日志测试 / Session write-ahead log tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "../../src/session/session_manager.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+class SessionLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / "roboclaw_session_log_test";
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::unique_ptr<SessionManager> makeManager(const SessionLogConfig& config = SessionLogConfig()) {
+        auto manager = std::make_unique<SessionManager>();
+        manager->setLogConfig(config);
+        manager->setSessionsDir(dir_.string());
+        return manager;
+    }
+
+    // 添加一轮对话 / Append one turn
+    static void addTurn(ConversationTree& tree, const std::string& user, const std::string& reply) {
+        auto node = tree.addNode(tree.getCurrentNodeId(), user);
+        tree.switchToNode(node->getId());
+        ConversationNode::AssistantMessage message;
+        message.content = reply;
+        tree.setAssistantMessage(node->getId(), message);
+    }
+
+    static size_t countLines(const fs::path& path) {
+        std::ifstream file(path);
+        size_t lines = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines++;
+        }
+        return lines;
+    }
+
+    fs::path sessionDir(const std::string& id) const { return dir_ / id; }
+
+    fs::path dir_;
+};
+
+} // namespace
+
+// 测试保存只追加记录，不重写快照 / Saves append records instead of rewriting the snapshot
+TEST_F(SessionLogTest, SavesAppendToLog) {
+    auto manager = makeManager();
+    auto session = manager->createSession("wal");
+    auto snapshot = sessionDir(session->getConversationId()) / "tree.json";
+    auto snapshotSize = fs::file_size(snapshot);
+
+    addTurn(*session, "hello", "hi there");
+    ASSERT_TRUE(manager->saveSession(session));
+    addTurn(*session, "again", "sure");
+    ASSERT_TRUE(manager->saveSession(session));
+
+    // 每轮3条记录：节点、当前节点、回复 / Three records per turn: node, current, reply
+    EXPECT_EQ(countLines(sessionDir(session->getConversationId()) / "log.jsonl"), 6u);
+    EXPECT_EQ(fs::file_size(snapshot), snapshotSize);
+    EXPECT_FALSE(session->hasJournal());
+}
+
+// 测试重启后重放日志恢复会话 / Replaying the log restores the session after a restart
+TEST_F(SessionLogTest, RecoversFromSnapshotAndLog) {
+    std::string id;
+    std::string currentId;
+    {
+        auto manager = makeManager();
+        auto session = manager->createSession();
+        id = session->getConversationId();
+        addTurn(*session, "first", "one");
+        addTurn(*session, "second", "two");
+        auto branch = session->createBranch(session->getCurrentNodeId(), "experiment");
+        session->switchToNode(branch->getId());
+        currentId = branch->getId();
+        ASSERT_TRUE(manager->saveSession(session));
+    }
+
+    auto manager = makeManager();
+    auto session = manager->loadSession(id);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->getNodeCount(), 4u);
+    EXPECT_EQ(session->getCurrentNodeId(), currentId);
+    EXPECT_EQ(session->getCurrentNode()->getBranchName(), "experiment");
+    EXPECT_EQ(session->getConversationHistory(), (std::vector<std::string>{"first", "second"}));
+    auto parent = session->getNode(session->getCurrentNode()->getParentId());
+    EXPECT_EQ(parent->getAssistantMessage().content, "two");
+    EXPECT_EQ(manager->getSessionMetadata(id).message_count, 4);
+}
+
+// 测试末尾写了一半的记录被丢弃 / A torn record at the tail is dropped
+TEST_F(SessionLogTest, DropsTornTail) {
+    std::string id;
+    {
+        auto manager = makeManager();
+        auto session = manager->createSession();
+        id = session->getConversationId();
+        addTurn(*session, "kept", "yes");
+        ASSERT_TRUE(manager->saveSession(session));
+    }
+
+    auto logPath = sessionDir(id) / "log.jsonl";
+    auto validSize = fs::file_size(logPath);
+    {
+        std::ofstream log(logPath, std::ios::app);
+        log << R"({"op":"node","id":"node_torn","par)";
+    }
+
+    auto manager = makeManager();
+    auto session = manager->loadSession(id);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->getNodeCount(), 2u);
+    EXPECT_EQ(fs::file_size(logPath), validSize);
+
+    // 截断后继续追加仍可恢复 / Appending after the truncation still recovers cleanly
+    addTurn(*session, "after", "ok");
+    ASSERT_TRUE(manager->saveSession(session));
+    manager.reset();
+    EXPECT_EQ(makeManager()->loadSession(id)->getNodeCount(), 3u);
+}
+
+// 测试日志过长时压缩为快照 / The log is compacted into a snapshot once it grows long
+TEST_F(SessionLogTest, CompactsLongLogs) {
+    SessionLogConfig config;
+    config.compact_after_records = 7;
+    std::string id;
+    {
+        auto manager = makeManager(config);
+        auto session = manager->createSession();
+        id = session->getConversationId();
+        for (int i = 0; i < 4; ++i) {
+            addTurn(*session, "turn " + std::to_string(i), "reply");
+            ASSERT_TRUE(manager->saveSession(session));
+        }
+        // 第3次保存后超过7条，第4次保存时压缩 / 9 records after the 3rd save, compacted on the 4th
+        EXPECT_EQ(countLines(sessionDir(id) / "log.jsonl"), 0u);
+    }
+
+    auto session = makeManager(config)->loadSession(id);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->getNodeCount(), 5u);
+    EXPECT_EQ(session->getConversationHistory().back(), "turn 3");
+}
+
+// 测试压缩中途崩溃时重复重放结果不变 / Replaying records already in the snapshot is harmless
+TEST_F(SessionLogTest, ReplayIsIdempotent) {
+    std::string id;
+    fs::path savedLog = dir_ / "saved_log.jsonl";
+    {
+        auto manager = makeManager();
+        auto session = manager->createSession();
+        id = session->getConversationId();
+        addTurn(*session, "one", "1");
+        addTurn(*session, "two", "2");
+        ASSERT_TRUE(manager->saveSession(session));
+        manager->flush();
+        fs::copy_file(sessionDir(id) / "log.jsonl", savedLog);
+
+        // 模拟快照已替换但日志尚未清空 / Simulate a crash after the rename but before the truncate
+        SessionLog log(sessionDir(id).string());
+        ASSERT_TRUE(log.compact(session->toJson()));
+    }
+    fs::copy_file(savedLog, sessionDir(id) / "log.jsonl", fs::copy_options::overwrite_existing);
+
+    auto session = makeManager()->loadSession(id);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->getNodeCount(), 3u);
+    EXPECT_EQ(session->getRoot()->getChildren().size(), 1u);
+    EXPECT_EQ(session->getConversationHistory(), (std::vector<std::string>{"one", "two"}));
+}
+
+// 测试保存失败时修改保留到下次保存 / A failed save keeps its records for the next save
+TEST_F(SessionLogTest, FailedSaveKeepsJournal) {
+    SessionLogConfig config;
+    config.compact_after_records = 0;   // 每次保存都压缩 / every save compacts
+    std::string id;
+    {
+        auto manager = makeManager(config);
+        auto session = manager->createSession();
+        id = session->getConversationId();
+
+        // 快照位置被目录占据，压缩无法替换 / A directory in the snapshot's place makes compaction fail
+        auto snapshot = sessionDir(id) / "tree.json";
+        fs::remove(snapshot);
+        fs::create_directory(snapshot);
+        addTurn(*session, "flash", "done");
+        EXPECT_FALSE(manager->saveSession(session));
+        EXPECT_TRUE(session->hasJournal());
+
+        fs::remove(snapshot);
+        ASSERT_TRUE(manager->saveSession(session));
+        EXPECT_FALSE(session->hasJournal());
+    }
+
+    auto session = makeManager(config)->loadSession(id);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->getConversationHistory(), (std::vector<std::string>{"flash"}));
+}
@@ -0,0 +1,159 @@
+// 会话搜索测试 / Session full-text search tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "../../src/session/session_manager.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+class SessionSearchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / "roboclaw_session_search_test";
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string indexPath() const { return (dir_ / "search.jsonl").string(); }
+
+    // 添加一轮对话 / Append one turn
+    static void addTurn(ConversationTree& tree, const std::string& user, const std::string& reply) {
+        auto node = tree.addNode(tree.getCurrentNodeId(), user);
+        tree.switchToNode(node->getId());
+        ConversationNode::AssistantMessage message;
+        message.content = reply;
+        tree.setAssistantMessage(node->getId(), message);
+    }
+
+    fs::path dir_;
+};
+
+} // namespace
+
+// 测试英文按词切分、中文切分为单字和二元组 / Words for ASCII, unigrams and bigrams for CJK
+TEST_F(SessionSearchTest, TokenizesMixedText) {
+    EXPECT_EQ(SessionSearchIndex::tokenize("Move the ARM_1, now!"),
+              (std::vector<std::string>{"move", "the", "arm_1", "now"}));
+    EXPECT_EQ(SessionSearchIndex::tokenize("控制机械臂"),
+              (std::vector<std::string>{"控", "控制", "制", "制机", "机", "机械", "械", "械臂", "臂"}));
+    EXPECT_EQ(SessionSearchIndex::tokenize("用ROS，启动"),
+              (std::vector<std::string>{"用", "ros", "启", "启动", "动"}));
+    EXPECT_EQ(SessionSearchIndex::tokenize("café naïve"), (std::vector<std::string>{"café", "naïve"}));
+}
+
+// 测试BM25排序和片段 / BM25 ranking and snippets
+TEST_F(SessionSearchTest, RanksByBm25) {
+    SessionSearchIndex index;
+    index.open(indexPath());
+    index.update("s1", {{"n1", "The gripper is closed"}, {"n2", "Calibrate the camera"}});
+    index.update("s2", {{"n3", "Gripper gripper force limit for the gripper"}});
+    index.update("s3", {{"n4", "请检查串口连接，然后重新启动机械臂"}});
+
+    auto hits = index.search("gripper");
+    ASSERT_EQ(hits.size(), 2u);
+    EXPECT_EQ(hits[0].node_id, "n3");
+    EXPECT_EQ(hits[1].node_id, "n1");
+    EXPECT_GT(hits[0].score, hits[1].score);
+    EXPECT_EQ(hits[1].snippet, "The gripper is closed");
+
+    hits = index.search("机械臂");
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].session_id, "s3");
+    EXPECT_NE(hits[0].snippet.find("机械臂"), std::string::npos);
+
+    EXPECT_TRUE(index.search("nothing here").empty());
+    EXPECT_TRUE(index.search("  ").empty());
+}
+
+// 测试替换、删除在重新加载后保持 / Replacements and drops survive a reload
+TEST_F(SessionSearchTest, PersistsUpdatesAndDrops) {
+    {
+        SessionSearchIndex index;
+        index.open(indexPath());
+        index.update("s1", {{"n1", "first draft"}});
+        index.update("s1", {{"n1", "final answer"}});
+        index.update("s2", {{"n2", "draft of a plan"}});
+        index.removeSession("s2");
+        index.markReady();
+    }
+
+    SessionSearchIndex index;
+    index.open(indexPath());
+    EXPECT_FALSE(index.needsBackfill());
+    EXPECT_EQ(index.documentCount(), 1u);
+    EXPECT_TRUE(index.search("draft").empty());
+    ASSERT_EQ(index.search("answer").size(), 1u);
+
+    // 删除后重新添加 / Re-adding after a drop
+    index.update("s2", {{"n2", "new draft"}});
+    SessionSearchIndex reloaded;
+    reloaded.open(indexPath());
+    ASSERT_EQ(reloaded.search("draft").size(), 1u);
+    EXPECT_EQ(reloaded.search("draft")[0].session_id, "s2");
+}
+
+// 测试崩溃留下的残缺末行不会吞掉下一批记录 / A torn last line never swallows the next batch
+TEST_F(SessionSearchTest, AppendsAfterTornLastLine) {
+    {
+        SessionSearchIndex index;
+        index.open(indexPath());
+        index.update("s1", {{"n1", "kept record"}});
+    }
+    {
+        std::ofstream torn(indexPath(), std::ios::binary | std::ios::app);
+        torn << R"({"op":"doc","s":"s1","n":"n2","t":"half wri)";
+    }
+
+    {
+        SessionSearchIndex index;
+        index.open(indexPath());
+        index.update("s1", {{"n3", "appended after crash"}});
+    }
+
+    SessionSearchIndex reloaded;
+    reloaded.open(indexPath());
+    EXPECT_EQ(reloaded.documentCount(), 2u);
+    EXPECT_EQ(reloaded.search("kept").size(), 1u);
+    EXPECT_EQ(reloaded.search("crash").size(), 1u);
+}
+
+// 测试会话保存时更新索引，首次查询回填已有会话 / Saves update the index; old sessions are backfilled
+TEST_F(SessionSearchTest, ManagerIndexesSessions) {
+    std::string oldId;
+    {
+        SessionManager manager;
+        manager.setSessionsDir(dir_.string());
+        auto session = manager.createSession("old");
+        oldId = session->getConversationId();
+        addTurn(*session, "how do I reset the servo", "Send the home command first");
+        ASSERT_TRUE(manager.saveSession(session));
+    }
+    // 模拟索引功能上线之前的会话 / Simulate sessions created before search existed
+    fs::remove(indexPath());
+
+    SessionManager manager;
+    manager.setSessionsDir(dir_.string());
+    auto session = manager.createSession("new");
+    addTurn(*session, "温度传感器读数异常", "请检查传感器的接线");
+    ASSERT_TRUE(manager.saveSession(session));
+
+    auto hits = manager.searchSessions("servo");
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].session_id, oldId);
+    EXPECT_NE(hits[0].snippet.find("home command"), std::string::npos);
+
+    hits = manager.searchSessions("传感器");
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].session_id, session->getConversationId());
+
+    ASSERT_TRUE(manager.deleteSession(oldId));
+    EXPECT_TRUE(manager.searchSessions("servo").empty());
+}
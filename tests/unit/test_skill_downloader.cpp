@@ -0,0 +1,247 @@
+// 技能下载器测试 / Skill downloader tests
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include "../../src/skills/skill_downloader.h"
+#include "../../src/utils/sha256.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 模拟服务器：支持ETag条件请求、Range续传和中途断开
+// Fake server with ETag revalidation, Range resume and dropped connections
+class FakeServer {
+public:
+    struct Resource {
+        std::string body;
+        std::string etag;
+        size_t drop_after = 0;   // >0时只发送这么多字节后断开 / Drop the connection after this many bytes
+    };
+
+    void put(const std::string& url, const std::string& body, const std::string& etag) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resources_[url] = {body, etag, 0};
+    }
+
+    void dropAfter(const std::string& url, size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resources_[url].drop_after = bytes;
+    }
+
+    DownloadTransport transport() {
+        return [this](const std::string& url, const std::map<std::string, std::string>& headers,
+                      const DataCallback& onData) { return serve(url, headers, onData); };
+    }
+
+    std::vector<std::map<std::string, std::string>> requestsFor(const std::string& url) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_[url];
+    }
+
+    int maxConcurrent() const { return max_concurrent_.load(); }
+
+private:
+    HttpResponse serve(const std::string& url, const std::map<std::string, std::string>& headers,
+                       const DataCallback& onData) {
+        int now = ++concurrent_;
+        int seen = max_concurrent_.load();
+        while (now > seen && !max_concurrent_.compare_exchange_weak(seen, now)) {
+        }
+
+        Resource resource;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_[url].push_back(headers);
+            auto it = resources_.find(url);
+            if (it == resources_.end()) {
+                --concurrent_;
+                onData("not found");
+                return HttpResponse::ok(404, "");
+            }
+            resource = it->second;
+            it->second.drop_after = 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+        std::map<std::string, std::string> responseHeaders{{"ETag", resource.etag}};
+        auto header = [&](const std::string& name) {
+            auto it = headers.find(name);
+            return it == headers.end() ? std::string() : it->second;
+        };
+
+        HttpResponse response;
+        if (header("If-None-Match") == resource.etag) {
+            response = HttpResponse::ok(304, "", responseHeaders);
+        } else if (!header("Range").empty() && header("If-Range") == resource.etag) {
+            size_t from = std::stoul(header("Range").substr(6));
+            responseHeaders["Content-Range"] = "bytes " + std::to_string(from) + "-" +
+                std::to_string(resource.body.size() - 1) + "/" + std::to_string(resource.body.size());
+            onData(std::string_view(resource.body).substr(from));
+            response = HttpResponse::ok(206, "", responseHeaders);
+        } else if (resource.drop_after > 0) {
+            onData(std::string_view(resource.body).substr(0, resource.drop_after));
+            response = HttpResponse::ok(0, "", responseHeaders);
+            response.error_message = "connection reset";
+        } else {
+            // 分块发送 / Send in chunks
+            for (size_t i = 0; i < resource.body.size(); i += 7) {
+                onData(std::string_view(resource.body).substr(i, 7));
+            }
+            response = HttpResponse::ok(200, "", responseHeaders);
+        }
+        --concurrent_;
+        return response;
+    }
+
+    std::mutex mutex_;
+    std::map<std::string, Resource> resources_;
+    std::map<std::string, std::vector<std::map<std::string, std::string>>> requests_;
+    std::atomic<int> concurrent_{0};
+    std::atomic<int> max_concurrent_{0};
+};
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+class SkillDownloaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / "roboclaw_skill_downloader_test";
+        fs::remove_all(dir_);
+        downloader_ = std::make_unique<SkillDownloader>((dir_ / "cache").string());
+        downloader_->setTransport(server_.transport());
+    }
+
+    void TearDown() override {
+        downloader_.reset();
+        fs::remove_all(dir_);
+    }
+
+    fs::path dir_;
+    FakeServer server_;
+    std::unique_ptr<SkillDownloader> downloader_;
+};
+
+} // namespace
+
+// 测试SHA-256标准向量和增量计算 / SHA-256 test vectors and incremental updates
+TEST(Sha256Test, MatchesKnownDigests) {
+    EXPECT_EQ(Sha256::hash(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(Sha256::hash("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(Sha256::hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    std::string text(1000, 'x');
+    Sha256 hasher;
+    for (size_t i = 0; i < text.size(); i += 13) {
+        hasher.update(std::string_view(text).substr(i, 13));
+    }
+    EXPECT_EQ(hasher.hexdigest(), Sha256::hash(text));
+}
+
+// 测试并发下载和摘要校验 / Parallel downloads with hash verification
+TEST_F(SkillDownloaderTest, DownloadsInParallelAndVerifiesHashes) {
+    std::vector<std::string> urls;
+    for (int i = 0; i < 40; ++i) {
+        std::string url = "https://skills.example/s" + std::to_string(i) + "/SKILL.md";
+        server_.put(url, "# skill " + std::to_string(i) + "\n", "\"v1\"");
+        urls.push_back(url);
+    }
+
+    std::vector<SkillDownloadRequest> requests;
+    for (int i = 0; i < 40; ++i) {
+        requests.push_back({urls[i], (dir_ / "out" / ("s" + std::to_string(i) + ".md")).string(), ""});
+    }
+    // 摘要正确和错误各一个 / One good and one bad expected digest
+    requests[0].sha256 = Sha256::hash("# skill 0\n");
+    requests[1].url += "#sha256=" + std::string(64, '0');
+
+    downloader_->setMaxParallel(8);
+    int callbacks = 0;
+    int last = 0;
+    int downloaded = downloader_->downloadSkills(requests, [&](const std::string&, int current, int total) {
+        ++callbacks;
+        EXPECT_EQ(current, last + 1);
+        EXPECT_EQ(total, 40);
+        last = current;
+    });
+
+    EXPECT_EQ(downloaded, 39);
+    EXPECT_EQ(callbacks, 40);
+    EXPECT_GT(server_.maxConcurrent(), 1);
+    EXPECT_LE(server_.maxConcurrent(), 8);
+    EXPECT_EQ(readFile(dir_ / "out" / "s0.md"), "# skill 0\n");
+    EXPECT_EQ(readFile(dir_ / "out" / "s39.md"), "# skill 39\n");
+    EXPECT_FALSE(fs::exists(dir_ / "out" / "s1.md"));
+
+    // 同名文件使用不同的缓存键，且不残留临时文件 / Same file names do not collide; no temp files remain
+    for (const auto& entry : fs::directory_iterator(dir_ / "cache")) {
+        std::string ext = entry.path().extension().string();
+        EXPECT_TRUE(ext == ".cache" || ext == ".json") << entry.path();
+    }
+    for (const auto& entry : fs::directory_iterator(dir_ / "out")) {
+        EXPECT_EQ(entry.path().extension(), ".md") << entry.path();
+    }
+}
+
+// 测试auto_update使用条件请求 / auto_update revalidates with conditional requests
+TEST_F(SkillDownloaderTest, RevalidatesWithEtag) {
+    const std::string url = "https://skills.example/arm/SKILL.md";
+    const fs::path dest = dir_ / "arm.md";
+    server_.put(url, "version one", "\"v1\"");
+
+    ASSERT_TRUE(downloader_->downloadSkill(url, dest.string()));
+    // 缓存有效期内不访问网络 / Fresh cache is used without a request
+    ASSERT_TRUE(downloader_->downloadSkill(url, dest.string()));
+    EXPECT_EQ(server_.requestsFor(url).size(), 1u);
+
+    downloader_->setAutoUpdate(true);
+    ASSERT_TRUE(downloader_->downloadSkill(url, dest.string()));
+    auto requests = server_.requestsFor(url);
+    ASSERT_EQ(requests.size(), 2u);
+    EXPECT_EQ(requests[1]["If-None-Match"], "\"v1\"");
+    EXPECT_EQ(readFile(dest), "version one");
+
+    server_.put(url, "version two", "\"v2\"");
+    ASSERT_TRUE(downloader_->downloadSkill(url, dest.string()));
+    EXPECT_EQ(readFile(dest), "version two");
+
+    // 缓存被篡改时重新下载 / A corrupted cache entry is re-downloaded
+    for (const auto& entry : fs::directory_iterator(dir_ / "cache")) {
+        if (entry.path().extension() == ".cache") {
+            std::ofstream(entry.path()) << "tampered";
+        }
+    }
+    ASSERT_TRUE(downloader_->downloadSkill(url, dest.string()));
+    EXPECT_EQ(readFile(dest), "version two");
+    EXPECT_TRUE(server_.requestsFor(url).back().count("If-None-Match") == 0);
+}
+
+// 测试中断后用Range续传 / Interrupted transfers resume with Range
+TEST_F(SkillDownloaderTest, ResumesInterruptedDownload) {
+    const std::string url = "https://skills.example/big/SKILL.md";
+    const fs::path dest = dir_ / "big.md";
+    std::string body;
+    for (int i = 0; i < 200; ++i) {
+        body += "line " + std::to_string(i) + "\n";
+    }
+    server_.put(url, body, "\"big\"");
+    server_.dropAfter(url, 100);
+
+    EXPECT_FALSE(downloader_->downloadSkill(url, dest.string(), Sha256::hash(body)));
+    EXPECT_FALSE(fs::exists(dest));
+
+    ASSERT_TRUE(downloader_->downloadSkill(url, dest.string(), Sha256::hash(body)));
+    auto requests = server_.requestsFor(url);
+    ASSERT_EQ(requests.size(), 2u);
+    EXPECT_EQ(requests[1]["Range"], "bytes=100-");
+    EXPECT_EQ(requests[1]["If-Range"], "\"big\"");
+    EXPECT_EQ(readFile(dest), body);
+}
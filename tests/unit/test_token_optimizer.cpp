@@ -0,0 +1,139 @@
+// Token优化器测试 / Token optimizer tests
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "../../src/optimization/token_optimizer.h"
+#include "../../src/optimization/token_constants.h"
+
+using namespace roboclaw;
+
+namespace {
+
+// 逐字节的参考实现 / Byte-at-a-time reference estimate
+int referenceEstimate(const std::string& text) {
+    int nonAscii = 0, ascii = 0, whitespace = 0;
+    for (unsigned char c : text) {
+        if (c < 0x80) {
+            if (std::isspace(c)) {
+                whitespace++;
+            } else {
+                ascii++;
+            }
+        } else {
+            nonAscii++;
+        }
+    }
+    int tokens = static_cast<int>(std::ceil(nonAscii / 1.5)) +
+                 static_cast<int>(std::ceil(ascii / static_cast<double>(TokenConstants::CHARS_PER_TOKEN_ENGLISH))) +
+                 static_cast<int>(std::ceil(whitespace / 10.0));
+    return std::max(tokens, 1);
+}
+
+} // namespace
+
+// 测试向量化计数与逐字节结果一致 / The vectorized counter matches the scalar reference
+TEST(TokenOptimizerTest, EstimateMatchesReference) {
+    TokenOptimizationConfig config;
+    config.enable_token_cache = false;
+    TokenOptimizer optimizer;
+    optimizer.setConfig(config);
+
+    std::mt19937 rng(42);
+    const std::string alphabet = "abc XYZ\t\n\r\v\f012{}();机器人控制";
+    for (size_t length : {0u, 1u, 15u, 16u, 17u, 31u, 64u, 1000u}) {
+        std::string text;
+        for (size_t i = 0; i < length; ++i) {
+            text += alphabet[rng() % alphabet.size()];
+        }
+        int expected = text.empty() ? 0 : referenceEstimate(text);
+        EXPECT_EQ(optimizer.estimateTokens(text), expected) << "length " << length;
+    }
+}
+
+// 测试历史增长时只估算新增消息 / Growing history only estimates new messages
+TEST(TokenOptimizerTest, HistoryTotalsAreIncremental) {
+    TokenOptimizer optimizer;
+    std::vector<ChatMessage> history;
+    for (int i = 0; i < 10; ++i) {
+        history.emplace_back(MessageRole::USER, "message number " + std::to_string(i));
+    }
+
+    int first = optimizer.estimateTokens(history);
+    EXPECT_EQ(optimizer.getCacheMisses(), 10u);
+
+    history.emplace_back(MessageRole::ASSISTANT, "reply");
+    history.back().tool_calls.push_back({"id", "read", json::object()});
+    int second = optimizer.estimateTokens(history);
+    EXPECT_EQ(optimizer.getCacheMisses(), 11u);
+    EXPECT_EQ(second, first + referenceEstimate("reply") + TokenConstants::TOKENS_PER_TOOL_CALL);
+
+    // 改写中间消息后只重新估算该消息 / Rewriting a message re-estimates only changed entries
+    history[5].content = "rewritten";
+    int third = optimizer.estimateTokens(history);
+    EXPECT_EQ(optimizer.getCacheMisses(), 12u);
+    EXPECT_EQ(third, second - referenceEstimate("message number 5") + referenceEstimate("rewritten"));
+
+    // 历史缩短也正确 / Shrinking history stays correct
+    history.resize(3);
+    EXPECT_EQ(optimizer.estimateTokens(history),
+              referenceEstimate("message number 0") + referenceEstimate("message number 1") +
+              referenceEstimate("message number 2"));
+}
+
+// 测试按内容键比对历史：复制的历史命中，原地改写被发现 / History is matched by content keys:
+// copies hit, in-place edits are detected
+TEST(TokenOptimizerTest, HistoryMatchesByContentKey) {
+    TokenOptimizer optimizer;
+    std::vector<ChatMessage> history;
+    for (int i = 0; i < 4; ++i) {
+        history.emplace_back(MessageRole::TOOL, std::string(4096, static_cast<char>('a' + i)) + " end");
+    }
+    history[0].tool_calls.push_back({"call_1", "read", {{"path", "a.c"}}});
+
+    int first = optimizer.estimateTokens(history);
+    EXPECT_EQ(optimizer.getCacheMisses(), 4u);
+
+    // 每轮复制一份历史（与Agent相同）仍整段命中 / A fresh copy each round still hits
+    std::vector<ChatMessage> copy = history;
+    copy.emplace_back(MessageRole::USER, "next");
+    EXPECT_EQ(optimizer.estimateTokens(copy), first + referenceEstimate("next"));
+    EXPECT_EQ(optimizer.getCacheMisses(), 5u);
+    EXPECT_EQ(optimizer.getCacheHits(), 4u);
+
+    // 长度不变的原地改写也会被发现 / A same-length edit anywhere is detected
+    copy[1].content[7] = ' ';
+    int expected = first - referenceEstimate(std::string(4096, 'b') + " end") +
+                   referenceEstimate(copy[1].content) + referenceEstimate("next");
+    EXPECT_EQ(optimizer.estimateTokens(copy), expected);
+    EXPECT_EQ(optimizer.getCacheMisses(), 6u);
+
+    // 工具调用参数改变同样使该消息重新计数 / Changing a tool argument re-counts that message
+    copy[0].tool_calls[0].arguments["path"] = "b.c";
+    EXPECT_EQ(optimizer.estimateTokens(copy), expected);
+    EXPECT_EQ(optimizer.getCacheMisses(), 7u);
+}
+
+// 测试LRU容量和淘汰 / LRU capacity and eviction
+TEST(TokenOptimizerTest, LruEvictsOldest) {
+    TokenOptimizationConfig config;
+    config.max_cache_size = 3;
+    TokenOptimizer optimizer;
+    optimizer.setConfig(config);
+
+    optimizer.estimateTokens(std::string("alpha"));
+    optimizer.estimateTokens(std::string("beta"));
+    optimizer.estimateTokens(std::string("gamma"));
+    optimizer.estimateTokens(std::string("alpha"));   // alpha成为最近使用 / alpha is now most recent
+    optimizer.estimateTokens(std::string("delta"));   // 淘汰beta / evicts beta
+    EXPECT_EQ(optimizer.getCacheSize(), 3u);
+    EXPECT_EQ(optimizer.getCacheHits(), 1u);
+
+    optimizer.estimateTokens(std::string("alpha"));
+    EXPECT_EQ(optimizer.getCacheHits(), 2u);
+    optimizer.estimateTokens(std::string("beta"));
+    EXPECT_EQ(optimizer.getCacheMisses(), 5u);
+
+    optimizer.clearCache();
+    EXPECT_EQ(optimizer.getCacheSize(), 0u);
+}
@@ -0,0 +1,215 @@
+// 工具流水线测试 / Tool pipeline tests
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "../../src/agent/tool_pipeline.h"
+#include "../../src/tools/read_tool.h"
+#include "../../src/tools/write_tool.h"
+#include "../../src/tools/serial_tool.h"
+
+using namespace roboclaw;
+
+namespace {
+
+ChatMessage::ToolCall makeCall(const std::string& id, const std::string& name,
+                               const json& args = json::object()) {
+    return {id, name, args};
+}
+
+// 使用真实工具的访问声明 / Use the real tools' access declarations
+ToolAccess resolveAccess(const ChatMessage::ToolCall& call) {
+    static ReadTool readTool;
+    static WriteTool writeTool;
+    static SerialTool serialTool;
+    if (call.name == "read") return readTool.describeAccess(call.arguments);
+    if (call.name == "write") return writeTool.describeAccess(call.arguments);
+    if (call.name == "serial") return serialTool.describeAccess(call.arguments);
+    return ToolAccess::unknown();
+}
+
+} // namespace
+
+// 测试结果按派发顺序返回 / Results come back in dispatch order
+TEST(ToolPipelineTest, ResultsKeepDispatchOrder) {
+    auto pool = std::make_shared<ThreadPool>(4);
+    ToolPipeline pipeline(pool, [](const ChatMessage::ToolCall& call) {
+        // 先派发的调用耗时更长 / Earlier calls take longer
+        std::this_thread::sleep_for(std::chrono::milliseconds(call.id == "a" ? 30 : 1));
+        return ToolResult::ok(call.id);
+    }, resolveAccess);
+
+    pipeline.dispatch(makeCall("a", "read", {{"path", "/tmp/a"}}));
+    pipeline.dispatch(makeCall("b", "read", {{"path", "/tmp/b"}}));
+    pipeline.dispatch(makeCall("c", "read", {{"path", "/tmp/c"}}));
+
+    auto results = pipeline.finish();
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].second.content, "a");
+    EXPECT_EQ(results[1].second.content, "b");
+    EXPECT_EQ(results[2].second.content, "c");
+    EXPECT_EQ(pipeline.getStats().deferred, 0u);
+}
+
+// 测试调用在流结束前已开始执行 / Calls start before the stream ends
+TEST(ToolPipelineTest, StartsBeforeResponseCompletes) {
+    auto pool = std::make_shared<ThreadPool>(2);
+    std::atomic<int> finished{0};
+    ToolPipeline pipeline(pool, [&](const ChatMessage::ToolCall& call) {
+        ++finished;
+        return ToolResult::ok(call.id);
+    }, resolveAccess);
+
+    pipeline.dispatch(makeCall("a", "read", {{"path", "/tmp/a"}}));
+
+    // 模拟模型仍在输出后续内容 / The model is still talking
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (finished.load() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(finished.load(), 1);
+
+    pipeline.dispatch(makeCall("b", "serial", {{"action", "read"}, {"port", "/dev/ttyUSB0"}}));
+    EXPECT_EQ(pipeline.finish().size(), 2u);
+}
+
+// 测试写调用等待之前的读调用 / Writes wait for earlier reads
+TEST(ToolPipelineTest, WriteWaitsForEarlierReads) {
+    auto pool = std::make_shared<ThreadPool>(4);
+    std::atomic<bool> readDone{false};
+    std::atomic<bool> writeSawRead{false};
+    std::atomic<bool> laterReadSawWrite{false};
+    std::atomic<bool> writeDone{false};
+
+    ToolPipeline pipeline(pool, [&](const ChatMessage::ToolCall& call) {
+        if (call.id == "read1") {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            readDone = true;
+        } else if (call.id == "write") {
+            writeSawRead = readDone.load();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            writeDone = true;
+        } else if (call.id == "read2") {
+            laterReadSawWrite = writeDone.load();
+        }
+        return ToolResult::ok(call.id);
+    }, resolveAccess);
+
+    pipeline.dispatch(makeCall("read1", "read", {{"path", "/tmp/x"}}));
+    pipeline.dispatch(makeCall("write", "write", {{"path", "/tmp/x"}, {"content", "new"}}));
+    pipeline.dispatch(makeCall("read2", "read", {{"path", "/tmp/x"}}));
+
+    auto results = pipeline.finish();
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_TRUE(writeSawRead.load());
+    EXPECT_TRUE(laterReadSawWrite.load());
+    EXPECT_EQ(pipeline.getStats().deferred, 2u);
+}
+
+// 测试执行异常转换为错误结果 / Executor exceptions become error results
+TEST(ToolPipelineTest, ExceptionBecomesErrorResult) {
+    ToolPipeline pipeline(nullptr, [](const ChatMessage::ToolCall& call) -> ToolResult {
+        if (call.id == "bad") {
+            throw std::runtime_error("boom");
+        }
+        return ToolResult::ok(call.id);
+    }, resolveAccess);
+
+    pipeline.dispatch(makeCall("ok", "bash", {{"command", "true"}}));
+    pipeline.dispatch(makeCall("bad", "bash", {{"command", "false"}}));
+
+    auto results = pipeline.finish();
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_TRUE(results[0].second.success);
+    EXPECT_FALSE(results[1].second.success);
+    EXPECT_NE(results[1].second.error_message.find("boom"), std::string::npos);
+}
+
+// 测试互不冲突的调用并行，冲突的调用按顺序执行 / Independent calls overlap, conflicting ones serialize
+TEST(ToolPipelineTest, ConflictGraphSchedulesBatch) {
+    auto pool = std::make_shared<ThreadPool>(4);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    std::mutex orderMutex;
+    std::vector<std::string> portOrder;
+
+    ToolPipeline pipeline(pool, [&](const ChatMessage::ToolCall& call) {
+        int now = ++running;
+        int expected = peak.load();
+        while (now > expected && !peak.compare_exchange_weak(expected, now)) {}
+        if (call.name == "serial") {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            portOrder.push_back(call.id);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --running;
+        return ToolResult::ok(call.id);
+    }, resolveAccess);
+
+    // 不同文件的写入互不冲突 / Writes to different files do not conflict
+    pipeline.dispatch(makeCall("w1", "write", {{"path", "/tmp/roboclaw_a.txt"}, {"content", "a"}}));
+    pipeline.dispatch(makeCall("w2", "write", {{"path", "/tmp/roboclaw_b.txt"}, {"content", "b"}}));
+    // 同一串口的操作独占设备 / Operations on one port are exclusive
+    pipeline.dispatch(makeCall("s1", "serial", {{"action", "write"}, {"port", "/dev/ttyUSB0"}, {"data", "x"}}));
+    pipeline.dispatch(makeCall("s2", "serial", {{"action", "read"}, {"port", "/dev/ttyUSB0"}}));
+
+    auto results = pipeline.finish();
+    ASSERT_EQ(results.size(), 4u);
+    EXPECT_GT(peak.load(), 1);
+    EXPECT_EQ(pipeline.getStats().deferred, 1u);
+    ASSERT_EQ(portOrder.size(), 2u);
+    EXPECT_EQ(portOrder[0], "s1");
+    EXPECT_EQ(portOrder[1], "s2");
+}
+
+// 测试线程池拒绝任务时依赖链仍能完成 / Rejected submissions still release their dependents
+TEST(ToolPipelineTest, RejectedSubmissionReleasesDependents) {
+    // 同步对象先于线程池构造，线程池析构时它们仍然有效 / Outlive the pool's workers
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool dispatched = false;
+    bool released = false;
+
+    ThreadPoolConfig config;
+    config.min_threads = 1;
+    config.max_threads = 1;
+    config.max_queue_size = 1;
+    config.enable_dynamic_scaling = false;
+    auto pool = std::make_shared<ThreadPool>(config);
+
+    ToolPipeline pipeline(pool, [&](const ChatMessage::ToolCall& call) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return dispatched; });
+        // 占满队列，使后续提交被拒绝 / Fill the queue so the next submissions are rejected
+        pool->submit([&] {
+            std::unique_lock<std::mutex> blocker(mutex);
+            cv.wait(blocker, [&] { return released; });
+        });
+        return ToolResult::ok(call.id);
+    }, resolveAccess);
+
+    pipeline.dispatch(makeCall("w1", "write", {{"path", "/tmp/roboclaw_x.txt"}, {"content", "1"}}));
+    pipeline.dispatch(makeCall("w2", "write", {{"path", "/tmp/roboclaw_x.txt"}, {"content", "2"}}));
+    pipeline.dispatch(makeCall("w3", "write", {{"path", "/tmp/roboclaw_x.txt"}, {"content", "3"}}));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dispatched = true;
+    }
+    cv.notify_all();
+
+    auto results = pipeline.finish();
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_TRUE(results[0].second.success);
+    EXPECT_FALSE(results[1].second.success);
+    EXPECT_FALSE(results[2].second.success);
+    EXPECT_NE(results[2].second.error_message.find("提交失败"), std::string::npos);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    cv.notify_all();
+}
@@ -4,10 +4,17 @@
 #include "../../src/tools/tool_base.h"
 #include "../../src/tools/read_tool.h"
 #include "../../src/tools/write_tool.h"
+#include "../../src/tools/edit_tool.h"
 #include "../../src/tools/bash_tool.h"
 #include "../../src/tools/serial_tool.h"
+#include "../../src/agent/tool_executor.h"
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
 
 using namespace roboclaw;
 
@@ -128,6 +135,123 @@ TEST_F(ToolsTest, BashToolForbiddenCommands) {
     EXPECT_NE(result.error_message.find("forbidden"), std::string::npos);
 }
 
+// 测试有界输出缓冲保留开头和结尾 / Test bounded output buffer keeps head and tail
+TEST_F(ToolsTest, OutputBufferKeepsHeadAndTail) {
+    OutputBuffer buffer(16);
+    buffer.append("abcdefgh");
+    buffer.append(std::string(1000, '-'));
+    buffer.append("12345");
+    buffer.append("678");
+
+    EXPECT_EQ(buffer.totalBytes(), 1016u);
+    EXPECT_EQ(buffer.droppedBytes(), 1000u);
+    std::string text = buffer.str();
+    EXPECT_EQ(text.rfind("abcdefgh", 0), 0u);
+    EXPECT_NE(text.find("1000"), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 8), "12345678");
+
+    // 截断点不拆分UTF-8字符 / Truncation never splits a UTF-8 character
+    OutputBuffer utf8(8);
+    for (int i = 0; i < 100; ++i) {
+        utf8.append("中文");
+    }
+    std::string utf8Text = utf8.str();
+    EXPECT_NO_THROW(json(utf8Text).dump());
+    EXPECT_EQ(utf8Text.rfind("中", 0), 0u);
+}
+
+// 测试大量标准错误输出不会死锁 / Test heavy stderr output does not deadlock
+TEST_F(ToolsTest, BashToolDrainsBothStreams) {
+    BashTool bashTool;
+    bashTool.setOutputLimit(4096);
+
+    json params;
+    params["command"] = "seq 1 200000 >&2; echo stdout-done; seq 1 200000";
+    params["timeout"] = 20;
+
+    ToolResult result = bashTool.execute(params);
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(result.metadata["exit_code"], 0);
+    EXPECT_NE(result.content.find("stdout-done"), std::string::npos);
+    EXPECT_NE(result.content.find("200000"), std::string::npos);
+    EXPECT_GT(result.metadata["stderr_bytes"].get<size_t>(), 1000000u);
+    EXPECT_GT(result.metadata["truncated_bytes"].get<size_t>(), 0u);
+    EXPECT_LT(result.content.size(), 10000u);
+}
+
+// 测试超时终止命令并返回已有输出 / Test timeout kills the command and keeps partial output
+TEST_F(ToolsTest, BashToolTimeout) {
+    BashTool bashTool;
+
+    json params;
+    params["command"] = "echo partial-output; sleep 30";
+    params["timeout"] = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    ToolResult result = bashTool.execute(params);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.error_message.find("超时"), std::string::npos);
+    EXPECT_NE(result.error_message.find("partial-output"), std::string::npos);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+// 测试并发调用的超时互不影响 / Test concurrent calls have independent timeouts
+TEST_F(ToolsTest, BashToolConcurrentTimeouts) {
+    BashTool bashTool;
+
+    std::vector<ToolResult> slow(2);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < slow.size(); ++i) {
+        threads.emplace_back([&, i] {
+            slow[i] = bashTool.execute({{"command", "sleep 30"}, {"timeout", 1}});
+        });
+    }
+    ToolResult fast = bashTool.execute({{"command", "sleep 2; echo finished"}, {"timeout", 10}});
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (const auto& result : slow) {
+        EXPECT_FALSE(result.success);
+    }
+    ASSERT_TRUE(fast.success) << fast.error_message;
+    EXPECT_NE(fast.content.find("finished"), std::string::npos);
+}
+
+// 测试后台进程不阻塞命令返回 / Test background processes do not block completion
+TEST_F(ToolsTest, BashToolBackgroundProcess) {
+    BashTool bashTool;
+
+    auto start = std::chrono::steady_clock::now();
+    ToolResult result = bashTool.execute({{"command", "sleep 5 & echo started"}, {"timeout", 10}});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_NE(result.content.find("started"), std::string::npos);
+    EXPECT_LT(elapsed, std::chrono::seconds(3));
+}
+
+// 测试实时输出回调 / Test streaming output callback
+TEST_F(ToolsTest, BashToolStreamsOutput) {
+    BashTool bashTool;
+    std::mutex mutex;
+    std::vector<std::string> stdoutLines;
+    std::vector<std::string> stderrLines;
+    bashTool.setOutputCallback([&](const std::string&, bool isStderr, std::string_view line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        (isStderr ? stderrLines : stdoutLines).emplace_back(line);
+    });
+
+    ToolResult result = bashTool.execute({{"command", "echo one; echo err >&2; printf 'two\nthree'"}});
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(stdoutLines, (std::vector<std::string>{"one", "two", "three"}));
+    EXPECT_EQ(stderrLines, (std::vector<std::string>{"err"}));
+}
+
 // 测试工具描述 / Test tool descriptions
 TEST_F(ToolsTest, ToolDescriptions) {
     ReadTool readTool;
@@ -220,3 +344,110 @@ int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+// 测试工具Schema缓存 / Test tool schema cache
+TEST_F(ToolsTest, ToolSchemaCache) {
+    ToolExecutor executor;
+    executor.registerTool("schema_read", std::make_shared<ReadTool>());
+
+    // 未注册新工具时返回同一快照 / Same snapshot while no tool is registered
+    auto first = executor.getToolSchema();
+    auto second = executor.getToolSchema();
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first->version, 0u);
+
+    auto it = std::find_if(first->tools.begin(), first->tools.end(),
+                           [](const ToolDefinition& tool) { return tool.name == "read"; });
+    ASSERT_NE(it, first->tools.end());
+    EXPECT_EQ(it->input_schema["type"], "object");
+    EXPECT_TRUE(it->input_schema["properties"].contains("path"));
+
+    // 注册工具使缓存失效 / Registering a tool invalidates the cache
+    executor.registerTool("schema_write", std::make_shared<WriteTool>());
+    auto third = executor.getToolSchema();
+    EXPECT_NE(third, first);
+    EXPECT_GT(third->version, first->version);
+    EXPECT_EQ(third->tools.size(), first->tools.size() + 1);
+}
+
+// 测试默认值转换 / Test default value conversion
+TEST_F(ToolsTest, ToolDefinitionDefaults) {
+    ToolDescription desc;
+    desc.name = "defaults";
+    desc.description = "default values";
+    desc.parameters = {
+        {"count", "integer", "count", false, "10"},
+        {"broken", "integer", "not a number", false, "abc"},
+        {"flag", "boolean", "flag", true, "true"}
+    };
+
+    ToolDefinition tool = ToolExecutor::toToolDefinition(desc);
+    const auto& props = tool.input_schema["properties"];
+    EXPECT_EQ(props["count"]["default"], 10);
+    EXPECT_EQ(props["broken"]["default"], "abc");
+    EXPECT_EQ(props["flag"]["default"], true);
+    EXPECT_EQ(tool.input_schema["required"], json::array({"flag"}));
+}
+
+// 测试资源访问冲突规则 / Resource access conflict rules
+TEST_F(ToolsTest, ToolAccessConflicts) {
+    std::string file = test_dir_ + "/a.txt";
+
+    ToolAccess readA = ToolAccess().reads(file);
+    ToolAccess readA2 = ToolAccess().reads(test_dir_ + "/./a.txt");
+    ToolAccess writeA = ToolAccess().writes(file);
+    ToolAccess writeB = ToolAccess().writes(test_dir_ + "/b.txt");
+    ToolAccess readDir = ToolAccess().reads(test_dir_ + "/");
+
+    EXPECT_FALSE(readA.conflictsWith(readA2));
+    EXPECT_TRUE(readA2.conflictsWith(writeA));
+    EXPECT_FALSE(writeA.conflictsWith(writeB));
+    EXPECT_TRUE(readDir.conflictsWith(writeB));
+
+    ToolAccess port0 = ToolAccess().exclusive("/dev/ttyUSB0");
+    EXPECT_TRUE(port0.conflictsWith(ToolAccess().exclusive("/dev/ttyUSB0")));
+    EXPECT_FALSE(port0.conflictsWith(ToolAccess().exclusive("/dev/ttyUSB1")));
+
+    EXPECT_TRUE(ToolAccess::unknown().conflictsWith(readA));
+    EXPECT_FALSE(ToolAccess::pureAccess().conflictsWith(ToolAccess::unknown()));
+}
+
+// 测试内置工具的访问声明 / Built-in tools declare their access
+TEST_F(ToolsTest, ToolAccessDeclarations) {
+    std::string file = test_dir_ + "/data.txt";
+    json pathArgs = {{"path", file}};
+
+    ToolAccess read = ReadTool().describeAccess(pathArgs);
+    ToolAccess write = WriteTool().describeAccess(pathArgs);
+    ToolAccess edit = EditTool().describeAccess(pathArgs);
+
+    EXPECT_FALSE(read.conflictsWith(ReadTool().describeAccess(pathArgs)));
+    EXPECT_TRUE(read.conflictsWith(write));
+    EXPECT_TRUE(read.conflictsWith(edit));
+    EXPECT_TRUE(BashTool().describeAccess({{"command", "ls"}}).global);
+
+    SerialTool serial;
+    EXPECT_TRUE(serial.describeAccess({{"action", "list"}}).pure);
+    EXPECT_TRUE(serial.describeAccess({{"action", "read"}, {"port", "/dev/ttyUSB0"}})
+                    .conflictsWith(serial.describeAccess({{"action", "write"}, {"port", "/dev/ttyUSB0"}})));
+}
+
+// 测试无法判断访问范围的调用保守串行 / Calls with unclear access fall back to serial
+TEST_F(ToolsTest, ToolAccessFallsBackToSerial) {
+    EXPECT_TRUE(ReadTool().describeAccess(json::object()).global);
+    EXPECT_TRUE(EditTool().describeAccess({{"path", ""}}).global);
+    EXPECT_TRUE(WriteTool().describeAccess({{"files", json::array()}}).global);
+    EXPECT_TRUE(WriteTool().describeAccess(
+        {{"files", {{{"path", test_dir_ + "/a.txt"}, {"content", "a"}}, {{"content", "b"}}}}}).global);
+
+    // 通过符号链接访问的同一端口判为冲突 / The same port reached through a symlink conflicts
+    std::string link = test_dir_ + "/ttyLink";
+    std::string target = test_dir_ + "/ttyTarget";
+    std::ofstream(target).close();
+    std::filesystem::create_symlink(target, link);
+    SerialTool serial;
+    EXPECT_TRUE(serial.describeAccess({{"action", "read"}, {"port", link}})
+                    .conflictsWith(serial.describeAccess({{"action", "write"}, {"port", target}})));
+    EXPECT_TRUE(serial.describeAccess({{"action", "open"}, {"port", target}})
+                    .conflictsWith(ReadTool().describeAccess({{"path", link}})));
+}
@@ -0,0 +1,378 @@
+// WebDriver/CDP客户端测试 / WebDriver and DevTools client tests
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../../src/tools/webdriver_client.h"
+
+using namespace roboclaw;
+
+namespace {
+
+// 本地模拟端点：WebDriver HTTP接口 + DevTools WebSocket
+// Local mock endpoint speaking WebDriver HTTP and DevTools WebSocket
+class MockBrowserEndpoint {
+public:
+    MockBrowserEndpoint() {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listen_fd_, 16);
+        socklen_t length = sizeof(address);
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        acceptor_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~MockBrowserEndpoint() {
+        stop_ = true;
+        acceptor_.join();
+        ::close(listen_fd_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : client_fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    int port() const { return port_; }
+    int connections() const { return connections_.load(); }
+
+    static std::string screenshotData() { return std::string(100000, 'Q'); }
+
+private:
+    void acceptLoop() {
+        while (!stop_) {
+            pollfd pfd{listen_fd_, POLLIN, 0};
+            if (::poll(&pfd, 1, 20) != 1) {
+                continue;
+            }
+            int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            connections_++;
+            std::lock_guard<std::mutex> lock(mutex_);
+            client_fds_.push_back(fd);
+            workers_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    static bool readMore(int fd, std::string& buffer) {
+        char chunk[4096];
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    static void sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        while (true) {
+            size_t headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                if (!readMore(fd, buffer)) {
+                    ::close(fd);
+                    return;
+                }
+            }
+            std::string head = buffer.substr(0, headerEnd);
+            size_t contentLength = 0;
+            size_t lengthPos = head.find("Content-Length: ");
+            if (lengthPos != std::string::npos) {
+                contentLength = std::stoul(head.substr(lengthPos + 16));
+            }
+            while (buffer.size() < headerEnd + 4 + contentLength) {
+                if (!readMore(fd, buffer)) {
+                    ::close(fd);
+                    return;
+                }
+            }
+            std::string body = buffer.substr(headerEnd + 4, contentLength);
+            buffer.erase(0, headerEnd + 4 + contentLength);
+
+            std::string method = head.substr(0, head.find(' '));
+            size_t pathStart = method.size() + 1;
+            std::string path = head.substr(pathStart, head.find(' ', pathStart) - pathStart);
+
+            if (head.find("Upgrade: websocket") != std::string::npos) {
+                sendAll(fd, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n");
+                serveWebSocket(fd, buffer);
+                ::close(fd);
+                return;
+            }
+
+            int status = 200;
+            json reply = route(method, path, body, status);
+            std::string payload = reply.dump();
+            bool closeAfter = path == "/close-after";
+            sendAll(fd, "HTTP/1.1 " + std::to_string(status) + " X\r\nContent-Type: application/json\r\n"
+                        "Content-Length: " + std::to_string(payload.size()) + "\r\n" +
+                        (closeAfter ? "Connection: close\r\n" : "") + "\r\n" + payload);
+            if (closeAfter) {
+                ::close(fd);
+                return;
+            }
+        }
+    }
+
+    json route(const std::string& method, const std::string& path, const std::string& body, int& status) {
+        std::string debugger = "127.0.0.1:" + std::to_string(port_);
+        if (path == "/status") {
+            return {{"value", {{"ready", true}}}};
+        }
+        if (method == "POST" && path == "/session") {
+            return {{"value", {{"sessionId", "s1"},
+                               {"capabilities", {{"goog:chromeOptions", {{"debuggerAddress", debugger}}}}}}}};
+        }
+        if (path == "/json/list") {
+            return json::array({{{"type", "service_worker"}},
+                                {{"type", "page"}, {"webSocketDebuggerUrl", "ws://" + debugger + "/devtools/page/A"}}});
+        }
+        if (path == "/session/s1/title") {
+            return {{"value", "Mock"}};
+        }
+        if (path == "/session/s1/element") {
+            if (json::parse(body).value("value", "") == "#missing") {
+                status = 404;
+                return {{"value", {{"error", "no such element"}, {"message", "Unable to locate"}}}};
+            }
+            return {{"value", {{"element-6066-11e4-a52e-4f735466cecf", "e1"}}}};
+        }
+        if (path == "/session/s1/url" || path == "/session/s1" || path == "/close-after") {
+            return {{"value", nullptr}};
+        }
+        status = 404;
+        return {{"value", {{"error", "unknown command"}, {"message", path}}}};
+    }
+
+    static void sendFrame(int fd, const std::string& payload) {
+        std::string frame(1, static_cast<char>(0x81));
+        if (payload.size() < 126) {
+            frame += static_cast<char>(payload.size());
+        } else if (payload.size() <= 0xffff) {
+            frame += static_cast<char>(126);
+            frame += static_cast<char>(payload.size() >> 8);
+            frame += static_cast<char>(payload.size() & 0xff);
+        } else {
+            frame += static_cast<char>(127);
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xff);
+            }
+        }
+        sendAll(fd, frame + payload);
+    }
+
+    static void sendEvent(int fd, const std::string& method, const json& params) {
+        sendFrame(fd, json{{"method", method}, {"params", params}}.dump());
+    }
+
+    void serveWebSocket(int fd, std::string& buffer) {
+        while (true) {
+            // 客户端帧：带掩码 / Client frames are masked
+            while (buffer.size() < 2 || buffer.size() < frameSize(buffer)) {
+                if (!readMore(fd, buffer)) {
+                    return;
+                }
+            }
+            size_t total = frameSize(buffer);
+            uint8_t opcode = buffer[0] & 0x0f;
+            size_t length = buffer[1] & 0x7f;
+            size_t pos = 2;
+            if (length == 126) {
+                length = (static_cast<uint8_t>(buffer[2]) << 8) | static_cast<uint8_t>(buffer[3]);
+                pos = 4;
+            }
+            std::string mask = buffer.substr(pos, 4);
+            std::string payload = buffer.substr(pos + 4, length);
+            for (size_t i = 0; i < payload.size(); ++i) {
+                payload[i] ^= mask[i & 3];
+            }
+            buffer.erase(0, total);
+            if (opcode == 0x8) {
+                return;
+            }
+
+            json message = json::parse(payload);
+            int id = message["id"];
+            std::string method = message["method"];
+            if (method == "Page.navigate") {
+                sendFrame(fd, json{{"id", id}, {"result", {{"frameId", "F"}}}}.dump());
+                sendEvent(fd, "Network.requestWillBeSent", {{"requestId", "r1"}});
+                sendEvent(fd, "Network.requestWillBeSent", {{"requestId", "r2"}});
+                sendEvent(fd, "Page.frameNavigated", {{"frame", {{"id", "F"}}}});
+                sendEvent(fd, "Page.loadEventFired", {{"timestamp", 1.0}});
+                sendEvent(fd, "Page.frameNavigated", {{"frame", {{"id", "child"}, {"parentId", "F"}}}});
+                std::this_thread::sleep_for(std::chrono::milliseconds(60));
+                sendEvent(fd, "Network.loadingFinished", {{"requestId", "r1"}});
+                sendEvent(fd, "Network.loadingFailed", {{"requestId", "r2"}});
+            } else if (method == "Page.reload") {
+                // 开始新的导航，但不发出load事件 / Starts a new navigation that never fires load
+                sendFrame(fd, json{{"id", id}, {"result", json::object()}}.dump());
+                sendEvent(fd, "Page.frameNavigated", {{"frame", {{"id", "F"}}}});
+            } else if (method == "Page.captureScreenshot") {
+                sendFrame(fd, json{{"id", id}, {"result", {{"data", screenshotData()}}}}.dump());
+            } else if (method == "Runtime.evaluate") {
+                // 先发一条id不是整数的消息，客户端应忽略 / A message with a non-integer id is ignored
+                sendFrame(fd, json{{"id", "stray"}, {"result", json::object()}}.dump());
+                sendFrame(fd, json{{"id", id}, {"result", {{"result", {{"type", "number"}, {"value", 42}}}}}}.dump());
+            } else if (method.find(".enable") != std::string::npos) {
+                sendFrame(fd, json{{"id", id}, {"result", json::object()}}.dump());
+            } else {
+                sendFrame(fd, json{{"id", id}, {"error", {{"code", -32601}, {"message", "not found"}}}}.dump());
+            }
+        }
+    }
+
+    static size_t frameSize(const std::string& buffer) {
+        size_t length = buffer[1] & 0x7f;
+        if (length == 126) {
+            if (buffer.size() < 4) {
+                return 4;
+            }
+            return 8 + ((static_cast<uint8_t>(buffer[2]) << 8) | static_cast<uint8_t>(buffer[3]));
+        }
+        return 6 + length;
+    }
+
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> connections_{0};
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> client_fds_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace
+
+// 测试命令复用同一连接、流水线和W3C错误 / One keep-alive connection, pipelining and W3C errors
+TEST(WebDriverClientTest, ReusesConnectionAndPipelines) {
+    MockBrowserEndpoint endpoint;
+    WebDriverClient client("127.0.0.1", endpoint.port());
+
+    ASSERT_TRUE(client.waitUntilReady(2000));
+    json capabilities;
+    ASSERT_TRUE(client.createSession({{"alwaysMatch", {{"browserName", "chrome"}}}}, &capabilities));
+    EXPECT_EQ(client.sessionId(), "s1");
+    EXPECT_TRUE(capabilities["goog:chromeOptions"].contains("debuggerAddress"));
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(client.command("POST", client.sessionPath("/url"), {{"url", "about:blank"}}).ok);
+    }
+
+    auto replies = client.pipeline({
+        {"GET", client.sessionPath("/title"), nullptr},
+        {"POST", client.sessionPath("/element"), {{"using", "css selector"}, {"value", "#ok"}}},
+        {"POST", client.sessionPath("/element"), {{"using", "css selector"}, {"value", "#missing"}}},
+    });
+    ASSERT_EQ(replies.size(), 3u);
+    EXPECT_EQ(replies[0].value, "Mock");
+    EXPECT_TRUE(replies[1].ok);
+    EXPECT_FALSE(replies[2].ok);
+    EXPECT_EQ(replies[2].status, 404);
+    EXPECT_NE(replies[2].error.find("no such element"), std::string::npos);
+
+    EXPECT_EQ(endpoint.connections(), 1);
+    EXPECT_EQ(client.getConnectionCount(), 1);
+    EXPECT_TRUE(client.deleteSession());
+}
+
+// 测试服务器关闭连接后重连，以及驱动未启动时超时 / Reconnects after close; times out without a driver
+TEST(WebDriverClientTest, ReconnectsAndTimesOut) {
+    MockBrowserEndpoint endpoint;
+    WebDriverClient client("127.0.0.1", endpoint.port());
+    EXPECT_TRUE(client.command("GET", "/close-after").ok);
+    EXPECT_TRUE(client.command("GET", "/status").ok);
+    EXPECT_EQ(client.getConnectionCount(), 2);
+
+    // 取一个空闲端口 / Grab an unused port
+    int port;
+    {
+        MockBrowserEndpoint unused;
+        port = unused.port();
+    }
+    WebDriverClient missing("127.0.0.1", port);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(missing.waitUntilReady(100));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_FALSE(missing.command("GET", "/status").error.empty());
+}
+
+// 测试CDP流水线、事件等待、网络空闲和截图 / CDP pipelining, event waits, network idle and screenshots
+TEST(CdpClientTest, WaitsForEventsInsteadOfSleeping) {
+    MockBrowserEndpoint endpoint;
+    std::string url = CdpClient::findPageWebSocketUrl("127.0.0.1", endpoint.port());
+    ASSERT_EQ(url, "ws://127.0.0.1:" + std::to_string(endpoint.port()) + "/devtools/page/A");
+
+    CdpClient cdp;
+    ASSERT_TRUE(cdp.connect(url));
+    auto results = cdp.callBatch({{"Page.enable", json::object()},
+                                  {"Network.enable", json::object()},
+                                  {"Bogus.method", json::object()}});
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_TRUE(results[0].is_object());
+    EXPECT_TRUE(results[1].is_object());
+    EXPECT_TRUE(results[2].is_null());
+    EXPECT_EQ(cdp.lastError(), "not found");
+
+    cdp.clearEvents();
+    json navigation = cdp.call("Page.navigate", {{"url", "http://example.test"}});
+    EXPECT_EQ(navigation["frameId"], "F");
+    ASSERT_TRUE(cdp.waitForEvent("Page.loadEventFired", 2000));
+    EXPECT_EQ(cdp.getInflightRequests(), 2u);
+
+    // load事件已被取走，但本次导航之后已经加载完成，立即返回（子框架导航不影响）
+    // The load event was consumed, yet the page already loaded after the navigation (subframes ignored)
+    auto loadStart = std::chrono::steady_clock::now();
+    EXPECT_TRUE(cdp.waitForEventAfter("Page.loadEventFired", "Page.frameNavigated", 0, 2000));
+    EXPECT_LT(std::chrono::steady_clock::now() - loadStart, std::chrono::milliseconds(1000));
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(cdp.waitForNetworkIdle(50, 2000));
+    EXPECT_EQ(cdp.getInflightRequests(), 0u);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+    json shot = cdp.call("Page.captureScreenshot", {{"format", "png"}});
+    EXPECT_EQ(shot.value("data", ""), MockBrowserEndpoint::screenshotData());
+
+    json evaluated = cdp.call("Runtime.evaluate", {{"expression", "6*7"}, {"returnByValue", true}});
+    EXPECT_EQ(evaluated["result"]["value"], 42);
+
+    EXPECT_FALSE(cdp.waitForEvent("Page.neverFired", 50));
+
+    // 新导航之后尚未加载 / Not loaded since the newer navigation
+    uint64_t since = cdp.eventSequence();
+    ASSERT_TRUE(cdp.call("Page.reload").is_object());
+    EXPECT_FALSE(cdp.waitForEventAfter("Page.loadEventFired", "Page.frameNavigated", since, 100));
+    EXPECT_GT(cdp.eventSequence(), since);
+    cdp.close();
+    EXPECT_FALSE(cdp.isConnected());
+}
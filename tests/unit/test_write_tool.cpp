@@ -0,0 +1,123 @@
+// 写入工具测试 / Write tool tests
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "../../src/tools/write_tool.h"
+
+using namespace roboclaw;
+namespace fs = std::filesystem;
+
+namespace {
+
+class WriteToolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() / ("roboclaw_write_tool_test_" + std::to_string(std::random_device{}()));
+        fs::create_directories(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    std::string pathOf(const std::string& name) const {
+        return (dir_ / name).string();
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    fs::path dir_;
+};
+
+// 测试单文件写入 / Test writing a single file
+TEST_F(WriteToolTest, WritesSingleFile) {
+    WriteTool tool;
+    ToolResult result = tool.execute({{"path", pathOf("a/b/main.c")}, {"content", "int main() {}\n"}});
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_EQ(readFile(pathOf("a/b/main.c")), "int main() {}\n");
+    EXPECT_EQ(result.metadata["bytes_written"], 14);
+    EXPECT_FALSE(result.metadata["overwrite"].get<bool>());
+    EXPECT_TRUE(result.metadata["timings_ms"].contains("total"));
+}
+
+// 测试批量写入与未变化文件的跳过 / Test batched writes and skipping unchanged files
+TEST_F(WriteToolTest, WritesBatchAndSkipsUnchangedFiles) {
+    WriteTool tool;
+    json files = json::array();
+    for (int i = 0; i < 12; ++i) {
+        files.push_back({{"path", pathOf("drv/src/file" + std::to_string(i) + ".c")},
+                         {"content", "/* generated " + std::to_string(i) + " */\n"}});
+    }
+    files.push_back({{"path", pathOf("drv/inc/driver.h")}, {"content", "#pragma once\n"}});
+
+    ToolResult first = tool.execute({{"files", files}});
+    ASSERT_TRUE(first.success) << first.error_message;
+    EXPECT_EQ(first.metadata["files_written"], 13);
+    EXPECT_EQ(first.metadata["files_unchanged"], 0);
+    EXPECT_EQ(readFile(pathOf("drv/src/file7.c")), "/* generated 7 */\n");
+
+    // 只修改一个文件，其余应被跳过且不被替换 / Change one file; the rest are skipped, not replaced
+    FileStamp before;
+    ASSERT_TRUE(readFileStamp(pathOf("drv/src/file3.c"), before));
+    files[0]["content"] = "/* regenerated */\n";
+    ToolResult second = tool.execute({{"files", files}});
+    ASSERT_TRUE(second.success) << second.error_message;
+    EXPECT_EQ(second.metadata["files_written"], 1);
+    EXPECT_EQ(second.metadata["files_unchanged"], 12);
+    EXPECT_EQ(second.metadata["files"][0]["status"], "overwritten");
+    EXPECT_EQ(second.metadata["files"][3]["status"], "unchanged");
+    FileStamp after;
+    ASSERT_TRUE(readFileStamp(pathOf("drv/src/file3.c"), after));
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(readFile(pathOf("drv/src/file0.c")), "/* regenerated */\n");
+
+    // 新的工具实例没有摘要缓存，仍能识别未变化的文件 / A fresh instance detects unchanged files by hashing
+    WriteTool fresh;
+    ToolResult third = fresh.execute({{"path", pathOf("drv/inc/driver.h")}, {"content", "#pragma once\n"}});
+    ASSERT_TRUE(third.success);
+    EXPECT_TRUE(third.metadata["unchanged"].get<bool>());
+}
+
+// 测试覆盖时保留权限 / Test overwriting keeps file permissions
+TEST_F(WriteToolTest, OverwriteKeepsPermissions) {
+    std::string path = pathOf("flash.sh");
+    std::ofstream(path) << "old\n";
+    fs::permissions(path, fs::perms::owner_all);
+
+    WriteTool tool;
+    ToolResult result = tool.execute({{"path", path}, {"content", "#!/bin/sh\n"}});
+
+    ASSERT_TRUE(result.success) << result.error_message;
+    EXPECT_TRUE(result.metadata["overwrite"].get<bool>());
+    EXPECT_EQ(fs::status(path).permissions() & fs::perms::all, fs::perms::owner_all);
+}
+
+// 测试批量写入失败时不替换任何文件 / Test a failing batch replaces nothing
+TEST_F(WriteToolTest, FailedBatchWritesNothing) {
+    fs::create_directories(dir_ / "occupied");
+    WriteTool tool;
+
+    json files = json::array({{{"path", pathOf("good.c")}, {"content", "ok\n"}},
+                              {{"path", pathOf("occupied")}, {"content", "not a directory\n"}}});
+    ToolResult result = tool.execute({{"files", files}});
+
+    EXPECT_FALSE(result.success);
+    EXPECT_FALSE(fs::exists(pathOf("good.c")));
+    // 没有残留的临时文件 / No temporary files are left behind
+    EXPECT_EQ(std::distance(fs::directory_iterator(dir_), fs::directory_iterator()), 1);
+
+    json duplicate = json::array({{{"path", pathOf("x.c")}, {"content", "1"}},
+                                  {{"path", pathOf("./x.c")}, {"content", "2"}}});
+    EXPECT_FALSE(tool.execute({{"files", duplicate}}).success);
+}
+
+} // namespace
@@ -288,6 +288,46 @@ TEST_CASE("Remove source from pipeline", "[pipeline]") {
     }
 }
 
+TEST_CASE("Replace source for hot reload", "[pipeline]") {
+    VisionPipeline pipeline;
+    nlohmann::json old_config = {{"width", 640}, {"height", 480}};
+    nlohmann::json new_config = {{"width", 1280}, {"height", 720}};
+
+    auto old_source = std::make_shared<MockVisionDevice>();
+    old_source->initialize(old_config);
+    old_source->openDevice("");
+    pipeline.addSource(old_source);
+
+    auto new_source = std::make_shared<MockVisionDevice>();
+    new_source->initialize(new_config);
+    new_source->openDevice("");
+
+    SECTION("Replacement takes over capture") {
+        REQUIRE(pipeline.replaceSource(old_source, new_source));
+        REQUIRE(pipeline.getSourceCount() == 1);
+
+        auto frame = pipeline.captureFrame();
+        REQUIRE(frame.width == 1280);
+        delete[] static_cast<uint8_t*>(frame.data);
+    }
+
+    SECTION("Pipeline releases the old source") {
+        std::weak_ptr<MockVisionDevice> weak_old = old_source;
+        REQUIRE(pipeline.replaceSource(old_source, new_source));
+        old_source.reset();
+        REQUIRE(weak_old.expired());
+    }
+
+    SECTION("Unknown source is not replaced") {
+        auto stranger = std::make_shared<MockVisionDevice>();
+        REQUIRE_FALSE(pipeline.replaceSource(stranger, new_source));
+
+        auto frame = pipeline.captureFrame();
+        REQUIRE(frame.width == 640);
+        delete[] static_cast<uint8_t*>(frame.data);
+    }
+}
+
 TEST_CASE("Pipeline cleanup on shutdown", "[pipeline]") {
     VisionPipeline pipeline;
     auto source = std::make_shared<MockVisionDevice>();